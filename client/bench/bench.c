@@ -0,0 +1,792 @@
+// Host benchmark and regression harness for the client's bundle code:
+// bundle.c (create, parse, stream decode, save hash) and shared/sha256.c,
+// built against stub/3ds.h so they can run without a console.
+//
+//   bench                 time every operation over the built-in corpus and
+//                         check the results round-trip
+//   bench --export DIR    write the corpus and the bundles bundle_create
+//                         makes from it, for crosscheck.py
+//   bench --verify DIR    decode the bundles crosscheck.py wrote back into
+//                         DIR and compare them with the corpus
+//
+// The corpus is generated from fixed seeds, so every run (and --export and
+// --verify in separate processes) sees the same bytes.
+
+#include "bundle.h"
+#include "sha256.h"
+#include <errno.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#define BENCH_TIMESTAMP   1700000000u
+#define BENCH_MIN_SECONDS 0.25
+#define BENCH_MIN_ROUNDS  3
+#define STREAM_PIECE      0x4000 // Roughly what one network read hands over
+#define BUNDLE_HEADER_BYTES 28
+
+//---------------------------------------------------------------------------
+// Allocation tracking
+//---------------------------------------------------------------------------
+
+// With glibc the malloc family is wrapped so zlib's internal state is
+// counted along with bundle.c's own buffers. Sizes come from
+// malloc_usable_size, so blocks allocated before tracking starts (or by
+// paths not wrapped here) free cleanly. Define BENCH_NO_ALLOC_TRACKING for
+// sanitizer builds, which bring their own allocator.
+#if defined(__GLIBC__) && !defined(BENCH_NO_ALLOC_TRACKING)
+#include <malloc.h>
+#define ALLOC_TRACKING 1
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static long long alloc_current;
+static long long alloc_peak;
+
+static void track_add(void *p) {
+    if (!p) return;
+    alloc_current += (long long)malloc_usable_size(p);
+    if (alloc_current > alloc_peak) alloc_peak = alloc_current;
+}
+
+void *malloc(size_t size) {
+    void *p = __libc_malloc(size);
+    track_add(p);
+    return p;
+}
+
+void *calloc(size_t n, size_t size) {
+    void *p = __libc_calloc(n, size);
+    track_add(p);
+    return p;
+}
+
+void *realloc(void *ptr, size_t size) {
+    long long old = ptr ? (long long)malloc_usable_size(ptr) : 0;
+    void *p = __libc_realloc(ptr, size);
+    if (p || size == 0) {
+        alloc_current -= old;
+        track_add(p);
+    }
+    return p;
+}
+
+void free(void *ptr) {
+    if (!ptr) return;
+    alloc_current -= (long long)malloc_usable_size(ptr);
+    __libc_free(ptr);
+}
+
+// Start a measurement; returns the baseline to pass to alloc_peak_since
+static long long alloc_mark(void) {
+    alloc_peak = alloc_current;
+    return alloc_current;
+}
+
+static long long alloc_peak_since(long long mark) {
+    return alloc_peak - mark;
+}
+#else
+#define ALLOC_TRACKING 0
+static long long alloc_mark(void) { return 0; }
+static long long alloc_peak_since(long long mark) { (void)mark; return -1; }
+#endif
+
+//---------------------------------------------------------------------------
+// Corpus
+//---------------------------------------------------------------------------
+
+typedef struct {
+    const char *name;
+    const char *desc;
+    u64 title_id;
+    ArchiveFile *files;
+    int count;
+    u32 total;
+} Corpus;
+
+static u32 rng_state;
+
+static u32 rng_next(void) {
+    // xorshift32
+    u32 x = rng_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return rng_state = x;
+}
+
+static u32 rng_range(u32 lo, u32 hi) {
+    return lo + rng_next() % (hi - lo + 1);
+}
+
+static void fill_random(u8 *buf, u32 len) {
+    for (u32 i = 0; i < len; i++)
+        buf[i] = (u8)(rng_next() >> 24);
+}
+
+// Game-save-like content: zero and 0xFF padding, small counters and flags,
+// and short runs of high-entropy data (checksums, RNG seeds, names).
+static void fill_structured(u8 *buf, u32 len) {
+    u32 pos = 0;
+    while (pos < len) {
+        u32 run;
+        switch (rng_next() % 4) {
+        case 0:
+            run = rng_range(16, 256);
+            if (run > len - pos) run = len - pos;
+            memset(buf + pos, 0, run);
+            break;
+        case 1:
+            run = rng_range(4, 32);
+            if (run > len - pos) run = len - pos;
+            fill_random(buf + pos, run);
+            break;
+        case 2: {
+            u16 v = (u16)rng_next();
+            run = rng_range(8, 64);
+            if (run > len - pos) run = len - pos;
+            for (u32 i = 0; i < run; i++)
+                buf[pos + i] = (i & 1) ? (u8)(v >> 8) : (u8)(v++);
+            break;
+        }
+        default:
+            run = rng_range(8, 128);
+            if (run > len - pos) run = len - pos;
+            memset(buf + pos, 0xFF, run);
+            break;
+        }
+        pos += run;
+    }
+}
+
+static ArchiveFile *corpus_add(Corpus *c, const char *path, u32 size) {
+    ArchiveFile *f = &c->files[c->count++];
+    snprintf(f->path, sizeof(f->path), "%s", path);
+    f->size = size;
+    f->data = malloc(size ? size : 1);
+    f->pooled = false;
+    c->total += size;
+    return f;
+}
+
+// Many small files, like a typical 3DS title's save archive
+static void make_3ds_small(Corpus *c) {
+    rng_state = 0x3D5A11u;
+    c->files = calloc(200, sizeof(ArchiveFile));
+    for (int i = 0; i < 200; i++) {
+        char path[64];
+        snprintf(path, sizeof(path), "data/slot%d/file%03d.bin", i % 8, i);
+        ArchiveFile *f = corpus_add(c, path, rng_range(256, 16384));
+        fill_structured(f->data, f->size);
+    }
+}
+
+// A few large, mostly empty files, like extdata or a save with a big
+// preallocated slot
+static void make_3ds_sparse(Corpus *c) {
+    rng_state = 0x3D5B16u;
+    c->files = calloc(4, sizeof(ArchiveFile));
+    ArchiveFile *f = corpus_add(c, "main", 1024 * 1024);
+    memset(f->data, 0, f->size);
+    for (u32 off = 0; off < f->size; off += 0x10000)
+        fill_structured(f->data + off, 0x800);
+    for (int i = 0; i < 3; i++) {
+        char path[32];
+        snprintf(path, sizeof(path), "sys/part%d.dat", i);
+        f = corpus_add(c, path, 64 * 1024);
+        fill_structured(f->data, f->size);
+    }
+}
+
+// A 512KB DS flash image: erased (0xFF) apart from a save block stored
+// twice (primary and backup) and some per-file records
+static void make_nds_flash(Corpus *c) {
+    rng_state = 0x0D5F1Au;
+    c->files = calloc(1, sizeof(ArchiveFile));
+    ArchiveFile *f = corpus_add(c, "save.dat", 512 * 1024);
+    memset(f->data, 0xFF, f->size);
+    fill_structured(f->data, 0x2000);
+    memcpy(f->data + 0x2000, f->data, 0x2000);
+    fill_structured(f->data + 0x10000, 0x8000);
+}
+
+// Incompressible data, which the entropy probe should store raw
+static void make_random(Corpus *c) {
+    rng_state = 0x5EED01u;
+    c->files = calloc(1, sizeof(ArchiveFile));
+    ArchiveFile *f = corpus_add(c, "save.bin", 1024 * 1024);
+    fill_random(f->data, f->size);
+}
+
+static Corpus corpus[] = {
+    { "3ds-small",  "200 small files",            0x0004000000055D00ULL, NULL, 0, 0 },
+    { "3ds-sparse", "1MB mostly zero + 3x64KB",   0x0004000000030800ULL, NULL, 0, 0 },
+    { "nds-flash",  "512KB DS flash image",       0x0004800041534D45ULL, NULL, 0, 0 },
+    { "random",     "1MB incompressible",         0x000400000F700000ULL, NULL, 0, 0 },
+};
+#define CORPUS_COUNT ((int)(sizeof(corpus) / sizeof(corpus[0])))
+
+static void corpus_build(void) {
+    make_3ds_small(&corpus[0]);
+    make_3ds_sparse(&corpus[1]);
+    make_nds_flash(&corpus[2]);
+    make_random(&corpus[3]);
+}
+
+static void corpus_free(void) {
+    for (int i = 0; i < CORPUS_COUNT; i++) {
+        archive_free_files(corpus[i].files, corpus[i].count);
+        free(corpus[i].files);
+    }
+}
+
+//---------------------------------------------------------------------------
+// archive.c stand-ins
+//---------------------------------------------------------------------------
+
+// bundle_create_archive and bundle_hash_archive read the save through
+// archive_stream; here it walks the corpus set up by the caller, in the
+// same ARCHIVE_CHUNK_SIZE pieces the real one uses.
+static const Corpus *stream_source;
+
+int archive_stream(u64 title_id, FS_MediaType media_type, const ArchiveSink *sink) {
+    (void)title_id;
+    (void)media_type;
+    const Corpus *c = stream_source;
+    for (int i = 0; i < c->count; i++) {
+        const ArchiveFile *f = &c->files[i];
+        if (!sink->begin_file(sink->ctx, f->path, f->size)) return -1;
+        for (u32 off = 0; off < f->size; off += ARCHIVE_CHUNK_SIZE) {
+            u32 len = f->size - off;
+            if (len > ARCHIVE_CHUNK_SIZE) len = ARCHIVE_CHUNK_SIZE;
+            if (!sink->write(sink->ctx, f->data + off, len)) return -1;
+        }
+        if (sink->end_file && !sink->end_file(sink->ctx)) return -1;
+    }
+    return c->count;
+}
+
+void archive_free_files(ArchiveFile *files, int count) {
+    for (int i = 0; i < count; i++) {
+        if (!files[i].pooled) free(files[i].data);
+        files[i].data = NULL;
+    }
+}
+
+//---------------------------------------------------------------------------
+// Checks
+//---------------------------------------------------------------------------
+
+static int failures;
+
+static void fail(const Corpus *c, const char *what) {
+    fprintf(stderr, "FAIL %s: %s\n", c->name, what);
+    failures++;
+}
+
+static bool files_match(const Corpus *c, const ArchiveFile *files, int count) {
+    if (count != c->count) return false;
+    for (int i = 0; i < count; i++) {
+        const ArchiveFile *a = &c->files[i], *b = &files[i];
+        if (strcmp(a->path, b->path) != 0 || a->size != b->size ||
+            memcmp(a->data, b->data, a->size) != 0)
+            return false;
+    }
+    return true;
+}
+
+// Decode a bundle with bundle_parse and compare it with the corpus
+static bool bundle_matches(const Corpus *c, const u8 *bundle, u32 size) {
+    ArchiveFile *files = calloc(c->count + 1, sizeof(ArchiveFile));
+    u8 *decompressed = NULL;
+    u64 title_id = 0;
+    u32 timestamp = 0;
+    int n = bundle_parse(bundle, size, &title_id, &timestamp,
+                         files, c->count + 1, &decompressed);
+    bool ok = n >= 0 && title_id == c->title_id &&
+              timestamp == BENCH_TIMESTAMP && files_match(c, files, n);
+    free(decompressed);
+    free(files);
+    return ok;
+}
+
+// Restore each file of a v3 bundle on its own, the way a client working
+// from Range requests would: index the header and table alone, then decode
+// each file from a copy of just its frame
+static bool random_access_matches(const Corpus *c, const u8 *bundle, u32 size) {
+    BundleEntry *entries = calloc(c->count + 1, sizeof(BundleEntry));
+    u32 table_end = entries ? BUNDLE_HEADER_BYTES : 0;
+    u32 bundle_size = 0;
+    int n = -1;
+    // Grow the prefix until the table is in, as a client fetching it would
+    while (entries && table_end <= size) {
+        n = bundle_index(bundle, table_end, entries, c->count + 1, &bundle_size);
+        if (n != BUNDLE_INDEX_SHORT) break;
+        table_end += 256;
+    }
+    bool ok = n == c->count && bundle_size == size;
+
+    // bundle_parse must use stored files in place
+    ArchiveFile *files = calloc(c->count + 1, sizeof(ArchiveFile));
+    u8 *decompressed = NULL;
+    u64 title_id;
+    u32 timestamp;
+    if (ok && bundle_parse(bundle, size, &title_id, &timestamp, files, c->count + 1,
+                           &decompressed) != n)
+        ok = false;
+    for (int i = 0; ok && i < n; i++)
+        if (entries[i].codec == BUNDLE_CODEC_STORED && files[i].data != bundle + entries[i].offset)
+            ok = false;
+    free(decompressed);
+    free(files);
+
+    for (int i = 0; ok && i < n; i++) {
+        const BundleEntry *e = &entries[i];
+        u8 *frame = malloc(e->encoded_size ? e->encoded_size : 1);
+        u8 *dest = malloc(e->size ? e->size : 1);
+        memcpy(frame, bundle + e->offset, e->encoded_size);
+        ArchiveFile f;
+        ok = bundle_decode_file(e, frame, dest, &f) && strcmp(f.path, c->files[i].path) == 0 &&
+             f.size == c->files[i].size && memcmp(f.data, c->files[i].data, f.size) == 0;
+        free(frame);
+        free(dest);
+    }
+    free(entries);
+    return ok;
+}
+
+// Run a bundle through the incremental decoder in network-sized pieces.
+// Returns the v1 bundle it produces (malloc'd) or NULL.
+static u8 *stream_decode(const u8 *bundle, u32 size, u32 *out_size) {
+    BundleStream *s = bundle_stream_begin(64 * 1024 * 1024);
+    if (!s) return NULL;
+    for (u32 off = 0; off < size; off += STREAM_PIECE) {
+        u32 len = size - off;
+        if (len > STREAM_PIECE) len = STREAM_PIECE;
+        if (!bundle_stream_feed(s, bundle + off, len)) break;
+    }
+    return bundle_stream_finish(s, out_size);
+}
+
+static void hex_digest(const u8 *data, u32 len, char *hex_out) {
+    u8 hash[32];
+    sha256(data, len, hash);
+    for (int i = 0; i < 32; i++)
+        sprintf(hex_out + i * 2, "%02x", hash[i]);
+}
+
+//---------------------------------------------------------------------------
+// Benchmarks
+//---------------------------------------------------------------------------
+
+typedef struct {
+    const Corpus *corpus;
+    const u8 *bundle; // bundle_create's output, for the decode benchmarks
+    u32 bundle_size;
+} BenchInput;
+
+typedef bool (*BenchFn)(const BenchInput *in);
+
+static bool run_sha256(const BenchInput *in) {
+    u8 hash[32];
+    for (int i = 0; i < in->corpus->count; i++)
+        sha256(in->corpus->files[i].data, in->corpus->files[i].size, hash);
+    return true;
+}
+
+static bool run_save_hash(const BenchInput *in) {
+    char hex[65];
+    bundle_compute_save_hash(in->corpus->files, in->corpus->count, hex);
+    return true;
+}
+
+static bool run_hash_archive(const BenchInput *in) {
+    char hex[65];
+    u32 size;
+    stream_source = in->corpus;
+    return bundle_hash_archive(in->corpus->title_id, MEDIATYPE_SD, hex, &size) ==
+           in->corpus->count;
+}
+
+static bool create_at(const BenchInput *in, BundleLevel level) {
+    u32 size;
+    u8 *bundle = bundle_create(in->corpus->title_id, BENCH_TIMESTAMP,
+                               in->corpus->files, in->corpus->count, level, &size, NULL);
+    free(bundle);
+    return bundle != NULL;
+}
+
+static bool run_create(const BenchInput *in) {
+    return create_at(in, BUNDLE_LEVEL_FAST);
+}
+
+static bool run_create_high(const BenchInput *in) {
+    return create_at(in, BUNDLE_LEVEL_HIGH);
+}
+
+static bool run_create_archive(const BenchInput *in) {
+    u8 *bundle;
+    u32 size;
+    stream_source = in->corpus;
+    int n = bundle_create_archive(in->corpus->title_id, MEDIATYPE_SD, BENCH_TIMESTAMP,
+                                  BUNDLE_LEVEL_FAST, &bundle, &size, NULL);
+    free(bundle);
+    return n == in->corpus->count;
+}
+
+static bool run_parse(const BenchInput *in) {
+    ArchiveFile *files = calloc(in->corpus->count, sizeof(ArchiveFile));
+    u8 *decompressed = NULL;
+    u64 title_id;
+    u32 timestamp;
+    int n = bundle_parse(in->bundle, in->bundle_size, &title_id, &timestamp,
+                         files, in->corpus->count, &decompressed);
+    free(decompressed);
+    free(files);
+    return n == in->corpus->count;
+}
+
+static bool run_stream(const BenchInput *in) {
+    u32 size;
+    u8 *v1 = stream_decode(in->bundle, in->bundle_size, &size);
+    free(v1);
+    return v1 != NULL;
+}
+
+static const struct {
+    const char *name;
+    BenchFn fn;
+} benches[] = {
+    { "sha256",         run_sha256 },
+    { "save_hash",      run_save_hash },
+    { "hash_archive",   run_hash_archive },
+    { "create",         run_create },
+    { "create_high",    run_create_high },
+    { "create_archive", run_create_archive },
+    { "parse",          run_parse },
+    { "stream",         run_stream },
+};
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Time one benchmark. Peak allocation is taken from the first round;
+// throughput is over the save's uncompressed size.
+static void bench_one(const char *name, BenchFn fn, const BenchInput *in) {
+    long long mark = alloc_mark();
+    if (!fn(in)) {
+        fail(in->corpus, name);
+        return;
+    }
+    long long peak = alloc_peak_since(mark);
+
+    int rounds = 0;
+    double start = now_seconds(), elapsed;
+    do {
+        fn(in);
+        rounds++;
+        elapsed = now_seconds() - start;
+    } while (elapsed < BENCH_MIN_SECONDS || rounds < BENCH_MIN_ROUNDS);
+
+    double mbps = (double)in->corpus->total * rounds / elapsed / (1024 * 1024);
+    if (peak >= 0)
+        printf("  %-15s %9.1f MB/s %10lld KB peak\n", name, mbps, (peak + 1023) / 1024);
+    else
+        printf("  %-15s %9.1f MB/s\n", name, mbps);
+}
+
+// Correctness checks on one corpus entry, run before it's timed
+static bool check_corpus(const Corpus *c, const u8 *bundle, u32 size,
+                         const char *create_hash) {
+    bool ok = true;
+    char hex[65];
+
+    bundle_compute_save_hash(c->files, c->count, hex);
+    if (strcmp(hex, create_hash) != 0) {
+        fail(c, "bundle_create save hash differs from bundle_compute_save_hash");
+        ok = false;
+    }
+
+    u32 streamed_size;
+    stream_source = c;
+    if (bundle_hash_archive(c->title_id, MEDIATYPE_SD, hex, &streamed_size) != c->count ||
+        strcmp(hex, create_hash) != 0 || streamed_size != c->total) {
+        fail(c, "bundle_hash_archive differs from bundle_compute_save_hash");
+        ok = false;
+    }
+
+    u8 *archived;
+    u32 archived_size;
+    int n = bundle_create_archive(c->title_id, MEDIATYPE_SD, BENCH_TIMESTAMP,
+                                  BUNDLE_LEVEL_FAST, &archived, &archived_size, hex);
+    if (n != c->count || archived_size != size || memcmp(archived, bundle, size) != 0 ||
+        strcmp(hex, create_hash) != 0) {
+        fail(c, "bundle_create_archive output differs from bundle_create");
+        ok = false;
+    }
+    free(archived);
+
+    if (!bundle_matches(c, bundle, size)) {
+        fail(c, "bundle_parse doesn't round-trip");
+        ok = false;
+    }
+
+    if (!random_access_matches(c, bundle, size)) {
+        fail(c, "bundle_index/bundle_decode_file don't round-trip");
+        ok = false;
+    }
+
+    u32 v1_size;
+    u8 *v1 = stream_decode(bundle, size, &v1_size);
+    if (!v1 || !bundle_matches(c, v1, v1_size)) {
+        fail(c, "bundle_stream doesn't round-trip");
+        ok = false;
+    }
+    free(v1);
+
+    // A flipped byte in the payload must not decode cleanly
+    u8 *bad = malloc(size);
+    memcpy(bad, bundle, size);
+    bad[size / 2] ^= 0x55;
+    v1 = stream_decode(bad, size, &v1_size);
+    if (v1) {
+        fail(c, "bundle_stream accepted a corrupted bundle");
+        ok = false;
+    }
+    free(v1);
+
+    // A table declaring files larger than the header's size field must be
+    // rejected before any of them is decoded past the buffer sized from it
+    u32 table_size = 0;
+    for (int i = 0; i < c->count; i++)
+        table_size += 2 + (u32)strlen(c->files[i].path) + 4 + 32;
+    memcpy(bad, bundle, size);
+    bad[24] = table_size & 0xFF;
+    bad[25] = (table_size >> 8) & 0xFF;
+    bad[26] = (table_size >> 16) & 0xFF;
+    bad[27] = (table_size >> 24) & 0xFF;
+    v1 = stream_decode(bad, size, &v1_size);
+    if (v1 && c->total != 0) {
+        fail(c, "bundle_stream accepted files larger than the header's size");
+        ok = false;
+    }
+    free(v1);
+    free(bad);
+    return ok;
+}
+
+static int run_benchmarks(void) {
+    printf("bundle benchmarks (allocation tracking %s)\n\n",
+           ALLOC_TRACKING ? "on" : "unavailable");
+
+    for (int i = 0; i < CORPUS_COUNT; i++) {
+        const Corpus *c = &corpus[i];
+        char hash[65];
+        u32 size;
+        u32 high_size;
+        u8 *bundle = bundle_create(c->title_id, BENCH_TIMESTAMP, c->files, c->count,
+                                   BUNDLE_LEVEL_FAST, &size, hash);
+        u8 *high = bundle_create(c->title_id, BENCH_TIMESTAMP, c->files, c->count,
+                                 BUNDLE_LEVEL_HIGH, &high_size, NULL);
+        if (!bundle || !high) {
+            fail(c, "bundle_create");
+            free(bundle);
+            free(high);
+            continue;
+        }
+        free(high);
+
+        printf("%s: %s, %d files, %u bytes -> %u bytes (ratio %.3f, high %.3f)\n",
+               c->name, c->desc, c->count, (unsigned)c->total, (unsigned)size,
+               (double)size / c->total, (double)high_size / c->total);
+
+        if (check_corpus(c, bundle, size, hash)) {
+            BenchInput in = { c, bundle, size };
+            for (size_t b = 0; b < sizeof(benches) / sizeof(benches[0]); b++)
+                bench_one(benches[b].name, benches[b].fn, &in);
+        }
+        printf("\n");
+        free(bundle);
+    }
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+// Cross-check with the Python implementation
+//---------------------------------------------------------------------------
+
+static bool make_dirs(const char *path) {
+    char buf[512];
+    snprintf(buf, sizeof(buf), "%s", path);
+    for (char *p = buf + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(buf, 0755) != 0 && errno != EEXIST) return false;
+        *p = '/';
+    }
+    return mkdir(buf, 0755) == 0 || errno == EEXIST;
+}
+
+static bool write_file(const char *path, const u8 *data, u32 len) {
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    bool ok = fwrite(data, 1, len, f) == len;
+    return fclose(f) == 0 && ok;
+}
+
+static u8 *read_file(const char *path, u32 *len_out) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    u8 *data = malloc(len > 0 ? len : 1);
+    if (fread(data, 1, len, f) != (size_t)len) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+    *len_out = (u32)len;
+    return data;
+}
+
+// Layout per corpus entry, under DIR/<name>/:
+//   manifest.txt   "<title id hex> <timestamp> <save hash>", then one
+//                  path per line in bundle order
+//   files/<path>   the file contents
+//   c.bundle       bundle_create's output at BUNDLE_LEVEL_FAST
+//   c_high.bundle  the same at BUNDLE_LEVEL_HIGH
+//   c_v1.bundle    the uncompressed bundle bundle_stream_finish produces
+static int export_corpus(const char *dir) {
+    for (int i = 0; i < CORPUS_COUNT; i++) {
+        const Corpus *c = &corpus[i];
+        char path[512];
+
+        for (int f = 0; f < c->count; f++) {
+            snprintf(path, sizeof(path), "%s/%s/files/%s", dir, c->name, c->files[f].path);
+            *strrchr(path, '/') = '\0';
+            if (!make_dirs(path)) {
+                fprintf(stderr, "can't create %s\n", path);
+                return 1;
+            }
+            snprintf(path, sizeof(path), "%s/%s/files/%s", dir, c->name, c->files[f].path);
+            if (!write_file(path, c->files[f].data, c->files[f].size)) {
+                fprintf(stderr, "can't write %s\n", path);
+                return 1;
+            }
+        }
+
+        char hash[65];
+        u32 size, high_size, v1_size;
+        u8 *bundle = bundle_create(c->title_id, BENCH_TIMESTAMP, c->files, c->count,
+                                   BUNDLE_LEVEL_FAST, &size, hash);
+        u8 *high = bundle_create(c->title_id, BENCH_TIMESTAMP, c->files, c->count,
+                                 BUNDLE_LEVEL_HIGH, &high_size, NULL);
+        u8 *v1 = bundle ? stream_decode(bundle, size, &v1_size) : NULL;
+        if (!v1 || !high) {
+            fail(c, "bundle_create");
+            free(bundle);
+            free(high);
+            free(v1);
+            return 1;
+        }
+
+        snprintf(path, sizeof(path), "%s/%s/c.bundle", dir, c->name);
+        bool ok = write_file(path, bundle, size);
+        snprintf(path, sizeof(path), "%s/%s/c_high.bundle", dir, c->name);
+        ok = ok && write_file(path, high, high_size);
+        snprintf(path, sizeof(path), "%s/%s/c_v1.bundle", dir, c->name);
+        ok = ok && write_file(path, v1, v1_size);
+        free(bundle);
+        free(high);
+        free(v1);
+
+        snprintf(path, sizeof(path), "%s/%s/manifest.txt", dir, c->name);
+        FILE *m = fopen(path, "w");
+        if (m) {
+            fprintf(m, "%016llX %u %s\n", (unsigned long long)c->title_id,
+                    BENCH_TIMESTAMP, hash);
+            for (int f = 0; f < c->count; f++)
+                fprintf(m, "%s\n", c->files[f].path);
+            ok = fclose(m) == 0 && ok;
+        }
+        if (!m || !ok) {
+            fprintf(stderr, "can't write %s/%s\n", dir, c->name);
+            return 1;
+        }
+    }
+    printf("exported %d corpus entries to %s\n", CORPUS_COUNT, dir);
+    return 0;
+}
+
+// Decode every py*.bundle crosscheck.py left next to a corpus entry
+static int verify_python_bundles(const char *dir) {
+    static const char *const names[] = {
+        "py_v1.bundle", "py_v2.bundle", "py_v3.bundle", "py_high.bundle", "py_ds.bundle",
+    };
+    int checked = 0;
+
+    for (int i = 0; i < CORPUS_COUNT; i++) {
+        const Corpus *c = &corpus[i];
+        for (size_t n = 0; n < sizeof(names) / sizeof(names[0]); n++) {
+            char path[512];
+            u32 size;
+            snprintf(path, sizeof(path), "%s/%s/%s", dir, c->name, names[n]);
+            u8 *bundle = read_file(path, &size);
+            if (!bundle) continue;
+
+            char what[64];
+            snprintf(what, sizeof(what), "%s: bundle_parse", names[n]);
+            if (!bundle_matches(c, bundle, size)) fail(c, what);
+
+            u32 v1_size;
+            u8 *v1 = stream_decode(bundle, size, &v1_size);
+            snprintf(what, sizeof(what), "%s: bundle_stream", names[n]);
+            if (!v1 || !bundle_matches(c, v1, v1_size)) fail(c, what);
+            free(v1);
+
+            char hex[65];
+            hex_digest(bundle, size, hex);
+            printf("%-10s %-14s ok  sha256 %.16s...\n", c->name, names[n], hex);
+            free(bundle);
+            checked++;
+        }
+    }
+
+    if (!checked) {
+        fprintf(stderr, "no Python bundles found in %s (run crosscheck.py first)\n", dir);
+        return 1;
+    }
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+    corpus_build();
+
+    int ret;
+    if (argc == 3 && strcmp(argv[1], "--export") == 0) {
+        ret = export_corpus(argv[2]);
+    } else if (argc == 3 && strcmp(argv[1], "--verify") == 0) {
+        ret = verify_python_bundles(argv[2]);
+    } else if (argc == 1) {
+        ret = run_benchmarks();
+    } else {
+        fprintf(stderr, "usage: %s [--export DIR | --verify DIR]\n", argv[0]);
+        ret = 2;
+    }
+
+    corpus_free();
+    return ret;
+}
@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+"""Cross-check the client's bundle.c against the Python bundle code.
+
+Reads a corpus written by `bench --export DIR` and checks that:
+  - the server's create_codec_bundle (v3, fast and high level) and, for
+    single save.dat saves, tools/ds_sync.py's create_bundle produce the
+    same bytes as bundle.c, so all three make the same codec choices
+  - the server's create_bundle(compress=False) matches the v1 bundle the
+    C stream decoder rebuilds
+  - the server's BundleParser and ds_sync's parse_bundle decode the C
+    bundles back to the corpus files, with the same save hash
+
+It then writes the Python-made bundles into DIR (py_v1, py_v2, py_v3,
+py_high and py_ds .bundle) for `bench --verify DIR` to decode with the C
+code; py_v2 is what the server still serves to older clients.
+
+Needs the server's dependencies (run it from the server environment, e.g.
+`make check PYTHON="uv run --project ../../server python"`).
+
+Usage: crosscheck.py DIR
+"""
+
+import hashlib
+import sys
+import zlib
+from pathlib import Path
+from unittest import mock
+
+ROOT = Path(__file__).resolve().parents[2]
+sys.path.insert(0, str(ROOT / "server"))
+sys.path.insert(0, str(ROOT / "tools"))
+
+import ds_sync  # noqa: E402
+from app.models.save import BundleFile, SaveBundle  # noqa: E402
+from app.services.bundle import (  # noqa: E402
+    LEVEL_HIGH,
+    BundleError,
+    BundleParser,
+    create_bundle,
+    create_codec_bundle,
+)
+
+
+def load_corpus(entry: Path) -> tuple[SaveBundle, str]:
+    lines = (entry / "manifest.txt").read_text().splitlines()
+    title_id, timestamp, save_hash = lines[0].split()
+    files = []
+    for path in lines[1:]:
+        data = (entry / "files" / path).read_bytes()
+        files.append(BundleFile(path, len(data), hashlib.sha256(data).digest(), data))
+    return SaveBundle(int(title_id, 16), int(timestamp), files), save_hash
+
+
+def same_files(a: list[BundleFile], b: list[BundleFile]) -> bool:
+    return [(f.path, f.size, f.sha256, bytes(f.data)) for f in a] == [
+        (f.path, f.size, f.sha256, bytes(f.data)) for f in b
+    ]
+
+
+def check_entry(entry: Path) -> list[str]:
+    errors: list[str] = []
+    save, save_hash = load_corpus(entry)
+    c_v3 = (entry / "c.bundle").read_bytes()
+    c_high = (entry / "c_high.bundle").read_bytes()
+    c_v1 = (entry / "c_v1.bundle").read_bytes()
+    c_bundles = (("c.bundle", c_v3), ("c_high.bundle", c_high), ("c_v1.bundle", c_v1))
+
+    py_v3 = create_codec_bundle(save)
+    py_high = create_codec_bundle(save, level=LEVEL_HIGH)
+    py_v2 = create_bundle(save, compress=True)
+    py_v1 = create_bundle(save, compress=False)
+    if py_v3 != c_v3:
+        errors.append(f"server v3 bundle differs ({len(py_v3)} vs {len(c_v3)} bytes)")
+    if py_high != c_high:
+        errors.append(f"server v3 high bundle differs ({len(py_high)} vs {len(c_high)} bytes)")
+    if py_v1 != c_v1:
+        errors.append(f"server v1 bundle differs ({len(py_v1)} vs {len(c_v1)} bytes)")
+
+    for name, data in c_bundles:
+        parser = BundleParser()
+        try:
+            parser.feed(data)
+            parsed = parser.close()
+        except BundleError as e:
+            errors.append(f"server parser: {name}: {e}")
+            continue
+        if (parsed.title_id, parsed.timestamp) != (save.title_id, save.timestamp):
+            errors.append(f"server parser: {name} header mismatch")
+        if not same_files(parsed.files, save.files):
+            errors.append(f"server parser: {name} files differ")
+        if parser.save_hash != save_hash:
+            errors.append(f"server parser: {name} save hash differs")
+
+    (entry / "py_v1.bundle").write_bytes(py_v1)
+    (entry / "py_v2.bundle").write_bytes(py_v2)
+    (entry / "py_v3.bundle").write_bytes(py_v3)
+    (entry / "py_high.bundle").write_bytes(py_high)
+
+    # ds_sync.py only deals in single-file "save.dat" bundles
+    if [f.path for f in save.files] == ["save.dat"]:
+        sav = save.files[0].data
+        with mock.patch.object(ds_sync.time, "time", return_value=save.timestamp):
+            py_ds = ds_sync.create_bundle(save.title_id, sav)
+        if py_ds != c_v3:
+            errors.append(f"ds_sync bundle differs ({len(py_ds)} vs {len(c_v3)} bytes)")
+        for name, data in c_bundles:
+            try:
+                if ds_sync.parse_bundle(data) != sav:
+                    errors.append(f"ds_sync parser: {name} data differs")
+            except (ValueError, zlib.error) as e:
+                errors.append(f"ds_sync parser: {name}: {e}")
+        (entry / "py_ds.bundle").write_bytes(py_ds)
+
+    return errors
+
+
+def main() -> int:
+    if len(sys.argv) != 2:
+        print(__doc__.strip().splitlines()[-1], file=sys.stderr)
+        return 2
+
+    entries = sorted(p.parent for p in Path(sys.argv[1]).glob("*/manifest.txt"))
+    if not entries:
+        print(f"no corpus in {sys.argv[1]} (run bench --export first)", file=sys.stderr)
+        return 1
+
+    failed = 0
+    for entry in entries:
+        errors = check_entry(entry)
+        print(f"{entry.name:<10} {'ok' if not errors else 'FAIL'}")
+        for error in errors:
+            print(f"  {error}")
+        failed += bool(errors)
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,28 @@
+// Minimal stand-in for libctru's <3ds.h>, enough to build bundle.c and
+// sha256.c on the host. Types match libctru's on the 3DS (u32 is 32-bit).
+
+#ifndef BENCH_STUB_3DS_H
+#define BENCH_STUB_3DS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+
+typedef s32 Result;
+
+typedef enum {
+    MEDIATYPE_NAND = 0,
+    MEDIATYPE_SD = 1,
+    MEDIATYPE_GAME_CARD = 2,
+} FS_MediaType;
+
+#endif // BENCH_STUB_3DS_H
@@ -17,6 +17,10 @@ typedef enum {
     SAVE_TYPE_FRAM_32K,      // 32KB, 16-bit address, instant writes
 } CardSaveType;
 
+// Progress of a whole-save read or write: done of total bytes so far.
+// Called from whichever thread runs the transfer.
+typedef void (*CardSpiProgressCb)(void *ctx, u32 done, u32 total);
+
 // Initialize the PXIDEV service for SPI access
 bool card_spi_init(void);
 void card_spi_exit(void);
@@ -27,11 +31,21 @@ CardSaveType card_spi_detect(void);
 // Get save size in bytes for a given type
 u32 card_spi_get_size(CardSaveType type);
 
-// Read entire save from NDS cartridge into buffer
-// buf must be at least card_spi_get_size(type) bytes
-bool card_spi_read_save(CardSaveType type, u8 *buf, u32 size);
+// Read entire save from NDS cartridge into buffer, in reads of up to 64KB
+// (continuous across pages). buf must be at least card_spi_get_size(type)
+// bytes. progress (optional) is called after each read.
+bool card_spi_read_save(CardSaveType type, u8 *buf, u32 size,
+                        CardSpiProgressCb progress, void *ctx);
 
 // Write entire save to NDS cartridge from buffer
-bool card_spi_write_save(CardSaveType type, const u8 *buf, u32 size);
+bool card_spi_write_save(CardSaveType type, const u8 *buf, u32 size,
+                         CardSpiProgressCb progress, void *ctx);
+
+// Write a save, touching only the parts that differ from the chip's current
+// contents: flash sectors are erased/programmed only where they changed,
+// EEPROM/FRAM pages only if they differ. Rewritten regions are read back
+// and verified. Sets *bytes_written (optional) to the bytes programmed.
+bool card_spi_write_save_diff(CardSaveType type, const u8 *buf, u32 size,
+                              u32 *bytes_written, CardSpiProgressCb progress, void *ctx);
 
 #endif // CARD_SPI_H
@@ -9,7 +9,6 @@
 // APP_VERSION is defined by the Makefile from the root VERSION file
 
 // Max values
-#define MAX_TITLES        256
 #define MAX_PATH_LEN      256
 #define MAX_URL_LEN       256
 #define MAX_API_KEY_LEN   128
@@ -17,6 +16,8 @@
 // Config file location on SD card
 #define CONFIG_PATH "sdmc:/3ds/3dssync/config.txt"
 #define BACKUP_DIR  "sdmc:/3ds/3dssync/backups"
+#define STATE_DIR   "sdmc:/3ds/3dssync/state"
+#define TIMING_LOG_PATH "sdmc:/3ds/3dssync/sync_timing.csv"
 
 // Title info for display and sync
 typedef struct {
@@ -24,12 +25,12 @@ typedef struct {
     FS_MediaType media_type;
     char title_id_hex[17]; // 16 hex chars + null
     char product_code[16]; // Product code from AM (e.g., CTR-P-BRBE) or NDS game code
-    char name[64];         // Game name (from server lookup or product code)
+    const char *name;      // Game name (from server lookup or product code), pooled
     bool has_save_data;
     bool in_conflict;      // Set after sync if this title has a conflict
     bool is_nds;           // NDS game (via nds-bootstrap on SD) vs 3DS title
     bool marked;           // User-selected for batch operations
-    char sav_path[MAX_PATH_LEN]; // NDS only: path to .sav file on SD card
+    const char *sav_path;  // NDS only: path to .sav file on SD card, pooled ("" = none)
 } TitleInfo;
 
 // Console ID file location
@@ -41,6 +42,10 @@ typedef struct {
     char api_key[MAX_API_KEY_LEN];
     char console_id[17];  // 16 hex chars + null (generated on first run)
     char nds_dir[MAX_PATH_LEN]; // NDS ROM directory on SD (e.g., "sdmc:/roms/nds")
+    int transfer_window;  // Titles transferred at once during sync (1 = one at a time)
+    bool timing_log;      // Append per-title sync timings to TIMING_LOG_PATH
+    bool high_compression; // Deflate uploads at zlib level 9 (slow links) instead of 1
+    bool keep_update_cia; // Also write downloaded updates to UPDATE_CIA_PATH
 } AppConfig;
 
 #endif // COMMON_H
@@ -1,6 +1,8 @@
 #include "archive.h"
+#include "hashcache.h"
 
-#define MAX_ARCHIVE_FILES 64
+#define ARCHIVE_MAX_DEPTH 16  // Directory levels below the archive root
+#define DIR_BATCH 32          // Directory entries read per FSDIR_Read
 
 static Result open_save_archive(FS_Archive *archive, u64 title_id, FS_MediaType media_type) {
     u32 path_data[3] = {media_type, (u32)(title_id & 0xFFFFFFFF), (u32)(title_id >> 32)};
@@ -8,96 +10,332 @@ static Result open_save_archive(FS_Archive *archive, u64 title_id, FS_MediaType
         (FS_Path){PATH_BINARY, sizeof(path_data), path_data});
 }
 
-// Recursively read files from a directory in the archive
-static int read_dir(FS_Archive archive, const char *dir_path,
-                    ArchiveFile *files, int offset, int max_files) {
+// State of one walk over a save archive. Each directory level gets one
+// entry batch, allocated on first use and reused for every directory at
+// that depth; file data goes through a single chunk buffer.
+typedef struct {
+    FS_Archive archive;
+    const ArchiveSink *sink;
+    FS_DirectoryEntry *levels[ARCHIVE_MAX_DEPTH];
+    u8 *chunk;    // NULL: only list files (sizes from the directory entries)
+    int count;
+    bool ok;
+} ArchiveWalk;
+
+// Pass one file to the sink, reading its data in chunks
+static void walk_file(ArchiveWalk *w, const char *full_path, u64 listed_size) {
+    const ArchiveSink *sink = w->sink;
+
+    if (!w->chunk) {
+        // Listing only
+        if (!sink->begin_file(sink->ctx, full_path + 1, (u32)listed_size) ||
+            (sink->end_file && !sink->end_file(sink->ctx))) {
+            w->ok = false;
+            return;
+        }
+        w->count++;
+        return;
+    }
+
+    Handle file_handle;
+    Result res = FSUSER_OpenFile(&file_handle, w->archive,
+        fsMakePath(PATH_ASCII, full_path), FS_OPEN_READ, 0);
+    if (R_FAILED(res)) return;  // Unreadable files are skipped, as before
+
+    u64 file_size = 0;
+    FSFILE_GetSize(file_handle, &file_size);
+
+    // Store path without leading slash for bundle format
+    if (!sink->begin_file(sink->ctx, full_path + 1, (u32)file_size)) {
+        FSFILE_Close(file_handle);
+        w->ok = false;
+        return;
+    }
+
+    u64 offset = 0;
+    while (offset < file_size) {
+        u32 want = (file_size - offset > ARCHIVE_CHUNK_SIZE)
+            ? ARCHIVE_CHUNK_SIZE : (u32)(file_size - offset);
+        u32 bytes_read = 0;
+        res = FSFILE_Read(file_handle, &bytes_read, offset, w->chunk, want);
+        if (R_FAILED(res) || bytes_read == 0 ||
+            !sink->write(sink->ctx, w->chunk, bytes_read)) {
+            w->ok = false;
+            break;
+        }
+        offset += bytes_read;
+    }
+    FSFILE_Close(file_handle);
+
+    if (w->ok && sink->end_file && !sink->end_file(sink->ctx)) w->ok = false;
+    if (w->ok) w->count++;
+}
+
+// Recursively walk a directory in the archive
+static void walk_dir(ArchiveWalk *w, const char *dir_path, int depth) {
+    if (depth >= ARCHIVE_MAX_DEPTH) { w->ok = false; return; }
+
+    if (!w->levels[depth]) {
+        w->levels[depth] = (FS_DirectoryEntry *)malloc(DIR_BATCH * sizeof(FS_DirectoryEntry));
+        if (!w->levels[depth]) { w->ok = false; return; }
+    }
+    FS_DirectoryEntry *entries = w->levels[depth];
+
     Handle dir_handle;
-    int added = 0;
+    Result res = FSUSER_OpenDirectory(&dir_handle, w->archive,
+        fsMakePath(PATH_ASCII, dir_path));
+    if (R_FAILED(res)) return;
+
+    u32 entries_read = 0;
+    while (w->ok) {
+        res = FSDIR_Read(dir_handle, &entries_read, DIR_BATCH, entries);
+        if (R_FAILED(res) || entries_read == 0) break;
+
+        for (u32 i = 0; i < entries_read && w->ok; i++) {
+            // Convert UTF-16 name to ASCII
+            char name[256];
+            int j;
+            for (j = 0; j < 255 && entries[i].name[j]; j++)
+                name[j] = (char)entries[i].name[j];
+            name[j] = '\0';
+
+            // Build full path
+            char full_path[MAX_PATH_LEN];
+            if (strcmp(dir_path, "/") == 0)
+                snprintf(full_path, sizeof(full_path), "/%s", name);
+            else
+                snprintf(full_path, sizeof(full_path), "%s/%s", dir_path, name);
+
+            if (entries[i].attributes & FS_ATTRIBUTE_DIRECTORY)
+                walk_dir(w, full_path, depth + 1);
+            else
+                walk_file(w, full_path, entries[i].fileSize);
+        }
+    }
+
+    FSDIR_Close(dir_handle);
+}
+
+// Walk an open archive. Returns number of files, or -1 on error.
+static int walk_archive(FS_Archive archive, const ArchiveSink *sink, bool with_data) {
+    ArchiveWalk w;
+    memset(&w, 0, sizeof(w));
+    w.archive = archive;
+    w.sink = sink;
+    w.ok = true;
+
+    if (with_data) {
+        w.chunk = (u8 *)malloc(ARCHIVE_CHUNK_SIZE);
+        if (!w.chunk) return -1;
+    }
+
+    walk_dir(&w, "/", 0);
+
+    for (int i = 0; i < ARCHIVE_MAX_DEPTH; i++) free(w.levels[i]);
+    free(w.chunk);
+    return w.ok ? w.count : -1;
+}
+
+int archive_stream(u64 title_id, FS_MediaType media_type, const ArchiveSink *sink) {
+    FS_Archive archive;
+    Result res = open_save_archive(&archive, title_id, media_type);
+    if (R_FAILED(res)) return -1;
+
+    int count = walk_archive(archive, sink, true);
+
+    FSUSER_CloseArchive(archive);
+    return count;
+}
+
+// archive_read collects in two walks: the first lists paths and sizes into
+// a growing table, the second fills one buffer sized for all the data
+typedef struct {
+    ArchiveFile *files;
+    int count;
+    int capacity;
+    u64 total_size;
+    u8 *pool;
+    u32 pool_offset;
+    int index;     // Second walk: file being filled
+    u32 filled;
+} ReadCollector;
+
+static bool list_begin(void *ctx, const char *path, u32 size) {
+    ReadCollector *c = (ReadCollector *)ctx;
+    if (c->count == c->capacity) {
+        int capacity = c->capacity ? c->capacity * 2 : 16;
+        ArchiveFile *grown = (ArchiveFile *)realloc(c->files, capacity * sizeof(ArchiveFile));
+        if (!grown) return false;
+        c->files = grown;
+        c->capacity = capacity;
+    }
+
+    ArchiveFile *af = &c->files[c->count++];
+    strncpy(af->path, path, MAX_PATH_LEN - 1);
+    af->path[MAX_PATH_LEN - 1] = '\0';
+    af->size = size;
+    af->data = NULL;
+    af->pooled = true;
+    c->total_size += size;
+    return c->total_size <= 0xFFFFFFFFu;
+}
+
+static bool fill_begin(void *ctx, const char *path, u32 size) {
+    ReadCollector *c = (ReadCollector *)ctx;
+    // Listed files that couldn't be opened are skipped (their data stays
+    // NULL); otherwise the archive must still match the listing
+    while (c->index < c->count && strncmp(c->files[c->index].path, path, MAX_PATH_LEN - 1) != 0)
+        c->index++;
+    if (c->index >= c->count) return false;
+    ArchiveFile *af = &c->files[c->index];
+    if (af->size != size) return false;
+
+    af->data = c->pool + c->pool_offset;
+    c->filled = 0;
+    return true;
+}
+
+static bool fill_write(void *ctx, const u8 *data, u32 len) {
+    ReadCollector *c = (ReadCollector *)ctx;
+    ArchiveFile *af = &c->files[c->index];
+    if (len > af->size - c->filled) return false;
+    memcpy(af->data + c->filled, data, len);
+    c->filled += len;
+    return true;
+}
+
+static bool fill_end(void *ctx) {
+    ReadCollector *c = (ReadCollector *)ctx;
+    ArchiveFile *af = &c->files[c->index];
+    if (c->filled != af->size) return false;
+    c->pool_offset += af->size;
+    c->index++;
+    return true;
+}
+
+int archive_read(u64 title_id, FS_MediaType media_type, ArchiveFile **files_out) {
+    *files_out = NULL;
+
+    FS_Archive archive;
+    Result res = open_save_archive(&archive, title_id, media_type);
+    if (R_FAILED(res)) return -1;
+
+    ReadCollector c;
+    memset(&c, 0, sizeof(c));
+
+    ArchiveSink list_sink = { list_begin, NULL, NULL, &c };
+    int listed = walk_archive(archive, &list_sink, false);
+
+    ArchiveSink fill_sink = { fill_begin, fill_write, fill_end, &c };
+    int count = -1;
+    if (listed >= 0) {
+        c.pool = (u8 *)malloc(c.total_size ? (size_t)c.total_size : 1);
+        if (c.pool) count = walk_archive(archive, &fill_sink, true);
+    }
+
+    FSUSER_CloseArchive(archive);
+
+    // Drop the skipped files
+    if (count >= 0) {
+        int kept = 0;
+        for (int i = 0; i < c.count; i++) {
+            if (c.files[i].data) c.files[kept++] = c.files[i];
+        }
+        if (kept != count) count = -1;
+    }
+
+    if (count <= 0) {
+        free(c.pool);
+        free(c.files);
+        if (count == 0) *files_out = (ArchiveFile *)malloc(sizeof(ArchiveFile));
+        return (count == 0 && *files_out) ? 0 : -1;
+    }
+
+    // The first file owns the shared buffer
+    c.files[0].data = c.pool;
+    c.files[0].pooled = false;
+    *files_out = c.files;
+    return count;
+}
 
+// Fold every file's path, size and last-modified timestamp under a
+// directory into sig. Clears *ok if FS can't report a timestamp.
+static void signature_dir(FS_Archive archive, const char *dir_path,
+                          u64 *sig, bool *ok) {
+    Handle dir_handle;
     Result res = FSUSER_OpenDirectory(&dir_handle, archive,
         fsMakePath(PATH_ASCII, dir_path));
-    if (R_FAILED(res)) return 0;
+    if (R_FAILED(res)) { *ok = false; return; }
 
     FS_DirectoryEntry *entries = (FS_DirectoryEntry *)malloc(32 * sizeof(FS_DirectoryEntry));
     if (!entries) {
         FSDIR_Close(dir_handle);
-        return 0;
+        *ok = false;
+        return;
     }
     u32 entries_read = 0;
 
-    while (true) {
+    while (*ok) {
         res = FSDIR_Read(dir_handle, &entries_read, 32, entries);
         if (R_FAILED(res) || entries_read == 0) break;
 
-        for (u32 i = 0; i < entries_read && (offset + added) < max_files; i++) {
-            // Convert UTF-16 name to ASCII
+        for (u32 i = 0; i < entries_read && *ok; i++) {
             char name[256];
             int j;
             for (j = 0; j < 255 && entries[i].name[j]; j++)
                 name[j] = (char)entries[i].name[j];
             name[j] = '\0';
 
-            // Build full path
             char full_path[MAX_PATH_LEN];
             if (strcmp(dir_path, "/") == 0)
                 snprintf(full_path, sizeof(full_path), "/%s", name);
             else
                 snprintf(full_path, sizeof(full_path), "%s/%s", dir_path, name);
 
+            *sig = hashcache_mix(*sig, full_path, strlen(full_path) + 1);
+
             if (entries[i].attributes & FS_ATTRIBUTE_DIRECTORY) {
-                // Recurse into subdirectory
-                added += read_dir(archive, full_path, files, offset + added, max_files);
-            } else {
-                // Read file
-                Handle file_handle;
-                res = FSUSER_OpenFile(&file_handle, archive,
-                    fsMakePath(PATH_ASCII, full_path), FS_OPEN_READ, 0);
-                if (R_FAILED(res)) continue;
-
-                u64 file_size;
-                FSFILE_GetSize(file_handle, &file_size);
-
-                u8 *buf = (u8 *)malloc((size_t)file_size);
-                if (!buf) {
-                    FSFILE_Close(file_handle);
-                    continue;
-                }
-
-                u32 bytes_read;
-                res = FSFILE_Read(file_handle, &bytes_read, 0, buf, (u32)file_size);
-                FSFILE_Close(file_handle);
-
-                if (R_FAILED(res)) {
-                    free(buf);
-                    continue;
-                }
-
-                ArchiveFile *af = &files[offset + added];
-                // Store path without leading slash for bundle format
-                strncpy(af->path, full_path + 1, MAX_PATH_LEN - 1);
-                af->path[MAX_PATH_LEN - 1] = '\0';
-                af->size = bytes_read;
-                af->data = buf;
-                added++;
+                signature_dir(archive, full_path, sig, ok);
+                continue;
             }
+
+            // Timestamp lookup takes a UTF-16 path
+            u16 path_utf16[MAX_PATH_LEN];
+            int k;
+            for (k = 0; k < MAX_PATH_LEN - 1 && full_path[k]; k++)
+                path_utf16[k] = (u16)(u8)full_path[k];
+            path_utf16[k] = 0;
+
+            u64 timestamp = 0;
+            res = FSUSER_ControlArchive(archive, ARCHIVE_ACTION_GET_TIMESTAMP,
+                path_utf16, (k + 1) * sizeof(u16), &timestamp, sizeof(timestamp));
+            if (R_FAILED(res) || timestamp == 0) {
+                *ok = false;
+                break;
+            }
+
+            u64 size = entries[i].fileSize;
+            *sig = hashcache_mix(*sig, &size, sizeof(size));
+            *sig = hashcache_mix(*sig, &timestamp, sizeof(timestamp));
         }
     }
 
     free(entries);
     FSDIR_Close(dir_handle);
-    return added;
 }
 
-int archive_read(u64 title_id, FS_MediaType media_type,
-                 ArchiveFile *files, int max_files) {
+bool archive_signature(u64 title_id, FS_MediaType media_type, u64 *sig_out) {
     FS_Archive archive;
     Result res = open_save_archive(&archive, title_id, media_type);
-    if (R_FAILED(res)) return -1;
+    if (R_FAILED(res)) return false;
 
-    int count = read_dir(archive, "/", files, 0, max_files);
+    u64 sig = HASHCACHE_SIG_INIT;
+    bool ok = true;
+    signature_dir(archive, "/", &sig, &ok);
 
     FSUSER_CloseArchive(archive);
-    return count;
+    if (ok) *sig_out = sig;
+    return ok;
 }
 
 // Delete all files/dirs in a directory recursively
@@ -159,54 +397,153 @@ static void ensure_parent_dirs(FS_Archive archive, const char *path) {
     }
 }
 
-bool archive_write(u64 title_id, FS_MediaType media_type,
-                   const ArchiveFile *files, int file_count) {
-    FS_Archive archive;
-    Result res = open_save_archive(&archive, title_id, media_type);
+// Write one file, replacing whatever is at its path. Not flushed: the
+// save commit at the end writes everything out at once.
+static bool write_file(FS_Archive archive, const ArchiveFile *file, bool recreate) {
+    char full_path[MAX_PATH_LEN];
+    snprintf(full_path, sizeof(full_path), "/%s", file->path);
+
+    if (recreate) {
+        FSUSER_DeleteFile(archive, fsMakePath(PATH_ASCII, full_path));
+        ensure_parent_dirs(archive, full_path);
+        FSUSER_CreateFile(archive, fsMakePath(PATH_ASCII, full_path), 0, file->size);
+    }
+
+    Handle file_handle;
+    Result res = FSUSER_OpenFile(&file_handle, archive,
+        fsMakePath(PATH_ASCII, full_path), FS_OPEN_WRITE, 0);
     if (R_FAILED(res)) return false;
 
-    // Clear existing save data
-    clear_dir(archive, "/");
+    u32 bytes_written = 0;
+    res = FSFILE_Write(file_handle, &bytes_written, 0, file->data, file->size, 0);
+    FSFILE_Close(file_handle);
+    return R_SUCCEEDED(res) && bytes_written == file->size;
+}
 
-    // Write each file
-    for (int i = 0; i < file_count; i++) {
-        char full_path[MAX_PATH_LEN];
-        snprintf(full_path, sizeof(full_path), "/%s", files[i].path);
+// Compares the files already in an archive against the ones being written
+typedef struct {
+    const ArchiveFile *files;
+    int file_count;
+    u8 *state;        // Per incoming file: DIFF_* below
+    int current;      // Incoming file matching the one being read, or -1
+    int next;         // Where to start looking for the next match
+    u32 offset;
+    char (*stale)[MAX_PATH_LEN]; // Existing files not being written
+    int stale_count;
+    int stale_capacity;
+} ArchiveDiff;
+
+#define DIFF_NEW       0  // Not in the archive yet (or a different size)
+#define DIFF_SAME_SIZE 1  // Same path and size, contents differ
+#define DIFF_UNCHANGED 2  // Identical, nothing to write
+
+static bool diff_begin(void *ctx, const char *path, u32 size) {
+    ArchiveDiff *d = (ArchiveDiff *)ctx;
+    d->current = -1;
+    d->offset = 0;
+
+    // Both sides usually list files in the same order, so start looking
+    // just past the last match
+    for (int n = 0; n < d->file_count; n++) {
+        int i = (d->next + n) % d->file_count;
+        if (strcmp(d->files[i].path, path) == 0) {
+            d->next = i + 1;
+            if (d->files[i].size == size) {
+                d->current = i;
+                d->state[i] = DIFF_UNCHANGED;
+            }
+            return true;
+        }
+    }
 
-        ensure_parent_dirs(archive, full_path);
+    if (d->stale_count == d->stale_capacity) {
+        int capacity = d->stale_capacity ? d->stale_capacity * 2 : 16;
+        char (*grown)[MAX_PATH_LEN] = realloc(d->stale, capacity * MAX_PATH_LEN);
+        if (!grown) return false;
+        d->stale = grown;
+        d->stale_capacity = capacity;
+    }
+    snprintf(d->stale[d->stale_count++], MAX_PATH_LEN, "/%s", path);
+    return true;
+}
 
-        // Create and write file
-        FSUSER_CreateFile(archive, fsMakePath(PATH_ASCII, full_path), 0, files[i].size);
+static bool diff_write(void *ctx, const u8 *data, u32 len) {
+    ArchiveDiff *d = (ArchiveDiff *)ctx;
+    if (d->current < 0) return true;
+    if (d->state[d->current] == DIFF_UNCHANGED &&
+        memcmp(d->files[d->current].data + d->offset, data, len) != 0)
+        d->state[d->current] = DIFF_SAME_SIZE;
+    d->offset += len;
+    return true;
+}
 
-        Handle file_handle;
-        res = FSUSER_OpenFile(&file_handle, archive,
-            fsMakePath(PATH_ASCII, full_path), FS_OPEN_WRITE, 0);
-        if (R_FAILED(res)) {
-            FSUSER_CloseArchive(archive);
-            return false;
-        }
+// Delete a stale file, then any parent directories it leaves empty
+static void delete_stale(FS_Archive archive, const char *path) {
+    FSUSER_DeleteFile(archive, fsMakePath(PATH_ASCII, path));
 
-        u32 bytes_written;
-        res = FSFILE_Write(file_handle, &bytes_written, 0,
-            files[i].data, files[i].size, FS_WRITE_FLUSH);
-        FSFILE_Close(file_handle);
+    char buf[MAX_PATH_LEN];
+    strncpy(buf, path, MAX_PATH_LEN - 1);
+    buf[MAX_PATH_LEN - 1] = '\0';
+    for (char *slash = strrchr(buf, '/'); slash && slash != buf; slash = strrchr(buf, '/')) {
+        *slash = '\0';
+        // Fails (and stops here) while the directory still has entries
+        if (R_FAILED(FSUSER_DeleteDirectory(archive, fsMakePath(PATH_ASCII, buf))))
+            break;
+    }
+}
 
-        if (R_FAILED(res) || bytes_written != files[i].size) {
-            FSUSER_CloseArchive(archive);
-            return false;
-        }
+bool archive_write(u64 title_id, FS_MediaType media_type,
+                   const ArchiveFile *files, int file_count) {
+    FS_Archive archive;
+    Result res = open_save_archive(&archive, title_id, media_type);
+    if (R_FAILED(res)) return false;
+
+    ArchiveDiff d;
+    memset(&d, 0, sizeof(d));
+    d.files = files;
+    d.file_count = file_count;
+    d.state = (u8 *)calloc(file_count ? file_count : 1, 1);
+    if (!d.state) {
+        FSUSER_CloseArchive(archive);
+        return false;
+    }
+
+    // Compare against what's there now; if that fails, rewrite everything
+    ArchiveSink sink = { diff_begin, diff_write, NULL, &d };
+    bool diffed = walk_archive(archive, &sink, true) >= 0;
+    if (!diffed) {
+        clear_dir(archive, "/");
+        memset(d.state, DIFF_NEW, file_count);
+        d.stale_count = 0;
     }
 
+    // Remove files that aren't in the new save first, so their paths
+    // (or parent directories) are free for the new files
+    bool changed = !diffed || d.stale_count > 0;
+    for (int i = 0; i < d.stale_count; i++) delete_stale(archive, d.stale[i]);
+    free(d.stale);
+
+    bool ok = true;
+    for (int i = 0; ok && i < file_count; i++) {
+        if (d.state[i] == DIFF_UNCHANGED) continue;
+        ok = write_file(archive, &files[i], d.state[i] == DIFF_NEW);
+        changed = true;
+    }
+    free(d.state);
+
     // CRITICAL: commit save data or changes are lost
-    FSUSER_ControlArchive(archive, ARCHIVE_ACTION_COMMIT_SAVE_DATA, NULL, 0, NULL, 0);
+    if (ok && changed) {
+        res = FSUSER_ControlArchive(archive, ARCHIVE_ACTION_COMMIT_SAVE_DATA, NULL, 0, NULL, 0);
+        ok = R_SUCCEEDED(res);
+    }
 
     FSUSER_CloseArchive(archive);
-    return true;
+    return ok;
 }
 
 void archive_free_files(ArchiveFile *files, int count) {
     for (int i = 0; i < count; i++) {
-        free(files[i].data);
+        if (!files[i].pooled) free(files[i].data);
         files[i].data = NULL;
     }
 }
@@ -7,17 +7,45 @@
 typedef struct {
     char path[MAX_PATH_LEN];
     u32 size;
-    u8 *data; // malloc'd, caller must free via archive_free_files()
+    u8 *data;    // malloc'd, caller must free via archive_free_files()
+    bool pooled; // data lives in files[0]'s buffer and isn't freed on its own
 } ArchiveFile;
 
-// Read all files from a title's save archive.
-// Returns number of files read, fills files array (up to max_files).
-// Caller must call archive_free_files() when done.
-int archive_read(u64 title_id, FS_MediaType media_type,
-                 ArchiveFile *files, int max_files);
+// Size of the read buffer archive_stream passes file data through
+#define ARCHIVE_CHUNK_SIZE 0x10000
 
-// Write files to a title's save archive (overwriting existing).
-// Returns true on success. Commits the save data.
+// Receives a save's files one after another from archive_stream.
+// begin_file gets the path (no leading slash) and size, write gets the data
+// in chunks of up to ARCHIVE_CHUNK_SIZE (valid only during the call), and
+// end_file closes the file. Returning false from any of them stops the walk.
+typedef struct {
+    bool (*begin_file)(void *ctx, const char *path, u32 size);
+    bool (*write)(void *ctx, const u8 *data, u32 len);
+    bool (*end_file)(void *ctx);
+    void *ctx;
+} ArchiveSink;
+
+// Stream every file of a title's save archive into sink, in the same order
+// archive_read returns them, through one reusable buffer.
+// Returns number of files, or -1 on error or if the sink stopped the walk.
+int archive_stream(u64 title_id, FS_MediaType media_type, const ArchiveSink *sink);
+
+// Read all files from a title's save archive into memory.
+// *files_out receives a malloc'd array; all file data shares one buffer.
+// Returns number of files read, or -1 on error.
+// Caller must call archive_free_files() and then free(*files_out).
+int archive_read(u64 title_id, FS_MediaType media_type, ArchiveFile **files_out);
+
+// Compute a change signature for a title's save archive without reading
+// file contents: covers each file's path, size and last-modified timestamp.
+// Returns false if the archive can't be opened or FS doesn't report
+// timestamps for it (the caller should then fall back to hashing the data).
+bool archive_signature(u64 title_id, FS_MediaType media_type, u64 *sig_out);
+
+// Write files to a title's save archive, replacing its contents.
+// Only files that differ from what's already there are rewritten, and files
+// not in the list are deleted. Returns true on success. Commits the save
+// data (skipped when nothing changed).
 bool archive_write(u64 title_id, FS_MediaType media_type,
                    const ArchiveFile *files, int file_count);
 
@@ -78,92 +78,539 @@ static int parse_payload(const u8 *payload, u32 payload_size,
     for (u32 i = 0; i < file_count; i++) {
         if (offset + files[i].size > payload_size) return -1;
         files[i].data = (u8 *)(payload + offset);
+        files[i].pooled = true;
         offset += files[i].size;
     }
 
     return (int)file_count;
 }
 
+// Format a 32-byte hash as 64 lowercase hex chars + null
+static void hash_to_hex(const u8 *hash, char *hex_out) {
+    static const char digits[] = "0123456789abcdef";
+    for (int i = 0; i < 32; i++) {
+        hex_out[i * 2] = digits[hash[i] >> 4];
+        hex_out[i * 2 + 1] = digits[hash[i] & 0x0F];
+    }
+    hex_out[64] = '\0';
+}
+
+#define BUNDLE_HEADER_SIZE 28
+
+// File table entry sizes: v1/v2 entries are path_len + path + size + sha256,
+// v3 adds the codec and the encoded size
+#define V1_ENTRY_SIZE(path_len) (2 + (u32)(path_len) + 4 + 32)
+#define V3_ENTRY_SIZE(path_len) (V1_ENTRY_SIZE(path_len) + 1 + 4)
+
+// Write the 28-byte header. size_field is the uncompressed payload size for
+// v3 as for v2: the size of the same save as a v1 payload.
+static void write_header(u8 *buf, u32 version, u64 title_id, u32 timestamp,
+                         u32 file_count, u32 size_field) {
+    memcpy(buf, BUNDLE_MAGIC, 4);
+    write_u32_le(buf + 4, version);
+    write_u64_be(buf + 8, title_id);
+    write_u32_le(buf + 16, timestamp);
+    write_u32_le(buf + 20, file_count);
+    write_u32_le(buf + 24, size_field);
+}
+
+// --- v3 codec choice ---
+
+// Entropy probe: up to three PROBE_WINDOW samples of a file (start, middle
+// and end). If their bytes collide no more than 1.25x as often as uniformly
+// random bytes would, deflate has nothing to work with and the file is
+// stored. Files under PROBE_MIN_SIZE are always stored; zlib's framing
+// alone is 11 bytes. server/app/services/bundle.py and tools/ds_sync.py
+// make the same choice, so the writers stay byte-for-byte compatible.
+#define PROBE_WINDOW   1024
+#define PROBE_MIN_SIZE 32
+
+typedef struct {
+    u32 counts[256];
+    u32 win_start[3];
+    u32 win_len[3];
+    int windows;
+    u32 size;   // File size
+    u32 pos;    // Bytes of the file seen so far
+    u32 n;      // Bytes sampled
+} Probe;
+
+static void probe_begin(Probe *p, u32 size) {
+    memset(p, 0, sizeof(*p));
+    p->size = size;
+    if (size <= 3 * PROBE_WINDOW) {
+        p->win_len[0] = size;
+        p->windows = 1;
+        return;
+    }
+    p->win_start[1] = size / 2 - PROBE_WINDOW / 2;
+    p->win_start[2] = size - PROBE_WINDOW;
+    for (int i = 0; i < 3; i++) p->win_len[i] = PROBE_WINDOW;
+    p->windows = 3;
+}
+
+// Count the bytes of the next len bytes of the file that fall in a window
+static void probe_feed(Probe *p, const u8 *data, u32 len) {
+    for (int w = 0; w < p->windows; w++) {
+        u32 lo = p->win_start[w] > p->pos ? p->win_start[w] : p->pos;
+        u32 end = p->win_start[w] + p->win_len[w];
+        u32 hi = end < p->pos + len ? end : p->pos + len;
+        for (u32 i = lo; i < hi; i++) p->counts[data[i - p->pos]]++;
+        if (hi > lo) p->n += hi - lo;
+    }
+    p->pos += len;
+}
+
+static u8 probe_codec(const Probe *p) {
+    if (p->size < PROBE_MIN_SIZE) return BUNDLE_CODEC_STORED;
+    u64 sum_sq = 0;
+    for (int i = 0; i < 256; i++) sum_sq += (u64)p->counts[i] * p->counts[i];
+    // Random bytes collide n + n(n-1)/256 times on average
+    u64 n = p->n;
+    return (1024 * sum_sq > 5 * n * (n + 255)) ? BUNDLE_CODEC_ZLIB : BUNDLE_CODEC_STORED;
+}
+
+// Deflate one whole file as its own zlib stream into out, which has room
+// for at least compressBound(len) bytes
+static bool deflate_file(z_stream *strm, const u8 *data, u32 len,
+                         u8 *out, u32 avail, u32 *out_len) {
+    if (deflateReset(strm) != Z_OK) return false;
+    strm->next_in = (Bytef *)data;
+    strm->avail_in = len;
+    strm->next_out = out;
+    strm->avail_out = avail;
+    if (deflate(strm, Z_FINISH) != Z_STREAM_END) return false;
+    *out_len = (u32)strm->total_out;
+    return true;
+}
+
 u8 *bundle_create(u64 title_id, u32 timestamp,
-                  const ArchiveFile *files, int file_count,
-                  u32 *out_size) {
-    // Calculate payload size (file table + file data)
-    u32 total_data = 0;
+                  const ArchiveFile *files, int file_count, BundleLevel level,
+                  u32 *out_size, char *save_hash_out) {
+    // File table size, the v1 payload the header describes, and the most
+    // the encoded data can take
     u32 table_size = 0;
+    u64 payload_size = 0;
+    u64 bound = 0;
     for (int i = 0; i < file_count; i++) {
         u16 path_len = (u16)strlen(files[i].path);
-        table_size += 2 + path_len + 4 + 32; // path_len + path + size + sha256
-        total_data += files[i].size;
+        table_size += V3_ENTRY_SIZE(path_len);
+        payload_size += V1_ENTRY_SIZE(path_len) + files[i].size;
+        bound += compressBound(files[i].size);
     }
-    u32 payload_size = table_size + total_data;
+    u32 data_start = BUNDLE_HEADER_SIZE + table_size;
+    if (payload_size > 0xFFFFFFFFu || data_start + bound > 0xFFFFFFFFu) return NULL;
 
-    // Build uncompressed payload
-    u8 *payload = (u8 *)malloc(payload_size);
-    if (!payload) return NULL;
+    // Single output buffer: header, file table, then each file's data
+    u32 cap = data_start + (u32)bound;
+    u8 *buf = (u8 *)malloc(cap);
+    if (!buf) return NULL;
 
-    u32 offset = 0;
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    if (deflateInit(&strm, level) != Z_OK) {
+        free(buf);
+        return NULL;
+    }
 
-    // File table
-    for (int i = 0; i < file_count; i++) {
-        u16 path_len = (u16)strlen(files[i].path);
-        write_u16_le(payload + offset, path_len); offset += 2;
-        memcpy(payload + offset, files[i].path, path_len); offset += path_len;
-        write_u32_le(payload + offset, files[i].size); offset += 4;
+    // One pass over the data for the per-file hashes, the whole-save hash
+    // and the codec probe, then one to encode
+    SHA256_CTX save_ctx;
+    sha256_init(&save_ctx);
 
-        // SHA-256 of file data
-        u8 hash[32];
-        sha256(files[i].data, files[i].size, hash);
-        memcpy(payload + offset, hash, 32); offset += 32;
-    }
+    u8 *entry = buf + BUNDLE_HEADER_SIZE;
+    u32 pos = data_start;
+    bool ok = true;
+    for (int i = 0; ok && i < file_count; i++) {
+        const ArchiveFile *f = &files[i];
+        u16 path_len = (u16)strlen(f->path);
+        write_u16_le(entry, path_len);
+        memcpy(entry + 2, f->path, path_len);
+        write_u32_le(entry + 2 + path_len, f->size);
 
-    // File data
-    for (int i = 0; i < file_count; i++) {
-        memcpy(payload + offset, files[i].data, files[i].size);
-        offset += files[i].size;
+        SHA256_CTX file_ctx;
+        sha256_init(&file_ctx);
+        sha256_update(&file_ctx, f->data, f->size);
+        sha256_update(&save_ctx, f->data, f->size);
+        sha256_final(&file_ctx, entry + 2 + path_len + 4);
+
+        Probe probe;
+        probe_begin(&probe, f->size);
+        probe_feed(&probe, f->data, f->size);
+        u8 codec = probe_codec(&probe);
+
+        u32 encoded = f->size;
+        if (codec == BUNDLE_CODEC_ZLIB)
+            ok = deflate_file(&strm, f->data, f->size, buf + pos, cap - pos, &encoded);
+        else
+            memcpy(buf + pos, f->data, f->size);
+
+        entry[V1_ENTRY_SIZE(path_len)] = codec;
+        write_u32_le(entry + V1_ENTRY_SIZE(path_len) + 1, encoded);
+        entry += V3_ENTRY_SIZE(path_len);
+        pos += encoded;
     }
+    deflateEnd(&strm);
 
-    // Compress payload
-    uLongf compressed_size = compressBound(payload_size);
-    u8 *compressed = (u8 *)malloc(compressed_size);
-    if (!compressed) {
-        free(payload);
+    if (!ok) {
+        free(buf);
         return NULL;
     }
 
-    int zret = compress2(compressed, &compressed_size, payload, payload_size, 6);
-    free(payload);
+    write_header(buf, BUNDLE_VERSION_CODECS, title_id, timestamp,
+                 (u32)file_count, (u32)payload_size);
 
-    if (zret != Z_OK) {
-        free(compressed);
-        return NULL;
+    if (save_hash_out) {
+        u8 save_hash[32];
+        sha256_final(&save_ctx, save_hash);
+        hash_to_hex(save_hash, save_hash_out);
     }
 
-    // Build final bundle: header + compressed payload
-    u32 header_size = 4 + 4 + 8 + 4 + 4 + 4; // magic + ver + tid + ts + count + uncompressed_size
-    u32 bundle_size = header_size + (u32)compressed_size;
+    // Give back the unused tail of the compressBound allocation
+    u8 *shrunk = (u8 *)realloc(buf, pos);
+    if (shrunk) buf = shrunk;
 
-    u8 *buf = (u8 *)malloc(bundle_size);
-    if (!buf) {
-        free(compressed);
-        return NULL;
+    *out_size = pos;
+    return buf;
+}
+
+// --- Bundles streamed from a save archive ---
+
+// First pass: build the file table (with per-file hashes and codecs) and
+// the save hash. Encoded sizes are filled in by the second pass.
+typedef struct {
+    u8 *table;
+    u32 table_size;
+    u32 table_cap;
+    u32 entry;         // Offset of the current file's entry in the table
+    u16 path_len;
+    u64 payload_size;  // As a v1 payload, for the header
+    u64 bound;         // Most the encoded data can take
+    Probe probe;
+    SHA256_CTX file_ctx;
+    SHA256_CTX save_ctx;
+} TablePass;
+
+static bool table_begin(void *ctx, const char *path, u32 size) {
+    TablePass *t = (TablePass *)ctx;
+    u16 path_len = (u16)strlen(path);
+    u32 need = t->table_size + V3_ENTRY_SIZE(path_len);
+    if (need > t->table_cap) {
+        u32 cap = t->table_cap ? t->table_cap * 2 : 1024;
+        while (cap < need) cap *= 2;
+        u8 *grown = (u8 *)realloc(t->table, cap);
+        if (!grown) return false;
+        t->table = grown;
+        t->table_cap = cap;
     }
 
-    offset = 0;
+    u8 *p = t->table + t->table_size;
+    write_u16_le(p, path_len);
+    memcpy(p + 2, path, path_len);
+    write_u32_le(p + 2 + path_len, size);
+    t->entry = t->table_size;
+    t->path_len = path_len;
+    t->table_size = need;
+    t->payload_size += V1_ENTRY_SIZE(path_len) + size;
+    t->bound += compressBound(size);
 
-    // Header (v2 compressed)
-    memcpy(buf + offset, BUNDLE_MAGIC, 4); offset += 4;
-    write_u32_le(buf + offset, BUNDLE_VERSION_COMPRESSED); offset += 4;
-    write_u64_be(buf + offset, title_id); offset += 8;
-    write_u32_le(buf + offset, timestamp); offset += 4;
-    write_u32_le(buf + offset, (u32)file_count); offset += 4;
-    write_u32_le(buf + offset, payload_size); offset += 4;  // uncompressed size
+    sha256_init(&t->file_ctx);
+    probe_begin(&t->probe, size);
+    return t->payload_size <= 0xFFFFFFFFu &&
+           BUNDLE_HEADER_SIZE + t->table_size + t->bound <= 0xFFFFFFFFu;
+}
 
-    // Compressed payload
-    memcpy(buf + offset, compressed, compressed_size);
-    free(compressed);
+static bool table_write(void *ctx, const u8 *data, u32 len) {
+    TablePass *t = (TablePass *)ctx;
+    sha256_update(&t->file_ctx, data, len);
+    sha256_update(&t->save_ctx, data, len);
+    probe_feed(&t->probe, data, len);
+    return true;
+}
 
-    *out_size = bundle_size;
-    return buf;
+static bool table_end(void *ctx) {
+    TablePass *t = (TablePass *)ctx;
+    u8 *p = t->table + t->entry;
+    sha256_final(&t->file_ctx, p + 2 + t->path_len + 4);
+    p[V1_ENTRY_SIZE(t->path_len)] = probe_codec(&t->probe);
+    write_u32_le(p + V1_ENTRY_SIZE(t->path_len) + 1, 0);
+    return true;
+}
+
+// Second pass: encode each file into a growing output buffer laid out as
+// header, file table, data
+typedef struct {
+    z_stream strm;
+    u8 *buf;
+    u32 cap;
+    u32 pos;         // End of the output so far
+    u32 entry;       // Offset in buf of the current file's table entry
+    u32 table_end;   // Offset in buf where the file table ends
+    u32 file_start;  // Where the current file's encoded data starts
+    u32 remaining;   // Bytes of the current file still to come
+    u8 codec;
+} EncodePass;
+
+// Make room for at least need more bytes of output
+static bool encode_reserve(EncodePass *e, u32 need) {
+    if (e->cap - e->pos >= need) return true;
+    u64 cap = e->cap;
+    while (cap - e->pos < need) cap *= 2;
+    if (cap > 0xFFFFFFFFu) return false;
+    u8 *grown = (u8 *)realloc(e->buf, (u32)cap);
+    if (!grown) return false;
+    e->buf = grown;
+    e->cap = (u32)cap;
+    return true;
+}
+
+// Run data through the current file's zlib stream (flush: Z_NO_FLUSH or
+// Z_FINISH), growing the output buffer as needed
+static bool encode_deflate(EncodePass *e, const u8 *data, u32 len, int flush) {
+    e->strm.next_in = (Bytef *)data;
+    e->strm.avail_in = len;
+    for (;;) {
+        if (!encode_reserve(e, 1)) return false;
+        e->strm.next_out = e->buf + e->pos;
+        e->strm.avail_out = e->cap - e->pos;
+        int zret = deflate(&e->strm, flush);
+        e->pos = e->cap - e->strm.avail_out;
+        if (flush == Z_FINISH) {
+            if (zret == Z_STREAM_END) return true;
+            if (zret != Z_OK) return false;
+        } else {
+            if (zret != Z_OK) return false;
+            if (e->strm.avail_in == 0) return true;
+        }
+    }
+}
+
+// The save must not change between passes: each file has to match its
+// table entry
+static bool encode_begin(void *ctx, const char *path, u32 size) {
+    EncodePass *e = (EncodePass *)ctx;
+    if (e->entry >= e->table_end) return false;
+    const u8 *p = e->buf + e->entry;
+    u16 path_len = read_u16_le(p);
+    if (path_len != strlen(path) || memcmp(p + 2, path, path_len) != 0 ||
+        read_u32_le(p + 2 + path_len) != size)
+        return false;
+
+    e->codec = p[V1_ENTRY_SIZE(path_len)];
+    e->remaining = size;
+    e->file_start = e->pos;
+    return e->codec != BUNDLE_CODEC_ZLIB || deflateReset(&e->strm) == Z_OK;
+}
+
+static bool encode_write(void *ctx, const u8 *data, u32 len) {
+    EncodePass *e = (EncodePass *)ctx;
+    if (len > e->remaining) return false;
+    e->remaining -= len;
+    if (e->codec == BUNDLE_CODEC_ZLIB) return encode_deflate(e, data, len, Z_NO_FLUSH);
+    if (!encode_reserve(e, len)) return false;
+    memcpy(e->buf + e->pos, data, len);
+    e->pos += len;
+    return true;
+}
+
+static bool encode_end(void *ctx) {
+    EncodePass *e = (EncodePass *)ctx;
+    if (e->remaining != 0) return false;
+    if (e->codec == BUNDLE_CODEC_ZLIB && !encode_deflate(e, NULL, 0, Z_FINISH)) return false;
+
+    u8 *p = e->buf + e->entry;
+    u16 path_len = read_u16_le(p);
+    write_u32_le(p + V1_ENTRY_SIZE(path_len) + 1, e->pos - e->file_start);
+    e->entry += V3_ENTRY_SIZE(path_len);
+    return true;
+}
+
+int bundle_create_archive(u64 title_id, FS_MediaType media_type, u32 timestamp,
+                          BundleLevel level, u8 **bundle_out, u32 *out_size,
+                          char *save_hash_out) {
+    *bundle_out = NULL;
+    *out_size = 0;
+
+    TablePass t;
+    memset(&t, 0, sizeof(t));
+    sha256_init(&t.save_ctx);
+
+    ArchiveSink table_sink = { table_begin, table_write, table_end, &t };
+    int file_count = archive_stream(title_id, media_type, &table_sink);
+    if (file_count <= 0) {
+        free(t.table);
+        return file_count;
+    }
+
+    u8 save_hash[32];
+    sha256_final(&t.save_ctx, save_hash);
+
+    EncodePass e;
+    memset(&e, 0, sizeof(e));
+    if (deflateInit(&e.strm, level) != Z_OK) {
+        free(t.table);
+        return -1;
+    }
+
+    // Start at a quarter of the payload past the table; encode_reserve
+    // doubles as needed
+    u32 quarter = (u32)(t.payload_size / 4);
+    e.table_end = BUNDLE_HEADER_SIZE + t.table_size;
+    e.cap = e.table_end + (quarter > 0x1000 ? quarter : 0x1000);
+    e.buf = (u8 *)malloc(e.cap);
+    bool ok = (e.buf != NULL);
+    if (ok) {
+        memcpy(e.buf + BUNDLE_HEADER_SIZE, t.table, t.table_size);
+        e.entry = BUNDLE_HEADER_SIZE;
+        e.pos = e.table_end;
+    }
+    free(t.table);
+
+    if (ok) {
+        ArchiveSink data_sink = { encode_begin, encode_write, encode_end, &e };
+        ok = (archive_stream(title_id, media_type, &data_sink) == file_count) &&
+             e.entry == e.table_end;
+    }
+    deflateEnd(&e.strm);
+
+    if (!ok) {
+        free(e.buf);
+        return -1;
+    }
+
+    u8 *buf = e.buf;
+    write_header(buf, BUNDLE_VERSION_CODECS, title_id, timestamp,
+                 (u32)file_count, (u32)t.payload_size);
+
+    // Give back the unused tail of the output buffer
+    u8 *shrunk = (u8 *)realloc(buf, e.pos);
+    if (shrunk) buf = shrunk;
+
+    if (save_hash_out) hash_to_hex(save_hash, save_hash_out);
+    *bundle_out = buf;
+    *out_size = e.pos;
+    return file_count;
+}
+
+// --- Random access to v3 bundles ---
+
+// A stored file's encoded size is its size; a zlib file is empty exactly
+// when its stream is
+static bool codec_sizes_valid(u8 codec, u32 size, u32 encoded) {
+    if (codec == BUNDLE_CODEC_STORED) return encoded == size;
+    if (codec == BUNDLE_CODEC_ZLIB) return (size == 0) == (encoded == 0);
+    return false;
+}
+
+int bundle_index(const u8 *data, u32 data_size, BundleEntry *entries,
+                 int max_entries, u32 *out_size) {
+    if (data_size < BUNDLE_HEADER_SIZE) return BUNDLE_INDEX_SHORT;
+    if (memcmp(data, BUNDLE_MAGIC, 4) != 0 ||
+        read_u32_le(data + 4) != BUNDLE_VERSION_CODECS)
+        return -1;
+    u32 file_count = read_u32_le(data + 20);
+    u32 payload_size = read_u32_le(data + 24);
+    if (file_count > payload_size / V1_ENTRY_SIZE(0) || file_count > (u32)max_entries)
+        return -1;
+
+    // Data offsets are running sums of the encoded sizes, so the table has
+    // to be walked once; it's small next to the data it describes
+    u32 pos = BUNDLE_HEADER_SIZE;
+    u64 v1_size = 0;
+    u64 encoded = 0;
+    for (u32 i = 0; i < file_count; i++) {
+        if (data_size - pos < 2) return BUNDLE_INDEX_SHORT;
+        u16 path_len = read_u16_le(data + pos);
+        if (path_len >= MAX_PATH_LEN) return -1;
+        if (data_size - pos < V3_ENTRY_SIZE(path_len)) return BUNDLE_INDEX_SHORT;
+
+        const u8 *p = data + pos;
+        BundleEntry *e = &entries[i];
+        e->path = (const char *)p + 2;
+        e->path_len = path_len;
+        e->size = read_u32_le(p + 2 + path_len);
+        e->sha256 = p + 2 + path_len + 4;
+        e->codec = p[V1_ENTRY_SIZE(path_len)];
+        e->encoded_size = read_u32_le(p + V1_ENTRY_SIZE(path_len) + 1);
+        if (!codec_sizes_valid(e->codec, e->size, e->encoded_size)) return -1;
+
+        e->offset = (u32)encoded; // From the start of the data for now
+        v1_size += V1_ENTRY_SIZE(path_len) + e->size;
+        encoded += e->encoded_size;
+        pos += V3_ENTRY_SIZE(path_len);
+    }
+    if (v1_size != payload_size || pos + encoded > 0xFFFFFFFFu) return -1;
+
+    for (u32 i = 0; i < file_count; i++) entries[i].offset += pos;
+    if (out_size) *out_size = pos + (u32)encoded;
+    return (int)file_count;
+}
+
+bool bundle_decode_file(const BundleEntry *entry, const u8 *frame, u8 *dest,
+                        ArchiveFile *out) {
+    memcpy(out->path, entry->path, entry->path_len);
+    out->path[entry->path_len] = '\0';
+    out->size = entry->size;
+    out->data = (u8 *)frame;
+    out->pooled = true;
+
+    if (entry->codec == BUNDLE_CODEC_ZLIB && entry->size) {
+        // The stream must fill dest exactly and end on the frame's last byte
+        uLongf dest_len = entry->size;
+        uLong src_len = entry->encoded_size;
+        if (uncompress2(dest, &dest_len, frame, &src_len) != Z_OK ||
+            dest_len != entry->size || src_len != entry->encoded_size)
+            return false;
+        out->data = dest;
+    }
+
+    u8 hash[32];
+    sha256(out->data, entry->size, hash);
+    return memcmp(hash, entry->sha256, 32) == 0;
+}
+
+// v3 bundle_parse: stored files are used in place, and only zlib files
+// are inflated, all into one buffer
+static int parse_codecs(const u8 *data, u32 data_size, u32 file_count,
+                        ArchiveFile *files, int max_files, u8 **out_decompressed) {
+    if (file_count > (u32)max_files) return -1;
+    BundleEntry *entries =
+        (BundleEntry *)malloc((file_count ? file_count : 1) * sizeof(BundleEntry));
+    if (!entries) return -1;
+
+    u32 bundle_size;
+    int n = bundle_index(data, data_size, entries, max_files, &bundle_size);
+    if (n < 0 || bundle_size > data_size) {
+        free(entries);
+        return -1;
+    }
+
+    u32 inflated = 0;
+    for (int i = 0; i < n; i++)
+        if (entries[i].codec == BUNDLE_CODEC_ZLIB) inflated += entries[i].size;
+    u8 *buf = NULL;
+    if (inflated) {
+        buf = (u8 *)malloc(inflated);
+        if (!buf) {
+            free(entries);
+            return -1;
+        }
+    }
+
+    u32 pos = 0;
+    for (int i = 0; i < n; i++) {
+        const BundleEntry *e = &entries[i];
+        if (!bundle_decode_file(e, data + e->offset, buf ? buf + pos : NULL, &files[i])) {
+            free(buf);
+            free(entries);
+            return -1;
+        }
+        if (e->codec == BUNDLE_CODEC_ZLIB) pos += e->size;
+    }
+
+    free(entries);
+    *out_decompressed = buf;
+    return n;
 }
 
 int bundle_parse(const u8 *data, u32 data_size,
@@ -172,7 +619,7 @@ int bundle_parse(const u8 *data, u32 data_size,
                  u8 **out_decompressed) {
     *out_decompressed = NULL;
 
-    if (data_size < 28) return -1;
+    if (data_size < BUNDLE_HEADER_SIZE) return -1;
 
     u32 offset = 0;
 
@@ -181,7 +628,8 @@ int bundle_parse(const u8 *data, u32 data_size,
     offset += 4;
 
     u32 version = read_u32_le(data + offset); offset += 4;
-    if (version != BUNDLE_VERSION && version != BUNDLE_VERSION_COMPRESSED)
+    if (version != BUNDLE_VERSION && version != BUNDLE_VERSION_COMPRESSED &&
+        version != BUNDLE_VERSION_CODECS)
         return -1;
 
     *out_title_id = read_u64_be(data + offset); offset += 8;
@@ -193,7 +641,9 @@ int bundle_parse(const u8 *data, u32 data_size,
     const u8 *payload;
     u32 payload_size;
 
-    if (version == BUNDLE_VERSION_COMPRESSED) {
+    if (version == BUNDLE_VERSION_CODECS) {
+        return parse_codecs(data, data_size, file_count, files, max_files, out_decompressed);
+    } else if (version == BUNDLE_VERSION_COMPRESSED) {
         // v2: decompress payload
         u32 uncompressed_size = size_field;
         u8 *decompressed = (u8 *)malloc(uncompressed_size);
@@ -219,6 +669,320 @@ int bundle_parse(const u8 *data, u32 data_size,
     return parse_payload(payload, payload_size, file_count, files, max_files);
 }
 
+// --- Streaming decode ---
+
+// Per-file record kept while a v3 table is decoded: codec, size, encoded size
+#define CODEC_INFO_SIZE 9
+
+struct BundleStream {
+    u8 *out;            // v1 header + payload being rebuilt
+    u32 capacity;       // Bytes allocated for out
+    u32 max_payload;
+    u8 header[BUNDLE_HEADER_SIZE];
+    u32 header_fill;
+    bool compressed;
+    bool codecs;        // v3: per-file codecs
+    bool inflating;     // z_stream is initialized
+    bool done;          // Whole payload received
+    bool failed;
+    z_stream strm;
+    u32 file_count;
+    u32 payload_size;   // Expected (v2/v3) or received so far (v1)
+    u32 produced;       // Payload bytes written to out
+    // File table walk: entries parsed, and where the data starts
+    u32 table_entries;
+    u32 table_pos;
+    // Hash check walk: next table entry and its data
+    u32 verified;
+    u32 verify_table_pos;
+    u32 verify_data_pos;
+    // v3: the table entry being received, and the files' codec records
+    u8 entry[V3_ENTRY_SIZE(MAX_PATH_LEN)];
+    u32 entry_fill;
+    u32 codec_entries;
+    u8 *codec_info;
+    u64 claimed;        // Table entries plus file sizes parsed so far
+    // v3: the file being decoded
+    u32 file;
+    bool file_open;
+    bool file_ended;    // Its zlib stream has ended
+    u32 encoded_left;
+    u32 decoded_left;
+};
+
+BundleStream *bundle_stream_begin(u32 max_payload) {
+    BundleStream *s = (BundleStream *)calloc(1, sizeof(BundleStream));
+    if (s) s->max_payload = max_payload;
+    return s;
+}
+
+void bundle_stream_reset(BundleStream *s) {
+    if (s->inflating) inflateEnd(&s->strm);
+    free(s->out);
+    free(s->codec_info);
+    u32 max_payload = s->max_payload;
+    memset(s, 0, sizeof(*s));
+    s->max_payload = max_payload;
+}
+
+// Make room for at least need bytes of payload (v1 bundles grow as they come)
+static bool stream_reserve(BundleStream *s, u32 need) {
+    if (need > s->max_payload) return false;
+    u32 want = BUNDLE_HEADER_SIZE + need;
+    if (want <= s->capacity) return true;
+    u32 cap = s->capacity ? s->capacity : 0x4000;
+    while (cap < want) cap *= 2;
+    u8 *grown = (u8 *)realloc(s->out, cap);
+    if (!grown) return false;
+    s->out = grown;
+    s->capacity = cap;
+    return true;
+}
+
+// Parse the 28-byte header and set up the payload buffer
+static bool stream_start(BundleStream *s) {
+    const u8 *h = s->header;
+    if (memcmp(h, BUNDLE_MAGIC, 4) != 0) return false;
+    u32 version = read_u32_le(h + 4);
+    if (version != BUNDLE_VERSION && version != BUNDLE_VERSION_COMPRESSED &&
+        version != BUNDLE_VERSION_CODECS)
+        return false;
+    s->compressed = (version == BUNDLE_VERSION_COMPRESSED);
+    s->codecs = (version == BUNDLE_VERSION_CODECS);
+    s->file_count = read_u32_le(h + 20);
+
+    if (s->compressed || s->codecs) {
+        // Uncompressed size is known: allocate it once
+        s->payload_size = read_u32_le(h + 24);
+        if (s->payload_size > s->max_payload) return false;
+        s->out = (u8 *)malloc(BUNDLE_HEADER_SIZE + (s->payload_size ? s->payload_size : 1));
+        if (!s->out) return false;
+        s->capacity = BUNDLE_HEADER_SIZE + s->payload_size;
+        if (inflateInit(&s->strm) != Z_OK) return false;
+        s->inflating = true;
+    } else if (!stream_reserve(s, 0)) {
+        return false;
+    }
+
+    if (s->codecs) {
+        // Every v1 table entry takes at least V1_ENTRY_SIZE(0) bytes of the
+        // payload, which bounds the file count
+        if (s->file_count > s->payload_size / V1_ENTRY_SIZE(0)) return false;
+        s->codec_info = (u8 *)malloc(s->file_count ? s->file_count * CODEC_INFO_SIZE : 1);
+        if (!s->codec_info) return false;
+    }
+
+    // Rebuilt as an uncompressed bundle; the size field is set on finish
+    memcpy(s->out, h, BUNDLE_HEADER_SIZE);
+    write_u32_le(s->out + 4, BUNDLE_VERSION);
+    return true;
+}
+
+// Walk the file table and check every file that has fully arrived
+static bool stream_check(BundleStream *s) {
+    const u8 *payload = s->out + BUNDLE_HEADER_SIZE;
+
+    while (s->table_entries < s->file_count) {
+        if (s->table_pos + 2 > s->produced) return true;
+        u16 path_len = read_u16_le(payload + s->table_pos);
+        if (path_len >= MAX_PATH_LEN) return false;
+        u32 entry = V1_ENTRY_SIZE(path_len);
+        if (s->table_pos + entry > s->produced) return true;
+        s->table_pos += entry;
+        s->table_entries++;
+        if (s->table_entries == s->file_count) s->verify_data_pos = s->table_pos;
+    }
+
+    while (s->verified < s->file_count) {
+        const u8 *entry = payload + s->verify_table_pos;
+        u16 path_len = read_u16_le(entry);
+        u32 size = read_u32_le(entry + 2 + path_len);
+        if (size > s->produced - s->verify_data_pos) return true;
+
+        u8 hash[32];
+        sha256(payload + s->verify_data_pos, size, hash);
+        if (memcmp(hash, entry + 2 + path_len + 4, 32) != 0) return false;
+
+        s->verify_table_pos += V1_ENTRY_SIZE(path_len);
+        s->verify_data_pos += size;
+        s->verified++;
+    }
+    return true;
+}
+
+// v3: a complete table entry has arrived. Its v1 part goes to out, the
+// codec and sizes to codec_info.
+static bool stream_table_entry(BundleStream *s) {
+    u16 path_len = read_u16_le(s->entry);
+    u32 v1_len = V1_ENTRY_SIZE(path_len);
+    u32 size = read_u32_le(s->entry + 2 + path_len);
+    u8 codec = s->entry[v1_len];
+    u32 encoded = read_u32_le(s->entry + v1_len + 1);
+
+    if (!codec_sizes_valid(codec, size, encoded)) return false;
+    // The table and every file it declares must fit the header's size, or
+    // decoding would run past out
+    s->claimed += (u64)v1_len + size;
+    if (s->claimed > s->payload_size) return false;
+
+    memcpy(s->out + BUNDLE_HEADER_SIZE + s->produced, s->entry, v1_len);
+    s->produced += v1_len;
+
+    u8 *info = s->codec_info + s->codec_entries * CODEC_INFO_SIZE;
+    info[0] = codec;
+    write_u32_le(info + 1, size);
+    write_u32_le(info + 5, encoded);
+    s->codec_entries++;
+    return true;
+}
+
+// v3: the file table, then each file's data (stored, or its own zlib
+// stream), decoded into out in the v1 layout
+static bool stream_feed_codecs(BundleStream *s, const u8 *data, u32 len) {
+    while (s->codec_entries < s->file_count) {
+        u32 need = 2;
+        if (s->entry_fill >= 2) {
+            u16 path_len = read_u16_le(s->entry);
+            if (path_len >= MAX_PATH_LEN) return false;
+            need = V3_ENTRY_SIZE(path_len);
+        }
+        u32 take = need - s->entry_fill;
+        if (take > len) take = len;
+        memcpy(s->entry + s->entry_fill, data, take);
+        s->entry_fill += take;
+        data += take;
+        len -= take;
+        if (s->entry_fill < need) {
+            if (len == 0) return true;
+            continue; // Path length is in; now the rest of the entry
+        }
+        if (need == 2) continue;
+        if (!stream_table_entry(s)) return false;
+        s->entry_fill = 0;
+    }
+
+    while (s->file < s->file_count) {
+        const u8 *info = s->codec_info + s->file * CODEC_INFO_SIZE;
+        bool zlib = (info[0] == BUNDLE_CODEC_ZLIB);
+        if (!s->file_open) {
+            s->decoded_left = read_u32_le(info + 1);
+            s->encoded_left = read_u32_le(info + 5);
+            s->file_open = true;
+            s->file_ended = false;
+            if (zlib && s->encoded_left && inflateReset(&s->strm) != Z_OK) return false;
+        }
+
+        if (s->encoded_left == 0) {
+            // All of this file's bytes are in: it must have decoded exactly
+            if (s->decoded_left != 0) return false;
+            if (zlib && read_u32_le(info + 5) && !s->file_ended) return false;
+            s->file++;
+            s->file_open = false;
+            continue;
+        }
+        if (len == 0) return true;
+
+        u32 take = len < s->encoded_left ? len : s->encoded_left;
+        u8 *dest = s->out + BUNDLE_HEADER_SIZE + s->produced;
+        if (!zlib) {
+            memcpy(dest, data, take);
+            s->produced += take;
+            s->decoded_left -= take;
+        } else {
+            if (s->file_ended) return false; // Encoded size runs past the stream
+            s->strm.next_in = (Bytef *)data;
+            s->strm.avail_in = take;
+            s->strm.next_out = dest;
+            s->strm.avail_out = s->decoded_left;
+            int zret = inflate(&s->strm, Z_NO_FLUSH);
+            u32 written = s->decoded_left - s->strm.avail_out;
+            s->produced += written;
+            s->decoded_left -= written;
+            take -= s->strm.avail_in;
+            if (zret == Z_STREAM_END) {
+                s->file_ended = true;
+            } else if (zret != Z_OK && !(zret == Z_BUF_ERROR && s->strm.avail_in == 0)) {
+                // Corrupt data, or more output than the table promised
+                return false;
+            }
+        }
+        data += take;
+        len -= take;
+        s->encoded_left -= take;
+    }
+
+    // Anything after the last file is ignored
+    s->done = true;
+    return true;
+}
+
+bool bundle_stream_feed(BundleStream *s, const u8 *data, u32 len) {
+    if (s->failed) return false;
+
+    if (s->header_fill < BUNDLE_HEADER_SIZE) {
+        u32 take = BUNDLE_HEADER_SIZE - s->header_fill;
+        if (take > len) take = len;
+        memcpy(s->header + s->header_fill, data, take);
+        s->header_fill += take;
+        data += take;
+        len -= take;
+        if (s->header_fill < BUNDLE_HEADER_SIZE) return true;
+        if (!stream_start(s)) { s->failed = true; return false; }
+    }
+
+    if (s->codecs) {
+        // Runs even without data: a save of empty files is complete once
+        // its table is in
+        if (!s->done && !stream_feed_codecs(s, data, len)) { s->failed = true; return false; }
+    } else if (len == 0) {
+        return true;
+    } else if (!s->compressed) {
+        if (!stream_reserve(s, s->produced + len)) { s->failed = true; return false; }
+        memcpy(s->out + BUNDLE_HEADER_SIZE + s->produced, data, len);
+        s->produced += len;
+        s->payload_size = s->produced;
+    } else {
+        // Anything after the end of the deflate stream is ignored
+        if (s->done) return true;
+        s->strm.next_in = (Bytef *)data;
+        s->strm.avail_in = len;
+        s->strm.next_out = s->out + BUNDLE_HEADER_SIZE + s->produced;
+        s->strm.avail_out = s->payload_size - s->produced;
+        int zret = inflate(&s->strm, Z_NO_FLUSH);
+        s->produced = s->payload_size - s->strm.avail_out;
+        if (zret == Z_STREAM_END) {
+            s->done = true;
+        } else if (zret != Z_OK && !(zret == Z_BUF_ERROR && s->strm.avail_in == 0)) {
+            // Corrupt data, or more output than the header promised
+            s->failed = true;
+            return false;
+        }
+    }
+
+    if (!stream_check(s)) { s->failed = true; return false; }
+    return true;
+}
+
+u8 *bundle_stream_finish(BundleStream *s, u32 *out_size) {
+    bool ok = !s->failed && s->header_fill == BUNDLE_HEADER_SIZE &&
+              s->verified == s->file_count;
+    if (ok && (s->compressed || s->codecs)) ok = s->done && s->produced == s->payload_size;
+    // A v1 payload must end with the last file's data
+    if (ok && !s->compressed && !s->codecs) ok = (s->verify_data_pos == s->produced);
+
+    u8 *out = ok ? s->out : NULL;
+    if (ok) {
+        write_u32_le(out + 24, s->produced - s->table_pos); // v1: total file data
+        *out_size = BUNDLE_HEADER_SIZE + s->produced;
+    } else {
+        free(s->out);
+    }
+    if (s->inflating) inflateEnd(&s->strm);
+    free(s->codec_info);
+    free(s);
+    return out;
+}
+
 void bundle_compute_save_hash(const ArchiveFile *files, int file_count,
                               char *hex_out) {
     SHA256_CTX ctx;
@@ -230,9 +994,39 @@ void bundle_compute_save_hash(const ArchiveFile *files, int file_count,
 
     u8 hash[32];
     sha256_final(&ctx, hash);
+    hash_to_hex(hash, hex_out);
+}
 
-    for (int i = 0; i < 32; i++) {
-        snprintf(hex_out + i * 2, 3, "%02x", hash[i]);
-    }
-    hex_out[64] = '\0';
+// Hash every file's data in archive order
+typedef struct {
+    SHA256_CTX ctx;
+    u64 total;
+} HashPass;
+
+static bool hash_begin(void *ctx, const char *path, u32 size) {
+    (void)path;
+    ((HashPass *)ctx)->total += size;
+    return true;
+}
+
+static bool hash_write(void *ctx, const u8 *data, u32 len) {
+    sha256_update(&((HashPass *)ctx)->ctx, data, len);
+    return true;
+}
+
+int bundle_hash_archive(u64 title_id, FS_MediaType media_type,
+                        char *hex_out, u32 *size_out) {
+    HashPass h;
+    sha256_init(&h.ctx);
+    h.total = 0;
+
+    ArchiveSink sink = { hash_begin, hash_write, NULL, &h };
+    int count = archive_stream(title_id, media_type, &sink);
+    if (count < 0) return -1;
+
+    u8 hash[32];
+    sha256_final(&h.ctx, hash);
+    hash_to_hex(hash, hex_out);
+    if (size_out) *size_out = (u32)h.total;
+    return count;
 }
@@ -7,30 +7,116 @@
 #define BUNDLE_MAGIC "3DSS"
 #define BUNDLE_VERSION 1
 #define BUNDLE_VERSION_COMPRESSED 2
+#define BUNDLE_VERSION_CODECS 3
 
-// Create a compressed binary bundle from archive files.
+// v3 per-file codecs
+#define BUNDLE_CODEC_STORED 0
+#define BUNDLE_CODEC_ZLIB   1
+
+// How hard zlib works on the files a v3 writer compresses. Files the
+// entropy probe judges incompressible (and tiny ones) are stored either way.
+typedef enum {
+    BUNDLE_LEVEL_FAST = 1, // zlib level 1: the default, light on the ARM11
+    BUNDLE_LEVEL_HIGH = 9, // zlib level 9: for slow links, where bytes cost more than CPU
+} BundleLevel;
+
+// Create a v3 bundle from archive files: each file is probed and then
+// stored or deflated at the given level, straight into the returned buffer.
+// If save_hash_out is non-NULL it receives the save hash (same value as
+// bundle_compute_save_hash, 65 bytes), computed in the same pass.
 // Returns malloc'd buffer (caller must free), sets out_size.
 // Returns NULL on failure.
 u8 *bundle_create(u64 title_id, u32 timestamp,
-                  const ArchiveFile *files, int file_count,
-                  u32 *out_size);
+                  const ArchiveFile *files, int file_count, BundleLevel level,
+                  u32 *out_size, char *save_hash_out);
+
+// Like bundle_create, but reads a title's save archive itself through
+// archive_stream: one pass for the file and save hashes and codec choice, a
+// second pass to encode. Memory use is the encoded output plus one read
+// buffer, however many files the save has. Produces the same bytes as
+// bundle_create. Returns the number of files, or -1 on error.
+// *bundle_out is malloc'd, or NULL if the save has no files.
+int bundle_create_archive(u64 title_id, FS_MediaType media_type, u32 timestamp,
+                          BundleLevel level, u8 **bundle_out, u32 *out_size,
+                          char *save_hash_out);
 
 // Parse a binary bundle into archive files.
-// Supports both v1 (uncompressed) and v2 (compressed) formats.
+// Supports v1 (uncompressed), v2 (compressed) and v3 (per-file codec)
+// bundles; v3 file hashes are checked while decoding.
 // Returns number of files parsed, fills files array.
-// If bundle is compressed, *out_decompressed is set to malloc'd buffer
-// that contains decompressed data - caller must free it.
-// If bundle is uncompressed, *out_decompressed is NULL and file data
-// points into bundle_data.
+// If any file had to be inflated, *out_decompressed is set to a malloc'd
+// buffer holding the inflated data - caller must free it. Otherwise it is
+// NULL. Files that weren't compressed (all of a v1 bundle, stored files
+// of a v3 one) point straight into bundle_data, without a copy.
 // Returns -1 on error.
 int bundle_parse(const u8 *bundle_data, u32 bundle_size,
                  u64 *out_title_id, u32 *out_timestamp,
                  ArchiveFile *files, int max_files,
                  u8 **out_decompressed);
 
+// --- Random access to v3 bundles ---
+
+// Where one file of a v3 bundle lies. The table gives every file's
+// encoded size, so each file's data can be located from the header and
+// table alone and decoded (or fetched with an HTTP Range request) on its own.
+typedef struct {
+    const char *path;  // Points into the table; not null-terminated
+    u16 path_len;
+    u32 size;
+    const u8 *sha256;  // Points into the table
+    u8 codec;
+    u32 encoded_size;
+    u32 offset;        // Of the encoded data, from the start of the bundle
+} BundleEntry;
+
+#define BUNDLE_INDEX_SHORT -2
+
+// Read a v3 bundle's file table into entries. Only the header and table
+// need to be present: data may be just a prefix of the bundle. *out_size,
+// if non-NULL, gets the full bundle size the table implies.
+// Returns the number of files, -1 if the bundle is malformed, isn't v3 or
+// has more than max_entries files, or BUNDLE_INDEX_SHORT if data ends
+// inside the table (fetch more of it and try again).
+int bundle_index(const u8 *data, u32 data_size, BundleEntry *entries,
+                 int max_entries, u32 *out_size);
+
+// Decode one file from its encoded data (entry->encoded_size bytes at
+// frame) and check its hash. A stored file's out->data points into frame;
+// a zlib file is inflated into dest, which has room for entry->size
+// bytes. The path is copied to out->path. Returns false on bad data.
+bool bundle_decode_file(const BundleEntry *entry, const u8 *frame, u8 *dest,
+                        ArchiveFile *out);
+
+// Incremental decoder for a bundle arriving in pieces (e.g. straight from
+// the network). v2 payloads and v3 files are decoded as data arrives into
+// one buffer sized from the header, and each file's SHA-256 from the file
+// table is checked as soon as the file is complete.
+typedef struct BundleStream BundleStream;
+
+// Start decoding. Bundles whose payload exceeds max_payload are rejected.
+// Returns NULL if out of memory.
+BundleStream *bundle_stream_begin(u32 max_payload);
+
+// Feed the next piece of the bundle. Returns false once the data is known
+// to be bad (malformed, too large, or a file hash mismatch).
+bool bundle_stream_feed(BundleStream *s, const u8 *data, u32 len);
+
+// Discard everything fed so far, to start over with the same bundle.
+void bundle_stream_reset(BundleStream *s);
+
+// Finish decoding and free the decoder. Returns the save as a malloc'd
+// uncompressed (v1) bundle for bundle_parse, or NULL if the bundle was
+// bad or incomplete.
+u8 *bundle_stream_finish(BundleStream *s, u32 *out_size);
+
 // Compute SHA-256 hash of all save data (for sync comparison).
 // Hashes the concatenation of all file contents in order.
 void bundle_compute_save_hash(const ArchiveFile *files, int file_count,
                               char *hex_out); // 65 bytes: 64 hex + null
 
+// Same hash as bundle_compute_save_hash, streamed from a title's save
+// archive. Returns number of files (size_out gets their total size), or -1.
+int bundle_hash_archive(u64 title_id, FS_MediaType media_type,
+                        char *hex_out, u32 *size_out);
+
 #endif // BUNDLE_H
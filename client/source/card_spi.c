@@ -27,10 +27,40 @@
 // Max bytes to read/write per SPI transaction
 #define SPI_CHUNK_SIZE     256
 
+// Reads continue across addresses on every chip (within the 64KB half
+// selected by the command byte on 128K EEPROMs, the 256B half on 512B ones),
+// so one command can cover many pages. Capped so progress stays live.
+#define SPI_READ_CHUNK     (64 * 1024)
+
+// EEPROM/FRAM span read per command when comparing, and per progress step
+// when writing; pages inside are still written at the chip's page size
+#define EEPROM_SPAN        4096
+
+// WIP polling backoff: the first poll follows the usual busy time of that
+// kind of write, then the interval doubles from MIN to MAX
+#define WIP_POLL_MIN_NS    20000LL    // 20us
+#define WIP_POLL_MAX_NS    1000000LL  // 1ms
+
 static u8 s_transfer_opt;
 static u64 s_wait_op;
 static bool s_initialized = false;
 
+// Usual busy time of each kind of write, learned as they complete
+static u64 s_wip_program_ns;  // Flash page program
+static u64 s_wip_erase_ns;    // Flash sector erase
+static u64 s_wip_eeprom_ns;   // EEPROM/FRAM page write
+
+// Progress of a whole-save transfer
+typedef struct {
+    CardSpiProgressCb cb;
+    void *ctx;
+    u32 total;
+} SpiProgress;
+
+static void report(const SpiProgress *p, u32 done) {
+    if (p && p->cb) p->cb(p->ctx, done, p->total);
+}
+
 bool card_spi_init(void) {
     if (s_initialized) return true;
     Result res = pxiDevInit();
@@ -91,15 +121,29 @@ static Result spi_write_disable(void) {
     return spi_cmd(&cmd, 1, NULL, 0, NULL, 0);
 }
 
-// Wait for WIP (Write In Progress) to clear, up to timeout_ms
-static bool spi_wait_wip(int timeout_ms) {
-    for (int i = 0; i < timeout_ms; i++) {
+// Wait for WIP (Write In Progress) to clear, up to timeout_ms. Sleeps most
+// of the usual busy time (*typical_ns) before the first poll, then backs off
+// from 20us, so fast chips aren't held to a 1ms tick and slow erases don't
+// flood the bus with status reads. Updates *typical_ns on success.
+static bool spi_wait_wip(int timeout_ms, u64 *typical_ns) {
+    u64 start = svcGetSystemTick();
+    u64 timeout_ticks = (u64)timeout_ms * (SYSCLOCK_ARM11 / 1000);
+    if (*typical_ns) svcSleepThread((s64)(*typical_ns * 3 / 4));
+
+    s64 step = WIP_POLL_MIN_NS;
+    for (;;) {
         u8 sr;
         if (R_FAILED(spi_read_status(&sr))) return false;
-        if (!(sr & SR_WIP)) return true;
-        svcSleepThread(1000000LL); // 1ms
+        u64 elapsed = svcGetSystemTick() - start;
+        if (!(sr & SR_WIP)) {
+            u64 ns = elapsed * 1000000000ULL / SYSCLOCK_ARM11;
+            *typical_ns = *typical_ns ? (*typical_ns * 3 + ns) / 4 : ns;
+            return true;
+        }
+        if (elapsed > timeout_ticks) return false;
+        svcSleepThread(step);
+        if (step < WIP_POLL_MAX_NS) step *= 2;
     }
-    return false;
 }
 
 // --- Flash read/write (24-bit address) ---
@@ -115,7 +159,7 @@ static bool flash_write_page(u32 addr, const u8 *data, u32 len) {
     u8 cmd[4] = {CMD_WRITE, (addr >> 16) & 0xFF, (addr >> 8) & 0xFF, addr & 0xFF};
     Result res = spi_cmd(cmd, 4, (u8 *)data, len, NULL, 0);
     if (R_FAILED(res)) return false;
-    return spi_wait_wip(50);
+    return spi_wait_wip(50, &s_wip_program_ns);
 }
 
 static bool flash_erase_sector(u32 addr) {
@@ -123,7 +167,7 @@ static bool flash_erase_sector(u32 addr) {
     u8 cmd[4] = {CMD_SE, (addr >> 16) & 0xFF, (addr >> 8) & 0xFF, addr & 0xFF};
     Result res = spi_cmd(cmd, 4, NULL, 0, NULL, 0);
     if (R_FAILED(res)) return false;
-    return spi_wait_wip(3000); // Sector erase can take up to 3s
+    return spi_wait_wip(3000, &s_wip_erase_ns); // Sector erase can take up to 3s
 }
 
 // --- EEPROM read/write (16-bit address, for 8K-64K) ---
@@ -146,7 +190,7 @@ static bool eeprom_write_2addr(u32 addr, const u8 *data, u32 len, u32 page_size)
         u8 cmd[3] = {CMD_WRITE, (a >> 8) & 0xFF, a & 0xFF};
         Result res = spi_cmd(cmd, 3, (u8 *)(data + offset), chunk, NULL, 0);
         if (R_FAILED(res)) return false;
-        if (!spi_wait_wip(50)) return false;
+        if (!spi_wait_wip(50, &s_wip_eeprom_ns)) return false;
         offset += chunk;
     }
     return true;
@@ -173,7 +217,7 @@ static bool eeprom_write_128k(u32 addr, const u8 *data, u32 len) {
         u8 cmd[3] = {cmd_byte, (a >> 8) & 0xFF, a & 0xFF};
         Result res = spi_cmd(cmd, 3, (u8 *)(data + offset), chunk, NULL, 0);
         if (R_FAILED(res)) return false;
-        if (!spi_wait_wip(50)) return false;
+        if (!spi_wait_wip(50, &s_wip_eeprom_ns)) return false;
         offset += chunk;
     }
     return true;
@@ -198,7 +242,7 @@ static bool eeprom_write_512b(u32 addr, const u8 *data, u32 len) {
         u8 cmd[2] = {CMD_WRITE | (((a >> 8) & 1) << 3), a & 0xFF};
         Result res = spi_cmd(cmd, 2, (u8 *)(data + offset), chunk, NULL, 0);
         if (R_FAILED(res)) return false;
-        if (!spi_wait_wip(50)) return false;
+        if (!spi_wait_wip(50, &s_wip_eeprom_ns)) return false;
         offset += chunk;
     }
     return true;
@@ -296,89 +340,228 @@ u32 card_spi_get_size(CardSaveType type) {
     }
 }
 
-bool card_spi_read_save(CardSaveType type, u8 *buf, u32 size) {
-    if (!s_initialized || type == SAVE_TYPE_UNKNOWN || !buf || size == 0)
-        return false;
+static bool is_flash(CardSaveType type) {
+    return type == SAVE_TYPE_FLASH_256K || type == SAVE_TYPE_FLASH_512K ||
+           type == SAVE_TYPE_FLASH_1M || type == SAVE_TYPE_FLASH_8M;
+}
 
-    u32 save_size = card_spi_get_size(type);
-    if (size < save_size) return false;
+// Span a single read command can't cross: the address bit carried in the
+// command byte on 512B and 128K EEPROMs. 0 means none.
+static u32 read_boundary(CardSaveType type) {
+    switch (type) {
+        case SAVE_TYPE_EEPROM_512B:  return 0x100;
+        case SAVE_TYPE_EEPROM_128K:  return 0x10000;
+        default:                     return 0;
+    }
+}
 
+// Read len bytes starting at addr, in commands of up to SPI_READ_CHUNK
+// bytes. Reports progress as base + bytes read, if given.
+static bool read_range(CardSaveType type, u32 addr, u8 *buf, u32 len,
+                       const SpiProgress *progress, u32 base) {
+    u32 boundary = read_boundary(type);
     u32 offset = 0;
-    while (offset < save_size) {
-        u32 chunk = SPI_CHUNK_SIZE;
-        if (chunk > save_size - offset) chunk = save_size - offset;
+    while (offset < len) {
+        u32 a = addr + offset;
+        u32 chunk = SPI_READ_CHUNK;
+        if (chunk > len - offset) chunk = len - offset;
+        if (boundary && chunk > boundary - (a % boundary)) chunk = boundary - (a % boundary);
 
         Result res;
         switch (type) {
             case SAVE_TYPE_EEPROM_512B:
-                res = eeprom_read_512b(offset, buf + offset, chunk);
+                res = eeprom_read_512b(a, buf + offset, chunk);
                 break;
             case SAVE_TYPE_EEPROM_8K:
             case SAVE_TYPE_EEPROM_64K:
             case SAVE_TYPE_FRAM_32K:
-                res = eeprom_read_2addr(offset, buf + offset, chunk);
+                res = eeprom_read_2addr(a, buf + offset, chunk);
                 break;
             case SAVE_TYPE_EEPROM_128K:
-                res = eeprom_read_128k(offset, buf + offset, chunk);
+                res = eeprom_read_128k(a, buf + offset, chunk);
                 break;
             case SAVE_TYPE_FLASH_256K:
             case SAVE_TYPE_FLASH_512K:
             case SAVE_TYPE_FLASH_1M:
             case SAVE_TYPE_FLASH_8M:
-                res = flash_read(offset, buf + offset, chunk);
+                res = flash_read(a, buf + offset, chunk);
                 break;
             default:
                 return false;
         }
         if (R_FAILED(res)) return false;
         offset += chunk;
+        report(progress, base + offset);
+    }
+    return true;
+}
+
+bool card_spi_read_save(CardSaveType type, u8 *buf, u32 size,
+                        CardSpiProgressCb progress, void *ctx) {
+    if (!s_initialized || type == SAVE_TYPE_UNKNOWN || !buf || size == 0)
+        return false;
+
+    u32 save_size = card_spi_get_size(type);
+    if (size < save_size) return false;
+
+    SpiProgress p = {progress, ctx, save_size};
+    return read_range(type, 0, buf, save_size, &p, 0);
+}
+
+// Page size used to compare and rewrite EEPROM/FRAM saves
+static u32 eeprom_page_size(CardSaveType type) {
+    switch (type) {
+        case SAVE_TYPE_EEPROM_512B:  return 16;
+        case SAVE_TYPE_EEPROM_8K:    return EEPROM_PAGE_8K;
+        case SAVE_TYPE_EEPROM_64K:   return EEPROM_PAGE_64K;
+        case SAVE_TYPE_EEPROM_128K:  return EEPROM_PAGE_128K;
+        default:                     return SPI_CHUNK_SIZE; // FRAM: no pages
+    }
+}
+
+// Write one EEPROM/FRAM page-aligned range
+static bool eeprom_write_range(CardSaveType type, u32 addr, const u8 *data, u32 len) {
+    switch (type) {
+        case SAVE_TYPE_EEPROM_512B:  return eeprom_write_512b(addr, data, len);
+        case SAVE_TYPE_EEPROM_128K:  return eeprom_write_128k(addr, data, len);
+        case SAVE_TYPE_EEPROM_8K:
+        case SAVE_TYPE_EEPROM_64K:
+            return eeprom_write_2addr(addr, data, len, eeprom_page_size(type));
+        case SAVE_TYPE_FRAM_32K:
+            // No pages and no write cycle: one transaction per range
+            return eeprom_write_2addr(addr, data, len, len);
+        default:
+            return false;
     }
+}
 
+// Write a page-aligned EEPROM/FRAM range, reporting progress per span
+static bool eeprom_write_reported(CardSaveType type, const u8 *buf, u32 size,
+                                  const SpiProgress *progress) {
+    for (u32 addr = 0; addr < size; addr += EEPROM_SPAN) {
+        u32 len = EEPROM_SPAN;
+        if (len > size - addr) len = size - addr;
+        if (!eeprom_write_range(type, addr, buf + addr, len)) return false;
+        report(progress, addr + len);
+    }
     return true;
 }
 
-bool card_spi_write_save(CardSaveType type, const u8 *buf, u32 size) {
+bool card_spi_write_save(CardSaveType type, const u8 *buf, u32 size,
+                         CardSpiProgressCb progress, void *ctx) {
     if (!s_initialized || type == SAVE_TYPE_UNKNOWN || !buf || size == 0)
         return false;
 
     u32 save_size = card_spi_get_size(type);
     if (size > save_size) size = save_size;
+    SpiProgress p = {progress, ctx, size};
 
     switch (type) {
         case SAVE_TYPE_FLASH_256K:
         case SAVE_TYPE_FLASH_512K:
         case SAVE_TYPE_FLASH_1M:
-        case SAVE_TYPE_FLASH_8M: {
-            // Flash requires sector erase before write
-            for (u32 addr = 0; addr < size; addr += FLASH_SECTOR_SIZE) {
-                if (!flash_erase_sector(addr)) return false;
-            }
-            // Write in pages
-            for (u32 addr = 0; addr < size; addr += FLASH_PAGE_SIZE) {
-                u32 chunk = FLASH_PAGE_SIZE;
-                if (chunk > size - addr) chunk = size - addr;
-                if (!flash_write_page(addr, buf + addr, chunk)) return false;
+        case SAVE_TYPE_FLASH_8M:
+            // Flash requires sector erase before write; go sector by sector
+            for (u32 sector = 0; sector < size; sector += FLASH_SECTOR_SIZE) {
+                if (!flash_erase_sector(sector)) return false;
+                u32 end = sector + FLASH_SECTOR_SIZE;
+                if (end > size) end = size;
+                for (u32 addr = sector; addr < end; addr += FLASH_PAGE_SIZE) {
+                    u32 chunk = FLASH_PAGE_SIZE;
+                    if (chunk > end - addr) chunk = end - addr;
+                    if (!flash_write_page(addr, buf + addr, chunk)) return false;
+                }
+                report(&p, end);
             }
             return true;
-        }
 
         case SAVE_TYPE_EEPROM_8K:
-            return eeprom_write_2addr(0, buf, size, EEPROM_PAGE_8K);
-
         case SAVE_TYPE_EEPROM_64K:
-            return eeprom_write_2addr(0, buf, size, EEPROM_PAGE_64K);
-
         case SAVE_TYPE_EEPROM_128K:
-            return eeprom_write_128k(0, buf, size);
-
         case SAVE_TYPE_EEPROM_512B:
-            return eeprom_write_512b(0, buf, size);
-
         case SAVE_TYPE_FRAM_32K:
-            // FRAM has no page limit and no erase needed, but write in chunks
-            return eeprom_write_2addr(0, buf, size, size); // One big "page"
+            return eeprom_write_reported(type, buf, size, &p);
 
         default:
             return false;
     }
 }
+
+// EEPROM/FRAM: rewrite the pages of a span that differ from its current
+// contents in cur, reading back each one.
+static bool eeprom_write_span_diff(CardSaveType type, u32 addr, const u8 *data,
+                                   u32 len, u8 *cur, u32 *written) {
+    u32 page = eeprom_page_size(type);
+    for (u32 off = 0; off < len; off += page) {
+        u32 chunk = page;
+        if (chunk > len - off) chunk = len - off;
+        if (memcmp(cur + off, data + off, chunk) == 0) continue;
+        if (!eeprom_write_range(type, addr + off, data + off, chunk)) return false;
+        if (!read_range(type, addr + off, cur + off, chunk, NULL, 0)) return false;
+        if (memcmp(cur + off, data + off, chunk) != 0) return false;
+        *written += chunk;
+    }
+    return true;
+}
+
+// Flash: rewrite one sector, given its current contents in cur (clobbered).
+// Erases only if some bit has to go from 0 to 1 - programming alone can
+// clear bits - and then programs only the pages that still differ.
+static bool flash_write_sector_diff(CardSaveType type, u32 addr, const u8 *data,
+                                    u32 len, u8 *cur, u32 *written) {
+    bool need_erase = false;
+    for (u32 i = 0; i < len; i++) {
+        if ((cur[i] & data[i]) != data[i]) { need_erase = true; break; }
+    }
+    if (need_erase) {
+        if (!flash_erase_sector(addr)) return false;
+        memset(cur, 0xFF, len);
+    }
+
+    for (u32 off = 0; off < len; off += FLASH_PAGE_SIZE) {
+        u32 chunk = FLASH_PAGE_SIZE;
+        if (chunk > len - off) chunk = len - off;
+        if (memcmp(cur + off, data + off, chunk) == 0) continue;
+        if (!flash_write_page(addr + off, data + off, chunk)) return false;
+        *written += chunk;
+    }
+
+    // Verify the rewritten sector
+    if (!read_range(type, addr, cur, len, NULL, 0)) return false;
+    return memcmp(cur, data, len) == 0;
+}
+
+bool card_spi_write_save_diff(CardSaveType type, const u8 *buf, u32 size,
+                              u32 *bytes_written, CardSpiProgressCb progress, void *ctx) {
+    u32 written = 0;
+    if (bytes_written) *bytes_written = 0;
+    if (!s_initialized || type == SAVE_TYPE_UNKNOWN || !buf || size == 0)
+        return false;
+
+    u32 save_size = card_spi_get_size(type);
+    if (size > save_size) size = save_size;
+    SpiProgress p = {progress, ctx, size};
+
+    // Compare in erase units on flash, in spans of pages on EEPROM/FRAM
+    u32 unit = is_flash(type) ? FLASH_SECTOR_SIZE : EEPROM_SPAN;
+    u8 *cur = (u8 *)malloc(unit);
+    if (!cur) return false;
+
+    bool ok = true;
+    for (u32 addr = 0; addr < size && ok; addr += unit) {
+        u32 len = unit;
+        if (len > size - addr) len = size - addr;
+
+        if (!read_range(type, addr, cur, len, NULL, 0)) { ok = false; break; }
+        if (memcmp(cur, buf + addr, len) != 0) {
+            ok = is_flash(type)
+                ? flash_write_sector_diff(type, addr, buf + addr, len, cur, &written)
+                : eeprom_write_span_diff(type, addr, buf + addr, len, cur, &written);
+        }
+        report(&p, addr + len);
+    }
+    free(cur);
+
+    if (bytes_written) *bytes_written = written;
+    return ok;
+}
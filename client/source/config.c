@@ -1,4 +1,5 @@
 #include "config.h"
+#include "transfer.h"
 #include <sys/stat.h>
 
 // Generate a random 16-char hex ID using 3DS random number generator
@@ -71,6 +72,7 @@ static void skip_bom(char *str) {
 
 bool config_load(AppConfig *config, char *error_out, int error_size) {
     memset(config, 0, sizeof(AppConfig));
+    config->transfer_window = TRANSFER_WINDOW_DEFAULT;
 
     FILE *f = fopen(CONFIG_PATH, "r");
     if (!f) {
@@ -108,6 +110,17 @@ bool config_load(AppConfig *config, char *error_out, int error_size) {
             strncpy(config->api_key, val, MAX_API_KEY_LEN - 1);
         } else if (strcmp(key, "nds_dir") == 0) {
             strncpy(config->nds_dir, val, MAX_PATH_LEN - 1);
+        } else if (strcmp(key, "transfer_window") == 0) {
+            int window = atoi(val);
+            if (window < 1) window = 1;
+            if (window > TRANSFER_WINDOW_MAX) window = TRANSFER_WINDOW_MAX;
+            config->transfer_window = window;
+        } else if (strcmp(key, "timing_log") == 0) {
+            config->timing_log = (atoi(val) != 0);
+        } else if (strcmp(key, "compression") == 0) {
+            config->high_compression = (strcmp(val, "high") == 0);
+        } else if (strcmp(key, "keep_update_cia") == 0) {
+            config->keep_update_cia = (atoi(val) != 0);
         }
     }
 
@@ -150,6 +163,14 @@ bool config_save(const AppConfig *config) {
     fprintf(f, "api_key=%s\n", config->api_key);
     if (config->nds_dir[0])
         fprintf(f, "nds_dir=%s\n", config->nds_dir);
+    if (config->transfer_window != TRANSFER_WINDOW_DEFAULT)
+        fprintf(f, "transfer_window=%d\n", config->transfer_window);
+    if (config->timing_log)
+        fprintf(f, "timing_log=1\n");
+    if (config->high_compression)
+        fprintf(f, "compression=high\n");
+    if (config->keep_update_cia)
+        fprintf(f, "keep_update_cia=1\n");
 
     fclose(f);
     return true;
@@ -0,0 +1,308 @@
+#include "delta.h"
+#include "sha256.h"
+#include <zlib.h>
+
+#define DELTA_HEADER_SIZE (4 + 4 + 8 + 4 + 4 + 4 + 32 + 4)
+#define BLOCK_LIST_HEADER_SIZE (4 + 4 + 4 + 4 + 32)
+
+// Write a u16 little-endian
+static void write_u16_le(u8 *buf, u16 val) {
+    buf[0] = (u8)(val);
+    buf[1] = (u8)(val >> 8);
+}
+
+// Write a u32 little-endian
+static void write_u32_le(u8 *buf, u32 val) {
+    buf[0] = (u8)(val);
+    buf[1] = (u8)(val >> 8);
+    buf[2] = (u8)(val >> 16);
+    buf[3] = (u8)(val >> 24);
+}
+
+// Write a u64 big-endian
+static void write_u64_be(u8 *buf, u64 val) {
+    for (int i = 0; i < 8; i++)
+        buf[i] = (u8)(val >> (56 - i * 8));
+}
+
+// Read a u16 little-endian
+static u16 read_u16_le(const u8 *buf) {
+    return (u16)buf[0] | ((u16)buf[1] << 8);
+}
+
+// Read a u32 little-endian
+static u32 read_u32_le(const u8 *buf) {
+    return (u32)buf[0] | ((u32)buf[1] << 8) |
+           ((u32)buf[2] << 16) | ((u32)buf[3] << 24);
+}
+
+// Read a u64 big-endian
+static u64 read_u64_be(const u8 *buf) {
+    u64 val = 0;
+    for (int i = 0; i < 8; i++)
+        val = (val << 8) | buf[i];
+    return val;
+}
+
+// One file entry of a server block list (points into the list buffer)
+typedef struct {
+    const u8 *path;
+    u16 path_len;
+    u32 size;
+    u32 block_count;
+    const u8 *hashes;  // block_count * 32 bytes
+} BlockListFile;
+
+// Find the block list entry for a path, or NULL
+static const BlockListFile *find_block_file(const BlockListFile *entries, u32 count,
+                                            const char *path) {
+    u16 len = (u16)strlen(path);
+    for (u32 i = 0; i < count; i++) {
+        if (entries[i].path_len == len && memcmp(entries[i].path, path, len) == 0)
+            return &entries[i];
+    }
+    return NULL;
+}
+
+u8 *delta_create(u64 title_id, u32 timestamp,
+                 const ArchiveFile *files, int file_count,
+                 const u8 *block_list, u32 block_list_size,
+                 u32 max_changed, u32 *out_size, u32 *out_changed) {
+    *out_changed = 0;
+
+    // --- Parse the server's block list ---
+    if (block_list_size < BLOCK_LIST_HEADER_SIZE) return NULL;
+    if (memcmp(block_list, BLOCK_LIST_MAGIC, 4) != 0) return NULL;
+    if (read_u32_le(block_list + 4) != DELTA_VERSION) return NULL;
+
+    u32 block_size = read_u32_le(block_list + 8);
+    u32 list_count = read_u32_le(block_list + 12);
+    const u8 *base_hash = block_list + 16;
+    if (block_size == 0 || list_count > block_list_size / 10) return NULL;
+
+    BlockListFile *entries = (BlockListFile *)malloc((list_count + 1) * sizeof(BlockListFile));
+    if (!entries) return NULL;
+
+    u32 offset = BLOCK_LIST_HEADER_SIZE;
+    for (u32 i = 0; i < list_count; i++) {
+        if (offset + 2 > block_list_size) { free(entries); return NULL; }
+        entries[i].path_len = read_u16_le(block_list + offset); offset += 2;
+        entries[i].path = block_list + offset;
+        offset += entries[i].path_len;
+        if (offset + 8 > block_list_size) { free(entries); return NULL; }
+        entries[i].size = read_u32_le(block_list + offset); offset += 4;
+        entries[i].block_count = read_u32_le(block_list + offset); offset += 4;
+        entries[i].hashes = block_list + offset;
+        if (entries[i].block_count > (block_list_size - offset) / 32) {
+            free(entries);
+            return NULL;
+        }
+        offset += entries[i].block_count * 32;
+    }
+
+    // --- Find changed blocks (one hashing pass over the local data) ---
+    u32 total_blocks = 0;
+    for (int i = 0; i < file_count; i++)
+        total_blocks += (files[i].size + block_size - 1) / block_size;
+
+    u32 *changed = (u32 *)malloc((total_blocks + 1) * sizeof(u32));
+    u32 *changed_per_file = (u32 *)malloc((file_count + 1) * sizeof(u32));
+    u8 (*file_hashes)[32] = (u8 (*)[32])malloc((file_count + 1) * 32);
+    if (!changed || !changed_per_file || !file_hashes) {
+        free(changed); free(changed_per_file); free(file_hashes);
+        free(entries);
+        return NULL;
+    }
+
+    u32 changed_count = 0;
+    u32 changed_bytes = 0;
+    u32 table_size = 0;
+    for (int i = 0; i < file_count; i++) {
+        const BlockListFile *base = find_block_file(entries, list_count, files[i].path);
+        u32 blocks = (files[i].size + block_size - 1) / block_size;
+        u32 before = changed_count;
+
+        SHA256_CTX file_ctx;
+        sha256_init(&file_ctx);
+        for (u32 b = 0; b < blocks; b++) {
+            u32 start = b * block_size;
+            u32 len = files[i].size - start;
+            if (len > block_size) len = block_size;
+
+            sha256_update(&file_ctx, files[i].data + start, len);
+
+            u8 hash[32];
+            sha256(files[i].data + start, len, hash);
+            if (!base || b >= base->block_count ||
+                memcmp(base->hashes + b * 32, hash, 32) != 0) {
+                changed[changed_count++] = b;
+                changed_bytes += len;
+            }
+        }
+        sha256_final(&file_ctx, file_hashes[i]);
+
+        changed_per_file[i] = changed_count - before;
+        table_size += 2 + strlen(files[i].path) + 4 + 32 + 4 + changed_per_file[i] * 4;
+    }
+    free(entries);
+
+    *out_changed = changed_bytes;
+    if (changed_bytes > max_changed) {
+        free(changed); free(changed_per_file); free(file_hashes);
+        return NULL;
+    }
+
+    // --- Build payload: file table, then changed block data ---
+    u32 payload_size = table_size + changed_bytes;
+    u8 *payload = (u8 *)malloc(payload_size ? payload_size : 1);
+    if (!payload) {
+        free(changed); free(changed_per_file); free(file_hashes);
+        return NULL;
+    }
+
+    offset = 0;
+    u32 ci = 0;
+    for (int i = 0; i < file_count; i++) {
+        u16 path_len = (u16)strlen(files[i].path);
+        write_u16_le(payload + offset, path_len); offset += 2;
+        memcpy(payload + offset, files[i].path, path_len); offset += path_len;
+        write_u32_le(payload + offset, files[i].size); offset += 4;
+        memcpy(payload + offset, file_hashes[i], 32); offset += 32;
+        write_u32_le(payload + offset, changed_per_file[i]); offset += 4;
+        for (u32 c = 0; c < changed_per_file[i]; c++) {
+            write_u32_le(payload + offset, changed[ci + c]); offset += 4;
+        }
+        ci += changed_per_file[i];
+    }
+
+    ci = 0;
+    for (int i = 0; i < file_count; i++) {
+        for (u32 c = 0; c < changed_per_file[i]; c++, ci++) {
+            u32 start = changed[ci] * block_size;
+            u32 len = files[i].size - start;
+            if (len > block_size) len = block_size;
+            memcpy(payload + offset, files[i].data + start, len);
+            offset += len;
+        }
+    }
+    free(changed); free(changed_per_file); free(file_hashes);
+
+    // --- Header + compressed payload ---
+    uLongf compressed_size = compressBound(payload_size);
+    u8 *buf = (u8 *)malloc(DELTA_HEADER_SIZE + compressed_size);
+    if (!buf) { free(payload); return NULL; }
+
+    int zret = compress2(buf + DELTA_HEADER_SIZE, &compressed_size, payload, payload_size, 6);
+    free(payload);
+    if (zret != Z_OK) { free(buf); return NULL; }
+
+    offset = 0;
+    memcpy(buf + offset, DELTA_MAGIC, 4); offset += 4;
+    write_u32_le(buf + offset, DELTA_VERSION); offset += 4;
+    write_u64_be(buf + offset, title_id); offset += 8;
+    write_u32_le(buf + offset, timestamp); offset += 4;
+    write_u32_le(buf + offset, (u32)file_count); offset += 4;
+    write_u32_le(buf + offset, block_size); offset += 4;
+    memcpy(buf + offset, base_hash, 32); offset += 32;
+    write_u32_le(buf + offset, payload_size); offset += 4;
+
+    *out_size = DELTA_HEADER_SIZE + (u32)compressed_size;
+    return buf;
+}
+
+int delta_apply(const u8 *delta, u32 delta_size,
+                const ArchiveFile *base, int base_count,
+                ArchiveFile *out_files, int max_files) {
+    if (delta_size < DELTA_HEADER_SIZE) return -1;
+    if (memcmp(delta, DELTA_MAGIC, 4) != 0) return -1;
+    if (read_u32_le(delta + 4) != DELTA_VERSION) return -1;
+
+    (void)read_u64_be(delta + 8); // title ID - caller already knows it
+    u32 file_count = read_u32_le(delta + 20);
+    u32 block_size = read_u32_le(delta + 24);
+    u32 payload_size = read_u32_le(delta + 60);
+    if (block_size == 0 || (int)file_count > max_files) return -1;
+
+    u8 *payload = (u8 *)malloc(payload_size ? payload_size : 1);
+    if (!payload) return -1;
+
+    uLongf dest_len = payload_size;
+    int zret = uncompress(payload, &dest_len, delta + DELTA_HEADER_SIZE,
+                          delta_size - DELTA_HEADER_SIZE);
+    if (zret != Z_OK || dest_len != payload_size) {
+        free(payload);
+        return -1;
+    }
+
+    // First pass: file table. Block data follows the whole table.
+    u32 offset = 0;
+    u32 *index_offsets = (u32 *)malloc((file_count + 1) * sizeof(u32));
+    u32 *index_counts = (u32 *)malloc((file_count + 1) * sizeof(u32));
+    u8 (*hashes)[32] = (u8 (*)[32])malloc((file_count + 1) * 32);
+    if (!index_offsets || !index_counts || !hashes) {
+        free(index_offsets); free(index_counts); free(hashes);
+        free(payload);
+        return -1;
+    }
+
+    bool ok = true;
+    u32 i;
+    for (i = 0; i < file_count && ok; i++) {
+        if (offset + 2 > payload_size) { ok = false; break; }
+        u16 path_len = read_u16_le(payload + offset); offset += 2;
+        if (path_len >= MAX_PATH_LEN || offset + path_len + 40 > payload_size) { ok = false; break; }
+        memcpy(out_files[i].path, payload + offset, path_len);
+        out_files[i].path[path_len] = '\0';
+        offset += path_len;
+
+        out_files[i].size = read_u32_le(payload + offset); offset += 4;
+        memcpy(hashes[i], payload + offset, 32); offset += 32;
+        index_counts[i] = read_u32_le(payload + offset); offset += 4;
+        index_offsets[i] = offset;
+        if (index_counts[i] > (payload_size - offset) / 4) { ok = false; break; }
+        offset += index_counts[i] * 4;
+        out_files[i].data = NULL;
+        out_files[i].pooled = false;
+    }
+    u32 parsed = i;
+
+    // Second pass: rebuild each file from its base plus changed blocks
+    for (i = 0; i < file_count && ok; i++) {
+        ArchiveFile *f = &out_files[i];
+        f->data = (u8 *)malloc(f->size ? f->size : 1);
+        if (!f->data) { ok = false; break; }
+
+        const ArchiveFile *src = NULL;
+        for (int b = 0; b < base_count; b++) {
+            if (strcmp(base[b].path, f->path) == 0) { src = &base[b]; break; }
+        }
+        u32 copy = 0;
+        if (src) copy = src->size < f->size ? src->size : f->size;
+        if (copy) memcpy(f->data, src->data, copy);
+        memset(f->data + copy, 0, f->size - copy);
+
+        for (u32 c = 0; c < index_counts[i]; c++) {
+            u32 idx = read_u32_le(payload + index_offsets[i] + c * 4);
+            u32 start = idx * block_size;
+            if (start >= f->size) { ok = false; break; }
+            u32 len = f->size - start;
+            if (len > block_size) len = block_size;
+            if (offset + len > payload_size) { ok = false; break; }
+            memcpy(f->data + start, payload + offset, len);
+            offset += len;
+        }
+
+        u8 hash[32];
+        sha256(f->data, f->size, hash);
+        if (memcmp(hash, hashes[i], 32) != 0) ok = false;
+    }
+
+    free(index_offsets); free(index_counts); free(hashes);
+    free(payload);
+
+    if (!ok) {
+        archive_free_files(out_files, parsed);
+        return -1;
+    }
+    return (int)file_count;
+}
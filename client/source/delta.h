@@ -0,0 +1,36 @@
+#ifndef DELTA_H
+#define DELTA_H
+
+#include "common.h"
+#include "archive.h"
+
+// Block-level delta transfers: only the fixed-size blocks that differ from
+// the other side's version are sent. See server/app/services/delta.py for
+// the block list ("3DBL") and delta ("3DDL") formats.
+
+#define DELTA_MAGIC       "3DDL"
+#define BLOCK_LIST_MAGIC  "3DBL"
+#define DELTA_VERSION     1
+
+// Saves smaller than this are always sent as full bundles
+#define DELTA_MIN_SAVE_SIZE 0x10000 // 64KB
+
+// Build a delta turning the version described by block_list (from the
+// server) into the local files. Fails (returns NULL) if the block list is
+// invalid or more than max_changed bytes of blocks differ.
+// *out_changed is set to the changed byte count either way.
+// Returns malloc'd delta (caller must free), sets out_size.
+u8 *delta_create(u64 title_id, u32 timestamp,
+                 const ArchiveFile *files, int file_count,
+                 const u8 *block_list, u32 block_list_size,
+                 u32 max_changed, u32 *out_size, u32 *out_changed);
+
+// Apply a delta (from the server) to the local base files.
+// Fills out_files with malloc'd data - caller must call archive_free_files().
+// Every rebuilt file is checked against its SHA-256.
+// Returns number of files, or -1 on error.
+int delta_apply(const u8 *delta, u32 delta_size,
+                const ArchiveFile *base, int base_count,
+                ArchiveFile *out_files, int max_files);
+
+#endif // DELTA_H
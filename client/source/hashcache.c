@@ -0,0 +1,169 @@
+#include "hashcache.h"
+#include "archive.h"
+
+#include <sys/stat.h>
+
+typedef struct {
+    u64 title_id;
+    u64 sig;
+    u32 size;
+    char hash[65];
+} HashCacheEntry;
+
+static HashCacheEntry *entries = NULL;
+static int entry_count = 0;
+static int entry_cap = 0;
+static bool loaded = false;
+static bool dirty = false;
+
+u64 hashcache_mix(u64 sig, const void *data, size_t len) {
+    const u8 *p = (const u8 *)data;
+    for (size_t i = 0; i < len; i++) {
+        sig ^= p[i];
+        sig *= 0x100000001B3ULL;
+    }
+    return sig;
+}
+
+static HashCacheEntry *new_entry(void) {
+    if (entry_count == entry_cap) {
+        int cap = entry_cap ? entry_cap * 2 : 64;
+        HashCacheEntry *grown = (HashCacheEntry *)realloc(entries, cap * sizeof(HashCacheEntry));
+        if (!grown) return NULL;
+        entries = grown;
+        entry_cap = cap;
+    }
+    return &entries[entry_count++];
+}
+
+static bool is_hex_hash(const char *s) {
+    for (int i = 0; i < 64; i++) {
+        char c = s[i];
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F')))
+            return false;
+    }
+    return s[64] == '\0';
+}
+
+// Load the cache file on first use.
+// Format: one "<title_id> <signature> <size> <hash>" line per title.
+static void hashcache_load(void) {
+    if (loaded) return;
+    loaded = true;
+    entry_count = 0;
+
+    FILE *f = fopen(HASHCACHE_PATH, "r");
+    if (!f) return;
+
+    char line[160];
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long long tid, sig;
+        unsigned long size;
+        char hash[65];
+        if (sscanf(line, "%16llx %16llx %lu %64s", &tid, &sig, &size, hash) != 4)
+            continue;
+        if (!is_hex_hash(hash)) continue;
+
+        HashCacheEntry *e = new_entry();
+        if (!e) break;
+        e->title_id = tid;
+        e->sig = sig;
+        e->size = (u32)size;
+        memcpy(e->hash, hash, 65);
+    }
+    fclose(f);
+}
+
+static HashCacheEntry *find_entry(u64 title_id) {
+    hashcache_load();
+    for (int i = 0; i < entry_count; i++) {
+        if (entries[i].title_id == title_id)
+            return &entries[i];
+    }
+    return NULL;
+}
+
+bool hashcache_signature(const TitleInfo *title, u64 *sig_out) {
+    // Cartridge saves are read over SPI and have no metadata to go on
+    if (title->media_type == MEDIATYPE_GAME_CARD) return false;
+
+    if (title->is_nds) {
+        struct stat st;
+        if (title->sav_path[0] == '\0' || stat(title->sav_path, &st) != 0)
+            return false;
+
+        u64 size = (u64)st.st_size;
+        u64 mtime = (u64)st.st_mtime;
+        u64 sig = HASHCACHE_SIG_INIT;
+        sig = hashcache_mix(sig, &size, sizeof(size));
+        sig = hashcache_mix(sig, &mtime, sizeof(mtime));
+        *sig_out = sig;
+        return true;
+    }
+
+    return archive_signature(title->title_id, title->media_type, sig_out);
+}
+
+bool hashcache_lookup(const TitleInfo *title, u64 sig,
+                      char *hash_out, u32 *size_out) {
+    HashCacheEntry *e = find_entry(title->title_id);
+    if (!e || e->sig != sig) return false;
+
+    memcpy(hash_out, e->hash, 65);
+    *size_out = e->size;
+    return true;
+}
+
+void hashcache_store(const TitleInfo *title, u64 sig,
+                     const char *hash, u32 size) {
+    HashCacheEntry *e = find_entry(title->title_id);
+    if (!e) {
+        e = new_entry();
+        if (!e) return;
+        e->title_id = title->title_id;
+    } else if (e->sig == sig && e->size == size && strcmp(e->hash, hash) == 0) {
+        return;
+    }
+
+    e->sig = sig;
+    e->size = size;
+    strncpy(e->hash, hash, 64);
+    e->hash[64] = '\0';
+    dirty = true;
+}
+
+void hashcache_invalidate(const TitleInfo *title) {
+    HashCacheEntry *e = find_entry(title->title_id);
+    if (!e) return;
+
+    *e = entries[--entry_count];
+    dirty = true;
+}
+
+void hashcache_flush(void) {
+    if (!dirty) return;
+
+    // Ensure directories exist
+    mkdir("sdmc:/3ds", 0777);
+    mkdir("sdmc:/3ds/3dssync", 0777);
+    mkdir(STATE_DIR, 0777);
+
+    FILE *f = fopen(HASHCACHE_PATH, "w");
+    if (!f) return;
+
+    for (int i = 0; i < entry_count; i++) {
+        fprintf(f, "%016llX %016llX %lu %s\n",
+            (unsigned long long)entries[i].title_id,
+            (unsigned long long)entries[i].sig,
+            (unsigned long)entries[i].size, entries[i].hash);
+    }
+    fclose(f);
+    dirty = false;
+}
+
+void hashcache_clear(void) {
+    entry_count = 0;
+    loaded = true;
+    dirty = false;
+    remove(HASHCACHE_PATH);
+}
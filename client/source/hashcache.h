@@ -0,0 +1,41 @@
+#ifndef HASHCACHE_H
+#define HASHCACHE_H
+
+#include "common.h"
+
+// Persistent save-hash cache, stored next to the per-title sync state files.
+// Each entry maps a title to the hash and total size of its save, keyed on
+// a cheap change signature (file sizes/mtimes) so sync_all can skip reading
+// and hashing saves that haven't changed since the last pass.
+
+#define HASHCACHE_PATH STATE_DIR "/hashcache.txt"
+
+// Fold data into a running 64-bit FNV-1a signature.
+// Start with HASHCACHE_SIG_INIT.
+#define HASHCACHE_SIG_INIT 0xCBF29CE484222325ULL
+u64 hashcache_mix(u64 sig, const void *data, size_t len);
+
+// Compute the change signature for a title's save without reading its data.
+// Returns false if no trustworthy signature is available (cartridge saves,
+// missing files, or FS not reporting timestamps) - the caller must hash.
+bool hashcache_signature(const TitleInfo *title, u64 *sig_out);
+
+// Look up a cached hash. Returns true if an entry exists for the title
+// with a matching signature, filling hash_out (65 bytes) and size_out.
+bool hashcache_lookup(const TitleInfo *title, u64 sig,
+                      char *hash_out, u32 *size_out);
+
+// Record the hash of a title's save under the given signature.
+void hashcache_store(const TitleInfo *title, u64 sig,
+                     const char *hash, u32 size);
+
+// Drop the cached entry for a title (e.g. after a failed write).
+void hashcache_invalidate(const TitleInfo *title);
+
+// Write pending changes back to SD. Call once after a batch of updates.
+void hashcache_flush(void);
+
+// Delete the cache so the next sync rehashes every save.
+void hashcache_clear(void);
+
+#endif // HASHCACHE_H
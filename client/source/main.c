@@ -1,6 +1,7 @@
 #include "common.h"
 #include "card_spi.h"
 #include "config.h"
+#include "hashcache.h"
 #include "network.h"
 #include "sync.h"
 #include "title.h"
@@ -8,15 +9,16 @@
 #include "update.h"
 
 static AppConfig config;
-static TitleInfo titles[MAX_TITLES];
-static int title_count = 0;
+static TitleList title_list;
 static int selected = 0;
 static int scroll_offset = 0;
 static char status[MAX_URL_LEN + 64];
 
-// View filtering: filtered[] maps visible indices -> titles[] indices
+// View filtering: filtered[] maps visible indices -> title_list.items[] indices
+// (grown with the list)
 static int view_mode = VIEW_ALL;
-static int filtered[MAX_TITLES];
+static int *filtered = NULL;
+static int filtered_cap = 0;
 static int filtered_count = 0;
 
 #define LIST_VISIBLE 27 // TOP_ROWS(30) - header(2) - footer(1)
@@ -37,11 +39,18 @@ static int title_compare(const void *a, const void *b) {
 // Rebuild the filtered index list based on current view_mode
 static void rebuild_filter(void) {
     filtered_count = 0;
-    for (int i = 0; i < title_count; i++) {
+    if (filtered_cap < title_list.count) {
+        int *grown = (int *)realloc(filtered, title_list.count * sizeof(int));
+        if (grown) {
+            filtered = grown;
+            filtered_cap = title_list.count;
+        }
+    }
+    for (int i = 0; i < title_list.count && filtered_count < filtered_cap; i++) {
         bool include = false;
         switch (view_mode) {
-            case VIEW_3DS: include = !titles[i].is_nds; break;
-            case VIEW_NDS: include = titles[i].is_nds; break;
+            case VIEW_3DS: include = !title_list.items[i].is_nds; break;
+            case VIEW_NDS: include = title_list.items[i].is_nds; break;
             default:       include = true; break;
         }
         if (include)
@@ -52,13 +61,14 @@ static void rebuild_filter(void) {
     scroll_offset = 0;
 }
 
-// Build a temporary TitleInfo array from filtered indices for drawing
-// (ui_draw_title_list expects a contiguous array)
-static TitleInfo filtered_titles[MAX_TITLES];
-
-static void build_filtered_titles(void) {
-    for (int i = 0; i < filtered_count; i++)
-        filtered_titles[i] = titles[filtered[i]];
+// Show the list and status. The consoles are single-buffered and the UI
+// only prints rows that changed, so one pass shows up on the next frame.
+static void draw_main_screens(void) {
+    ui_draw_title_list(title_list.items, filtered, filtered_count, selected, scroll_offset, view_mode);
+    ui_draw_status(status);
+    gfxFlushBuffers();
+    gfxSwapBuffers();
+    gspWaitForVBlank();
 }
 
 // Get the actual title index for the current selection
@@ -71,26 +81,28 @@ static int sel_title_idx(void) {
 // Count how many titles are marked (across ALL titles, not just filtered)
 static int count_marked(void) {
     int count = 0;
-    for (int i = 0; i < title_count; i++)
-        if (titles[i].marked) count++;
+    for (int i = 0; i < title_list.count; i++)
+        if (title_list.items[i].marked) count++;
     return count;
 }
 
 // Clear all marks
 static void clear_marks(void) {
-    for (int i = 0; i < title_count; i++)
-        titles[i].marked = false;
+    for (int i = 0; i < title_list.count; i++)
+        title_list.items[i].marked = false;
 }
 
 static void scan_titles(void) {
+    // A details refresh may still be reading the old list's save paths
+    sync_details_stop();
     ui_draw_message("Scanning titles...");
-    title_count = titles_scan(titles, MAX_TITLES, config.nds_dir);
+    titles_scan(&title_list, config.nds_dir);
 
     // Fetch game names from server
-    if (title_count > 0) {
+    if (title_list.count > 0) {
         ui_draw_message("Fetching game names...");
-        titles_fetch_names(&config, titles, title_count);
-        qsort(titles, title_count, sizeof(TitleInfo), title_compare);
+        titles_fetch_names(&config, title_list.items, title_list.count);
+        qsort(title_list.items, title_list.count, sizeof(TitleInfo), title_compare);
     }
 
     rebuild_filter();
@@ -112,6 +124,17 @@ static void sync_progress(const char *message) {
     gspWaitForVBlank();
 }
 
+// Block until any button is pressed (for message screens)
+static void wait_any_button(void) {
+    while (aptMainLoop()) {
+        hidScanInput();
+        if (hidKeysDown()) break;
+        gfxFlushBuffers();
+        gfxSwapBuffers();
+        gspWaitForVBlank();
+    }
+}
+
 // Update progress callback
 static void update_progress_cb(int pct) {
     static int last_pct = -1;
@@ -190,19 +213,12 @@ int main(int argc, char *argv[]) {
         return 0;
     }
 
-    // Initial title scan
+    // Initial title scan (from the cache), then re-check it in the background
     scan_titles();
+    titles_revalidate_start();
 
     snprintf(status, sizeof(status), "Server: %.200s", config.server_url);
-    // Draw to both buffers to prevent flicker
-    build_filtered_titles();
-    for (int buf = 0; buf < 2; buf++) {
-        ui_draw_title_list(filtered_titles, filtered_count, selected, scroll_offset, view_mode);
-        ui_draw_status(status);
-        gfxFlushBuffers();
-        gfxSwapBuffers();
-        gspWaitForVBlank();
-    }
+    draw_main_screens();
 
     // Main loop
     while (aptMainLoop()) {
@@ -214,6 +230,14 @@ int main(int argc, char *argv[]) {
         if (kDown & KEY_START)
             break;
 
+        // Background revalidation found saves created or deleted since cached
+        bool titles_changed;
+        if (titles_revalidate_poll(&titles_changed) && titles_changed) {
+            scan_titles();
+            snprintf(status, sizeof(status), "Title list updated. %d title(s) found.", title_list.count);
+            redraw = true;
+        }
+
         if (kDown & KEY_DOWN && filtered_count > 0) {
             selected = (selected + 1) % filtered_count;
             update_scroll();
@@ -257,11 +281,8 @@ int main(int argc, char *argv[]) {
             if (idx >= 0) {
                 ui_draw_message("Loading save details...");
                 SaveDetails details;
-                if (sync_get_save_details(&config, &titles[idx], &details)) {
-                    ui_show_save_details(&titles[idx], &details);
-                } else {
-                    snprintf(status, sizeof(status), "Failed to load save details");
-                }
+                sync_details_open(&config, title_list.items, title_list.count, idx, &details);
+                ui_show_save_details(&title_list.items[idx], &details);
             }
             redraw = true;
         }
@@ -285,20 +306,22 @@ int main(int argc, char *argv[]) {
                 }
                 if (go) {
                     int ok_count = 0, fail_count = 0;
-                    for (int i = 0; i < title_count; i++) {
-                        if (!titles[i].marked) continue;
+                    network_session_begin();
+                    for (int i = 0; i < title_list.count; i++) {
+                        if (!title_list.items[i].marked) continue;
                         char msg[128];
                         snprintf(msg, sizeof(msg), "Uploading %d/%d: %.30s",
-                            ok_count + fail_count + 1, marked, titles[i].name);
+                            ok_count + fail_count + 1, marked, title_list.items[i].name);
                         sync_progress(msg);
-                        SyncResult res = sync_title(&config, &titles[i], sync_progress);
+                        SyncResult res = sync_title(&config, &title_list.items[i], sync_progress);
                         if (res == SYNC_OK) {
                             ok_count++;
-                            titles[i].in_conflict = false;
+                            title_list.items[i].in_conflict = false;
                         } else {
                             fail_count++;
                         }
                     }
+                    network_session_end();
                     clear_marks();
                     snprintf(status, sizeof(status), "Batch upload: %d OK, %d failed",
                         ok_count, fail_count);
@@ -311,21 +334,18 @@ int main(int argc, char *argv[]) {
                 if (idx >= 0) {
                     ui_draw_message("Loading save details...");
                     SaveDetails details;
-                    if (sync_get_save_details(&config, &titles[idx], &details)) {
-                        if (ui_confirm_sync(&titles[idx], &details, true)) {
-                            SyncResult res = sync_title(&config, &titles[idx], sync_progress);
-                            if (res == SYNC_OK) {
-                                snprintf(status, sizeof(status), "Uploaded: %.40s", titles[idx].name);
-                                titles[idx].in_conflict = false;
-                            } else {
-                                snprintf(status, sizeof(status), "\x1b[31mUpload failed\x1b[0m: %s",
-                                    sync_result_str(res));
-                            }
+                    sync_details_open(&config, title_list.items, title_list.count, idx, &details);
+                    if (ui_confirm_sync(&title_list.items[idx], &details, true)) {
+                        SyncResult res = sync_title(&config, &title_list.items[idx], sync_progress);
+                        if (res == SYNC_OK) {
+                            snprintf(status, sizeof(status), "Uploaded: %.40s", title_list.items[idx].name);
+                            title_list.items[idx].in_conflict = false;
                         } else {
-                            snprintf(status, sizeof(status), "Upload cancelled");
+                            snprintf(status, sizeof(status), "\x1b[31mUpload failed\x1b[0m: %s",
+                                sync_result_str(res));
                         }
                     } else {
-                        snprintf(status, sizeof(status), "Failed to load save details");
+                        snprintf(status, sizeof(status), "Upload cancelled");
                     }
                 }
             }
@@ -351,20 +371,22 @@ int main(int argc, char *argv[]) {
                 }
                 if (go) {
                     int ok_count = 0, fail_count = 0;
-                    for (int i = 0; i < title_count; i++) {
-                        if (!titles[i].marked) continue;
+                    network_session_begin();
+                    for (int i = 0; i < title_list.count; i++) {
+                        if (!title_list.items[i].marked) continue;
                         char msg[128];
                         snprintf(msg, sizeof(msg), "Downloading %d/%d: %.30s",
-                            ok_count + fail_count + 1, marked, titles[i].name);
+                            ok_count + fail_count + 1, marked, title_list.items[i].name);
                         sync_progress(msg);
-                        SyncResult res = sync_download_title(&config, &titles[i], sync_progress);
+                        SyncResult res = sync_download_title(&config, &title_list.items[i], sync_progress);
                         if (res == SYNC_OK) {
                             ok_count++;
-                            titles[i].in_conflict = false;
+                            title_list.items[i].in_conflict = false;
                         } else {
                             fail_count++;
                         }
                     }
+                    network_session_end();
                     clear_marks();
                     snprintf(status, sizeof(status), "Batch download: %d OK, %d failed",
                         ok_count, fail_count);
@@ -377,40 +399,37 @@ int main(int argc, char *argv[]) {
                 if (idx >= 0) {
                     ui_draw_message("Loading save details...");
                     SaveDetails details;
-                    if (sync_get_save_details(&config, &titles[idx], &details)) {
-                        if (ui_confirm_sync(&titles[idx], &details, false)) {
-                            SyncResult res = sync_download_title(&config, &titles[idx], sync_progress);
-                            if (res == SYNC_OK) {
-                                snprintf(status, sizeof(status), "Downloaded: %.40s", titles[idx].name);
-                                titles[idx].in_conflict = false;
-                            } else {
-                                snprintf(status, sizeof(status), "\x1b[31mDownload failed\x1b[0m: %s",
-                                    sync_result_str(res));
-                            }
+                    sync_details_open(&config, title_list.items, title_list.count, idx, &details);
+                    if (ui_confirm_sync(&title_list.items[idx], &details, false)) {
+                        SyncResult res = sync_download_title(&config, &title_list.items[idx], sync_progress);
+                        if (res == SYNC_OK) {
+                            snprintf(status, sizeof(status), "Downloaded: %.40s", title_list.items[idx].name);
+                            title_list.items[idx].in_conflict = false;
                         } else {
-                            snprintf(status, sizeof(status), "Download cancelled");
+                            snprintf(status, sizeof(status), "\x1b[31mDownload failed\x1b[0m: %s",
+                                sync_result_str(res));
                         }
                     } else {
-                        snprintf(status, sizeof(status), "Failed to load save details");
+                        snprintf(status, sizeof(status), "Download cancelled");
                     }
                 }
             }
             redraw = true;
         }
 
-        if (kDown & KEY_X && title_count > 0) {
+        if (kDown & KEY_X && title_list.count > 0) {
             // Clear all conflict flags before sync
-            for (int i = 0; i < title_count; i++)
-                titles[i].in_conflict = false;
+            for (int i = 0; i < title_list.count; i++)
+                title_list.items[i].in_conflict = false;
 
             SyncSummary summary;
-            bool ok = sync_all(&config, titles, title_count, sync_progress, &summary);
+            bool ok = sync_all(&config, title_list.items, title_list.count, sync_progress, &summary);
             if (ok) {
                 // Mark conflicting titles in our list
                 for (int i = 0; i < summary.conflicts && i < MAX_CONFLICT_DISPLAY; i++) {
-                    for (int j = 0; j < title_count; j++) {
-                        if (strcmp(titles[j].title_id_hex, summary.conflict_titles[i]) == 0) {
-                            titles[j].in_conflict = true;
+                    for (int j = 0; j < title_list.count; j++) {
+                        if (strcmp(title_list.items[j].title_id_hex, summary.conflict_titles[i]) == 0) {
+                            title_list.items[j].in_conflict = true;
                             break;
                         }
                     }
@@ -418,9 +437,9 @@ int main(int argc, char *argv[]) {
 
                 if (summary.conflicts > 0) {
                     // Auto-mark conflicting titles for batch resolve
-                    for (int i = 0; i < title_count; i++) {
-                        if (titles[i].in_conflict)
-                            titles[i].marked = true;
+                    for (int i = 0; i < title_list.count; i++) {
+                        if (title_list.items[i].in_conflict)
+                            title_list.items[i].marked = true;
                     }
 
                     // Show conflict details - use game names
@@ -430,10 +449,10 @@ int main(int argc, char *argv[]) {
                         summary.conflicts);
 
                     // List conflicting titles by name
-                    for (int i = 0; i < title_count && pos < (int)sizeof(conflict_msg) - 50; i++) {
-                        if (titles[i].in_conflict) {
+                    for (int i = 0; i < title_list.count && pos < (int)sizeof(conflict_msg) - 50; i++) {
+                        if (title_list.items[i].in_conflict) {
                             pos += snprintf(conflict_msg + pos, sizeof(conflict_msg) - pos,
-                                "  %.35s\n", titles[i].name);
+                                "  %.35s\n", title_list.items[i].name);
                         }
                     }
                     if (summary.conflicts > MAX_CONFLICT_DISPLAY) {
@@ -441,31 +460,39 @@ int main(int argc, char *argv[]) {
                             "  ...and %d more\n", summary.conflicts - MAX_CONFLICT_DISPLAY);
                     }
 
+                    char timing[160];
+                    sync_format_timing(&summary.timing, timing, sizeof(timing));
                     snprintf(conflict_msg + pos, sizeof(conflict_msg) - pos,
                         "\nConflicts \x1b[32mmarked\x1b[0m for batch resolve.\n"
                         "Press B to download all, or\n"
                         "resolve individually.\n\n"
-                        "Press any button to continue.");
+                        "\x1b[90m%s\x1b[0m\n\n"
+                        "Press any button to continue.", timing);
 
                     ui_draw_message(conflict_msg);
-                    // Wait for any button press
-                    while (aptMainLoop()) {
-                        hidScanInput();
-                        if (hidKeysDown()) break;
-                        gfxFlushBuffers();
-                        gfxSwapBuffers();
-                        gspWaitForVBlank();
-                    }
+                    wait_any_button();
 
                     snprintf(status, sizeof(status),
                         "Up:%d Dn:%d OK:%d \x1b[33mConflict:%d\x1b[0m Fail:%d",
                         summary.uploaded, summary.downloaded, summary.up_to_date,
                         summary.conflicts, summary.failed);
                 } else {
+                    if (config.timing_log) {
+                        // Profiling: show where the time went
+                        char timing[160], timing_msg[320];
+                        sync_format_timing(&summary.timing, timing, sizeof(timing));
+                        snprintf(timing_msg, sizeof(timing_msg),
+                            "\x1b[32mSync completed.\x1b[0m\n\n%s\n\n"
+                            "Logged to %s\n\n"
+                            "Press any button to continue.", timing, TIMING_LOG_PATH);
+                        ui_draw_message(timing_msg);
+                        wait_any_button();
+                    }
                     snprintf(status, sizeof(status),
-                        "Up:%d Dn:%d OK:%d Fail:%d",
+                        "Up:%d Dn:%d OK:%d Fail:%d (%lu.%lus)",
                         summary.uploaded, summary.downloaded, summary.up_to_date,
-                        summary.failed);
+                        summary.failed, (unsigned long)(summary.timing.total_ms / 1000),
+                        (unsigned long)(summary.timing.total_ms % 1000 / 100));
                 }
             } else {
                 snprintf(status, sizeof(status), "\x1b[31mSync failed!\x1b[0m Check server.");
@@ -478,7 +505,7 @@ int main(int argc, char *argv[]) {
         if (kDown & KEY_SELECT && filtered_count > 0) {
             int idx = sel_title_idx();
             if (idx >= 0) {
-                titles[idx].marked = !titles[idx].marked;
+                title_list.items[idx].marked = !title_list.items[idx].marked;
                 int mc = count_marked();
                 if (mc > 0)
                     snprintf(status, sizeof(status), "%d title(s) marked", mc);
@@ -492,8 +519,13 @@ int main(int argc, char *argv[]) {
         if (kDown & KEY_L) {
             int result = ui_show_config_editor(&config);
             if (result == CONFIG_RESULT_RESCAN) {
+                titles_cache_clear();
                 scan_titles();
-                snprintf(status, sizeof(status), "Rescanned. %d title(s) found.", title_count);
+                snprintf(status, sizeof(status), "Rescanned. %d title(s) found.", title_list.count);
+            } else if (result == CONFIG_RESULT_REHASH) {
+                sync_details_stop();
+                hashcache_clear();
+                snprintf(status, sizeof(status), "Hash cache cleared. Next sync rehashes all.");
             } else if (result == CONFIG_RESULT_SAVED) {
                 snprintf(status, sizeof(status), "Config saved. Server: %.30s", config.server_url);
             } else if (result == CONFIG_RESULT_UPDATE) {
@@ -531,48 +563,46 @@ int main(int argc, char *argv[]) {
                     }
 
                     if (do_update) {
-                        ui_draw_message("Downloading update...");
-                        if (!update_download(&config, update_info.download_url, update_progress_cb)) {
-                            snprintf(status, sizeof(status), "\x1b[31mDownload failed!\x1b[0m");
+                        ui_draw_message("Installing update...\n\nPlease wait, do not power off.");
+                        char install_error[128] = {0};
+                        // Streamed straight into the CIA install (and SD with keep_update_cia)
+                        if (!update_stream_install(&config, update_info.download_url,
+                                                   update_info.file_size, update_progress_cb,
+                                                   install_error, sizeof(install_error))) {
+                            char errmsg[256];
+                            snprintf(errmsg, sizeof(errmsg),
+                                "\x1b[31mUpdate failed:\x1b[0m\n\n%s\n\n"
+                                "Press any button to continue.",
+                                install_error);
+                            ui_draw_message(errmsg);
+                            while (aptMainLoop()) {
+                                hidScanInput();
+                                if (hidKeysDown()) break;
+                                gfxFlushBuffers();
+                                gfxSwapBuffers();
+                                gspWaitForVBlank();
+                            }
+                            snprintf(status, sizeof(status), "Update failed");
                         } else {
-                            ui_draw_message("Installing update...\n\nPlease wait, do not power off.");
-                            char install_error[128] = {0};
-                            if (!update_install(update_progress_cb, install_error, sizeof(install_error))) {
-                                char errmsg[256];
-                                snprintf(errmsg, sizeof(errmsg),
-                                    "\x1b[31mInstall failed:\x1b[0m\n\n%s\n\n"
-                                    "Press any button to continue.",
-                                    install_error);
-                                ui_draw_message(errmsg);
-                                while (aptMainLoop()) {
-                                    hidScanInput();
-                                    if (hidKeysDown()) break;
-                                    gfxFlushBuffers();
-                                    gfxSwapBuffers();
-                                    gspWaitForVBlank();
-                                }
-                                snprintf(status, sizeof(status), "Install failed");
-                            } else {
-                                ui_draw_message(
-                                    "\x1b[32mUpdate installed!\x1b[0m\n\n"
-                                    "Restarting application...");
-                                svcSleepThread(1500000000LL);
-                                update_relaunch();
-
-                                ui_draw_message(
-                                    "\x1b[32mUpdate installed!\x1b[0m\n\n"
-                                    "Please restart the application\n"
-                                    "to use the new version.\n\n"
-                                    "Press START to exit.");
-                                while (aptMainLoop()) {
-                                    hidScanInput();
-                                    if (hidKeysDown() & KEY_START) break;
-                                    gfxFlushBuffers();
-                                    gfxSwapBuffers();
-                                    gspWaitForVBlank();
-                                }
-                                goto cleanup;
+                            ui_draw_message(
+                                "\x1b[32mUpdate installed!\x1b[0m\n\n"
+                                "Restarting application...");
+                            svcSleepThread(1500000000LL);
+                            update_relaunch();
+
+                            ui_draw_message(
+                                "\x1b[32mUpdate installed!\x1b[0m\n\n"
+                                "Please restart the application\n"
+                                "to use the new version.\n\n"
+                                "Press START to exit.");
+                            while (aptMainLoop()) {
+                                hidScanInput();
+                                if (hidKeysDown() & KEY_START) break;
+                                gfxFlushBuffers();
+                                gfxSwapBuffers();
+                                gspWaitForVBlank();
                             }
+                            goto cleanup;
                         }
                     } else {
                         snprintf(status, sizeof(status), "Update cancelled");
@@ -585,15 +615,7 @@ int main(int argc, char *argv[]) {
         }
 
         if (redraw) {
-            build_filtered_titles();
-            // Draw to both buffers to prevent flicker with double buffering
-            for (int buf = 0; buf < 2; buf++) {
-                ui_draw_title_list(filtered_titles, filtered_count, selected, scroll_offset, view_mode);
-                ui_draw_status(status);
-                gfxFlushBuffers();
-                gfxSwapBuffers();
-                gspWaitForVBlank();
-            }
+            draw_main_screens();
         } else {
             // No redraw needed, just wait for next frame
             gspWaitForVBlank();
@@ -602,6 +624,8 @@ int main(int argc, char *argv[]) {
 
 cleanup:
     // Cleanup
+    titles_revalidate_stop();
+    sync_details_stop();
     network_exit();
     card_spi_exit();
     psExit();
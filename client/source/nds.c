@@ -1,36 +1,14 @@
 #include "nds.h"
 #include "card_spi.h"
+#include "romindex.h"
 #include "title.h"
 
 #include <dirent.h>
 #include <sys/stat.h>
 
-#define NDS_GAMECODE_OFFSET 0x0C
 #define NDS_TITLE_ID_PREFIX 0x00048000ULL
-
-// Read the 4-char game code from an NDS ROM header on the SD card.
-// Returns true and fills code_out (5 bytes) on success.
-static bool nds_read_gamecode(const char *rom_path, char *code_out) {
-    FILE *f = fopen(rom_path, "rb");
-    if (!f) return false;
-
-    fseek(f, NDS_GAMECODE_OFFSET, SEEK_SET);
-    char code[4];
-    size_t rd = fread(code, 1, 4, f);
-    fclose(f);
-
-    if (rd != 4) return false;
-
-    // Validate printable ASCII
-    for (int i = 0; i < 4; i++) {
-        if (code[i] < 0x20 || code[i] > 0x7E)
-            return false;
-    }
-
-    memcpy(code_out, code, 4);
-    code_out[4] = '\0';
-    return true;
-}
+#define NDS_SCAN_DEPTH      4 // Subdirectory levels below nds_dir
+#define CART_PROGRESS_MS    200 // Min time between cartridge progress messages
 
 // Convert a 4-char NDS game code to a u64 title ID.
 // Format: 00048000 (high 32) + ASCII hex of game code (low 32)
@@ -97,103 +75,146 @@ static bool find_sav_for_rom(const char *rom_path, char *sav_path_out, int out_s
     return false;
 }
 
-int nds_scan(const char *nds_dir, TitleInfo *titles, int offset, int max_titles) {
-    if (!nds_dir || !nds_dir[0])
-        return 0;
+// Default save path for a ROM without one: saves/ subfolder if it exists
+static void default_sav_path(const char *rom_path, char *sav_path_out, int out_size) {
+    char dir[MAX_PATH_LEN];
+    strncpy(dir, rom_path, MAX_PATH_LEN - 1);
+    dir[MAX_PATH_LEN - 1] = '\0';
+    char *sl = strrchr(dir, '/');
+    char stem[MAX_PATH_LEN];
+    if (sl) {
+        strncpy(stem, sl + 1, MAX_PATH_LEN - 1);
+        stem[MAX_PATH_LEN - 1] = '\0';
+        *sl = '\0';
+    } else {
+        strncpy(stem, rom_path, MAX_PATH_LEN - 1);
+        stem[MAX_PATH_LEN - 1] = '\0';
+        dir[0] = '\0';
+    }
+    char *dot = strrchr(stem, '.');
+    if (dot) *dot = '\0';
 
-    DIR *dp = opendir(nds_dir);
-    if (!dp) return 0;
+    // Check if saves/ subfolder exists
+    char saves_sub[MAX_PATH_LEN];
+    snprintf(saves_sub, sizeof(saves_sub), "%s/saves", dir);
+    struct stat st;
+    if (stat(saves_sub, &st) == 0) {
+        snprintf(sav_path_out, out_size, "%s/saves/%s.sav", dir, stem);
+    } else {
+        snprintf(sav_path_out, out_size, "%s/%s.sav", dir, stem);
+    }
+}
 
-    int added = 0;
-    struct dirent *entry;
+// Add one ROM, taking its game code and save path from the index when
+// the ROM is unchanged. Returns true if a title was added.
+static bool add_rom(const char *rom_path, const char *filename, const struct stat *rom_st,
+                    TitleList *list) {
+    RomIndexEntry *e = romindex_find(rom_path, (u32)rom_st->st_size, (u32)rom_st->st_mtime);
+    if (!e) {
+        // New or changed ROM: read game code from the header
+        char code[5];
+        if (!romindex_read_gamecode(rom_path, code))
+            return false;
+        e = romindex_add(rom_path, (u32)rom_st->st_size, (u32)rom_st->st_mtime, code);
+        if (!e) return false;
+    }
+    const char *code = e->code;
 
-    while ((entry = readdir(dp)) != NULL && (offset + added) < max_titles) {
-        // Skip . and ..
-        if (entry->d_name[0] == '.') continue;
+    // Check for duplicate game codes (already in title list)
+    for (int j = 0; j < list->count; j++) {
+        if (list->items[j].is_nds && strcmp(list->items[j].product_code, code) == 0)
+            return false;
+    }
 
-        // Only process .nds files
-        if (!ends_with_ci(entry->d_name, ".nds")) continue;
+    // A save found last time only needs a stat to confirm
+    char sav_path[MAX_PATH_LEN];
+    struct stat st;
+    bool has_save = e->sav_path[0] && stat(e->sav_path, &st) == 0 && S_ISREG(st.st_mode);
+    if (has_save) {
+        snprintf(sav_path, sizeof(sav_path), "%s", e->sav_path);
+    } else {
+        // Find matching .sav file (or set default path for downloads)
+        has_save = find_sav_for_rom(rom_path, sav_path, sizeof(sav_path));
+        romindex_set_save(e, has_save ? sav_path : "");
+        if (!has_save)
+            default_sav_path(rom_path, sav_path, sizeof(sav_path));
+    }
 
-        // Build full ROM path
-        char rom_path[MAX_PATH_LEN];
-        snprintf(rom_path, sizeof(rom_path), "%s/%s", nds_dir, entry->d_name);
+    // Build TitleInfo
+    TitleInfo *t = titles_append(list);
+    if (!t) return false;
+    if (!title_set_sav_path(t, sav_path)) {
+        list->count--;
+        return false;
+    }
 
-        // Read game code from ROM header
-        char code[5];
-        if (!nds_read_gamecode(rom_path, code))
-            continue;
+    t->title_id = nds_gamecode_to_title_id(code);
+    t->media_type = MEDIATYPE_SD;  // NDS ROMs are on SD card
+    t->is_nds = true;
+    t->has_save_data = has_save;
+    t->in_conflict = false;
+
+    title_id_to_hex(t->title_id, t->title_id_hex);
+    strncpy(t->product_code, code, sizeof(t->product_code) - 1);
+
+    // Set initial name to ROM filename (will be updated by server lookup)
+    // Strip .nds extension for display
+    char display_name[64];
+    strncpy(display_name, filename, sizeof(display_name) - 1);
+    display_name[sizeof(display_name) - 1] = '\0';
+    char *ext = strrchr(display_name, '.');
+    if (ext) *ext = '\0';
+    title_set_name(t, display_name);
+    return true;
+}
 
-        // Check for duplicate game codes (already in title list)
-        bool dup = false;
-        for (int j = 0; j < offset + added; j++) {
-            if (titles[j].is_nds && strcmp(titles[j].product_code, code) == 0) {
-                dup = true;
-                break;
-            }
-        }
-        if (dup) continue;
+static void scan_dir(const char *dir, int depth, TitleList *list) {
+    DIR *dp = opendir(dir);
+    if (!dp) return;
 
-        // Find matching .sav file (or set default path for downloads)
-        char sav_path[MAX_PATH_LEN];
-        bool has_save = find_sav_for_rom(rom_path, sav_path, sizeof(sav_path));
-        if (!has_save) {
-            // Build default sav_path: prefer saves/ subfolder if it exists
-            char dir[MAX_PATH_LEN];
-            strncpy(dir, rom_path, MAX_PATH_LEN - 1);
-            dir[MAX_PATH_LEN - 1] = '\0';
-            char *sl = strrchr(dir, '/');
-            char stem[MAX_PATH_LEN];
-            if (sl) {
-                strncpy(stem, sl + 1, MAX_PATH_LEN - 1);
-                stem[MAX_PATH_LEN - 1] = '\0';
-                *sl = '\0';
-            } else {
-                strncpy(stem, rom_path, MAX_PATH_LEN - 1);
-                stem[MAX_PATH_LEN - 1] = '\0';
-                dir[0] = '\0';
-            }
-            char *dot = strrchr(stem, '.');
-            if (dot) *dot = '\0';
-
-            // Check if saves/ subfolder exists
-            char saves_sub[MAX_PATH_LEN];
-            snprintf(saves_sub, sizeof(saves_sub), "%s/saves", dir);
-            struct stat st;
-            if (stat(saves_sub, &st) == 0) {
-                snprintf(sav_path, sizeof(sav_path), "%s/saves/%s.sav", dir, stem);
-            } else {
-                snprintf(sav_path, sizeof(sav_path), "%s/%s.sav", dir, stem);
-            }
+    struct dirent *entry;
+    while ((entry = readdir(dp)) != NULL) {
+        // Skip . and .. (and hidden entries)
+        if (entry->d_name[0] == '.') continue;
+
+        char path[MAX_PATH_LEN];
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+
+        if (entry->d_type == DT_DIR) {
+            // saves/ holds .sav files next to the ROMs, never ROMs
+            if (depth < NDS_SCAN_DEPTH && strcasecmp(entry->d_name, "saves") != 0)
+                scan_dir(path, depth + 1, list);
+            continue;
         }
 
-        // Build TitleInfo
-        TitleInfo *t = &titles[offset + added];
-        memset(t, 0, sizeof(TitleInfo));
-
-        t->title_id = nds_gamecode_to_title_id(code);
-        t->media_type = MEDIATYPE_SD;  // NDS ROMs are on SD card
-        t->is_nds = true;
-        t->has_save_data = has_save;
-        t->in_conflict = false;
-
-        title_id_to_hex(t->title_id, t->title_id_hex);
-        strncpy(t->product_code, code, sizeof(t->product_code) - 1);
-        strncpy(t->sav_path, sav_path, MAX_PATH_LEN - 1);
-
-        // Set initial name to ROM filename (will be updated by server lookup)
-        // Strip .nds extension for display
-        char display_name[64];
-        strncpy(display_name, entry->d_name, sizeof(display_name) - 1);
-        display_name[sizeof(display_name) - 1] = '\0';
-        char *ext = strrchr(display_name, '.');
-        if (ext) *ext = '\0';
-        snprintf(t->name, sizeof(t->name), "%s", display_name);
-
-        added++;
+        // Only process .nds files
+        if (!ends_with_ci(entry->d_name, ".nds")) continue;
+
+        struct stat st;
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) continue;
+
+        add_rom(path, entry->d_name, &st, list);
     }
 
     closedir(dp);
-    return added;
+}
+
+int nds_scan(const char *nds_dir, TitleList *list) {
+    if (!nds_dir || !nds_dir[0])
+        return 0;
+
+    struct stat st;
+    if (stat(nds_dir, &st) != 0 || !S_ISDIR(st.st_mode))
+        return 0;
+
+    mkdir("sdmc:/3ds", 0777);
+    mkdir("sdmc:/3ds/3dssync", 0777);
+    mkdir(STATE_DIR, 0777);
+    romindex_begin(ROMINDEX_FILE);
+    int before = list->count;
+    scan_dir(nds_dir, 0, list);
+    romindex_end();
+    return list->count - before;
 }
 
 int nds_read_save(const char *sav_path, ArchiveFile *files, int max_files) {
@@ -225,6 +246,7 @@ int nds_read_save(const char *sav_path, ArchiveFile *files, int max_files) {
     files[0].path[MAX_PATH_LEN - 1] = '\0';
     files[0].size = (u32)size;
     files[0].data = data;
+    files[0].pooled = false;
 
     return 1;
 }
@@ -254,7 +276,35 @@ bool nds_write_save(const char *sav_path, const ArchiveFile *files, int file_cou
     return written == sav->size;
 }
 
-int nds_cart_read_save(ArchiveFile *files, int max_files) {
+// Turns card_spi byte counts into "<label> 512/8192KB (350KB/s)" messages
+typedef struct {
+    NdsProgressCb progress;
+    const char *label;
+    u64 start;
+    u64 last;
+} CartProgress;
+
+static void cart_progress(void *ctx, u32 done, u32 total) {
+    CartProgress *p = (CartProgress *)ctx;
+    u64 now = svcGetSystemTick();
+    u64 ticks_per_ms = SYSCLOCK_ARM11 / 1000;
+    if (done < total && now - p->last < CART_PROGRESS_MS * ticks_per_ms) return;
+    p->last = now;
+
+    u64 ms = (now - p->start) / ticks_per_ms;
+    u32 kbps = ms ? (u32)((u64)done * 1000 / 1024 / ms) : 0;
+    char msg[64];
+    snprintf(msg, sizeof(msg), "%s %lu/%luKB (%luKB/s)", p->label,
+             (unsigned long)(done / 1024), (unsigned long)(total / 1024), (unsigned long)kbps);
+    p->progress(msg);
+}
+
+static CartProgress cart_progress_start(NdsProgressCb progress, const char *label) {
+    u64 now = svcGetSystemTick();
+    return (CartProgress){progress, label, now, now};
+}
+
+int nds_cart_read_save(ArchiveFile *files, int max_files, NdsProgressCb progress) {
     if (max_files < 1) return -1;
 
     CardSaveType type = card_spi_detect();
@@ -266,7 +316,8 @@ int nds_cart_read_save(ArchiveFile *files, int max_files) {
     u8 *data = (u8 *)malloc(save_size);
     if (!data) return -1;
 
-    if (!card_spi_read_save(type, data, save_size)) {
+    CartProgress p = cart_progress_start(progress, "Reading cartridge:");
+    if (!card_spi_read_save(type, data, save_size, progress ? cart_progress : NULL, &p)) {
         free(data);
         return -1;
     }
@@ -275,11 +326,14 @@ int nds_cart_read_save(ArchiveFile *files, int max_files) {
     files[0].path[MAX_PATH_LEN - 1] = '\0';
     files[0].size = save_size;
     files[0].data = data;
+    files[0].pooled = false;
 
     return 1;
 }
 
-bool nds_cart_write_save(const ArchiveFile *files, int file_count) {
+bool nds_cart_write_save(const ArchiveFile *files, int file_count, u32 *bytes_written,
+                         NdsProgressCb progress) {
+    if (bytes_written) *bytes_written = 0;
     if (file_count < 1) return false;
 
     CardSaveType type = card_spi_detect();
@@ -293,17 +347,26 @@ bool nds_cart_write_save(const ArchiveFile *files, int file_count) {
     u32 write_size = sav->size < save_size ? save_size : sav->size;
     if (write_size > save_size) write_size = save_size;
 
-    u8 *buf;
+    const u8 *data = sav->data;
+    u8 *buf = NULL;
     if (sav->size < save_size) {
         // Pad with 0xFF
         buf = (u8 *)malloc(save_size);
         if (!buf) return false;
         memset(buf, 0xFF, save_size);
         memcpy(buf, sav->data, sav->size);
-        bool ok = card_spi_write_save(type, buf, save_size);
-        free(buf);
-        return ok;
+        data = buf;
     }
 
-    return card_spi_write_save(type, sav->data, write_size);
+    CardSpiProgressCb cb = progress ? cart_progress : NULL;
+    CartProgress p = cart_progress_start(progress, "Writing cartridge:");
+    bool ok = card_spi_write_save_diff(type, data, write_size, bytes_written, cb, &p);
+    if (!ok) {
+        // Differential write failed part-way - rewrite the whole chip
+        p = cart_progress_start(progress, "Rewriting cartridge:");
+        ok = card_spi_write_save(type, data, write_size, cb, &p);
+        if (bytes_written) *bytes_written = ok ? write_size : 0;
+    }
+    free(buf);
+    return ok;
 }
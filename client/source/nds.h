@@ -3,11 +3,16 @@
 
 #include "common.h"
 #include "archive.h"
+#include "title.h"
 
-// Scan an SD card directory for NDS ROMs with .sav files.
-// Fills titles starting at offset, up to max_titles.
-// Returns number of NDS titles found.
-int nds_scan(const char *nds_dir, TitleInfo *titles, int offset, int max_titles);
+// ROM scan index (game code and save path per ROM, see shared/romindex.h)
+#define ROMINDEX_FILE STATE_DIR "/romindex.txt"
+
+// Scan an SD card directory (and its subdirectories) for NDS ROMs with
+// .sav files. Only ROMs that are new or changed since the last scan are
+// opened to read their game code.
+// Appends the titles to list. Returns number of NDS titles found.
+int nds_scan(const char *nds_dir, TitleList *list);
 
 // Read NDS save file into ArchiveFile format (single file "save.dat").
 // Returns number of files (1) on success, -1 on error.
@@ -19,13 +24,21 @@ int nds_read_save(const char *sav_path, ArchiveFile *files, int max_files);
 // Returns true on success.
 bool nds_write_save(const char *sav_path, const ArchiveFile *files, int file_count);
 
+// Progress message for cartridge transfers (same shape as SyncProgressCb)
+typedef void (*NdsProgressCb)(const char *message);
+
 // Read save from a physical NDS cartridge via SPI.
 // Detects save type automatically. Returns 1 on success, -1 on error.
-// Caller must call archive_free_files() when done.
-int nds_cart_read_save(ArchiveFile *files, int max_files);
+// progress (optional, main thread only) gets KB done and KB/s a few
+// times a second. Caller must call archive_free_files() when done.
+int nds_cart_read_save(ArchiveFile *files, int max_files, NdsProgressCb progress);
 
 // Write save to a physical NDS cartridge via SPI.
-// Detects save type automatically. Returns true on success.
-bool nds_cart_write_save(const ArchiveFile *files, int file_count);
+// Detects save type automatically. Only regions that differ from the
+// cartridge are rewritten; *bytes_written (optional) gets the bytes
+// actually programmed. progress as for nds_cart_read_save.
+// Returns true on success.
+bool nds_cart_write_save(const ArchiveFile *files, int file_count, u32 *bytes_written,
+                         NdsProgressCb progress);
 
 #endif // NDS_H
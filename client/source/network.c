@@ -13,7 +13,70 @@ static void request_delay(void) {
     svcSleepThread(50000000LL); // 50ms
 }
 
+// Persistent-connection session state. While a session is active, requests
+// ask httpc to keep the TCP connection open so consecutive requests to the
+// server skip the handshake and the cleanup delay. If reused connections
+// keep failing, the session falls back to one connection per request.
+#define SESSION_MAX_FAILURES 3
+
+static bool session_active = false;
+static bool session_keepalive = false;
+static int session_failures = 0;
+
+// Requests may run on several threads at once (see transfer.h). The lock
+// guards the session state and the POST data budget: bodies of requests
+// in flight together must fit httpc's shared memory.
+static LightLock net_lock;
+static CondVar post_freed;
+static u32 post_in_use = 0;
+static NetworkStats stats;
+
+void network_stats_reset(void) {
+    LightLock_Lock(&net_lock);
+    memset(&stats, 0, sizeof(stats));
+    LightLock_Unlock(&net_lock);
+}
+
+void network_stats_get(NetworkStats *out) {
+    LightLock_Lock(&net_lock);
+    *out = stats;
+    LightLock_Unlock(&net_lock);
+}
+
+void network_session_begin(void) {
+    LightLock_Lock(&net_lock);
+    session_active = true;
+    session_keepalive = true;
+    session_failures = 0;
+    LightLock_Unlock(&net_lock);
+}
+
+void network_session_end(void) {
+    LightLock_Lock(&net_lock);
+    session_active = false;
+    session_keepalive = false;
+    LightLock_Unlock(&net_lock);
+}
+
+// Wait until size bytes of POST data can be handed to httpc
+static void post_reserve(u32 size) {
+    LightLock_Lock(&net_lock);
+    while (post_in_use > 0 && post_in_use + size > MAX_POST_SIZE)
+        CondVar_Wait(&post_freed, &net_lock);
+    post_in_use += size;
+    LightLock_Unlock(&net_lock);
+}
+
+static void post_release(u32 size) {
+    LightLock_Lock(&net_lock);
+    post_in_use -= size;
+    CondVar_Broadcast(&post_freed);
+    LightLock_Unlock(&net_lock);
+}
+
 bool network_init(void) {
+    LightLock_Init(&net_lock);
+    CondVar_Init(&post_freed);
     // Shared memory size for POST data (512KB)
     return R_SUCCEEDED(httpcInit(0x80000));
 }
@@ -42,17 +105,21 @@ static Result download_data_timeout(httpcContext *context, u8 *buffer, u32 size,
     return ret;
 }
 
-// Read full response body with dynamic buffer
+// Read full response body. The buffer is sized from Content-Length when the
+// server sends one, and grows by doubling otherwise.
 static u8 *read_response(httpcContext *context, u32 *out_size) {
+    u32 pos = 0, content_size = 0;
+    httpcGetDownloadSizeState(context, &pos, &content_size);
+
     u32 size = 0;
-    u32 buf_cap = HTTP_BUF_SIZE;
+    u32 buf_cap = (content_size > 0 && content_size <= MAX_RESPONSE) ? content_size : HTTP_BUF_SIZE;
     u8 *buf = (u8 *)malloc(buf_cap);
     if (!buf) return NULL;
 
     Result res;
     do {
         // Grow buffer if needed
-        if (size + HTTP_BUF_SIZE > buf_cap) {
+        if (size == buf_cap) {
             buf_cap *= 2;
             if (buf_cap > MAX_RESPONSE) {
                 free(buf);
@@ -66,8 +133,10 @@ static u8 *read_response(httpcContext *context, u32 *out_size) {
             buf = new_buf;
         }
 
+        u32 want = buf_cap - size;
+        if (want > HTTP_BUF_SIZE) want = HTTP_BUF_SIZE;
         u32 read = 0;
-        res = download_data_timeout(context, buf + size, HTTP_BUF_SIZE, &read, TIMEOUT_TRANSFER);
+        res = download_data_timeout(context, buf + size, want, &read, TIMEOUT_TRANSFER);
         size += read;
 
         if (res == (Result)HTTPC_RESULTCODE_TIMEDOUT) {
@@ -85,23 +154,80 @@ static u8 *read_response(httpcContext *context, u32 *out_size) {
     return buf;
 }
 
-u8 *network_get(const AppConfig *config, const char *path,
-                u32 *out_size, u32 *out_status) {
-    request_delay(); // Let previous request fully clean up
+// Pass the response body to sink chunk by chunk instead of buffering it.
+// Sets *out_size to the number of bytes passed on, and *rejected when the
+// sink refused the data (as opposed to the transfer failing).
+static bool stream_response(httpcContext *context, const NetworkSink *sink, u32 *out_size,
+                            bool *rejected) {
+    *rejected = false;
+    u8 *buf = (u8 *)malloc(HTTP_BUF_SIZE);
+    if (!buf) return false;
+
+    Result res;
+    bool ok = true;
+    do {
+        u32 read = 0;
+        res = download_data_timeout(context, buf, HTTP_BUF_SIZE, &read, TIMEOUT_TRANSFER);
+        if (res == (Result)HTTPC_RESULTCODE_TIMEDOUT) { ok = false; break; }
+        if (read > 0 && !sink->write(sink->ctx, buf, read)) {
+            *rejected = true;
+            ok = false;
+            break;
+        }
+        *out_size += read;
+    } while (res == (s32)HTTPC_RESULTCODE_DOWNLOADPENDING);
+
+    if (ok && R_FAILED(res) && res != HTTPC_RESULTCODE_DOWNLOADPENDING) ok = false;
+    free(buf);
+    return ok;
+}
+
+// Where a request attempt failed - decides whether it is safe to retry
+typedef enum {
+    REQ_OK,
+    REQ_FAILED_CONNECT,   // Before the request was sent - always safe to retry
+    REQ_FAILED_RESPONSE,  // After sending - server may have processed it
+    REQ_FAILED_SINK,      // The sink refused the body - resending fetches the same
+} RequestStage;
+
+// One request attempt. With a sink, a 200 response's body goes to the sink
+// and the returned pointer is only a success marker (not to be freed).
+static u8 *request_once(const AppConfig *config, HTTPC_RequestMethod method,
+                        const char *path, const char *content_type,
+                        const char *if_none_match,
+                        const u8 *body, u32 body_size, bool keepalive,
+                        const NetworkSink *sink, u32 *out_size, u32 *out_status,
+                        RequestStage *stage) {
+    *stage = REQ_FAILED_CONNECT;
 
     char url[MAX_URL_LEN + 128];
     build_url(config, path, url, sizeof(url));
 
     httpcContext context;
-    Result res = httpcOpenContext(&context, HTTPC_METHOD_GET, url, 0);
+    Result res = httpcOpenContext(&context, method, url, 0);
     if (R_FAILED(res)) return NULL;
 
     httpcSetSSLOpt(&context, SSLCOPT_DisableVerify);
-    httpcSetKeepAlive(&context, HTTPC_KEEPALIVE_DISABLED);
+    httpcSetKeepAlive(&context, keepalive ? HTTPC_KEEPALIVE_ENABLED : HTTPC_KEEPALIVE_DISABLED);
     httpcAddRequestHeaderField(&context, "User-Agent", "3DSSaveSync/" APP_VERSION);
     httpcAddRequestHeaderField(&context, "X-API-Key", config->api_key);
     httpcAddRequestHeaderField(&context, "X-Console-ID", config->console_id);
-    httpcAddRequestHeaderField(&context, "Connection", "close");
+    httpcAddRequestHeaderField(&context, "Connection", keepalive ? "keep-alive" : "close");
+    if (if_none_match) {
+        char etag[72];
+        snprintf(etag, sizeof(etag), "\"%s\"", if_none_match);
+        httpcAddRequestHeaderField(&context, "If-None-Match", etag);
+    }
+
+    if (body) {
+        httpcAddRequestHeaderField(&context, "Content-Type", content_type);
+        res = httpcAddPostDataRaw(&context, (u32 *)body, body_size);
+        if (R_FAILED(res)) {
+            httpcCancelConnection(&context);
+            httpcCloseContext(&context);
+            return NULL;
+        }
+    }
 
     res = httpcBeginRequest(&context);
     if (R_FAILED(res)) {
@@ -110,6 +236,7 @@ u8 *network_get(const AppConfig *config, const char *path,
         return NULL;
     }
 
+    *stage = REQ_FAILED_RESPONSE;
     res = httpcGetResponseStatusCodeTimeout(&context, out_status, TIMEOUT_RESPONSE);
     if (R_FAILED(res)) {
         httpcCancelConnection(&context);
@@ -117,108 +244,95 @@ u8 *network_get(const AppConfig *config, const char *path,
         return NULL;
     }
 
-    u8 *body = read_response(&context, out_size);
-    httpcCancelConnection(&context);
+    u8 *resp;
+    if (sink && *out_status == 200) {
+        *out_size = 0;
+        bool rejected;
+        resp = stream_response(&context, sink, out_size, &rejected) ? (u8 *)sink : NULL;
+        if (rejected) *stage = REQ_FAILED_SINK;
+    } else {
+        resp = read_response(&context, out_size);
+        if (resp && sink) { free(resp); resp = (u8 *)sink; }
+    }
+    // Keep the connection pooled in httpc when reusing it
+    if (!keepalive) httpcCancelConnection(&context);
     httpcCloseContext(&context);
-    return body;
+    if (resp) *stage = REQ_OK;
+
+    LightLock_Lock(&net_lock);
+    stats.requests++;
+    stats.bytes_sent += body ? body_size : 0;
+    if (resp) stats.bytes_received += *out_size;
+    LightLock_Unlock(&net_lock);
+    return resp;
+}
+
+static u8 *request(const AppConfig *config, HTTPC_RequestMethod method,
+                   const char *path, const char *content_type,
+                   const char *if_none_match,
+                   const u8 *body, u32 body_size, const NetworkSink *sink,
+                   u32 *out_size, u32 *out_status) {
+    LightLock_Lock(&net_lock);
+    bool keepalive = session_active && session_keepalive;
+    LightLock_Unlock(&net_lock);
+    if (!keepalive) request_delay(); // Let previous request fully clean up
+
+    if (body) post_reserve(body_size);
+
+    RequestStage stage;
+    u8 *resp = request_once(config, method, path, content_type, if_none_match, body, body_size,
+                            keepalive, sink, out_size, out_status, &stage);
+    if (!resp && keepalive && stage != REQ_FAILED_SINK) {
+        // The reused connection may have been closed by the server. Reconnect
+        // with a fresh connection - but only retry non-GET requests if they
+        // never reached the server, so an upload isn't applied twice. A body
+        // the sink refused is not a connection problem and isn't fetched again.
+        LightLock_Lock(&net_lock);
+        if (++session_failures >= SESSION_MAX_FAILURES)
+            session_keepalive = false;
+        LightLock_Unlock(&net_lock);
+
+        if (stage != REQ_FAILED_RESPONSE || method == HTTPC_METHOD_GET) {
+            request_delay();
+            if (sink) sink->reset(sink->ctx);
+            resp = request_once(config, method, path, content_type, if_none_match,
+                                body, body_size, false, sink, out_size, out_status, &stage);
+        }
+    }
+
+    if (body) post_release(body_size);
+    return resp;
+}
+
+u8 *network_get(const AppConfig *config, const char *path,
+                u32 *out_size, u32 *out_status) {
+    return request(config, HTTPC_METHOD_GET, path, NULL, NULL, NULL, 0, NULL,
+                   out_size, out_status);
 }
 
 u8 *network_post(const AppConfig *config, const char *path,
                  const u8 *body, u32 body_size,
                  u32 *out_size, u32 *out_status) {
-    request_delay(); // Let previous request fully clean up
-
     // Reject oversized POST bodies that would overflow httpc buffer
     if (body_size > MAX_POST_SIZE) return NULL;
 
-    char url[MAX_URL_LEN + 128];
-    build_url(config, path, url, sizeof(url));
-
-    httpcContext context;
-    Result res = httpcOpenContext(&context, HTTPC_METHOD_POST, url, 0);
-    if (R_FAILED(res)) return NULL;
-
-    httpcSetSSLOpt(&context, SSLCOPT_DisableVerify);
-    httpcSetKeepAlive(&context, HTTPC_KEEPALIVE_DISABLED);
-    httpcAddRequestHeaderField(&context, "User-Agent", "3DSSaveSync/" APP_VERSION);
-    httpcAddRequestHeaderField(&context, "X-API-Key", config->api_key);
-    httpcAddRequestHeaderField(&context, "X-Console-ID", config->console_id);
-    httpcAddRequestHeaderField(&context, "Connection", "close");
-    httpcAddRequestHeaderField(&context, "Content-Type", "application/octet-stream");
-
-    res = httpcAddPostDataRaw(&context, (u32 *)body, body_size);
-    if (R_FAILED(res)) {
-        httpcCancelConnection(&context);
-        httpcCloseContext(&context);
-        return NULL;
-    }
-
-    res = httpcBeginRequest(&context);
-    if (R_FAILED(res)) {
-        httpcCancelConnection(&context);
-        httpcCloseContext(&context);
-        return NULL;
-    }
-
-    res = httpcGetResponseStatusCodeTimeout(&context, out_status, TIMEOUT_RESPONSE);
-    if (R_FAILED(res)) {
-        httpcCancelConnection(&context);
-        httpcCloseContext(&context);
-        return NULL;
-    }
-
-    u8 *resp = read_response(&context, out_size);
-    httpcCancelConnection(&context);
-    httpcCloseContext(&context);
-    return resp;
+    return request(config, HTTPC_METHOD_POST, path, "application/octet-stream", NULL,
+                   body, body_size, NULL, out_size, out_status);
 }
 
 u8 *network_post_json(const AppConfig *config, const char *path,
                       const char *json_body,
                       u32 *out_size, u32 *out_status) {
-    request_delay(); // Let previous request fully clean up
-
     u32 json_len = strlen(json_body);
     if (json_len > MAX_POST_SIZE) return NULL;
 
-    char url[MAX_URL_LEN + 128];
-    build_url(config, path, url, sizeof(url));
-
-    httpcContext context;
-    Result res = httpcOpenContext(&context, HTTPC_METHOD_POST, url, 0);
-    if (R_FAILED(res)) return NULL;
-
-    httpcSetSSLOpt(&context, SSLCOPT_DisableVerify);
-    httpcSetKeepAlive(&context, HTTPC_KEEPALIVE_DISABLED);
-    httpcAddRequestHeaderField(&context, "User-Agent", "3DSSaveSync/" APP_VERSION);
-    httpcAddRequestHeaderField(&context, "X-API-Key", config->api_key);
-    httpcAddRequestHeaderField(&context, "X-Console-ID", config->console_id);
-    httpcAddRequestHeaderField(&context, "Connection", "close");
-    httpcAddRequestHeaderField(&context, "Content-Type", "application/json");
-
-    res = httpcAddPostDataRaw(&context, (u32 *)json_body, json_len);
-    if (R_FAILED(res)) {
-        httpcCancelConnection(&context);
-        httpcCloseContext(&context);
-        return NULL;
-    }
-
-    res = httpcBeginRequest(&context);
-    if (R_FAILED(res)) {
-        httpcCancelConnection(&context);
-        httpcCloseContext(&context);
-        return NULL;
-    }
-
-    res = httpcGetResponseStatusCodeTimeout(&context, out_status, TIMEOUT_RESPONSE);
-    if (R_FAILED(res)) {
-        httpcCancelConnection(&context);
-        httpcCloseContext(&context);
-        return NULL;
-    }
+    return request(config, HTTPC_METHOD_POST, path, "application/json", NULL,
+                   (const u8 *)json_body, json_len, NULL, out_size, out_status);
+}
 
-    u8 *resp = read_response(&context, out_size);
-    httpcCancelConnection(&context);
-    httpcCloseContext(&context);
-    return resp;
+bool network_get_stream(const AppConfig *config, const char *path, const char *etag,
+                        const NetworkSink *sink, u32 *out_status) {
+    u32 size;
+    return request(config, HTTPC_METHOD_GET, path, NULL, etag, NULL, 0, sink,
+                   &size, out_status) != NULL;
 }
@@ -9,11 +9,43 @@ bool network_init(void);
 // Cleanup httpc service. Call at shutdown.
 void network_exit(void);
 
+// Begin/end a persistent-connection session. Between these calls requests
+// reuse the server connection (HTTP keep-alive) instead of reconnecting and
+// sleeping before each one, reconnecting automatically if it drops.
+// Use around batches of requests such as sync_all.
+void network_session_begin(void);
+void network_session_end(void);
+
+// Totals over all requests since the last network_stats_reset
+typedef struct {
+    u32 requests;
+    u64 bytes_sent;      // Request bodies
+    u64 bytes_received;  // Response bodies
+} NetworkStats;
+
+void network_stats_reset(void);
+void network_stats_get(NetworkStats *out);
+
 // HTTP GET - returns malloc'd response body, sets out_size and out_status.
 // Returns NULL on failure. Caller must free.
 u8 *network_get(const AppConfig *config, const char *path,
                 u32 *out_size, u32 *out_status);
 
+// Receives a response body chunk by chunk. write returns false to abort
+// the transfer; reset drops a partial body before the request is retried.
+typedef struct {
+    bool (*write)(void *ctx, const u8 *data, u32 len);
+    void (*reset)(void *ctx);
+    void *ctx;
+} NetworkSink;
+
+// HTTP GET that passes a 200 response's body to sink as it arrives instead
+// of buffering it (other statuses' bodies are discarded). etag, if non-NULL,
+// is a save hash sent as If-None-Match: a 304 status means the server still
+// holds exactly that version. Returns false on failure.
+bool network_get_stream(const AppConfig *config, const char *path, const char *etag,
+                        const NetworkSink *sink, u32 *out_status);
+
 // HTTP POST with binary body - returns malloc'd response body.
 // Returns NULL on failure. Caller must free.
 u8 *network_post(const AppConfig *config, const char *path,
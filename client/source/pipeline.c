@@ -0,0 +1,78 @@
+#include "pipeline.h"
+
+#define WORKER_STACK_SIZE 0x10000 // 64KB - deflate state lives on the heap
+
+void pipeline_init(Pipeline *p) {
+    memset(p, 0, sizeof(Pipeline));
+
+    // The rest of the heap is left for the jobs being worked on at either
+    // end, so big saves fit on an Old 3DS too
+    u32 budget = (u32)(osGetMemRegionFree(MEMREGION_APPLICATION) / PIPELINE_HEAP_SHARE);
+    if (budget < PIPELINE_MIN_BYTES) budget = PIPELINE_MIN_BYTES;
+    if (budget > PIPELINE_MAX_BYTES) budget = PIPELINE_MAX_BYTES;
+    p->max_bytes = budget;
+    LightLock_Init(&p->lock);
+    CondVar_Init(&p->not_empty);
+    CondVar_Init(&p->not_full);
+}
+
+void pipeline_push(Pipeline *p, const PipelineJob *job) {
+    LightLock_Lock(&p->lock);
+    while (p->count >= PIPELINE_DEPTH ||
+           (p->count > 0 && p->bytes + job->size > p->max_bytes)) {
+        CondVar_Wait(&p->not_full, &p->lock);
+    }
+
+    p->jobs[(p->head + p->count) % PIPELINE_DEPTH] = *job;
+    p->count++;
+    p->bytes += job->size;
+
+    CondVar_Signal(&p->not_empty);
+    LightLock_Unlock(&p->lock);
+}
+
+bool pipeline_pop(Pipeline *p, PipelineJob *job) {
+    LightLock_Lock(&p->lock);
+    while (p->count == 0 && !p->closed) {
+        CondVar_Wait(&p->not_empty, &p->lock);
+    }
+
+    if (p->count == 0) {
+        LightLock_Unlock(&p->lock);
+        return false;
+    }
+
+    *job = p->jobs[p->head];
+    p->head = (p->head + 1) % PIPELINE_DEPTH;
+    p->count--;
+    p->bytes -= job->size;
+
+    CondVar_Signal(&p->not_full);
+    LightLock_Unlock(&p->lock);
+    return true;
+}
+
+void pipeline_close(Pipeline *p) {
+    LightLock_Lock(&p->lock);
+    p->closed = true;
+    CondVar_Broadcast(&p->not_empty);
+    LightLock_Unlock(&p->lock);
+}
+
+Thread pipeline_start_worker(ThreadFunc func, void *arg) {
+    // Run just below the main thread so UI and network handling stay
+    // responsive; the worker fills in while the main thread waits on httpc.
+    s32 prio = 0x30;
+    svcGetThreadPriority(&prio, CUR_THREAD_HANDLE);
+    if (prio < 0x3F) prio++;
+
+    bool is_new3ds = false;
+    APT_CheckNew3DS(&is_new3ds);
+
+    Thread thread = NULL;
+    if (is_new3ds)
+        thread = threadCreate(func, arg, WORKER_STACK_SIZE, prio, 2, false);
+    if (!thread)
+        thread = threadCreate(func, arg, WORKER_STACK_SIZE, prio, -2, false);
+    return thread;
+}
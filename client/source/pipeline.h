@@ -0,0 +1,62 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "common.h"
+
+// Bounded producer/consumer queue for overlapping save I/O with network
+// transfers. One side runs on a worker thread (see pipeline_start_worker),
+// the other on the main thread, which keeps all UI/progress output.
+
+#define PIPELINE_DEPTH     4  // Max jobs in flight
+
+// Buffered job data is capped at a share of the free application heap,
+// kept within these bounds
+#define PIPELINE_HEAP_SHARE 4                  // 1/4 of the free heap
+#define PIPELINE_MIN_BYTES  (512 * 1024)
+#define PIPELINE_MAX_BYTES  (8 * 1024 * 1024)
+
+#define JOB_DELTA 0x1     // Job data is a block delta, not a full bundle
+#define JOB_UNCHANGED 0x2 // Server still has the local version, nothing to write
+
+// One unit of work passed between the threads
+typedef struct {
+    int index;        // Caller-defined (e.g. title index)
+    u8 *data;         // malloc'd payload (bundle or response), may be NULL
+    u32 size;
+    int result;       // SyncResult of the producing stage
+    int flags;        // JOB_* flags
+    char hash[65];    // Save hash travelling with the job
+} PipelineJob;
+
+typedef struct {
+    PipelineJob jobs[PIPELINE_DEPTH];
+    int head;
+    int count;
+    u32 bytes;        // Sum of queued job sizes
+    u32 max_bytes;    // Byte budget, sized from the heap by pipeline_init
+    bool closed;      // Producer finished
+    LightLock lock;
+    CondVar not_empty;
+    CondVar not_full;
+} Pipeline;
+
+// Set up an empty queue, sizing its byte budget from the heap free now.
+void pipeline_init(Pipeline *p);
+
+// Queue a job, blocking while the queue is full. A job larger than the
+// byte budget is still accepted once the queue has drained.
+void pipeline_push(Pipeline *p, const PipelineJob *job);
+
+// Take the next job, blocking until one is available.
+// Returns false once the producer has closed the queue and it is empty.
+bool pipeline_pop(Pipeline *p, PipelineJob *job);
+
+// Signal that no more jobs will be pushed.
+void pipeline_close(Pipeline *p);
+
+// Start a worker thread, on the extra core of a New 3DS when available.
+// Returns NULL if the thread couldn't be created (caller should run the
+// work inline instead).
+Thread pipeline_start_worker(ThreadFunc func, void *arg);
+
+#endif // PIPELINE_H
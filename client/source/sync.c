@@ -1,16 +1,23 @@
 #include "sync.h"
 #include "archive.h"
 #include "bundle.h"
+#include "delta.h"
+#include "hashcache.h"
 #include "nds.h"
 #include "network.h"
+#include "pipeline.h"
+#include "transfer.h"
 #include "sha256.h"
 
 #include <inttypes.h>
 #include <sys/stat.h>
+#include <time.h>
 
-#define MAX_SAVE_FILES 64
-#define STATE_DIR "sdmc:/3ds/3dssync/state"
-#define MAX_UPLOAD_SIZE 0x70000  // 448KB compressed - bundles are zlib compressed
+#define MAX_UPLOAD_SIZE 0x70000  // 448KB compressed - larger bundles use chunked upload
+#define MAX_CHUNKED_UPLOAD_SIZE (32 * 1024 * 1024) // Server default max_upload_size
+#define MAX_DOWNLOAD_FILES 4096 // Sanity cap on a downloaded bundle's file count
+#define MAX_DOWNLOAD_PAYLOAD MAX_CHUNKED_UPLOAD_SIZE // Largest save the server accepts
+#define UPLOAD_PART_RETRIES 3
 
 const char *sync_result_str(SyncResult result) {
     switch (result) {
@@ -24,6 +31,102 @@ const char *sync_result_str(SyncResult result) {
     }
 }
 
+// --- Timing ---
+// While sync_all runs, each phase's time (svcGetSystemTick) and bytes are
+// summed here, from whichever thread ran it, and optionally logged per
+// title as CSV rows: run start (unix time), title ID, phase, ms, bytes.
+
+static const char *const phase_names[SYNC_PHASE_COUNT] = {
+    "hash", "plan", "bundle", "upload", "download", "write",
+};
+
+static LightLock timing_lock;
+static bool timing_active = false;
+static u64 timing_ticks[SYNC_PHASE_COUNT];
+static u64 timing_bytes[SYNC_PHASE_COUNT];
+static FILE *timing_log = NULL;
+static u32 timing_run;
+
+static u32 ticks_to_ms(u64 ticks) {
+    return (u32)(ticks * 1000 / SYSCLOCK_ARM11);
+}
+
+static void timing_begin(const AppConfig *config) {
+    LightLock_Init(&timing_lock);
+    memset(timing_ticks, 0, sizeof(timing_ticks));
+    memset(timing_bytes, 0, sizeof(timing_bytes));
+    timing_run = (u32)(osGetTime() / 1000) + 946684800;
+    timing_log = NULL;
+    if (config->timing_log) {
+        struct stat st;
+        bool is_new = (stat(TIMING_LOG_PATH, &st) != 0);
+        timing_log = fopen(TIMING_LOG_PATH, "a");
+        if (timing_log && is_new) fprintf(timing_log, "run,title_id,phase,ms,bytes\n");
+    }
+    timing_active = true;
+}
+
+// Record one phase of one title (title NULL: not tied to a title)
+static void timing_record(SyncPhase phase, const TitleInfo *title, u64 start, u64 bytes) {
+    if (!timing_active) return;
+    u64 ticks = svcGetSystemTick() - start;
+
+    LightLock_Lock(&timing_lock);
+    timing_ticks[phase] += ticks;
+    timing_bytes[phase] += bytes;
+    if (timing_log) {
+        fprintf(timing_log, "%lu,%s,%s,%lu,%llu\n", (unsigned long)timing_run,
+            title ? title->title_id_hex : "-", phase_names[phase],
+            (unsigned long)ticks_to_ms(ticks), (unsigned long long)bytes);
+    }
+    LightLock_Unlock(&timing_lock);
+}
+
+// Stop recording and fill timing with the run's totals
+static void timing_end(SyncTiming *timing, u64 run_start) {
+    timing_active = false;
+    memset(timing, 0, sizeof(SyncTiming));
+    for (int i = 0; i < SYNC_PHASE_COUNT; i++) {
+        timing->phase_ms[i] = ticks_to_ms(timing_ticks[i]);
+        timing->phase_bytes[i] = timing_bytes[i];
+    }
+    timing->total_ms = ticks_to_ms(svcGetSystemTick() - run_start);
+
+    NetworkStats net;
+    network_stats_get(&net);
+    timing->requests = net.requests;
+    timing->net_sent = net.bytes_sent;
+    timing->net_received = net.bytes_received;
+
+    if (timing_log) {
+        for (int i = 0; i < SYNC_PHASE_COUNT; i++) {
+            fprintf(timing_log, "%lu,total,%s,%lu,%llu\n", (unsigned long)timing_run,
+                phase_names[i], (unsigned long)timing->phase_ms[i],
+                (unsigned long long)timing->phase_bytes[i]);
+        }
+        fprintf(timing_log, "%lu,total,run,%lu,%llu\n", (unsigned long)timing_run,
+            (unsigned long)timing->total_ms,
+            (unsigned long long)(timing->net_sent + timing->net_received));
+        fclose(timing_log);
+        timing_log = NULL;
+    }
+}
+
+void sync_format_timing(const SyncTiming *t, char *out, int out_size) {
+    const u32 *ms = t->phase_ms;
+    snprintf(out, out_size,
+        "%lu.%lus: hash %lu.%lu, pack %lu.%lu, up %lu.%lu,\n"
+        "down %lu.%lu, write %lu.%lu; %lu req, %luKB sent, %luKB recv",
+        (unsigned long)(t->total_ms / 1000), (unsigned long)(t->total_ms % 1000 / 100),
+        (unsigned long)(ms[SYNC_PHASE_HASH] / 1000), (unsigned long)(ms[SYNC_PHASE_HASH] % 1000 / 100),
+        (unsigned long)(ms[SYNC_PHASE_BUNDLE] / 1000), (unsigned long)(ms[SYNC_PHASE_BUNDLE] % 1000 / 100),
+        (unsigned long)(ms[SYNC_PHASE_UPLOAD] / 1000), (unsigned long)(ms[SYNC_PHASE_UPLOAD] % 1000 / 100),
+        (unsigned long)(ms[SYNC_PHASE_DOWNLOAD] / 1000), (unsigned long)(ms[SYNC_PHASE_DOWNLOAD] % 1000 / 100),
+        (unsigned long)(ms[SYNC_PHASE_WRITE] / 1000), (unsigned long)(ms[SYNC_PHASE_WRITE] % 1000 / 100),
+        (unsigned long)t->requests, (unsigned long)(t->net_sent / 1024),
+        (unsigned long)(t->net_received / 1024));
+}
+
 // Load the last synced hash for a title from the state file.
 // Returns true and fills hash_out (65 bytes) on success.
 static bool load_last_synced_hash(const char *title_id_hex, char *hash_out) {
@@ -70,6 +173,122 @@ static bool save_last_synced_hash(const char *title_id_hex, const char *hash) {
     return written == 64;
 }
 
+// --- Save details cache ---
+// What the details and confirm dialogs show, per title, so they can open at
+// once. Entries are filled by syncs (the hashes they compute and the /sync
+// plan) and by a background refresh that rehashes the save (through the
+// hash cache) and fetches /saves/{id}/meta. Guarded by details_lock, since
+// upload/download workers record into it too.
+
+#define DETAILS_CACHE_MAX 32
+
+typedef struct {
+    u64 title_id;
+    SaveDetails details;
+    u64 local_sig;      // Change signature the local fields were read under
+    bool has_sig;
+    u32 used;           // For evicting the least recently used entry
+} DetailsEntry;
+
+static DetailsEntry details_cache[DETAILS_CACHE_MAX];
+static int details_count = 0;
+static u32 details_clock = 0;
+static LightLock details_lock;
+static bool details_lock_ready = false;
+static bool details_changed = false;  // An entry changed since the last poll
+
+// Background refresh of one title (see sync_details_open)
+static Thread details_thread = NULL;
+static const AppConfig *details_config;
+static TitleInfo details_title;
+
+static void details_init(void) {
+    if (details_lock_ready) return;
+    LightLock_Init(&details_lock);
+    details_lock_ready = true;
+}
+
+// Find a title's entry, creating it (evicting the oldest) if create is set.
+// Call with details_lock held.
+static DetailsEntry *details_entry(u64 title_id, bool create) {
+    DetailsEntry *oldest = NULL;
+    for (int i = 0; i < details_count; i++) {
+        DetailsEntry *e = &details_cache[i];
+        if (e->title_id == title_id) {
+            e->used = ++details_clock;
+            return e;
+        }
+        if (!oldest || e->used < oldest->used) oldest = e;
+    }
+    if (!create) return NULL;
+
+    DetailsEntry *e = (details_count < DETAILS_CACHE_MAX) ? &details_cache[details_count++] : oldest;
+    memset(e, 0, sizeof(*e));
+    e->title_id = title_id;
+    e->used = ++details_clock;
+    e->details.local_pending = true;
+    e->details.server_pending = true;
+    return e;
+}
+
+static void details_update_status(SaveDetails *d) {
+    d->is_synced = d->local_exists && d->server_exists &&
+                   strcmp(d->local_hash, d->server_hash) == 0;
+}
+
+// Record a local save's hash and size as computed during a sync. A file
+// count of -1 means it isn't known (only the hash was computed); a new hash
+// then leaves it unknown until the next refresh.
+static void details_note_local(const TitleInfo *title, const char *hash, u32 size,
+                               int file_count) {
+    details_init();
+    LightLock_Lock(&details_lock);
+    DetailsEntry *e = details_entry(title->title_id, true);
+    SaveDetails *d = &e->details;
+    if (d->local_pending || !d->local_exists || strcmp(d->local_hash, hash) != 0) {
+        d->local_exists = true;
+        d->local_file_count = -1;
+        strcpy(d->local_hash, hash);
+        e->has_sig = false;
+    }
+    if (size) d->local_size = size;
+    if (file_count >= 0) d->local_file_count = file_count;
+    d->local_pending = false;
+    details_update_status(d);
+    details_changed = true;
+    LightLock_Unlock(&details_lock);
+}
+
+// Record that the server now holds the same save as this console, after an
+// upload or download of hash (or, with hash NULL, the local save already
+// recorded, e.g. for titles the /sync plan reported up to date). The
+// server's date and console ID are cleared until the next refresh.
+static void details_note_synced(const TitleInfo *title, const char *hash, u32 size,
+                                int file_count) {
+    details_init();
+    if (hash) details_note_local(title, hash, size, file_count);
+
+    LightLock_Lock(&details_lock);
+    DetailsEntry *e = details_entry(title->title_id, false);
+    if (e && !e->details.local_pending && e->details.local_exists) {
+        SaveDetails *d = &e->details;
+        if (d->server_pending || !d->server_exists || strcmp(d->server_hash, d->local_hash) != 0) {
+            d->server_exists = true;
+            strcpy(d->server_hash, d->local_hash);
+            d->server_last_sync[0] = '\0';
+            d->server_console_id[0] = '\0';
+        }
+        d->server_file_count = d->local_file_count;
+        d->server_size = d->local_size;
+        d->server_pending = false;
+        d->has_last_synced = true;
+        strcpy(d->last_synced_hash, d->local_hash);
+        details_update_status(d);
+        details_changed = true;
+    }
+    LightLock_Unlock(&details_lock);
+}
+
 // Minimal JSON string search - find value for a key in a JSON string.
 // Returns pointer to the start of the value (after the colon and quote).
 // Only handles simple string/number values, not nested objects.
@@ -84,147 +303,485 @@ static const char *json_find_key(const char *json, const char *key) {
     return pos;
 }
 
-// Parse a JSON array of strings, returns count. Fills out_items.
-static int json_parse_string_array(const char *json, const char *key,
-                                   char out_items[][17], int max_items) {
-    const char *arr = json_find_key(json, key);
-    if (!arr || *arr != '[') return 0;
-    arr++; // skip '['
-
-    int count = 0;
-    while (*arr && *arr != ']' && count < max_items) {
-        // Find next quoted string
-        const char *q1 = strchr(arr, '"');
-        if (!q1) break;
-        q1++;
-        const char *q2 = strchr(q1, '"');
-        if (!q2) break;
-
-        int len = (int)(q2 - q1);
-        if (len > 0 && len <= 16) {
-            memcpy(out_items[count], q1, len);
-            out_items[count][len] = '\0';
-            count++;
+// Parse a JSON string value (no escapes, simple case)
+static bool json_parse_string(const char *json, const char *key, char *out, int out_size) {
+    const char *pos = json_find_key(json, key);
+    if (!pos || *pos != '"') return false;
+    pos++; // skip opening quote
+
+    const char *end = strchr(pos, '"');
+    if (!end) return false;
+
+    int len = (int)(end - pos);
+    if (len >= out_size) len = out_size - 1;
+    memcpy(out, pos, len);
+    out[len] = '\0';
+    return true;
+}
+
+// Parse a JSON integer value
+static bool json_parse_int(const char *json, const char *key, int *out) {
+    const char *pos = json_find_key(json, key);
+    if (!pos) return false;
+    *out = atoi(pos);
+    return true;
+}
+
+// Hex string to bytes. Returns false if malformed.
+static bool hex_to_bytes(const char *hex, u8 *out, int len) {
+    for (int i = 0; i < len * 2; i++) {
+        char c = hex[i];
+        int d;
+        if (c >= '0' && c <= '9') d = c - '0';
+        else if (c >= 'a' && c <= 'f') d = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') d = c - 'A' + 10;
+        else return false;
+        if (i & 1) out[i / 2] |= (u8)d;
+        else out[i / 2] = (u8)(d << 4);
+    }
+    return true;
+}
+
+// Write a u32 little-endian
+static void put_u32_le(u8 *buf, u32 val) {
+    buf[0] = (u8)(val);
+    buf[1] = (u8)(val >> 8);
+    buf[2] = (u8)(val >> 16);
+    buf[3] = (u8)(val >> 24);
+}
+
+// Read a u32 little-endian
+static u32 get_u32_le(const u8 *buf) {
+    return (u32)buf[0] | ((u32)buf[1] << 8) |
+           ((u32)buf[2] << 16) | ((u32)buf[3] << 24);
+}
+
+// Upload a bundle too large for one request as a chunked upload session:
+// start the session, send each part (retrying individually), then commit.
+// Sets *out_status to the HTTP status of the commit.
+static SyncResult upload_chunked(const AppConfig *config, const TitleInfo *title,
+                                 const u8 *bundle, u32 bundle_size,
+                                 SyncProgressCb progress, u32 *out_status) {
+    char path[128];
+    char body[64];
+    char msg[128];
+    snprintf(path, sizeof(path), "/saves/%s/upload", title->title_id_hex);
+    snprintf(body, sizeof(body), "{\"size\":%lu}", (unsigned long)bundle_size);
+
+    u32 resp_size, status;
+    u8 *resp = network_post_json(config, path, body, &resp_size, &status);
+    if (!resp) return SYNC_ERR_NETWORK;
+
+    u8 *resp_str = (u8 *)realloc(resp, resp_size + 1);
+    if (!resp_str) { free(resp); return SYNC_ERR_NETWORK; }
+    resp_str[resp_size] = '\0';
+
+    char upload_id[33] = {0};
+    int part_size = 0;
+    bool parsed = status == 200 &&
+        json_parse_string((char *)resp_str, "upload_id", upload_id, sizeof(upload_id)) &&
+        json_parse_int((char *)resp_str, "part_size", &part_size);
+    free(resp_str);
+    if (!parsed || part_size <= 0 || part_size > MAX_UPLOAD_SIZE) {
+        *out_status = status;
+        return SYNC_ERR_SERVER;
+    }
+
+    u32 part_count = (bundle_size + part_size - 1) / part_size;
+    for (u32 i = 0; i < part_count; i++) {
+        u32 offset = i * part_size;
+        u32 len = bundle_size - offset;
+        if (len > (u32)part_size) len = part_size;
+
+        snprintf(msg, sizeof(msg), "Uploading: %s (part %lu/%lu)",
+            title->title_id_hex, (unsigned long)(i + 1), (unsigned long)part_count);
+        if (progress) progress(msg);
+
+        snprintf(path, sizeof(path), "/saves/%s/upload/%s/%lu",
+            title->title_id_hex, upload_id, (unsigned long)i);
+
+        // Parts are idempotent on the server, so a dropped connection or a
+        // server error (5xx) only costs a resend of this part
+        bool sent = false, rejected = false, answered = false;
+        for (int attempt = 0; attempt < UPLOAD_PART_RETRIES && !sent && !rejected; attempt++) {
+            if (attempt > 0) svcSleepThread(500000000LL); // 500ms
+            resp = network_post(config, path, bundle + offset, len, &resp_size, &status);
+            if (!resp) continue;
+            free(resp);
+            answered = true;
+            if (status == 200) sent = true;
+            else if (status < 500) rejected = true; // Server refused the part - retrying won't help
+        }
+        if (!sent) {
+            *out_status = status;
+            return answered ? SYNC_ERR_SERVER : SYNC_ERR_NETWORK;
         }
-        arr = q2 + 1;
     }
+
+    snprintf(path, sizeof(path), "/saves/%s/upload/%s/commit",
+        title->title_id_hex, upload_id);
+    resp = network_post_json(config, path, "{}", &resp_size, out_status);
+    if (!resp) return SYNC_ERR_NETWORK;
+    free(resp);
+    return SYNC_OK;
+}
+
+// Read a title's save into a malloc'd files array (*files_out).
+// Returns number of files read, or -1 on error. On success the caller
+// calls archive_free_files() and then frees *files_out. progress (NULL
+// off the main thread) follows slow cartridge reads.
+static int read_save(const TitleInfo *title, ArchiveFile **files_out,
+                     SyncProgressCb progress) {
+    *files_out = NULL;
+    if (!title->is_nds)
+        return archive_read(title->title_id, title->media_type, files_out);
+
+    ArchiveFile *files = (ArchiveFile *)calloc(1, sizeof(ArchiveFile));
+    if (!files) return -1;
+    int count = (title->media_type == MEDIATYPE_GAME_CARD)
+        ? nds_cart_read_save(files, 1, progress)
+        : nds_read_save(title->sav_path, files, 1);
+    if (count < 0) { free(files); return -1; }
+    *files_out = files;
     return count;
 }
 
-// Build JSON metadata for one title
-static int build_title_json(char *buf, int buf_size, const TitleInfo *title,
-                            const char *hash, u32 total_size,
-                            const char *last_synced_hash) {
-    // Get a timestamp (seconds since 2000-01-01 from 3DS, convert to rough unix)
-    u64 ms = osGetTime(); // ms since Jan 1 2000
-    u32 timestamp = (u32)(ms / 1000) + 946684800; // add seconds from 1970 to 2000
-
-    if (last_synced_hash && last_synced_hash[0] != '\0') {
-        return snprintf(buf, buf_size,
-            "{\"title_id\":\"%s\",\"save_hash\":\"%s\","
-            "\"timestamp\":%lu,\"size\":%lu,\"last_synced_hash\":\"%s\"}",
-            title->title_id_hex, hash,
-            (unsigned long)timestamp, (unsigned long)total_size,
-            last_synced_hash);
-    } else {
-        return snprintf(buf, buf_size,
-            "{\"title_id\":\"%s\",\"save_hash\":\"%s\","
-            "\"timestamp\":%lu,\"size\":%lu}",
-            title->title_id_hex, hash,
-            (unsigned long)timestamp, (unsigned long)total_size);
-    }
+// Hash a title's current save. Archive saves are streamed rather than read
+// into memory. Returns number of files (size_out gets their total size),
+// or -1 on error.
+static int hash_save(const TitleInfo *title, char *hex_out, u32 *size_out) {
+    *size_out = 0;
+    if (!title->is_nds)
+        return bundle_hash_archive(title->title_id, title->media_type, hex_out, size_out);
+
+    ArchiveFile *files;
+    int count = read_save(title, &files, NULL);
+    if (count < 0) return -1;
+    bundle_compute_save_hash(files, count, hex_out);
+    for (int i = 0; i < count; i++) *size_out += files[i].size;
+    archive_free_files(files, count);
+    free(files);
+    return count;
 }
 
-static SyncResult upload_title_with_hash(const AppConfig *config, const TitleInfo *title,
-                                         SyncProgressCb progress, const char *save_hash) {
+// Allocate the files array for a downloaded bundle or delta, sized from the
+// file count in its header. Returns NULL if the header is unusable.
+static ArchiveFile *alloc_download_files(const u8 *data, u32 size, int *max_out) {
+    if (size < 24) return NULL;
+    u32 count = (u32)data[20] | ((u32)data[21] << 8) |
+                ((u32)data[22] << 16) | ((u32)data[23] << 24);
+    if (count > MAX_DOWNLOAD_FILES) return NULL;
+    *max_out = (int)count;
+    return (ArchiveFile *)calloc(count ? count : 1, sizeof(ArchiveFile));
+}
+
+// Fetch the server's per-block hashes of a title's current save.
+// Returns malloc'd block list, or NULL if the server has none.
+static u8 *fetch_block_list(const AppConfig *config, const TitleInfo *title, u32 *out_size) {
+    char path[64];
+    snprintf(path, sizeof(path), "/saves/%s/blocks", title->title_id_hex);
+
+    u32 status;
+    u8 *resp = network_get(config, path, out_size, &status);
+    if (resp && status != 200) { free(resp); return NULL; }
+    return resp;
+}
+
+// Read a title's save and build its upload bundle.
+// Sets *out_bundle (malloc'd, NULL if the save is empty) and fills hash_out
+// (65 bytes) with save_hash, or the computed hash if save_hash is NULL/empty.
+// If block_list (the server's current version) is given and only a small
+// part of a large save changed, builds a delta instead and sets JOB_DELTA
+// in *out_flags.
+static SyncResult prepare_upload(const AppConfig *config, const TitleInfo *title,
+                                 SyncProgressCb progress, const char *save_hash,
+                                 const u8 *block_list, u32 block_list_size, u8 **out_bundle,
+                                 u32 *out_size, char *hash_out, int *out_flags) {
+    *out_bundle = NULL;
+    *out_size = 0;
+    *out_flags = 0;
+
     char msg[128];
     snprintf(msg, sizeof(msg), "Reading save: %s", title->title_id_hex);
     if (progress) progress(msg);
 
-    // Heap-allocate to avoid stack overflow
-    ArchiveFile *files = (ArchiveFile *)malloc(MAX_SAVE_FILES * sizeof(ArchiveFile));
-    if (!files) return SYNC_ERR_ARCHIVE;
+    // Compute hash while bundling if not provided
+    bool need_hash = (!save_hash || save_hash[0] == '\0');
+    if (!need_hash) {
+        strncpy(hash_out, save_hash, 64);
+        hash_out[64] = '\0';
+    }
+
+    u64 ms = osGetTime();
+    u32 timestamp = (u32)(ms / 1000) + 946684800;
+    BundleLevel level = config->high_compression ? BUNDLE_LEVEL_HIGH : BUNDLE_LEVEL_FAST;
+
+    // Without a delta to build, stream the archive straight into the bundle
+    // instead of holding the whole save in memory
+    if (!block_list && !title->is_nds) {
+        u8 *bundle;
+        u32 bundle_size;
+        int file_count = bundle_create_archive(title->title_id, title->media_type,
+                                               timestamp, level, &bundle, &bundle_size,
+                                               need_hash ? hash_out : NULL);
+        if (file_count < 0) return SYNC_ERR_ARCHIVE;
+        if (file_count == 0) return SYNC_OK;
+        if (bundle_size > MAX_CHUNKED_UPLOAD_SIZE) {
+            free(bundle);
+            return SYNC_ERR_TOO_LARGE;
+        }
+        *out_bundle = bundle;
+        *out_size = bundle_size;
+        return SYNC_OK;
+    }
 
-    int file_count;
-    if (title->is_nds && title->media_type == MEDIATYPE_GAME_CARD)
-        file_count = nds_cart_read_save(files, MAX_SAVE_FILES);
-    else if (title->is_nds)
-        file_count = nds_read_save(title->sav_path, files, MAX_SAVE_FILES);
-    else
-        file_count = archive_read(title->title_id, title->media_type,
-                                  files, MAX_SAVE_FILES);
-    if (file_count < 0) { free(files); return SYNC_ERR_ARCHIVE; }
+    ArchiveFile *files;
+    int file_count = read_save(title, &files, progress);
+    if (file_count < 0) return SYNC_ERR_ARCHIVE;
     if (file_count == 0) { free(files); return SYNC_OK; }
 
-    // Compute hash if not provided
-    char computed_hash[65] = {0};
-    const char *hash_to_save = save_hash;
-    if (!hash_to_save || hash_to_save[0] == '\0') {
-        bundle_compute_save_hash(files, file_count, computed_hash);
-        hash_to_save = computed_hash;
+    u32 total_size = 0;
+    for (int i = 0; i < file_count; i++) total_size += files[i].size;
+
+    // Send only changed blocks when that is clearly cheaper than a full bundle
+    if (block_list && total_size >= DELTA_MIN_SAVE_SIZE) {
+        u32 delta_size, changed;
+        u8 *delta = delta_create(title->title_id, timestamp, files, file_count,
+                                 block_list, block_list_size, total_size / 2,
+                                 &delta_size, &changed);
+        if (delta && delta_size <= MAX_UPLOAD_SIZE) {
+            if (need_hash) bundle_compute_save_hash(files, file_count, hash_out);
+            archive_free_files(files, file_count);
+            free(files);
+
+            *out_bundle = delta;
+            *out_size = delta_size;
+            *out_flags = JOB_DELTA;
+            return SYNC_OK;
+        }
+        free(delta);
     }
 
-    snprintf(msg, sizeof(msg), "Uploading: %s (%d files)", title->title_id_hex, file_count);
-    if (progress) progress(msg);
-
     // Create bundle
-    u64 ms = osGetTime();
-    u32 timestamp = (u32)(ms / 1000) + 946684800;
     u32 bundle_size;
     u8 *bundle = bundle_create(title->title_id, timestamp,
-                               files, file_count, &bundle_size);
+                               files, file_count, level, &bundle_size,
+                               need_hash ? hash_out : NULL);
     archive_free_files(files, file_count);
     free(files);
 
     if (!bundle) return SYNC_ERR_BUNDLE;
 
     // Check size before attempting upload
-    if (bundle_size > MAX_UPLOAD_SIZE) {
+    if (bundle_size > MAX_CHUNKED_UPLOAD_SIZE) {
         free(bundle);
         return SYNC_ERR_TOO_LARGE;
     }
 
-    // POST to server
-    char path[64];
-    snprintf(path, sizeof(path), "/saves/%s", title->title_id_hex);
+    *out_bundle = bundle;
+    *out_size = bundle_size;
+    return SYNC_OK;
+}
 
-    u32 resp_size, status;
-    u8 *resp = network_post(config, path, bundle, bundle_size, &resp_size, &status);
-    free(bundle);
+static SyncResult upload_title_with_hash(const AppConfig *config, const TitleInfo *title,
+                                         SyncProgressCb progress, const char *save_hash,
+                                         bool try_delta);
+
+// Send a prepared bundle (or delta) and record its hash as the last synced
+// state. A delta the server can't apply falls back to a full upload.
+// Does not free the bundle.
+static SyncResult send_upload(const AppConfig *config, const TitleInfo *title,
+                              SyncProgressCb progress, const u8 *bundle,
+                              u32 bundle_size, const char *hash, int flags) {
+    char msg[128];
+    snprintf(msg, sizeof(msg), "Uploading: %s (%luKB%s)", title->title_id_hex,
+        (unsigned long)(bundle_size / 1024), (flags & JOB_DELTA) ? ", delta" : "");
+    if (progress) progress(msg);
 
-    if (!resp) return SYNC_ERR_NETWORK;
-    free(resp);
+    u32 status;
+    if (flags & JOB_DELTA) {
+        char path[64];
+        snprintf(path, sizeof(path), "/saves/%s/delta", title->title_id_hex);
+
+        u32 resp_size;
+        u8 *resp = network_post(config, path, bundle, bundle_size, &resp_size, &status);
+        if (!resp) return SYNC_ERR_NETWORK;
+        free(resp);
+
+        // 412: server save changed since the block list was fetched,
+        // 400: delta didn't rebuild cleanly - send everything instead
+        if (status == 412 || status == 400)
+            return upload_title_with_hash(config, title, progress, hash, false);
+    } else if (bundle_size > MAX_UPLOAD_SIZE) {
+        // Too big for the httpc POST buffer - send in parts
+        SyncResult res = upload_chunked(config, title, bundle, bundle_size,
+                                        progress, &status);
+        if (res != SYNC_OK) return res;
+    } else {
+        // POST to server
+        char path[64];
+        snprintf(path, sizeof(path), "/saves/%s", title->title_id_hex);
+
+        u32 resp_size;
+        u8 *resp = network_post(config, path, bundle, bundle_size, &resp_size, &status);
+        if (!resp) return SYNC_ERR_NETWORK;
+        free(resp);
+    }
 
     if (status == 200) {
         // Upload succeeded - save this hash as last synced state
-        save_last_synced_hash(title->title_id_hex, hash_to_save);
+        save_last_synced_hash(title->title_id_hex, hash);
+        details_note_synced(title, hash, 0, -1);
         return SYNC_OK;
     }
     return SYNC_ERR_SERVER;
 }
 
-static SyncResult download_title(const AppConfig *config, const TitleInfo *title,
-                                 SyncProgressCb progress) {
+static SyncResult upload_title_with_hash(const AppConfig *config, const TitleInfo *title,
+                                         SyncProgressCb progress, const char *save_hash,
+                                         bool try_delta) {
+    // The save size isn't known before reading it, so the block list is
+    // fetched up front; it's small and 404s quickly for new titles
+    u32 block_list_size = 0;
+    u8 *block_list = try_delta ? fetch_block_list(config, title, &block_list_size) : NULL;
+
+    u8 *bundle;
+    u32 bundle_size;
+    char hash[65] = {0};
+    int flags;
+    u64 start = svcGetSystemTick();
+    SyncResult res = prepare_upload(config, title, progress, save_hash, block_list,
+                                    block_list_size, &bundle, &bundle_size, hash, &flags);
+    timing_record(SYNC_PHASE_BUNDLE, title, start, bundle ? bundle_size : 0);
+    free(block_list);
+    if (res != SYNC_OK || !bundle) return res;
+
+    start = svcGetSystemTick();
+    res = send_upload(config, title, progress, bundle, bundle_size, hash, flags);
+    timing_record(SYNC_PHASE_UPLOAD, title, start, bundle_size);
+    free(bundle);
+    return res;
+}
+
+// Feeds a downloading bundle to the streaming decoder
+typedef struct {
+    BundleStream *bundle;
+    bool rejected;  // Decoder found the data bad
+} DownloadStream;
+
+static bool download_write(void *ctx, const u8 *data, u32 len) {
+    DownloadStream *d = (DownloadStream *)ctx;
+    if (!bundle_stream_feed(d->bundle, data, len)) d->rejected = true;
+    return !d->rejected;
+}
+
+static void download_reset(void *ctx) {
+    DownloadStream *d = (DownloadStream *)ctx;
+    bundle_stream_reset(d->bundle);
+    d->rejected = false;
+}
+
+// Fetch a title's save from the server. Sets *out_resp (malloc'd).
+// With a base_hash (the local save's hash), asks for a delta against it
+// first and sets JOB_DELTA in *out_flags if the server could provide one.
+// With a held_hash (the local save's hash), the full download is
+// conditional: if the server still has that version nothing is transferred
+// and JOB_UNCHANGED is set instead.
+static SyncResult fetch_download(const AppConfig *config, const TitleInfo *title,
+                                 SyncProgressCb progress, const char *base_hash,
+                                 const char *held_hash,
+                                 u8 **out_resp, u32 *out_size, int *out_flags) {
+    *out_resp = NULL;
+    *out_flags = 0;
+
     char msg[128];
     snprintf(msg, sizeof(msg), "Downloading: %s", title->title_id_hex);
     if (progress) progress(msg);
 
-    char path[64];
-    snprintf(path, sizeof(path), "/saves/%s", title->title_id_hex);
-
+    char path[160];
     u32 resp_size, status;
-    u8 *resp = network_get(config, path, &resp_size, &status);
-    if (!resp) return SYNC_ERR_NETWORK;
+    u8 *resp;
+
+    if (base_hash && base_hash[0] != '\0') {
+        snprintf(path, sizeof(path), "/saves/%s/delta?base=%s", title->title_id_hex, base_hash);
+        resp = network_get(config, path, &resp_size, &status);
+        if (resp && status == 200) {
+            *out_resp = resp;
+            *out_size = resp_size;
+            *out_flags = JOB_DELTA;
+            return SYNC_OK;
+        }
+        // Base unknown to the server (e.g. pruned) - fall back to full
+        free(resp);
+    }
+
+    // The full save is inflated and hash-checked while it downloads, so
+    // only the uncompressed copy is ever held. Asked for as v3, so files
+    // the server found incompressible arrive as-is.
+    DownloadStream stream = { bundle_stream_begin(MAX_DOWNLOAD_PAYLOAD), false };
+    if (!stream.bundle) return SYNC_ERR_BUNDLE;
+    NetworkSink sink = { download_write, download_reset, &stream };
+
+    snprintf(path, sizeof(path), "/saves/%s?format=%d", title->title_id_hex,
+             BUNDLE_VERSION_CODECS);
+    bool got = network_get_stream(config, path, held_hash, &sink, &status);
+    resp = bundle_stream_finish(stream.bundle, &resp_size);
+    if (stream.rejected) { free(resp); return SYNC_ERR_BUNDLE; }
+    if (!got) { free(resp); return SYNC_ERR_NETWORK; }
+    if (status == 304) {
+        // Already have it - just record it as synced
+        free(resp);
+        save_last_synced_hash(title->title_id_hex, held_hash);
+        details_note_synced(title, held_hash, 0, -1);
+        *out_flags = JOB_UNCHANGED;
+        return SYNC_OK;
+    }
     if (status != 200) { free(resp); return SYNC_ERR_SERVER; }
+    if (!resp) return SYNC_ERR_BUNDLE;
+
+    *out_resp = resp;
+    *out_size = resp_size;
+    return SYNC_OK;
+}
+
+// Rebuild the new save from a delta and the current local save.
+// Fills files with malloc'd data. Returns number of files, or -1 on error.
+static int apply_save_delta(const TitleInfo *title, SyncProgressCb progress,
+                            const u8 *delta, u32 delta_size,
+                            ArchiveFile *files, int max_files) {
+    ArchiveFile *base;
+    int base_count = read_save(title, &base, progress);
+    if (base_count < 0) return -1;
+
+    int file_count = delta_apply(delta, delta_size, base, base_count, files, max_files);
+    archive_free_files(base, base_count);
+    free(base);
+    return file_count;
+}
+
+// Parse a downloaded bundle (or delta, with JOB_DELTA) and write it to the
+// title's save. Records the last synced hash and refreshes the hash cache.
+// Frees resp.
+static SyncResult apply_download(const TitleInfo *title, SyncProgressCb progress,
+                                 u8 *resp, u32 resp_size, int flags) {
+    if (flags & JOB_UNCHANGED) { free(resp); return SYNC_OK; }
 
-    // Heap-allocate to avoid stack overflow
-    ArchiveFile *files = (ArchiveFile *)malloc(MAX_SAVE_FILES * sizeof(ArchiveFile));
+    int max_files;
+    ArchiveFile *files = alloc_download_files(resp, resp_size, &max_files);
     if (!files) { free(resp); return SYNC_ERR_BUNDLE; }
 
     u64 tid;
     u32 ts;
     u8 *decompressed = NULL;
-    int file_count = bundle_parse(resp, resp_size, &tid, &ts, files, MAX_SAVE_FILES, &decompressed);
+    int file_count;
+    if (flags & JOB_DELTA) {
+        // Rebuilt files own their data
+        file_count = apply_save_delta(title, progress, resp, resp_size, files, max_files);
+        free(resp);
+        resp = NULL;
+    } else {
+        file_count = bundle_parse(resp, resp_size, &tid, &ts, files, max_files, &decompressed);
+    }
     if (file_count < 0) {
         free(files);
         if (decompressed) free(decompressed);
@@ -235,18 +792,30 @@ static SyncResult download_title(const AppConfig *config, const TitleInfo *title
     // Compute hash of downloaded save (before write, while data is valid)
     char new_hash[65];
     bundle_compute_save_hash(files, file_count, new_hash);
+    u32 new_size = 0;
+    for (int i = 0; i < file_count; i++) new_size += files[i].size;
 
+    char msg[128];
     snprintf(msg, sizeof(msg), "Writing save: %s (%d files)", title->title_id_hex, file_count);
     if (progress) progress(msg);
 
     // Write save data
+    u64 write_start = svcGetSystemTick();
     bool ok;
-    if (title->is_nds && title->media_type == MEDIATYPE_GAME_CARD)
-        ok = nds_cart_write_save(files, file_count);
-    else if (title->is_nds)
+    if (title->is_nds && title->media_type == MEDIATYPE_GAME_CARD) {
+        u32 written;
+        ok = nds_cart_write_save(files, file_count, &written, progress);
+        if (ok) {
+            snprintf(msg, sizeof(msg), "Cartridge: %luKB of %luKB rewritten",
+                (unsigned long)(written / 1024), (unsigned long)(new_size / 1024));
+            if (progress) progress(msg);
+        }
+    } else if (title->is_nds)
         ok = nds_write_save(title->sav_path, files, file_count);
     else
         ok = archive_write(title->title_id, title->media_type, files, file_count);
+    timing_record(SYNC_PHASE_WRITE, title, write_start, new_size);
+    if (flags & JOB_DELTA) archive_free_files(files, file_count);
     free(files);
     // Free decompressed buffer if we had a compressed bundle
     // (file data pointers point into decompressed, not resp)
@@ -256,320 +825,928 @@ static SyncResult download_title(const AppConfig *config, const TitleInfo *title
     if (ok) {
         // Download and write succeeded - save this hash as last synced state
         save_last_synced_hash(title->title_id_hex, new_hash);
+        details_note_synced(title, new_hash, new_size, file_count);
+
+        // Remember the new hash so the next sync doesn't re-read the save
+        u64 sig;
+        if (hashcache_signature(title, &sig))
+            hashcache_store(title, sig, new_hash, new_size);
+        else
+            hashcache_invalidate(title);
+        hashcache_flush();
         return SYNC_OK;
     }
+    hashcache_invalidate(title);
+    hashcache_flush();
     return SYNC_ERR_ARCHIVE;
 }
 
+static SyncResult download_title(const AppConfig *config, const TitleInfo *title,
+                                 SyncProgressCb progress, const char *base_hash,
+                                 const char *held_hash) {
+    u8 *resp;
+    u32 resp_size;
+    int flags;
+    u64 start = svcGetSystemTick();
+    SyncResult res = fetch_download(config, title, progress, base_hash, held_hash,
+                                    &resp, &resp_size, &flags);
+    timing_record(SYNC_PHASE_DOWNLOAD, title, start, res == SYNC_OK && resp ? resp_size : 0);
+    if (res != SYNC_OK) return res;
+
+    res = apply_download(title, progress, resp, resp_size, flags);
+    // Local save no longer matches the delta's base - get the full save
+    if (res == SYNC_ERR_BUNDLE && (flags & JOB_DELTA))
+        res = download_title(config, title, progress, NULL, NULL);
+    return res;
+}
+
+// Hash of the local save for conditional downloads, or NULL if there is none
+static const char *known_hash(const char *hash) {
+    if (hash[0] == '\0') return NULL;
+    if (strcmp(hash, "0000000000000000000000000000000000000000000000000000000000000000") == 0)
+        return NULL;
+    return hash;
+}
+
+// Base hash for a delta download, or NULL if a full download is cheaper
+// (small or missing local save)
+static const char *delta_base(const char *hash, u32 size) {
+    if (size < DELTA_MIN_SAVE_SIZE) return NULL;
+    return known_hash(hash);
+}
 SyncResult sync_title(const AppConfig *config, const TitleInfo *title,
                       SyncProgressCb progress) {
+    sync_details_stop();
     // For single-title sync: always upload (the server will reject if older)
     // Pass NULL for hash - upload_title_with_hash will compute it
-    return upload_title_with_hash(config, title, progress, NULL);
+    return upload_title_with_hash(config, title, progress, NULL, true);
 }
 
 SyncResult sync_download_title(const AppConfig *config, const TitleInfo *title,
                                SyncProgressCb progress) {
-    // Force download from server, ignoring local state
-    return download_title(config, title, progress);
+    sync_details_stop();
+    // Force download from server, ignoring local state (always a full save,
+    // so it also recovers a local save the server never saw)
+    return download_title(config, title, progress, NULL, NULL);
 }
 
-bool sync_all(const AppConfig *config, const TitleInfo *titles, int title_count,
-              SyncProgressCb progress, SyncSummary *summary) {
-    // Initialize summary
-    SyncSummary local_summary = {0};
+// --- Sync plan ---
+// Title IDs from the /sync response are parsed to u64 once and looked up
+// in a sorted index over the local titles, so applying the plan is
+// O(n log n) however many titles are listed.
 
-    if (progress) progress("Preparing sync metadata...");
+typedef struct {
+    u64 title_id;
+    int index;  // Into the titles array
+} TitleIndexEntry;
 
-    // Cache for computed hashes (needed for upload later)
-    char (*hash_cache)[65] = (char (*)[65])malloc(title_count * 65);
-    if (!hash_cache) return false;
+static int compare_title_index(const void *a, const void *b) {
+    u64 x = ((const TitleIndexEntry *)a)->title_id;
+    u64 y = ((const TitleIndexEntry *)b)->title_id;
+    return (x > y) - (x < y);
+}
 
-    // Heap-allocate files array to avoid stack overflow
-    ArchiveFile *files = (ArchiveFile *)malloc(MAX_SAVE_FILES * sizeof(ArchiveFile));
-    if (!files) { free(hash_cache); return false; }
+// Build a sorted index over titles. Returns malloc'd array (title_count entries).
+static TitleIndexEntry *build_title_index(const TitleInfo *titles, int title_count) {
+    TitleIndexEntry *idx = (TitleIndexEntry *)malloc((title_count + 1) * sizeof(TitleIndexEntry));
+    if (!idx) return NULL;
+    for (int i = 0; i < title_count; i++) {
+        idx[i].title_id = titles[i].title_id;
+        idx[i].index = i;
+    }
+    qsort(idx, title_count, sizeof(TitleIndexEntry), compare_title_index);
+    return idx;
+}
 
-    // Build JSON for sync request
-    // Estimate: ~230 bytes per title (with last_synced_hash) + overhead
-    int json_cap = title_count * 230 + 64;
-    char *json = (char *)malloc(json_cap);
-    if (!json) { free(files); free(hash_cache); return false; }
+// Find a title by ID. Returns its index, or -1 if not present locally.
+static int find_title(const TitleIndexEntry *idx, int title_count, u64 title_id) {
+    int lo = 0, hi = title_count - 1;
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (idx[mid].title_id == title_id) return idx[mid].index;
+        if (idx[mid].title_id < title_id) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return -1;
+}
 
-    int pos = snprintf(json, json_cap, "{\"console_id\":\"%s\",\"titles\":[", config->console_id);
-    bool first_title = true;
+// Binary /sync exchange (see server/app/services/sync_binary.py).
+// Request: "3DSY", version, console ID[16], count, then per title
+// title ID (BE), hash[32], last synced hash[32] (zero = none), size, timestamp.
+// Response: "3DSP", version, count, then per title title ID (BE), action.
+#define SYNC_REQUEST_MAGIC "3DSY"
+#define SYNC_PLAN_MAGIC    "3DSP"
+#define SYNC_BINARY_VERSION 1
+#define SYNC_HEADER_SIZE   (4 + 4 + 16 + 4)
+#define SYNC_TITLE_SIZE    (8 + 32 + 32 + 4 + 4)
+#define SYNC_PLAN_HEADER   (4 + 4 + 4)
+#define SYNC_PLAN_ENTRY    (8 + 1)
+
+// Action codes as sent on the wire
+typedef enum {
+    PLAN_UPLOAD      = 0,
+    PLAN_DOWNLOAD    = 1,
+    PLAN_CONFLICT    = 2,
+    PLAN_UP_TO_DATE  = 3,
+    PLAN_SERVER_ONLY = 4,
+} PlanAction;
+
+// A sync plan resolved to local title indices
+typedef struct {
+    int *upload_order;    // title_count capacity
+    int upload_count;
+    int *download_order;  // title_count capacity
+    int download_count;
+    const char (*hashes)[65];  // Local hash per title ("" = skipped)
+    const char (*synced)[65];  // Last synced hash per title ("" = none)
+} SyncPlan;
+
+// Apply one plan entry to the plan and summary
+static void plan_apply(SyncPlan *plan, SyncSummary *summary, const TitleInfo *titles,
+                       const TitleIndexEntry *idx, int title_count,
+                       PlanAction action, u64 title_id) {
+    int j = find_title(idx, title_count, title_id);
+
+    switch (action) {
+        case PLAN_UPLOAD:
+            // A ROM without a save yet has nothing to upload
+            if (j >= 0 && !titles[j].has_save_data)
+                summary->skipped++;
+            else if (j >= 0 && plan->upload_count < title_count)
+                plan->upload_order[plan->upload_count++] = j;
+            break;
+        case PLAN_DOWNLOAD:
+            if (j >= 0 && plan->download_count < title_count)
+                plan->download_order[plan->download_count++] = j;
+            break;
+        case PLAN_SERVER_ONLY:
+            // Download if the title exists locally, otherwise it's skipped
+            if (j >= 0 && plan->download_count < title_count)
+                plan->download_order[plan->download_count++] = j;
+            else
+                summary->skipped++;
+            break;
+        case PLAN_CONFLICT:
+            // No local save means nothing to lose - safe to download
+            if (j >= 0 && !titles[j].has_save_data && plan->download_count < title_count) {
+                plan->download_order[plan->download_count++] = j;
+                break;
+            }
+            // Keep the first few conflicting title IDs for UI display
+            if (summary->conflicts < MAX_CONFLICT_DISPLAY)
+                title_id_to_hex(title_id, summary->conflict_titles[summary->conflicts]);
+            summary->conflicts++;
+            break;
+        case PLAN_UP_TO_DATE:
+            if (j >= 0) {
+                details_note_synced(&titles[j], NULL, 0, -1);
+                // Both sides agree: that is the last synced version now
+                if (plan->hashes[j][0] && strncasecmp(plan->hashes[j], plan->synced[j], 64) != 0)
+                    save_last_synced_hash(titles[j].title_id_hex, plan->hashes[j]);
+            }
+            summary->up_to_date++;
+            break;
+        default:
+            break;
+    }
+}
 
-    for (int i = 0; i < title_count; i++) {
-        // Skip cartridge games in automatic sync (use manual A/B buttons instead)
-        if (titles[i].media_type == MEDIATYPE_GAME_CARD) {
-            hash_cache[i][0] = '\0';  // Mark as skipped
-            continue;
+// Apply every entry of a binary /sync response. Returns false if malformed.
+static bool plan_parse(const u8 *resp, u32 resp_size, SyncPlan *plan, SyncSummary *summary,
+                       const TitleInfo *titles, const TitleIndexEntry *idx, int title_count) {
+    if (resp_size < SYNC_PLAN_HEADER) return false;
+    if (memcmp(resp, SYNC_PLAN_MAGIC, 4) != 0) return false;
+    if (get_u32_le(resp + 4) != SYNC_BINARY_VERSION) return false;
+
+    u32 count = get_u32_le(resp + 8);
+    if (count > (resp_size - SYNC_PLAN_HEADER) / SYNC_PLAN_ENTRY) return false;
+
+    const u8 *p = resp + SYNC_PLAN_HEADER;
+    for (u32 i = 0; i < count; i++, p += SYNC_PLAN_ENTRY) {
+        u64 title_id = 0;
+        for (int b = 0; b < 8; b++)
+            title_id = (title_id << 8) | p[b];
+        plan_apply(plan, summary, titles, idx, title_count, (PlanAction)p[8], title_id);
+    }
+    return true;
+}
+
+// --- Pipelined transfers ---
+// Uploads: a worker thread reads saves and builds bundles while the main
+// thread's transfer window sends the prepared ones, up to
+// config->transfer_window at once. Downloads: the transfer window fetches
+// while the worker parses and writes finished bundles. Progress output
+// stays on the main thread.
+
+typedef struct {
+    Pipeline queue;
+    const AppConfig *config;
+    const TitleInfo *titles;
+    const int *order;
+    int count;
+    char (*hashes)[65];
+    const u32 *sizes;
+    u8 **block_lists;     // Uploads: server block lists, prefetched per title
+    u32 *block_list_sizes;
+    int *candidates;      // Uploads: titles whose block list is fetched
+    int *sent;            // Uploads: title sent by each transfer
+    SyncResult *results;  // Downloads: per-entry result
+    int *flags;           // Downloads: per-entry JOB_* flags
+    SyncProgressCb progress;
+    SyncSummary *summary;
+} TransferWorker;
+
+// Network trouble or server errors: send fewer requests at once
+static bool transfer_back_off(int result) {
+    return result == SYNC_ERR_NETWORK || result == SYNC_ERR_SERVER;
+}
+
+static void upload_worker(void *arg) {
+    TransferWorker *w = (TransferWorker *)arg;
+    for (int i = 0; i < w->count; i++) {
+        PipelineJob job;
+        memset(&job, 0, sizeof(job));
+        job.index = w->order[i];
+        u64 start = svcGetSystemTick();
+        job.result = prepare_upload(w->config, &w->titles[job.index], NULL, w->hashes[job.index],
+                                    w->block_lists[job.index], w->block_list_sizes[job.index],
+                                    &job.data, &job.size, job.hash, &job.flags);
+        timing_record(SYNC_PHASE_BUNDLE, &w->titles[job.index], start,
+                      job.data ? job.size : 0);
+        pipeline_push(&w->queue, &job);
+    }
+    pipeline_close(&w->queue);
+}
+
+static int fetch_block_list_job(void *ctx, int i) {
+    TransferWorker *w = (TransferWorker *)ctx;
+    int t = w->candidates[i];
+    w->block_lists[t] = fetch_block_list(w->config, &w->titles[t], &w->block_list_sizes[t]);
+    return SYNC_OK;
+}
+
+static void fetch_block_list_done(void *ctx, int i, int result, int completed) {
+    TransferWorker *w = (TransferWorker *)ctx;
+    (void)i; (void)result;
+    char msg[64];
+    snprintf(msg, sizeof(msg), "Checking changes %d/%d...", completed, w->count);
+    if (w->progress) w->progress(msg);
+}
+
+// Send the next bundle the worker has prepared
+static int send_upload_job(void *ctx, int i) {
+    TransferWorker *w = (TransferWorker *)ctx;
+    PipelineJob job;
+    if (!pipeline_pop(&w->queue, &job)) return SYNC_ERR_ARCHIVE;
+    w->sent[i] = job.index;
+
+    SyncResult res = (SyncResult)job.result;
+    if (res == SYNC_OK && job.data) {
+        u64 start = svcGetSystemTick();
+        res = send_upload(w->config, &w->titles[job.index], NULL, job.data, job.size,
+                          job.hash, job.flags);
+        timing_record(SYNC_PHASE_UPLOAD, &w->titles[job.index], start, job.size);
+    }
+    free(job.data);
+    return res;
+}
+
+static void send_upload_done(void *ctx, int i, int result, int completed) {
+    TransferWorker *w = (TransferWorker *)ctx;
+    char msg[128];
+    snprintf(msg, sizeof(msg), "Uploaded %d/%d: %s",
+        completed, w->count, w->titles[w->sent[i]].title_id_hex);
+    if (w->progress) w->progress(msg);
+
+    if (result == SYNC_OK)
+        w->summary->uploaded++;
+    else
+        w->summary->failed++;
+}
+
+static void free_block_lists(u8 **block_lists, u32 *block_list_sizes,
+                             const int *order, int count) {
+    if (block_lists) {
+        for (int i = 0; i < count; i++) free(block_lists[order[i]]);
+    }
+    free(block_lists);
+    free(block_list_sizes);
+}
+
+static void run_uploads(const AppConfig *config, const TitleInfo *titles, int title_count,
+                        const int *order, int count, char (*hashes)[65],
+                        const u32 *sizes, SyncProgressCb progress, SyncSummary *summary) {
+    if (count == 0) return;
+
+    char msg[128];
+    TransferWorker w = { .config = config, .titles = titles, .order = order, .count = count,
+                         .hashes = hashes, .sizes = sizes, .progress = progress,
+                         .summary = summary };
+    w.block_lists = (u8 **)calloc(title_count, sizeof(u8 *));
+    w.block_list_sizes = (u32 *)calloc(title_count, sizeof(u32));
+    w.candidates = (int *)malloc(count * sizeof(int));
+    w.sent = (int *)malloc(count * sizeof(int));
+
+    Thread worker = NULL;
+    if (w.block_lists && w.block_list_sizes && w.candidates && w.sent) {
+        // The worker can't use the network, so fetch the server's block
+        // lists for large saves (delta candidates) here first
+        int candidate_count = 0;
+        for (int i = 0; i < count; i++) {
+            if (sizes[order[i]] >= DELTA_MIN_SAVE_SIZE) w.candidates[candidate_count++] = order[i];
         }
+        TransferBatch lists = { fetch_block_list_job, NULL, fetch_block_list_done, &w };
+        w.count = candidate_count;
+        transfer_run(&lists, candidate_count, config->transfer_window);
+        w.count = count;
 
-        char msg[128];
-        snprintf(msg, sizeof(msg), "Hashing save %d/%d: %s",
-            i + 1, title_count, titles[i].title_id_hex);
-        if (progress) progress(msg);
+        pipeline_init(&w.queue);
+        worker = pipeline_start_worker(upload_worker, &w);
+    }
+    free(w.candidates);
+    if (!worker) {
+        // No thread available - fall back to one title at a time
+        free(w.sent);
+        free_block_lists(w.block_lists, w.block_list_sizes, order, count);
+        for (int i = 0; i < count; i++) {
+            snprintf(msg, sizeof(msg), "Uploading %d/%d: %s",
+                i + 1, count, titles[order[i]].title_id_hex);
+            if (progress) progress(msg);
+
+            if (upload_title_with_hash(config, &titles[order[i]], NULL, hashes[order[i]],
+                                       sizes[order[i]] >= DELTA_MIN_SAVE_SIZE) == SYNC_OK)
+                summary->uploaded++;
+            else
+                summary->failed++;
+        }
+        return;
+    }
 
-        // Read save to compute current hash
-        int fc;
-        if (titles[i].is_nds && titles[i].media_type == MEDIATYPE_GAME_CARD)
-            fc = nds_cart_read_save(files, MAX_SAVE_FILES);
-        else if (titles[i].is_nds)
-            fc = nds_read_save(titles[i].sav_path, files, MAX_SAVE_FILES);
-        else
-            fc = archive_read(titles[i].title_id, titles[i].media_type,
-                              files, MAX_SAVE_FILES);
-        if (fc < 0) fc = 0;
+    if (progress) progress("Uploading...");
+    TransferBatch sends = { send_upload_job, transfer_back_off, send_upload_done, &w };
+    transfer_run(&sends, count, config->transfer_window);
 
-        char current_hash[65] = {0};
-        u32 total_size = 0;
-        if (fc > 0) {
-            bundle_compute_save_hash(files, fc, current_hash);
-            for (int j = 0; j < fc; j++) total_size += files[j].size;
-            archive_free_files(files, fc);
-        } else {
-            strcpy(current_hash, "0000000000000000000000000000000000000000000000000000000000000000");
+    threadJoin(worker, U64_MAX);
+    threadFree(worker);
+    free(w.sent);
+    free_block_lists(w.block_lists, w.block_list_sizes, order, count);
+}
+
+static void download_worker(void *arg) {
+    TransferWorker *w = (TransferWorker *)arg;
+    PipelineJob job;
+    while (pipeline_pop(&w->queue, &job)) {
+        const TitleInfo *title = &w->titles[w->order[job.index]];
+        w->results[job.index] = apply_download(title, NULL, job.data, job.size, job.flags);
+    }
+}
+
+// Fetch one title's save and queue it for the worker to write
+static int fetch_download_job(void *ctx, int i) {
+    TransferWorker *w = (TransferWorker *)ctx;
+    int t = w->order[i];
+
+    PipelineJob job;
+    memset(&job, 0, sizeof(job));
+    job.index = i;
+    const char *base = delta_base(w->hashes[t], w->sizes[t]);
+    u64 start = svcGetSystemTick();
+    SyncResult res = fetch_download(w->config, &w->titles[t], NULL, base,
+                                    known_hash(w->hashes[t]),
+                                    &job.data, &job.size, &job.flags);
+    timing_record(SYNC_PHASE_DOWNLOAD, &w->titles[t], start, job.data ? job.size : 0);
+    w->flags[i] = job.flags;
+    w->results[i] = res;
+    if (res == SYNC_OK)
+        pipeline_push(&w->queue, &job);
+    return res;
+}
+
+static void fetch_download_done(void *ctx, int i, int result, int completed) {
+    TransferWorker *w = (TransferWorker *)ctx;
+    (void)result;
+    char msg[128];
+    snprintf(msg, sizeof(msg), "Downloaded %d/%d: %s",
+        completed, w->count, w->titles[w->order[i]].title_id_hex);
+    if (w->progress) w->progress(msg);
+}
+
+static void run_downloads(const AppConfig *config, const TitleInfo *titles,
+                          const int *order, int count, char (*hashes)[65],
+                          const u32 *sizes, SyncProgressCb progress, SyncSummary *summary) {
+    if (count == 0) return;
+
+    char msg[128];
+    SyncResult *results = (SyncResult *)malloc(count * sizeof(SyncResult));
+    int *flags = (int *)calloc(count, sizeof(int));
+    TransferWorker w = { .config = config, .titles = titles, .order = order, .count = count,
+                         .hashes = hashes, .sizes = sizes, .results = results, .flags = flags,
+                         .progress = progress, .summary = summary };
+    pipeline_init(&w.queue);
+
+    Thread worker = (results && flags) ? pipeline_start_worker(download_worker, &w) : NULL;
+    if (!worker) {
+        // No thread available - fall back to one title at a time
+        free(results);
+        free(flags);
+        for (int i = 0; i < count; i++) {
+            snprintf(msg, sizeof(msg), "Downloading %d/%d: %s",
+                i + 1, count, titles[order[i]].title_id_hex);
+            if (progress) progress(msg);
+
+            const char *base = delta_base(hashes[order[i]], sizes[order[i]]);
+            if (download_title(config, &titles[order[i]], NULL, base,
+                               known_hash(hashes[order[i]])) == SYNC_OK)
+                summary->downloaded++;
+            else
+                summary->failed++;
         }
+        return;
+    }
 
-        // Cache this hash for potential upload later
-        strcpy(hash_cache[i], current_hash);
+    if (progress) progress("Downloading...");
+    TransferBatch fetches = { fetch_download_job, transfer_back_off, fetch_download_done, &w };
+    transfer_run(&fetches, count, config->transfer_window);
+    pipeline_close(&w.queue);
 
-        // Load last synced hash (if exists)
-        char last_synced[65] = {0};
-        bool has_last_synced = load_last_synced_hash(titles[i].title_id_hex, last_synced);
+    if (progress) progress("Writing saves...");
+    threadJoin(worker, U64_MAX);
+    threadFree(worker);
 
-        if (!first_title) pos += snprintf(json + pos, json_cap - pos, ",");
-        first_title = false;
-        pos += build_title_json(json + pos, json_cap - pos, &titles[i],
-                               current_hash, total_size,
-                               has_last_synced ? last_synced : NULL);
+    // Deltas whose base no longer matched the local save: get the full save
+    for (int i = 0; i < count; i++) {
+        if ((flags[i] & JOB_DELTA) && results[i] == SYNC_ERR_BUNDLE)
+            results[i] = download_title(config, &titles[order[i]], progress, NULL, NULL);
     }
+    free(flags);
 
-    pos += snprintf(json + pos, json_cap - pos, "]}");
+    for (int i = 0; i < count; i++) {
+        if (results[i] == SYNC_OK)
+            summary->downloaded++;
+        else
+            summary->failed++;
+    }
+    free(results);
+}
 
-    // Done with files array for hashing phase
-    free(files);
+// --- Change feed ---
+// The server numbers every save it stores; GET /changes (see
+// server/app/services/changes_binary.py) lists the titles changed after a
+// cursor. The cursor is kept after a sync that left nothing unresolved, so
+// every title's last synced hash then matches the server. If the next sync
+// finds none of its titles changed on the server since (our own uploads
+// show up with the hash we recorded for them), the /sync comparison is
+// skipped: saves that differ from their last synced hash are uploaded and
+// the rest are up to date.
+// Response: "3DSF", version, cursor (u64), flags, count, then per title
+// title ID (BE), hash[32].
+#define CHANGES_MAGIC       "3DSF"
+#define CHANGES_VERSION     1
+#define CHANGES_HEADER_SIZE (4 + 4 + 8 + 4 + 4)
+#define CHANGES_ENTRY_SIZE  (8 + 32)
+#define CHANGES_FLAG_RESET  1  // Our cursor was ahead of the server's
+#define CHANGES_CURSOR_PATH STATE_DIR "/changes_cursor.txt"
+
+// Binary bulk metadata lookup (see server/app/services/meta_binary.py).
+// Request: "3DSM", version, count, then title IDs (BE).
+// Response: "3DSI", version, count, then per title that has a save:
+// title ID (BE), hash[32], size, file count, client timestamp, last sync
+// (unix time), console ID[16].
+#define META_REQUEST_MAGIC  "3DSM"
+#define META_RESPONSE_MAGIC "3DSI"
+#define META_BINARY_VERSION 1
+#define META_HEADER_SIZE    (4 + 4 + 4)
+#define META_ENTRY_SIZE     (8 + 32 + 4 + 4 + 4 + 4 + 16)
+
+typedef struct {
+    u8 *resp;          // Response body, owns entries
+    const u8 *entries;
+    u32 count;
+    u64 cursor;
+    bool reset;
+} ChangeFeed;
+
+static bool load_changes_cursor(u64 *cursor_out) {
+    FILE *f = fopen(CHANGES_CURSOR_PATH, "r");
+    if (!f) return false;
+    unsigned long long cursor;
+    bool ok = fscanf(f, "%llu", &cursor) == 1;
+    fclose(f);
+    if (ok) *cursor_out = cursor;
+    return ok;
+}
 
-    // Send sync request
-    if (progress) progress("Sending sync request...");
+static void save_changes_cursor(u64 cursor) {
+    mkdir("sdmc:/3ds", 0777);
+    mkdir("sdmc:/3ds/3dssync", 0777);
+    mkdir(STATE_DIR, 0777);
+
+    FILE *f = fopen(CHANGES_CURSOR_PATH, "w");
+    if (!f) return;
+    fprintf(f, "%llu\n", (unsigned long long)cursor);
+    fclose(f);
+}
+
+// Fetch the changes after since (or just the current cursor if has_since
+// is false). Returns false if the server doesn't answer with a feed.
+static bool fetch_changes(const AppConfig *config, bool has_since, u64 since, ChangeFeed *feed) {
+    memset(feed, 0, sizeof(ChangeFeed));
+    char path[64];
+    if (has_since)
+        snprintf(path, sizeof(path), "/changes?since=%llu&format=binary", (unsigned long long)since);
+    else
+        snprintf(path, sizeof(path), "/changes?format=binary");
 
     u32 resp_size, status;
-    u8 *resp = network_post_json(config, "/sync", json, &resp_size, &status);
-    free(json);
+    u8 *resp = network_get(config, path, &resp_size, &status);
+    if (!resp) return false;
+    if (status != 200 || resp_size < CHANGES_HEADER_SIZE ||
+        memcmp(resp, CHANGES_MAGIC, 4) != 0 || get_u32_le(resp + 4) != CHANGES_VERSION) {
+        free(resp);
+        return false;
+    }
 
-    if (!resp) { free(hash_cache); return false; }
-    if (status != 200) { free(resp); free(hash_cache); return false; }
+    u32 count = get_u32_le(resp + 20);
+    if (count > (resp_size - CHANGES_HEADER_SIZE) / CHANGES_ENTRY_SIZE) {
+        free(resp);
+        return false;
+    }
+    feed->resp = resp;
+    feed->entries = resp + CHANGES_HEADER_SIZE;
+    feed->count = count;
+    feed->cursor = get_u32_le(resp + 8) | ((u64)get_u32_le(resp + 12) << 32);
+    feed->reset = (get_u32_le(resp + 16) & CHANGES_FLAG_RESET) != 0;
+    return true;
+}
 
-    // Null-terminate response for string parsing
-    u8 *resp_str = (u8 *)realloc(resp, resp_size + 1);
-    if (!resp_str) { free(resp); free(hash_cache); return false; }
-    resp_str[resp_size] = '\0';
-    char *plan = (char *)resp_str;
-
-    // Parse sync plan - heap allocate to avoid stack overflow (256 * 17 * 5 = 21KB)
-    char (*upload_ids)[17] = (char (*)[17])malloc(MAX_TITLES * 17);
-    char (*download_ids)[17] = (char (*)[17])malloc(MAX_TITLES * 17);
-    char (*server_only_ids)[17] = (char (*)[17])malloc(MAX_TITLES * 17);
-    char (*conflict_ids)[17] = (char (*)[17])malloc(MAX_TITLES * 17);
-    char (*up_to_date_ids)[17] = (char (*)[17])malloc(MAX_TITLES * 17);
-
-    if (!upload_ids || !download_ids || !server_only_ids || !conflict_ids || !up_to_date_ids) {
-        free(upload_ids);
-        free(download_ids);
-        free(server_only_ids);
-        free(conflict_ids);
-        free(up_to_date_ids);
-        free(resp_str);
-        free(hash_cache);
+// Ask the server whether it holds a save for any title that has neither a
+// local save nor a sync record. The feed only lists changes after the
+// cursor, so a save the server had before then would otherwise never be
+// downloaded. Answers true if the server couldn't be asked.
+static bool server_has_unsynced(const AppConfig *config, const TitleInfo *titles, int title_count,
+                                const char (*hashes)[65], const char (*synced)[65]) {
+    u8 *req = (u8 *)malloc(META_HEADER_SIZE + title_count * 8);
+    if (!req) return true;
+    u32 count = 0;
+    for (int i = 0; i < title_count; i++) {
+        if (!hashes[i][0] || titles[i].has_save_data || synced[i][0]) continue;
+        for (int b = 0; b < 8; b++)
+            req[META_HEADER_SIZE + count * 8 + b] = (u8)(titles[i].title_id >> (56 - b * 8));
+        count++;
+    }
+    if (count == 0) {
+        free(req);
         return false;
     }
+    memcpy(req, META_REQUEST_MAGIC, 4);
+    put_u32_le(req + 4, META_BINARY_VERSION);
+    put_u32_le(req + 8, count);
 
-    int upload_count = json_parse_string_array(plan, "upload", upload_ids, MAX_TITLES);
-    int download_count = json_parse_string_array(plan, "download", download_ids, MAX_TITLES);
-    int server_only_count = json_parse_string_array(plan, "server_only", server_only_ids, MAX_TITLES);
-    int conflict_count = json_parse_string_array(plan, "conflict", conflict_ids, MAX_TITLES);
-    int up_to_date_count = json_parse_string_array(plan, "up_to_date", up_to_date_ids, MAX_TITLES);
+    u32 resp_size, status;
+    u8 *resp = network_post(config, "/titles/meta", req, META_HEADER_SIZE + count * 8,
+                            &resp_size, &status);
+    free(req);
+    if (!resp) return true;
+
+    // The response only lists titles the server has a save for
+    bool ok = status == 200 && resp_size >= META_HEADER_SIZE &&
+              memcmp(resp, META_RESPONSE_MAGIC, 4) == 0 &&
+              get_u32_le(resp + 4) == META_BINARY_VERSION;
+    bool any = !ok || get_u32_le(resp + 8) != 0;
+    free(resp);
+    return any;
+}
 
-    free(resp_str);
+// Check whether the server may hold a version of one of our titles that
+// this console hasn't synced: a listed change to a title whose hash isn't
+// its last synced one, a save that was never synced at all, or a server
+// save for a title we have none of and never synced.
+static bool changes_need_compare(const AppConfig *config, const ChangeFeed *feed,
+                                 const TitleInfo *titles, const TitleIndexEntry *idx,
+                                 int title_count, const char (*hashes)[65],
+                                 const char (*synced)[65]) {
+    if (feed->reset) return true;
+    for (int i = 0; i < title_count; i++) {
+        if (hashes[i][0] && titles[i].has_save_data && !synced[i][0]) return true;
+    }
 
-    // Auto-resolve conflicts for titles without local saves -> download
-    // (no local save means nothing to lose, safe to download from server)
-    for (int i = 0; i < conflict_count; ) {
-        bool resolved = false;
-        for (int j = 0; j < title_count; j++) {
-            if (strcmp(titles[j].title_id_hex, conflict_ids[i]) == 0 &&
-                !titles[j].has_save_data) {
-                // Move to download list
-                if (download_count < MAX_TITLES) {
-                    strcpy(download_ids[download_count], conflict_ids[i]);
-                    download_count++;
-                }
-                // Remove from conflict list (shift remaining)
-                for (int k = i; k < conflict_count - 1; k++)
-                    strcpy(conflict_ids[k], conflict_ids[k + 1]);
-                conflict_count--;
-                resolved = true;
-                break;
-            }
+    const u8 *p = feed->entries;
+    for (u32 n = 0; n < feed->count; n++, p += CHANGES_ENTRY_SIZE) {
+        u64 title_id = 0;
+        for (int b = 0; b < 8; b++)
+            title_id = (title_id << 8) | p[b];
+        int j = find_title(idx, title_count, title_id);
+        if (j < 0 || !hashes[j][0]) continue;  // Not a title we sync
+
+        u8 synced_hash[32];
+        if (!hex_to_bytes(synced[j], synced_hash, 32) || memcmp(synced_hash, p + 8, 32) != 0)
+            return true;
+    }
+    return server_has_unsynced(config, titles, title_count, hashes, synced);
+}
+
+// The plan when nothing changed on the server: upload what changed here
+static void plan_local_changes(SyncPlan *plan, SyncSummary *summary, const TitleInfo *titles,
+                               int title_count) {
+    for (int i = 0; i < title_count; i++) {
+        if (!plan->hashes[i][0]) continue;
+        if (!titles[i].has_save_data) {
+            summary->skipped++;
+        } else if (strncasecmp(plan->hashes[i], plan->synced[i], 64) == 0) {
+            details_note_synced(&titles[i], NULL, 0, -1);
+            summary->up_to_date++;
+        } else {
+            plan->upload_order[plan->upload_count++] = i;
         }
-        if (!resolved) i++;
     }
+}
+
+static bool run_sync_all(const AppConfig *config, const TitleInfo *titles, int title_count,
+                         SyncProgressCb progress, SyncSummary *summary) {
+    // Initialize summary
+    SyncSummary local_summary = {0};
+
+    if (progress) progress("Preparing sync metadata...");
 
-    // Record counts in summary
-    local_summary.up_to_date = up_to_date_count;
-    local_summary.conflicts = conflict_count;
-    local_summary.skipped = server_only_count; // Will reduce as we download
+    // Server changes since the last clean sync, if it keeps a change feed
+    u64 since = 0;
+    bool has_since = load_changes_cursor(&since);
+    ChangeFeed feed;
+    bool has_feed = fetch_changes(config, has_since, since, &feed);
 
-    // Copy conflict title IDs for UI display (up to MAX_CONFLICT_DISPLAY)
-    int copy_count = conflict_count < MAX_CONFLICT_DISPLAY ? conflict_count : MAX_CONFLICT_DISPLAY;
-    for (int i = 0; i < copy_count; i++) {
-        strncpy(local_summary.conflict_titles[i], conflict_ids[i], 16);
-        local_summary.conflict_titles[i][16] = '\0';
+    // Cache for computed hashes (needed for upload later)
+    char (*hash_cache)[65] = (char (*)[65])malloc(title_count * 65);
+    char (*synced_cache)[65] = (char (*)[65])malloc(title_count * 65);
+    u32 *size_cache = (u32 *)calloc(title_count, sizeof(u32));
+    if (!hash_cache || !synced_cache || !size_cache) {
+        free(hash_cache); free(synced_cache); free(size_cache); free(feed.resp);
+        return false;
     }
-    // Clear remaining slots
-    for (int i = copy_count; i < MAX_CONFLICT_DISPLAY; i++) {
-        local_summary.conflict_titles[i][0] = '\0';
+
+    // Build the binary sync request (see SYNC_REQUEST_MAGIC)
+    u8 *req = (u8 *)malloc(SYNC_HEADER_SIZE + title_count * SYNC_TITLE_SIZE);
+    if (!req) {
+        free(hash_cache); free(synced_cache); free(size_cache); free(feed.resp);
+        return false;
     }
 
-    char msg[128];
+    memcpy(req, SYNC_REQUEST_MAGIC, 4);
+    put_u32_le(req + 4, SYNC_BINARY_VERSION);
+    memset(req + 8, 0, 16);
+    memcpy(req + 8, config->console_id, strnlen(config->console_id, 16));
+    u32 req_count = 0;
+    u32 pos = SYNC_HEADER_SIZE;
 
-    // Process uploads
-    for (int i = 0; i < upload_count; i++) {
-        // Find the title and its cached hash
-        for (int j = 0; j < title_count; j++) {
-            if (strcmp(titles[j].title_id_hex, upload_ids[i]) == 0) {
-                snprintf(msg, sizeof(msg), "Uploading %d/%d: %s",
-                    i + 1, upload_count, upload_ids[i]);
-                if (progress) progress(msg);
-
-                if (upload_title_with_hash(config, &titles[j], NULL, hash_cache[j]) == SYNC_OK)
-                    local_summary.uploaded++;
-                else
-                    local_summary.failed++;
-                break;
-            }
-        }
-    }
+    // Timestamp: seconds since 2000-01-01 from the 3DS, converted to rough unix
+    u32 timestamp = (u32)(osGetTime() / 1000) + 946684800;
 
-    // Process downloads (both "download" and "server_only")
-    int total_dl = download_count + server_only_count;
-    int dl_done = 0;
+    for (int i = 0; i < title_count; i++) {
+        // Skip cartridge games in automatic sync (use manual A/B buttons instead)
+        if (titles[i].media_type == MEDIATYPE_GAME_CARD) {
+            hash_cache[i][0] = '\0';  // Mark as skipped
+            synced_cache[i][0] = '\0';
+            continue;
+        }
 
-    for (int i = 0; i < download_count; i++) {
-        for (int j = 0; j < title_count; j++) {
-            if (strcmp(titles[j].title_id_hex, download_ids[i]) == 0) {
-                snprintf(msg, sizeof(msg), "Downloading %d/%d: %s",
-                    ++dl_done, total_dl, download_ids[i]);
-                if (progress) progress(msg);
+        char current_hash[65] = {0};
+        u32 total_size = 0;
 
-                if (download_title(config, &titles[j], NULL) == SYNC_OK)
-                    local_summary.downloaded++;
-                else
-                    local_summary.failed++;
-                break;
+        // Reuse the cached hash if the save hasn't changed since last pass
+        u64 sig;
+        bool has_sig = hashcache_signature(&titles[i], &sig);
+        if (has_sig && hashcache_lookup(&titles[i], sig, current_hash, &total_size)) {
+            details_note_local(&titles[i], current_hash, total_size, -1);
+        } else {
+            char msg[128];
+            snprintf(msg, sizeof(msg), "Hashing save %d/%d: %s",
+                i + 1, title_count, titles[i].title_id_hex);
+            if (progress) progress(msg);
+
+            u64 start = svcGetSystemTick();
+            int fc = hash_save(&titles[i], current_hash, &total_size);
+            timing_record(SYNC_PHASE_HASH, &titles[i], start, fc > 0 ? total_size : 0);
+            if (fc > 0) {
+                if (has_sig) hashcache_store(&titles[i], sig, current_hash, total_size);
+                details_note_local(&titles[i], current_hash, total_size, fc);
+            } else {
+                total_size = 0;
+                strcpy(current_hash, "0000000000000000000000000000000000000000000000000000000000000000");
             }
         }
+
+        // Cache this hash for potential upload later
+        strcpy(hash_cache[i], current_hash);
+        size_cache[i] = total_size;
+
+        // Load last synced hash (if exists)
+        char *last_synced = synced_cache[i];
+        last_synced[0] = '\0';
+        bool has_last_synced = load_last_synced_hash(titles[i].title_id_hex, last_synced);
+
+        u8 *entry = req + pos;
+        for (int b = 0; b < 8; b++)
+            entry[b] = (u8)(titles[i].title_id >> (56 - b * 8));
+        if (!hex_to_bytes(current_hash, entry + 8, 32)) memset(entry + 8, 0, 32);
+        if (!has_last_synced || !hex_to_bytes(last_synced, entry + 40, 32))
+            memset(entry + 40, 0, 32);
+        put_u32_le(entry + 72, total_size);
+        put_u32_le(entry + 76, timestamp);
+        pos += SYNC_TITLE_SIZE;
+        req_count++;
+    }
+    put_u32_le(req + 24, req_count);
+
+    hashcache_flush();
+
+    // Resolve the plan against the local titles
+    TitleIndexEntry *idx = build_title_index(titles, title_count);
+    SyncPlan plan = {0};
+    plan.upload_order = (int *)malloc((title_count + 1) * sizeof(int));
+    plan.download_order = (int *)malloc((title_count + 1) * sizeof(int));
+    plan.hashes = hash_cache;
+    plan.synced = synced_cache;
+    bool parsed = idx && plan.upload_order && plan.download_order;
+
+    if (parsed && has_feed && has_since &&
+        !changes_need_compare(config, &feed, titles, idx, title_count, hash_cache,
+                              synced_cache)) {
+        if (progress) progress("No server changes since last sync");
+        plan_local_changes(&plan, &local_summary, titles, title_count);
+    } else if (parsed) {
+        // Send sync request
+        if (progress) progress("Sending sync request...");
+
+        u32 resp_size, status;
+        u64 start = svcGetSystemTick();
+        u8 *resp = network_post(config, "/sync", req, pos, &resp_size, &status);
+        timing_record(SYNC_PHASE_PLAN, NULL, start, pos + (resp ? resp_size : 0));
+
+        parsed = resp && status == 200 &&
+            plan_parse(resp, resp_size, &plan, &local_summary, titles, idx, title_count);
+        free(resp);
+    }
+    free(req);
+    free(idx);
+    if (!parsed) {
+        free(plan.upload_order);
+        free(plan.download_order);
+        free(hash_cache);
+        free(synced_cache);
+        free(size_cache);
+        free(feed.resp);
+        return false;
     }
 
-    // server_only titles: download if title exists locally
-    for (int i = 0; i < server_only_count; i++) {
-        for (int j = 0; j < title_count; j++) {
-            if (strcmp(titles[j].title_id_hex, server_only_ids[i]) == 0) {
-                snprintf(msg, sizeof(msg), "Downloading %d/%d: %s",
-                    ++dl_done, total_dl, server_only_ids[i]);
-                if (progress) progress(msg);
-
-                if (download_title(config, &titles[j], NULL) == SYNC_OK) {
-                    local_summary.downloaded++;
-                    local_summary.skipped--; // Was counted as skipped, now downloaded
-                } else {
-                    local_summary.failed++;
-                    local_summary.skipped--;
-                }
-                break;
-            }
-        }
-        // If not found locally, remains in skipped count
+    // Clear remaining conflict display slots
+    for (int i = local_summary.conflicts; i < MAX_CONFLICT_DISPLAY; i++) {
+        local_summary.conflict_titles[i][0] = '\0';
     }
 
-    free(upload_ids);
-    free(download_ids);
-    free(server_only_ids);
-    free(conflict_ids);
-    free(up_to_date_ids);
+    run_uploads(config, titles, title_count, plan.upload_order, plan.upload_count,
+                hash_cache, size_cache, progress, &local_summary);
+    run_downloads(config, titles, plan.download_order, plan.download_count,
+                  hash_cache, size_cache, progress, &local_summary);
+
+    // Only a sync that left every title matching the server can skip the
+    // comparison next time
+    if (local_summary.conflicts == 0 && local_summary.failed == 0 && has_feed)
+        save_changes_cursor(feed.cursor);
+    else
+        remove(CHANGES_CURSOR_PATH);
+
+    free(plan.upload_order);
+    free(plan.download_order);
     free(hash_cache);
+    free(synced_cache);
+    free(size_cache);
+    free(feed.resp);
 
     if (summary) *summary = local_summary;
     return true;
 }
 
-// Parse a JSON string value (no escapes, simple case)
-static bool json_parse_string(const char *json, const char *key, char *out, int out_size) {
-    const char *pos = json_find_key(json, key);
-    if (!pos || *pos != '"') return false;
-    pos++; // skip opening quote
+bool sync_all(const AppConfig *config, const TitleInfo *titles, int title_count,
+              SyncProgressCb progress, SyncSummary *summary) {
+    sync_details_stop();
+    u64 run_start = svcGetSystemTick();
+    timing_begin(config);
+    network_stats_reset();
+
+    // Reuse one server connection for the whole run
+    network_session_begin();
+    bool ok = run_sync_all(config, titles, title_count, progress, summary);
+    network_session_end();
+
+    SyncTiming timing;
+    timing_end(&timing, run_start);
+    if (summary) summary->timing = timing;
+    return ok;
+}
 
-    const char *end = strchr(pos, '"');
-    if (!end) return false;
+// --- Save details refresh ---
 
-    int len = (int)(end - pos);
-    if (len >= out_size) len = out_size - 1;
-    memcpy(out, pos, len);
-    out[len] = '\0';
-    return true;
+// Titles the refresh asks the server about: the opened one first, then
+// the next titles in the list whose server side isn't cached yet
+static u64 details_batch[DETAILS_CACHE_MAX];
+static int details_batch_count = 0;
+
+static u64 get_u64_be(const u8 *buf) {
+    u64 val = 0;
+    for (int i = 0; i < 8; i++) val = (val << 8) | buf[i];
+    return val;
 }
 
-// Parse a JSON integer value
-static bool json_parse_int(const char *json, const char *key, int *out) {
-    const char *pos = json_find_key(json, key);
-    if (!pos) return false;
-    *out = atoi(pos);
-    return true;
+// Replace the cached server side of a title. After a network error
+// (answered false), details already cached are kept.
+static void details_store_server(u64 title_id, const SaveDetails *fresh, bool answered) {
+    LightLock_Lock(&details_lock);
+    SaveDetails *d = &details_entry(title_id, true)->details;
+    if (answered || d->server_pending) {
+        d->server_exists = fresh->server_exists;
+        d->server_file_count = fresh->server_file_count;
+        d->server_size = fresh->server_size;
+        memcpy(d->server_hash, fresh->server_hash, sizeof(d->server_hash));
+        memcpy(d->server_last_sync, fresh->server_last_sync, sizeof(d->server_last_sync));
+        memcpy(d->server_console_id, fresh->server_console_id, sizeof(d->server_console_id));
+        d->server_pending = false;
+    }
+    details_update_status(d);
+    details_changed = true;
+    LightLock_Unlock(&details_lock);
 }
 
-bool sync_get_save_details(const AppConfig *config, const TitleInfo *title,
-                           SaveDetails *details) {
-    memset(details, 0, sizeof(SaveDetails));
+// Decode one bulk metadata entry into the server fields of fresh
+static void parse_meta_entry(const u8 *entry, SaveDetails *fresh) {
+    fresh->server_exists = true;
+    for (int i = 0; i < 32; i++)
+        snprintf(fresh->server_hash + i * 2, 3, "%02x", entry[8 + i]);
+    fresh->server_size = get_u32_le(entry + 40);
+    fresh->server_file_count = (int)get_u32_le(entry + 44);
+
+    // Same form as /meta's ISO 8601 last_sync (UTC)
+    time_t last_sync = (time_t)get_u32_le(entry + 52);
+    struct tm *tm = gmtime(&last_sync);
+    if (tm) strftime(fresh->server_last_sync, sizeof(fresh->server_last_sync), "%Y-%m-%dT%H:%M:%S", tm);
+
+    memcpy(fresh->server_console_id, entry + 56, 16);
+    fresh->server_console_id[16] = '\0';
+}
 
-    // --- Get local info ---
-    ArchiveFile *files = (ArchiveFile *)malloc(MAX_SAVE_FILES * sizeof(ArchiveFile));
-    if (!files) return false;
+// Fetch the server side of every title in details_batch with one
+// POST /titles/meta. Returns false if the server couldn't answer (older
+// servers lack the endpoint), leaving the cache untouched.
+static bool details_fetch_batch(const AppConfig *config) {
+    u8 req[META_HEADER_SIZE + DETAILS_CACHE_MAX * 8];
+    memcpy(req, META_REQUEST_MAGIC, 4);
+    put_u32_le(req + 4, META_BINARY_VERSION);
+    put_u32_le(req + 8, (u32)details_batch_count);
+    for (int i = 0; i < details_batch_count; i++) {
+        for (int b = 0; b < 8; b++)
+            req[META_HEADER_SIZE + i * 8 + b] = (u8)(details_batch[i] >> (56 - b * 8));
+    }
 
-    int file_count;
-    if (title->is_nds && title->media_type == MEDIATYPE_GAME_CARD)
-        file_count = nds_cart_read_save(files, MAX_SAVE_FILES);
-    else if (title->is_nds)
-        file_count = nds_read_save(title->sav_path, files, MAX_SAVE_FILES);
-    else
-        file_count = archive_read(title->title_id, title->media_type,
-                                  files, MAX_SAVE_FILES);
-    if (file_count > 0) {
-        details->local_exists = true;
-        details->local_file_count = file_count;
+    u32 resp_size, status;
+    u8 *resp = network_post(config, "/titles/meta", req,
+                            META_HEADER_SIZE + details_batch_count * 8, &resp_size, &status);
+    if (!resp) return false;
+
+    bool ok = status == 200 && resp_size >= META_HEADER_SIZE &&
+              memcmp(resp, META_RESPONSE_MAGIC, 4) == 0 &&
+              get_u32_le(resp + 4) == META_BINARY_VERSION;
+    u32 count = ok ? get_u32_le(resp + 8) : 0;
+    if (!ok || count > (resp_size - META_HEADER_SIZE) / META_ENTRY_SIZE) {
+        free(resp);
+        return false;
+    }
 
-        // Compute hash and total size
-        bundle_compute_save_hash(files, file_count, details->local_hash);
-        for (int i = 0; i < file_count; i++) {
-            details->local_size += files[i].size;
+    // Entries come in request order; titles left out have no server save
+    const u8 *entry = resp + META_HEADER_SIZE;
+    u32 next = 0;
+    for (int i = 0; i < details_batch_count; i++) {
+        SaveDetails fresh;
+        memset(&fresh, 0, sizeof(fresh));
+        if (next < count && get_u64_be(entry) == details_batch[i]) {
+            parse_meta_entry(entry, &fresh);
+            entry += META_ENTRY_SIZE;
+            next++;
         }
-        archive_free_files(files, file_count);
-    } else {
-        details->local_exists = (file_count == 0);  // 0 files = empty save, -1 = error/no save
-        details->local_file_count = 0;
-        details->local_size = 0;
-        strcpy(details->local_hash, "N/A");
+        details_store_server(details_batch[i], &fresh, true);
     }
-    free(files);
+    free(resp);
+    return true;
+}
 
-    // --- Load last synced hash ---
-    details->has_last_synced = load_last_synced_hash(title->title_id_hex, details->last_synced_hash);
+// Fetch one title's server side from /saves/{id}/meta
+static void details_fetch_meta(const AppConfig *config, const TitleInfo *title) {
+    SaveDetails fresh;
+    memset(&fresh, 0, sizeof(fresh));
 
-    // --- Fetch server info ---
     char path[64];
     snprintf(path, sizeof(path), "/saves/%s/meta", title->title_id_hex);
 
     u32 resp_size, status;
     u8 *resp = network_get(config, path, &resp_size, &status);
+    bool answered = (resp != NULL);
 
     if (resp && status == 200) {
         // Null-terminate for string parsing
@@ -578,33 +1755,162 @@ bool sync_get_save_details(const AppConfig *config, const TitleInfo *title,
             resp_str[resp_size] = '\0';
             char *json = (char *)resp_str;
 
-            details->server_exists = true;
+            fresh.server_exists = true;
 
-            json_parse_string(json, "save_hash", details->server_hash, sizeof(details->server_hash));
-            json_parse_string(json, "last_sync", details->server_last_sync, sizeof(details->server_last_sync));
-            json_parse_string(json, "console_id", details->server_console_id, sizeof(details->server_console_id));
+            json_parse_string(json, "save_hash", fresh.server_hash, sizeof(fresh.server_hash));
+            json_parse_string(json, "last_sync", fresh.server_last_sync, sizeof(fresh.server_last_sync));
+            json_parse_string(json, "console_id", fresh.server_console_id, sizeof(fresh.server_console_id));
 
             int size = 0, fc = 0;
-            if (json_parse_int(json, "save_size", &size)) details->server_size = (u32)size;
-            if (json_parse_int(json, "file_count", &fc)) details->server_file_count = fc;
+            if (json_parse_int(json, "save_size", &size)) fresh.server_size = (u32)size;
+            if (json_parse_int(json, "file_count", &fc)) fresh.server_file_count = fc;
 
             free(resp_str);
         } else {
             free(resp);
         }
-    } else if (resp) {
+    } else {
         free(resp);
-        details->server_exists = false;
+    }
+
+    details_store_server(title->title_id, &fresh, answered);
+}
+
+// Refresh the server side of the opened title (and the rest of the batch)
+static void details_refresh_server(const AppConfig *config, const TitleInfo *title) {
+    char last_synced[65];
+    bool has_last_synced = load_last_synced_hash(title->title_id_hex, last_synced);
+
+    if (!details_fetch_batch(config))
+        details_fetch_meta(config, title);
+
+    LightLock_Lock(&details_lock);
+    SaveDetails *d = &details_entry(title->title_id, true)->details;
+    d->has_last_synced = has_last_synced;
+    if (has_last_synced) memcpy(d->last_synced_hash, last_synced, sizeof(last_synced));
+    LightLock_Unlock(&details_lock);
+}
+
+// Read the local side of a title's details. Nothing is read if the save's
+// signature still matches the cached entry; NDS saves (a single file) can
+// also come straight from the hash cache. Anything else is rehashed.
+static void details_refresh_local(const TitleInfo *title) {
+    u64 sig = 0;
+    bool has_sig = hashcache_signature(title, &sig);
+
+    LightLock_Lock(&details_lock);
+    DetailsEntry *e = details_entry(title->title_id, true);
+    bool current = has_sig && e->has_sig && e->local_sig == sig &&
+                   !e->details.local_pending && e->details.local_file_count >= 0;
+    LightLock_Unlock(&details_lock);
+    if (current) return;
+
+    char hash[65];
+    u32 size;
+    int file_count;
+    if (has_sig && title->is_nds && hashcache_lookup(title, sig, hash, &size)) {
+        file_count = 1;
     } else {
-        details->server_exists = false;
+        file_count = hash_save(title, hash, &size);
+        if (file_count > 0 && has_sig) {
+            hashcache_store(title, sig, hash, size);
+            hashcache_flush();
+        }
     }
 
-    // --- Determine sync status ---
-    if (details->local_exists && details->server_exists) {
-        details->is_synced = (strcmp(details->local_hash, details->server_hash) == 0);
+    LightLock_Lock(&details_lock);
+    e = details_entry(title->title_id, true);
+    SaveDetails *d = &e->details;
+    if (file_count > 0) {
+        d->local_exists = true;
+        d->local_file_count = file_count;
+        d->local_size = size;
+        strcpy(d->local_hash, hash);
     } else {
-        details->is_synced = false;
+        d->local_exists = (file_count == 0);  // 0 files = empty save, -1 = error/no save
+        d->local_file_count = 0;
+        d->local_size = 0;
+        strcpy(d->local_hash, "N/A");
     }
+    e->local_sig = sig;
+    e->has_sig = has_sig && file_count > 0;
+    d->local_pending = false;
+    details_update_status(d);
+    details_changed = true;
+    LightLock_Unlock(&details_lock);
+}
 
-    return true;
+// The server is asked first: /meta is quick, hashing a big save is not
+static void details_worker(void *arg) {
+    (void)arg;
+    details_refresh_server(details_config, &details_title);
+    details_refresh_local(&details_title);
+}
+
+// Copy a title's cached details, marking whether a refresh is still running
+static void details_copy(const TitleInfo *title, SaveDetails *details) {
+    LightLock_Lock(&details_lock);
+    DetailsEntry *e = details_entry(title->title_id, false);
+    if (e) {
+        *details = e->details;
+    } else {
+        memset(details, 0, sizeof(SaveDetails));
+        details->local_pending = true;
+        details->server_pending = true;
+    }
+    details->refreshing = details_thread && details_title.title_id == title->title_id;
+    LightLock_Unlock(&details_lock);
+}
+
+void sync_details_open(const AppConfig *config, const TitleInfo *titles, int title_count,
+                       int index, SaveDetails *details) {
+    const TitleInfo *title = &titles[index];
+    sync_details_stop();
+    details_config = config;
+    details_title = *title;
+
+    details_batch[0] = title->title_id;
+    details_batch_count = 1;
+    LightLock_Lock(&details_lock);
+    for (int n = 1; n < title_count && details_batch_count < DETAILS_CACHE_MAX; n++) {
+        const TitleInfo *t = &titles[(index + n) % title_count];
+        DetailsEntry *e = details_entry(t->title_id, false);
+        if (e && !e->details.server_pending) continue;
+
+        // The server answers each title once
+        bool listed = false;
+        for (int i = 0; i < details_batch_count && !listed; i++)
+            listed = (details_batch[i] == t->title_id);
+        if (!listed) details_batch[details_batch_count++] = t->title_id;
+    }
+    LightLock_Unlock(&details_lock);
+
+    details_thread = pipeline_start_worker(details_worker, NULL);
+    if (!details_thread) details_worker(NULL);
+    details_copy(title, details);
+}
+
+bool sync_details_poll(const TitleInfo *title, SaveDetails *details) {
+    details_init();
+    bool finished = details_thread && R_SUCCEEDED(threadJoin(details_thread, 0));
+    if (finished) {
+        threadFree(details_thread);
+        details_thread = NULL;
+    }
+
+    LightLock_Lock(&details_lock);
+    bool changed = details_changed || finished;
+    details_changed = false;
+    LightLock_Unlock(&details_lock);
+
+    if (changed) details_copy(title, details);
+    return changed;
+}
+
+void sync_details_stop(void) {
+    details_init();
+    if (!details_thread) return;
+    threadJoin(details_thread, U64_MAX);
+    threadFree(details_thread);
+    details_thread = NULL;
 }
@@ -14,6 +14,31 @@ typedef enum {
     SYNC_ERR_TOO_LARGE,
 } SyncResult;
 
+// Phases of a sync_all run, timed for profiling
+typedef enum {
+    SYNC_PHASE_HASH,      // Reading and hashing local saves
+    SYNC_PHASE_PLAN,      // The /sync request
+    SYNC_PHASE_BUNDLE,    // Reading saves and building upload bundles/deltas
+    SYNC_PHASE_UPLOAD,    // Sending bundles
+    SYNC_PHASE_DOWNLOAD,  // Fetching (and inflating) saves
+    SYNC_PHASE_WRITE,     // Writing downloaded saves
+    SYNC_PHASE_COUNT,
+} SyncPhase;
+
+// Time and bytes per phase, summed over titles. Transfers run alongside
+// save I/O on other threads, so phases can add up to more than total_ms.
+typedef struct {
+    u32 phase_ms[SYNC_PHASE_COUNT];
+    // hash: save bytes read, plan: request + response, bundle: bundle bytes
+    // built, upload: bundle bytes sent, download: bundle bytes fetched
+    // (uncompressed for full saves), write: save bytes written
+    u64 phase_bytes[SYNC_PHASE_COUNT];
+    u32 total_ms;
+    u32 requests;       // HTTP requests answered by the server
+    u64 net_sent;       // Request/response body bytes over all requests
+    u64 net_received;
+} SyncTiming;
+
 // Summary of sync_all operation
 #define MAX_CONFLICT_DISPLAY 8  // Max conflicts to report for UI
 
@@ -26,6 +51,7 @@ typedef struct {
     int skipped;       // server_only titles not on this device
     // First few conflicting title IDs for display (null-terminated strings)
     char conflict_titles[MAX_CONFLICT_DISPLAY][17];
+    SyncTiming timing;
 } SyncSummary;
 
 // Callback for progress updates during sync
@@ -45,6 +71,9 @@ SyncResult sync_title(const AppConfig *config, const TitleInfo *title,
 bool sync_all(const AppConfig *config, const TitleInfo *titles, int title_count,
               SyncProgressCb progress, SyncSummary *summary);
 
+// Format a run's timing as two short lines for the summary screen
+void sync_format_timing(const SyncTiming *timing, char *out, int out_size);
+
 // Download a specific title from the server (force download, ignore local state)
 SyncResult sync_download_title(const AppConfig *config, const TitleInfo *title,
                                SyncProgressCb progress);
@@ -69,11 +98,29 @@ typedef struct {
     bool is_synced;           // local_hash == server_hash
     bool has_last_synced;     // Whether we have a sync state file
     char last_synced_hash[65];
+
+    // Cache state: fields learned from a sync rather than a refresh may be
+    // partial (file counts of -1, no server date or console ID)
+    bool local_pending;       // Local save not looked at yet
+    bool server_pending;      // Server not asked yet
+    bool refreshing;          // Background refresh still running
 } SaveDetails;
 
-// Get detailed info about a save (local + server).
-// Fills details struct with information. Returns true on success.
-bool sync_get_save_details(const AppConfig *config, const TitleInfo *title,
-                           SaveDetails *details);
+// Fill details with what is cached for titles[index] (from earlier syncs
+// and refreshes) and start refreshing them in the background: the local save
+// is rehashed through the hash cache, and one POST /titles/meta fetches the
+// server side of this title and of the following titles not cached yet, so
+// opening those is instant too (older servers: /saves/{id}/meta instead).
+// Without a worker thread the refresh runs inline, before returning.
+void sync_details_open(const AppConfig *config, const TitleInfo *titles, int title_count,
+                       int index, SaveDetails *details);
+
+// Non-blocking check for refreshed details. Returns true (and updates
+// details) if the cache changed since the last poll or the refresh finished.
+bool sync_details_poll(const TitleInfo *title, SaveDetails *details);
+
+// Wait for a running refresh to finish. The sync functions call this
+// first, since the refresh shares the hash cache with them.
+void sync_details_stop(void);
 
 #endif // SYNC_H
@@ -1,6 +1,71 @@
 #include "title.h"
+#include "hashcache.h"
 #include "nds.h"
 #include "network.h"
+#include "pipeline.h"
+#include "strpool.h"
+
+#include <sys/stat.h>
+
+// Scan cache: one entry per game/demo in the SD title list, with or
+// without save data, so a scan only probes titles it hasn't seen
+typedef struct {
+    u64 title_id;
+    bool has_save;
+    char product_code[16];
+} TitleCacheEntry;
+
+static TitleCacheEntry *cache = NULL;
+static int cache_count = 0;
+static int cache_cap = 0;
+static u32 cache_list_count = 0; // Key: size and signature of the AM title list
+static u64 cache_list_sig = 0;
+static bool cache_loaded = false;
+
+// Background revalidation: probes a snapshot of the cached entries
+static TitleCacheEntry *probe = NULL;
+static int probe_count = 0;
+static Thread probe_thread = NULL;
+static volatile bool probe_abort = false;
+
+// Names and save paths of the scanned titles; cleared by each scan
+static StrPool strings;
+
+// Make room for need items in a malloc'd array, doubling its capacity.
+static bool reserve(void **items, int *cap, int need, size_t item_size) {
+    if (need <= *cap) return true;
+    int grown_cap = *cap ? *cap * 2 : 64;
+    while (grown_cap < need) grown_cap *= 2;
+    void *grown = realloc(*items, grown_cap * item_size);
+    if (!grown) return false;
+    *items = grown;
+    *cap = grown_cap;
+    return true;
+}
+
+TitleInfo *titles_append(TitleList *list) {
+    if (!reserve((void **)&list->items, &list->capacity, list->count + 1, sizeof(TitleInfo)))
+        return NULL;
+    TitleInfo *t = &list->items[list->count++];
+    memset(t, 0, sizeof(TitleInfo));
+    t->name = "";
+    t->sav_path = "";
+    return t;
+}
+
+bool title_set_name(TitleInfo *t, const char *name) {
+    const char *pooled = strpool_add(&strings, name);
+    if (!pooled) return false;
+    t->name = pooled;
+    return true;
+}
+
+bool title_set_sav_path(TitleInfo *t, const char *path) {
+    const char *pooled = strpool_add(&strings, path);
+    if (!pooled) return false;
+    t->sav_path = pooled;
+    return true;
+}
 
 void title_id_to_hex(u64 title_id, char *out) {
     // Format as 16-char uppercase hex
@@ -22,51 +87,67 @@ static bool title_has_save(u64 title_id, FS_MediaType media_type) {
     return false;
 }
 
-// Scan a single media type for 3DS titles with save data (AM-based)
-static int scan_media(FS_MediaType media_type, TitleInfo *titles, int offset, int max_titles) {
+static bool is_game_title(u64 title_id) {
+    // Filter: only standard application titles (high word 0x00040000)
+    u32 high = (u32)(title_id >> 32);
+    return high == 0x00040000 || high == 0x00040002; // games + demos
+}
+
+static void fill_title(TitleInfo *t, u64 title_id, FS_MediaType media_type,
+                       const char *product_code) {
+    t->title_id = title_id;
+    t->media_type = media_type;
+    t->has_save_data = true;
+    title_id_to_hex(title_id, t->title_id_hex);
+    snprintf(t->product_code, sizeof(t->product_code), "%s", product_code);
+
+    // Set initial name to product code (will be updated by server lookup)
+    title_set_name(t, t->product_code[0] ? t->product_code : t->title_id_hex);
+}
+
+// Read the AM title list of a media type. Returns a malloc'd array or NULL.
+static u64 *get_title_list(FS_MediaType media_type, u32 *count_out) {
     u32 count = 0;
-    int added = 0;
+    *count_out = 0;
 
     Result res = AM_GetTitleCount(media_type, &count);
     if (R_FAILED(res) || count == 0)
-        return 0;
+        return NULL;
 
     u64 *ids = (u64 *)malloc(count * sizeof(u64));
-    if (!ids) return 0;
+    if (!ids) return NULL;
 
     u32 read = 0;
     res = AM_GetTitleList(&read, media_type, count, ids);
     if (R_FAILED(res)) {
         free(ids);
-        return 0;
+        return NULL;
     }
+    *count_out = read;
+    return ids;
+}
 
-    for (u32 i = 0; i < read && (offset + added) < max_titles; i++) {
-        // Filter: only standard application titles (high word 0x00040000)
-        u32 high = (u32)(ids[i] >> 32);
-        if (high != 0x00040000 && high != 0x00040002) // games + demos
+// Scan a single media type for 3DS titles with save data (AM-based)
+static int scan_media(FS_MediaType media_type, TitleList *list) {
+    u32 read = 0;
+    int added = 0;
+    u64 *ids = get_title_list(media_type, &read);
+    if (!ids) return 0;
+
+    for (u32 i = 0; i < read; i++) {
+        if (!is_game_title(ids[i]))
             continue;
 
         if (!title_has_save(ids[i], media_type))
             continue;
 
-        TitleInfo *t = &titles[offset + added];
-        memset(t, 0, sizeof(TitleInfo));
-        t->title_id = ids[i];
-        t->media_type = media_type;
-        t->has_save_data = true;
-        title_id_to_hex(ids[i], t->title_id_hex);
-
         // Get product code from AM
-        t->product_code[0] = '\0';
-        AM_GetTitleProductCode(media_type, ids[i], t->product_code);
+        char product_code[16] = "";
+        AM_GetTitleProductCode(media_type, ids[i], product_code);
 
-        // Set initial name to product code (will be updated by server lookup)
-        if (t->product_code[0]) {
-            snprintf(t->name, sizeof(t->name), "%s", t->product_code);
-        } else {
-            snprintf(t->name, sizeof(t->name), "%.16s", t->title_id_hex);
-        }
+        TitleInfo *t = titles_append(list);
+        if (!t) break;
+        fill_title(t, ids[i], media_type, product_code);
         added++;
     }
 
@@ -74,12 +155,149 @@ static int scan_media(FS_MediaType media_type, TitleInfo *titles, int offset, in
     return added;
 }
 
+// Load the scan cache on first use.
+// Format: a "<list count> <list signature>" line, then one
+// "<title_id> <has_save> <product_code or ->" line per title.
+static void cache_load(void) {
+    if (cache_loaded) return;
+    cache_loaded = true;
+    cache_count = 0;
+    cache_list_count = 0;
+    cache_list_sig = 0;
+
+    FILE *f = fopen(TITLECACHE_PATH, "r");
+    if (!f) return;
+
+    char line[96];
+    unsigned long list_count;
+    unsigned long long list_sig;
+    if (!fgets(line, sizeof(line), f) ||
+        sscanf(line, "%lu %16llx", &list_count, &list_sig) != 2) {
+        fclose(f);
+        return;
+    }
+
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long long tid;
+        int has_save;
+        char code[16];
+        if (sscanf(line, "%16llx %d %15s", &tid, &has_save, code) != 3)
+            continue;
+        if (!reserve((void **)&cache, &cache_cap, cache_count + 1, sizeof(TitleCacheEntry)))
+            break;
+
+        TitleCacheEntry *e = &cache[cache_count++];
+        e->title_id = tid;
+        e->has_save = has_save != 0;
+        if (strcmp(code, "-") == 0) code[0] = '\0';
+        snprintf(e->product_code, sizeof(e->product_code), "%s", code);
+    }
+    fclose(f);
+
+    cache_list_count = (u32)list_count;
+    cache_list_sig = list_sig;
+}
+
+static void cache_flush(void) {
+    mkdir("sdmc:/3ds", 0777);
+    mkdir("sdmc:/3ds/3dssync", 0777);
+    mkdir(STATE_DIR, 0777);
+
+    FILE *f = fopen(TITLECACHE_PATH, "w");
+    if (!f) return;
+
+    fprintf(f, "%lu %016llX\n", (unsigned long)cache_list_count,
+        (unsigned long long)cache_list_sig);
+    for (int i = 0; i < cache_count; i++) {
+        fprintf(f, "%016llX %d %s\n", (unsigned long long)cache[i].title_id,
+            cache[i].has_save ? 1 : 0,
+            cache[i].product_code[0] ? cache[i].product_code : "-");
+    }
+    fclose(f);
+}
+
+static TitleCacheEntry *cache_find(TitleCacheEntry *entries, int count, u64 title_id) {
+    for (int i = 0; i < count; i++) {
+        if (entries[i].title_id == title_id)
+            return &entries[i];
+    }
+    return NULL;
+}
+
+// Probe a title the way scan_media does, into a cache entry.
+static void probe_title(TitleCacheEntry *e, u64 title_id) {
+    e->title_id = title_id;
+    e->has_save = title_has_save(title_id, MEDIATYPE_SD);
+    e->product_code[0] = '\0';
+    if (e->has_save)
+        AM_GetTitleProductCode(MEDIATYPE_SD, title_id, e->product_code);
+}
+
+// Scan SD titles through the cache: the AM list is always read (one call),
+// but only titles missing from the cache get their save archive probed.
+static int scan_sd_cached(TitleList *list) {
+    u32 read = 0;
+    u64 *ids = get_title_list(MEDIATYPE_SD, &read);
+    if (!ids) return 0;
+
+    cache_load();
+    // An unchanged list means nothing to probe or rewrite
+    u64 sig = hashcache_mix(HASHCACHE_SIG_INIT, ids, read * sizeof(u64));
+    bool changed = read != cache_list_count || sig != cache_list_sig;
+
+    // Rebuild the entry list in AM order, dropping uninstalled titles.
+    // Without memory for it the old cache is kept as it is. An empty list
+    // needs no memory (malloc(0) may return NULL) and replaces the cache.
+    TitleCacheEntry *fresh =
+        read > 0 ? (TitleCacheEntry *)malloc(read * sizeof(TitleCacheEntry)) : NULL;
+    bool have_fresh = read == 0 || fresh;
+    int fresh_count = 0;
+    int added = 0;
+    for (u32 i = 0; i < read; i++) {
+        if (!is_game_title(ids[i]))
+            continue;
+
+        // Same list as last time is the common case: entries line up
+        TitleCacheEntry probed;
+        TitleCacheEntry *e;
+        if (fresh_count < cache_count && cache[fresh_count].title_id == ids[i])
+            e = &cache[fresh_count];
+        else
+            e = cache_find(cache, cache_count, ids[i]);
+        if (!e) {
+            probe_title(&probed, ids[i]);
+            e = &probed;
+            changed = true;
+        }
+
+        if (fresh)
+            fresh[fresh_count++] = *e;
+        TitleInfo *t = e->has_save ? titles_append(list) : NULL;
+        if (t) {
+            fill_title(t, e->title_id, MEDIATYPE_SD, e->product_code);
+            added++;
+        }
+    }
+    free(ids);
+
+    if (changed && have_fresh) {
+        free(cache);
+        cache = fresh;
+        cache_count = fresh_count;
+        cache_cap = (int)read;
+        cache_list_count = read;
+        cache_list_sig = sig;
+        cache_flush();
+    } else {
+        free(fresh);
+    }
+    return added;
+}
+
 // Detect a physical NDS cartridge via FS service and read its ROM header.
 // AM doesn't enumerate NDS carts, so we use FSUSER_GetCardType + GetLegacyRomHeader.
 // Returns 1 if NDS cart found and added, 0 otherwise.
-static int scan_nds_cart(TitleInfo *titles, int offset, int max_titles) {
-    if (offset >= max_titles) return 0;
-
+static int scan_nds_cart(TitleList *list) {
     // Check if a card is inserted
     bool inserted = false;
     if (R_FAILED(FSUSER_CardSlotIsInserted(&inserted)) || !inserted)
@@ -120,106 +338,382 @@ static int scan_nds_cart(TitleInfo *titles, int offset, int max_titles) {
     tid |= ((u64)(u8)code[2]) << 8;
     tid |= ((u64)(u8)code[3]);
 
-    TitleInfo *t = &titles[offset];
-    memset(t, 0, sizeof(TitleInfo));
+    TitleInfo *t = titles_append(list);
+    if (!t) return 0;
     t->title_id = tid;
     t->media_type = MEDIATYPE_GAME_CARD;
     t->is_nds = true;
     t->has_save_data = true;
     title_id_to_hex(tid, t->title_id_hex);
     memcpy(t->product_code, code, 5);
-    snprintf(t->name, sizeof(t->name), "%s", code);
+    title_set_name(t, code);
 
     return 1;
 }
 
-int titles_scan(TitleInfo *titles, int max_titles, const char *nds_dir) {
-    int total = 0;
+int titles_scan(TitleList *list, const char *nds_dir) {
+    // The previous scan's names and paths go with its titles
+    list->count = 0;
+    strpool_clear(&strings);
 
     // Scan SD card (3DS digital games)
-    total += scan_media(MEDIATYPE_SD, titles, total, max_titles);
+    scan_sd_cached(list);
 
     // Scan game card (3DS cartridge or NDS cartridge)
-    total += scan_media(MEDIATYPE_GAME_CARD, titles, total, max_titles);
-    total += scan_nds_cart(titles, total, max_titles);
+    scan_media(MEDIATYPE_GAME_CARD, list);
+    scan_nds_cart(list);
 
     // Scan NDS ROMs on SD card (nds-bootstrap)
     if (nds_dir && nds_dir[0])
-        total += nds_scan(nds_dir, titles, total, max_titles);
+        nds_scan(nds_dir, list);
+
+    return list->count;
+}
+
+static void revalidate_worker(void *arg) {
+    (void)arg;
+    for (int i = 0; i < probe_count && !probe_abort; i++)
+        probe_title(&probe[i], probe[i].title_id);
+}
+
+bool titles_revalidate_start(void) {
+    if (probe_thread || !cache_loaded || cache_count == 0) return false;
+
+    probe = (TitleCacheEntry *)malloc(cache_count * sizeof(TitleCacheEntry));
+    if (!probe) return false;
+    memcpy(probe, cache, cache_count * sizeof(TitleCacheEntry));
+    probe_count = cache_count;
+    probe_abort = false;
+    probe_thread = pipeline_start_worker(revalidate_worker, NULL);
+    if (!probe_thread) {
+        free(probe);
+        probe = NULL;
+    }
+    return probe_thread != NULL;
+}
+
+bool titles_revalidate_poll(bool *changed) {
+    *changed = false;
+    if (!probe_thread || R_FAILED(threadJoin(probe_thread, 0)))
+        return false;
+    threadFree(probe_thread);
+    probe_thread = NULL;
+
+    // A scan may have rebuilt the cache meanwhile - merge by title ID
+    for (int i = 0; i < probe_count; i++) {
+        TitleCacheEntry *e = cache_find(cache, cache_count, probe[i].title_id);
+        if (!e || e->has_save == probe[i].has_save) continue;
+        *e = probe[i];
+        *changed = true;
+    }
+    free(probe);
+    probe = NULL;
+    if (*changed) cache_flush();
+    return true;
+}
 
-    return total;
+void titles_revalidate_stop(void) {
+    if (!probe_thread) return;
+    probe_abort = true;
+    threadJoin(probe_thread, U64_MAX);
+    threadFree(probe_thread);
+    probe_thread = NULL;
+    free(probe);
+    probe = NULL;
 }
 
-// Minimal JSON parsing - find value for a key (string value)
-static bool json_get_string(const char *json, const char *key, char *out, int out_size) {
-    // Find "key":
-    char search[64];
-    snprintf(search, sizeof(search), "\"%s\"", key);
-    const char *pos = strstr(json, search);
-    if (!pos) return false;
+void titles_cache_clear(void) {
+    titles_revalidate_stop();
+    cache_count = 0;
+    cache_list_count = 0;
+    cache_list_sig = 0;
+    cache_loaded = true;
+    remove(TITLECACHE_PATH);
+}
 
-    pos += strlen(search);
-    // Skip : and whitespace
-    while (*pos == ':' || *pos == ' ' || *pos == '\t') pos++;
-    if (*pos != '"') return false;
-    pos++; // skip opening quote
+// Game name cache: names from /titles/names, including codes the server
+// has no name for, tagged with the server's name database version
+typedef struct {
+    char code[16];
+    char name[64]; // "" = no name on the server
+} NameCacheEntry;
+
+static NameCacheEntry *name_cache = NULL;
+static int name_count = 0;
+static int name_cap = 0;
+static char names_version[32] = "";
+static bool names_loaded = false;
+static bool names_dirty = false;
+
+// Load the name cache on first use.
+// Format: the database version on the first line, then "<code>\t<name>".
+static void names_load(void) {
+    if (names_loaded) return;
+    names_loaded = true;
+    name_count = 0;
+    names_version[0] = '\0';
+
+    FILE *f = fopen(NAMECACHE_PATH, "r");
+    if (!f) return;
+
+    char line[96];
+    if (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        snprintf(names_version, sizeof(names_version), "%s", line);
+    }
+    while (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        char *tab = strchr(line, '\t');
+        if (!tab || tab == line) continue;
+        *tab = '\0';
+        if (!reserve((void **)&name_cache, &name_cap, name_count + 1, sizeof(NameCacheEntry)))
+            break;
+
+        NameCacheEntry *e = &name_cache[name_count++];
+        snprintf(e->code, sizeof(e->code), "%s", line);
+        snprintf(e->name, sizeof(e->name), "%s", tab + 1);
+    }
+    fclose(f);
+}
 
-    // Copy until closing quote
+static void names_flush(void) {
+    if (!names_dirty) return;
+
+    mkdir("sdmc:/3ds", 0777);
+    mkdir("sdmc:/3ds/3dssync", 0777);
+    mkdir(STATE_DIR, 0777);
+
+    FILE *f = fopen(NAMECACHE_PATH, "w");
+    if (!f) return;
+
+    fprintf(f, "%s\n", names_version);
+    for (int i = 0; i < name_count; i++)
+        fprintf(f, "%s\t%s\n", name_cache[i].code, name_cache[i].name);
+    fclose(f);
+    names_dirty = false;
+}
+
+static NameCacheEntry *names_find(const char *code) {
+    for (int i = 0; i < name_count; i++) {
+        if (strcmp(name_cache[i].code, code) == 0)
+            return &name_cache[i];
+    }
+    return NULL;
+}
+
+static void names_put(const char *code, const char *name) {
+    NameCacheEntry *e = names_find(code);
+    if (!e) {
+        if (!reserve((void **)&name_cache, &name_cap, name_count + 1, sizeof(NameCacheEntry)))
+            return;
+        e = &name_cache[name_count++];
+        snprintf(e->code, sizeof(e->code), "%s", code);
+    }
+    // Tabs and newlines would break the cache file format
     int i = 0;
-    while (*pos && *pos != '"' && i < out_size - 1) {
-        out[i++] = *pos++;
+    for (; name[i] && i < (int)sizeof(e->name) - 1; i++)
+        e->name[i] = (name[i] == '\t' || name[i] == '\n' || name[i] == '\r') ? ' ' : name[i];
+    e->name[i] = '\0';
+    names_dirty = true;
+}
+
+static const char *json_skip_ws(const char *p) {
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') p++;
+    return p;
+}
+
+// Read a JSON string starting at its opening quote, unescaping into out
+// (truncated to out_size). Returns the position after the closing quote,
+// or NULL if the string is malformed.
+static const char *json_read_string(const char *p, char *out, int out_size) {
+    if (*p != '"') return NULL;
+    p++;
+    int n = 0;
+    while (*p && *p != '"') {
+        char c = *p++;
+        if (c == '\\') {
+            c = *p++;
+            switch (c) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case 'r': c = '\r'; break;
+                case 'b': case 'f': c = ' '; break;
+                case 'u': {
+                    unsigned cp = 0;
+                    for (int i = 0; i < 4; i++) {
+                        char h = *p;
+                        if (!h) return NULL;
+                        p++;
+                        cp = (cp << 4) | (unsigned)(h <= '9' ? h - '0' : (h | 0x20) - 'a' + 10);
+                    }
+                    // Encode as UTF-8 (surrogate pairs end up as '?')
+                    char utf8[3];
+                    int len = 1;
+                    if (cp < 0x80) {
+                        utf8[0] = (char)cp;
+                    } else if (cp < 0x800) {
+                        utf8[0] = (char)(0xC0 | (cp >> 6));
+                        utf8[1] = (char)(0x80 | (cp & 0x3F));
+                        len = 2;
+                    } else if (cp < 0xD800 || cp > 0xDFFF) {
+                        utf8[0] = (char)(0xE0 | (cp >> 12));
+                        utf8[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+                        utf8[2] = (char)(0x80 | (cp & 0x3F));
+                        len = 3;
+                    } else {
+                        utf8[0] = '?';
+                    }
+                    for (int i = 0; i < len; i++)
+                        if (n < out_size - 1) out[n++] = utf8[i];
+                    continue;
+                }
+                case '\0': return NULL;
+                default: break; // \" \\ \/
+            }
+        }
+        if (n < out_size - 1) out[n++] = c;
     }
-    out[i] = '\0';
-    return i > 0;
+    if (*p != '"') return NULL;
+    out[n] = '\0';
+    return p + 1;
 }
 
-// Fetch game names from server for all titles
-int titles_fetch_names(const AppConfig *config, TitleInfo *titles, int count) {
-    if (count <= 0) return 0;
+// Parse {"names": {"<code>": "<name>", ...}, "db_version": "..."} in one
+// pass into found (up to max entries). Returns false if malformed.
+static bool parse_names_response(const char *json, NameCacheEntry *found, int max,
+                                 int *found_count, char *version, int version_size) {
+    *found_count = 0;
+    const char *p = json_skip_ws(json);
+    if (*p++ != '{') return false;
+
+    char key[32];
+    while (true) {
+        p = json_skip_ws(p);
+        if (*p == ',') p = json_skip_ws(p + 1);
+        if (*p == '}') return true;
+        if (!(p = json_read_string(p, key, sizeof(key)))) return false;
+        p = json_skip_ws(p);
+        if (*p++ != ':') return false;
+        p = json_skip_ws(p);
+
+        if (strcmp(key, "names") == 0 && *p == '{') {
+            p++;
+            while (true) {
+                NameCacheEntry e;
+                p = json_skip_ws(p);
+                if (*p == ',') p = json_skip_ws(p + 1);
+                if (*p == '}') { p++; break; }
+                if (!(p = json_read_string(p, e.code, sizeof(e.code)))) return false;
+                p = json_skip_ws(p);
+                if (*p++ != ':') return false;
+                p = json_skip_ws(p);
+                if (!(p = json_read_string(p, e.name, sizeof(e.name)))) return false;
+                if (e.name[0] && *found_count < max) found[(*found_count)++] = e;
+            }
+        } else if (*p == '"') {
+            char value[64];
+            if (!(p = json_read_string(p, value, sizeof(value)))) return false;
+            if (strcmp(key, "db_version") == 0)
+                snprintf(version, version_size, "%s", value);
+        } else {
+            // Number/literal - nothing else is expected at the top level
+            while (*p && *p != ',' && *p != '}') p++;
+        }
+    }
+}
 
+// Ask the server for the given codes, caching names and misses.
+// Returns false if the request failed.
+static bool request_names(const AppConfig *config, const char **codes, int count) {
     // Build JSON request: {"codes": ["CTR-P-XXXX", ...]}
-    // Estimate ~20 bytes per code
     int json_cap = count * 20 + 32;
     char *json = (char *)malloc(json_cap);
-    if (!json) return 0;
+    if (!json) return false;
 
     int pos = snprintf(json, json_cap, "{\"codes\":[");
-    for (int i = 0; i < count; i++) {
-        if (titles[i].product_code[0]) {
-            if (i > 0) pos += snprintf(json + pos, json_cap - pos, ",");
-            pos += snprintf(json + pos, json_cap - pos, "\"%s\"", titles[i].product_code);
-        }
-    }
-    pos += snprintf(json + pos, json_cap - pos, "]}");
+    for (int i = 0; i < count; i++)
+        pos += snprintf(json + pos, json_cap - pos, "%s\"%s\"", i > 0 ? "," : "", codes[i]);
+    snprintf(json + pos, json_cap - pos, "]}");
 
-    // POST to server
     u32 resp_size, status;
     u8 *resp = network_post_json(config, "/titles/names", json, &resp_size, &status);
     free(json);
 
     if (!resp || status != 200) {
         if (resp) free(resp);
-        return 0;
+        return false;
     }
 
-    // Null-terminate response
     char *resp_str = (char *)realloc(resp, resp_size + 1);
-    if (!resp_str) { free(resp); return 0; }
+    if (!resp_str) { free(resp); return false; }
     resp_str[resp_size] = '\0';
 
-    // Parse response: {"names": {"CTR-P-XXXX": "Game Name", ...}}
-    // Simple parsing: for each title with a product code, search for it in the response
+    NameCacheEntry *found = (NameCacheEntry *)malloc(count * sizeof(NameCacheEntry));
+    if (!found) { free(resp_str); return false; }
+
+    char version[32] = "";
+    int found_count = 0;
+    bool ok = parse_names_response(resp_str, found, count, &found_count,
+                                   version, sizeof(version));
+    free(resp_str);
+    if (!ok) { free(found); return false; }
+
+    // Names from another database version may be stale - start over
+    if (strcmp(version, names_version) != 0) {
+        name_count = 0;
+        snprintf(names_version, sizeof(names_version), "%s", version);
+        names_dirty = true;
+    }
+    for (int i = 0; i < found_count; i++)
+        names_put(found[i].code, found[i].name);
+    free(found);
+
+    // Remember misses too, so they aren't asked for again
+    for (int i = 0; i < count; i++) {
+        if (!names_find(codes[i])) names_put(codes[i], "");
+    }
+    return true;
+}
+
+// Fetch game names for all titles: cached names are used as-is and only
+// codes not seen before (or all of them, after a database change) are
+// requested from the server.
+int titles_fetch_names(const AppConfig *config, TitleInfo *titles, int count) {
+    if (count <= 0) return 0;
+    names_load();
+
+    const char **missing = (const char **)malloc(count * sizeof(char *));
+    if (!missing) return 0;
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        int missing_count = 0;
+        for (int i = 0; i < count; i++) {
+            const char *code = titles[i].product_code;
+            if (!code[0] || names_find(code)) continue;
+
+            bool dup = false;
+            for (int j = 0; j < missing_count && !dup; j++)
+                dup = strcmp(missing[j], code) == 0;
+            if (!dup) missing[missing_count++] = code;
+        }
+        if (missing_count == 0) break;
+
+        char old_version[32];
+        snprintf(old_version, sizeof(old_version), "%s", names_version);
+        if (!request_names(config, missing, missing_count)) break;
+        // A new database version dropped the other cached names: ask for them too
+        if (strcmp(old_version, names_version) == 0) break;
+    }
+    free(missing);
+    names_flush();
+
     int updated = 0;
     for (int i = 0; i < count; i++) {
         if (!titles[i].product_code[0]) continue;
 
-        char name[64];
-        if (json_get_string(resp_str, titles[i].product_code, name, sizeof(name))) {
-            snprintf(titles[i].name, sizeof(titles[i].name), "%s", name);
+        NameCacheEntry *e = names_find(titles[i].product_code);
+        if (e && e->name[0] && title_set_name(&titles[i], e->name))
             updated++;
-        }
     }
-
-    free(resp_str);
     return updated;
 }
@@ -3,16 +3,59 @@
 
 #include "common.h"
 
+// Scan cache for SD titles, keyed on the AM title list
+#define TITLECACHE_PATH STATE_DIR "/titlecache.txt"
+
+// The title table: fixed-size TitleInfo records in one array that grows
+// as titles are added. Names and save paths are kept in a string pool
+// owned by this module and stay valid until the next scan.
+typedef struct {
+    TitleInfo *items;
+    int count;
+    int capacity;
+} TitleList;
+
 // Scan for installed titles that have save data.
-// Fills titles array, returns number found (up to MAX_TITLES).
+// Replaces the list's contents, returns the number found.
 // nds_dir: path to NDS ROM directory on SD card (NULL or "" to skip NDS scan).
-int titles_scan(TitleInfo *titles, int max_titles, const char *nds_dir);
+// SD titles come from the scan cache; only titles it doesn't know yet have
+// their save archive probed.
+int titles_scan(TitleList *list, const char *nds_dir);
+
+// Add a zeroed title (empty name and save path) to the end of the list.
+// Returns NULL if out of memory.
+TitleInfo *titles_append(TitleList *list);
+
+// Set a title's name or save path from a copy in the string pool.
+// Returns false (leaving the old value) if out of memory.
+bool title_set_name(TitleInfo *t, const char *name);
+bool title_set_sav_path(TitleInfo *t, const char *path);
+
+// Re-probe every cached SD title on a background thread, catching saves
+// created or deleted since they were cached. Returns false if not started.
+bool titles_revalidate_start(void);
+
+// Check on a background revalidation. Returns true once it has finished;
+// *changed is then set if the cache was updated and the list should be
+// rescanned.
+bool titles_revalidate_poll(bool *changed);
+
+// Abandon a background revalidation (before exit or a full rescan).
+void titles_revalidate_stop(void);
+
+// Drop the scan cache so the next scan probes every title.
+void titles_cache_clear(void);
 
 // Format a u64 title ID as a 16-char uppercase hex string.
 void title_id_to_hex(u64 title_id, char *out);
 
-// Fetch game names from server for all titles.
-// Updates title->name for each title. Returns number of names fetched.
+// Game names from the server, cached with its name database version
+#define NAMECACHE_PATH STATE_DIR "/names.txt"
+
+// Fetch game names for all titles, from the name cache where possible.
+// Only codes the cache doesn't know are sent to the server; a changed
+// database version discards the cache.
+// Updates title->name for each title. Returns number of names set.
 int titles_fetch_names(const AppConfig *config, TitleInfo *titles, int count);
 
 #endif // TITLE_H
@@ -0,0 +1,123 @@
+#include "transfer.h"
+#include "pipeline.h"
+
+#define BACKOFF_DELAY_NS 500000000LL // 500ms pause after a failed transfer
+
+typedef struct {
+    const TransferBatch *batch;
+    int count;
+    int next;         // Next transfer to hand out
+    int in_flight;
+    int limit;        // Current window, 1..window
+    int window;
+    int streak;       // Successes since the window last changed
+    int *finished;    // Completion order: index, result pairs
+    int finished_count;
+    LightLock lock;
+    CondVar changed;
+} TransferState;
+
+static void transfer_worker(void *arg) {
+    TransferState *s = (TransferState *)arg;
+    const TransferBatch *b = s->batch;
+
+    LightLock_Lock(&s->lock);
+    while (true) {
+        while (s->next < s->count && s->in_flight >= s->limit)
+            CondVar_Wait(&s->changed, &s->lock);
+        if (s->next >= s->count) break;
+
+        int index = s->next++;
+        s->in_flight++;
+        LightLock_Unlock(&s->lock);
+
+        int result = b->run(b->ctx, index);
+        bool back_off = b->should_back_off && b->should_back_off(result);
+
+        LightLock_Lock(&s->lock);
+        s->in_flight--;
+        s->finished[s->finished_count * 2] = index;
+        s->finished[s->finished_count * 2 + 1] = result;
+        s->finished_count++;
+
+        if (back_off) {
+            s->limit = s->limit > 1 ? s->limit / 2 : 1;
+            s->streak = 0;
+        } else if (s->limit < s->window && ++s->streak >= s->limit) {
+            s->limit++;
+            s->streak = 0;
+        }
+        CondVar_Broadcast(&s->changed);
+
+        if (back_off) {
+            LightLock_Unlock(&s->lock);
+            svcSleepThread(BACKOFF_DELAY_NS);
+            LightLock_Lock(&s->lock);
+        }
+    }
+    LightLock_Unlock(&s->lock);
+}
+
+void transfer_run(const TransferBatch *batch, int count, int window) {
+    if (count <= 0) return;
+    if (window > TRANSFER_WINDOW_MAX) window = TRANSFER_WINDOW_MAX;
+    if (window > count) window = count;
+
+    TransferState s;
+    memset(&s, 0, sizeof(s));
+    s.batch = batch;
+    s.count = count;
+    s.window = window;
+    s.limit = window;
+    LightLock_Init(&s.lock);
+    CondVar_Init(&s.changed);
+
+    Thread workers[TRANSFER_WINDOW_MAX];
+    int started = 0;
+    if (window > 1) {
+        s.finished = (int *)malloc(count * 2 * sizeof(int));
+        for (int i = 0; s.finished && i < window; i++) {
+            workers[started] = pipeline_start_worker(transfer_worker, &s);
+            if (workers[started]) started++;
+        }
+    }
+
+    if (started == 0) {
+        free(s.finished);
+        for (int i = 0; i < count; i++) {
+            int result = batch->run(batch->ctx, i);
+            if (batch->done) batch->done(batch->ctx, i, result, i + 1);
+        }
+        return;
+    }
+
+    // Fewer threads than asked for just means a smaller window
+    if (s.window > started) {
+        LightLock_Lock(&s.lock);
+        s.window = started;
+        if (s.limit > started) s.limit = started;
+        LightLock_Unlock(&s.lock);
+    }
+
+    int reported = 0;
+    LightLock_Lock(&s.lock);
+    while (reported < count) {
+        while (reported == s.finished_count)
+            CondVar_Wait(&s.changed, &s.lock);
+        int index = s.finished[reported * 2];
+        int result = s.finished[reported * 2 + 1];
+        reported++;
+
+        // Report without holding the lock so workers keep going
+        LightLock_Unlock(&s.lock);
+        if (batch->done) batch->done(batch->ctx, index, result, reported);
+        LightLock_Lock(&s.lock);
+    }
+    LightLock_Unlock(&s.lock);
+
+    for (int i = 0; i < started; i++) {
+        threadJoin(workers[i], U64_MAX);
+        threadFree(workers[i]);
+    }
+    free(s.finished);
+}
@@ -0,0 +1,33 @@
+#ifndef TRANSFER_H
+#define TRANSFER_H
+
+#include "common.h"
+
+// Runs a batch of network transfers with up to a window of them in flight
+// at once, each on its own worker thread. The calling thread only waits
+// and reports completions, so UI/progress output stays on it.
+//
+// When a transfer fails in a way that suggests the server or httpc is
+// struggling, the window halves (down to one) and that worker pauses
+// briefly; it grows back by one after a window's worth of successes.
+
+#define TRANSFER_WINDOW_DEFAULT 2
+#define TRANSFER_WINDOW_MAX     4
+
+typedef struct {
+    // Perform transfer `index` (0..count-1). Runs on a worker thread.
+    int (*run)(void *ctx, int index);
+    // Whether a result from run should shrink the window
+    bool (*should_back_off)(int result);
+    // Called on the calling thread as each transfer finishes, in completion
+    // order; `completed` counts finished transfers including this one
+    void (*done)(void *ctx, int index, int result, int completed);
+    void *ctx;
+} TransferBatch;
+
+// Run all count transfers and return once every one has finished.
+// With a window of 1, or if no worker thread can be started, the
+// transfers run one after another on the calling thread.
+void transfer_run(const TransferBatch *batch, int count, int window);
+
+#endif // TRANSFER_H
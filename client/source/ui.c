@@ -1,4 +1,5 @@
 #include "ui.h"
+#include "sha256.h"
 #include "sync.h"
 
 static PrintConsole top_screen;
@@ -7,15 +8,45 @@ static PrintConsole bottom_screen;
 #define TOP_ROWS    30
 #define TOP_COLS    50
 #define LIST_ROWS   (TOP_ROWS - 3) // Reserve top 2 for header, bottom 1 for count
+#define BOT_COLS    40 // Bottom screen width
+#define BOT_ROWS    30
+
+// What each row of the two screens last showed (escapes included).
+// ui_draw_title_list and ui_draw_status only print rows that changed, so
+// moving the cursor repaints two rows instead of the whole screen. Anything
+// else that draws over a screen clears its cache.
+#define ROW_BYTES 96
+static char top_drawn[TOP_ROWS + 1][ROW_BYTES];
+static char bottom_drawn[BOT_ROWS + 1][ROW_BYTES];
+
+static void invalidate_top(void) {
+    memset(top_drawn, 0, sizeof(top_drawn));
+}
+
+static void invalidate_bottom(void) {
+    memset(bottom_drawn, 0, sizeof(bottom_drawn));
+}
+
+// Print line at row (1-based) of the selected console unless it's
+// already showing there
+static void put_row(char (*drawn)[ROW_BYTES], int row, const char *line) {
+    if (strcmp(drawn[row], line) == 0) return;
+    snprintf(drawn[row], ROW_BYTES, "%s", line);
+    printf("\x1b[%d;1H%s", row, line);
+}
 
 void ui_init(void) {
     consoleInit(GFX_TOP, &top_screen);
     consoleInit(GFX_BOTTOM, &bottom_screen);
+    invalidate_top();
+    invalidate_bottom();
 }
 
 void ui_reinit(void) {
     consoleInit(GFX_TOP, &top_screen);
     consoleInit(GFX_BOTTOM, &bottom_screen);
+    invalidate_top();
+    invalidate_bottom();
 }
 
 static const char *media_type_str(const TitleInfo *t) {
@@ -36,19 +67,25 @@ static const char *view_mode_str(int view_mode) {
     }
 }
 
-void ui_draw_title_list(const TitleInfo *titles, int count, int selected, int scroll_offset, int view_mode) {
+void ui_draw_title_list(const TitleInfo *titles, const int *order, int count,
+                        int selected, int scroll_offset, int view_mode) {
     consoleSelect(&top_screen);
+    char out[ROW_BYTES];
 
     // Header (line 1) - pad to full width to overwrite without clearing
-    printf("\x1b[1;1H\x1b[36m--- Save Sync v%s %s ---\x1b[0m%-*s",
+    snprintf(out, sizeof(out), "\x1b[36m--- Save Sync v%s %s ---\x1b[0m%-*s",
         APP_VERSION, view_mode_str(view_mode), TOP_COLS - 24, "");
+    put_row(top_drawn, 1, out);
 
     if (count == 0) {
-        printf("\x1b[3;1H  No titles with save data found.%-*s", TOP_COLS - 34, "");
-        printf("\x1b[4;1H  Make sure you have games installed.%-*s", TOP_COLS - 38, "");
+        snprintf(out, sizeof(out), "  No titles with save data found.%-*s", TOP_COLS - 34, "");
+        put_row(top_drawn, 3, out);
+        snprintf(out, sizeof(out), "  Make sure you have games installed.%-*s", TOP_COLS - 38, "");
+        put_row(top_drawn, 4, out);
         // Blank remaining lines with spaces
+        snprintf(out, sizeof(out), "%-*s", TOP_COLS, "");
         for (int i = 5; i <= TOP_ROWS; i++) {
-            printf("\x1b[%d;1H%-*s", i, TOP_COLS, "");
+            put_row(top_drawn, i, out);
         }
         return;
     }
@@ -58,15 +95,14 @@ void ui_draw_title_list(const TitleInfo *titles, int count, int selected, int sc
         int row = 3 + i;  // Start at line 3
         int idx = scroll_offset + i;
 
-        printf("\x1b[%d;1H", row);  // Position cursor
-
         if (idx >= count) {
             // Blank line - overwrite with spaces
-            printf("%-*s", TOP_COLS, "");
+            snprintf(out, sizeof(out), "%-*s", TOP_COLS, "");
+            put_row(top_drawn, row, out);
             continue;
         }
 
-        const TitleInfo *t = &titles[idx];
+        const TitleInfo *t = &titles[order[idx]];
         const char *cursor = (idx == selected) ? ">" : " ";
         const char *mark = t->marked ? "*" : " ";
 
@@ -94,47 +130,57 @@ void ui_draw_title_list(const TitleInfo *titles, int count, int selected, int sc
             media_type_str(t),
             t->name);
 
-        printf("%s%-*s\x1b[0m", color, TOP_COLS, line);
+        snprintf(out, sizeof(out), "%s%-*s\x1b[0m", color, TOP_COLS, line);
+        put_row(top_drawn, row, out);
     }
 
     // Footer with count (last row) - pad to full width
     char footer[TOP_COLS + 1];
     snprintf(footer, sizeof(footer), " %d title(s) | D-Pad: navigate", count);
-    printf("\x1b[%d;1H\x1b[90m%-*s\x1b[0m", TOP_ROWS, TOP_COLS, footer);
+    snprintf(out, sizeof(out), "\x1b[90m%-*s\x1b[0m", TOP_COLS, footer);
+    put_row(top_drawn, TOP_ROWS, out);
 }
 
-#define BOT_COLS 40  // Bottom screen width
-
 void ui_draw_status(const char *status_line) {
     consoleSelect(&bottom_screen);
+    char out[ROW_BYTES];
 
     // Overwrite each line - pad to full width instead of clearing
-    printf("\x1b[1;1H\x1b[36mActions:\x1b[0m%-*s", BOT_COLS - 8, "");
-    printf("\x1b[2;1H A - Upload | B - Download%-*s", BOT_COLS - 26, "");
-    printf("\x1b[3;1H X - Sync all | Y - Save details%-*s", BOT_COLS - 32, "");
-    printf("\x1b[4;1H R - Switch tab | SELECT - Mark%-*s", BOT_COLS - 31, "");
-    printf("\x1b[5;1H L - Config | START - Exit%-*s", BOT_COLS - 26, "");
-    printf("\x1b[6;1H%-*s", BOT_COLS, "");
-    printf("\x1b[7;1H\x1b[36mCyan\x1b[0m=cart \x1b[35mMag\x1b[0m=NDS \x1b[32mGrn\x1b[0m=mark%-*s", BOT_COLS - 26, "");
-    printf("\x1b[8;1H%-*s", BOT_COLS, "");
-    printf("\x1b[9;1H%-*s", BOT_COLS, "");
-    printf("\x1b[10;1H%-*s", BOT_COLS, "");
-    printf("\x1b[11;1H%-*s", BOT_COLS, "");
+    snprintf(out, sizeof(out), "\x1b[36mActions:\x1b[0m%-*s", BOT_COLS - 8, "");
+    put_row(bottom_drawn, 1, out);
+    snprintf(out, sizeof(out), " A - Upload | B - Download%-*s", BOT_COLS - 26, "");
+    put_row(bottom_drawn, 2, out);
+    snprintf(out, sizeof(out), " X - Sync all | Y - Save details%-*s", BOT_COLS - 32, "");
+    put_row(bottom_drawn, 3, out);
+    snprintf(out, sizeof(out), " R - Switch tab | SELECT - Mark%-*s", BOT_COLS - 31, "");
+    put_row(bottom_drawn, 4, out);
+    snprintf(out, sizeof(out), " L - Config | START - Exit%-*s", BOT_COLS - 26, "");
+    put_row(bottom_drawn, 5, out);
+    snprintf(out, sizeof(out), "%-*s", BOT_COLS, "");
+    put_row(bottom_drawn, 6, out);
+    for (int row = 8; row <= 11; row++)
+        put_row(bottom_drawn, row, out);
+    snprintf(out, sizeof(out), "\x1b[36mCyan\x1b[0m=cart \x1b[35mMag\x1b[0m=NDS \x1b[32mGrn\x1b[0m=mark%-*s",
+             BOT_COLS - 26, "");
+    put_row(bottom_drawn, 7, out);
 
     char status_padded[BOT_COLS + 1];
     snprintf(status_padded, sizeof(status_padded), "%s", status_line ? status_line : "Ready.");
-    printf("\x1b[12;1H\x1b[90m%-*s\x1b[0m", BOT_COLS, status_padded);
+    snprintf(out, sizeof(out), "\x1b[90m%-*s\x1b[0m", BOT_COLS, status_padded);
+    put_row(bottom_drawn, 12, out);
 }
 
 void ui_draw_message(const char *msg) {
     consoleSelect(&bottom_screen);
     consoleClear();
+    invalidate_bottom();
     printf("\x1b[1;1H%s\n", msg);
 }
 
 void ui_update_progress(const char *msg) {
     // Lightweight update: just overwrite line 1, pad to full width
     consoleSelect(&bottom_screen);
+    bottom_drawn[1][0] = '\0';
     printf("\x1b[1;1H%-*s", BOT_COLS, msg);
 }
 
@@ -143,6 +189,8 @@ void ui_clear(void) {
     consoleClear();
     consoleSelect(&bottom_screen);
     consoleClear();
+    invalidate_top();
+    invalidate_bottom();
 }
 
 // Format size in human-readable form
@@ -168,10 +216,22 @@ static void format_date(const char *iso, char *out, int out_size) {
     }
 }
 
+// File count and size of one side of a save's details. Details learned
+// from a sync have no file count (-1) until refreshed.
+static void print_files_line(int row, int file_count, u32 size) {
+    char size_str[32];
+    format_size(size, size_str, sizeof(size_str));
+    if (file_count >= 0)
+        printf("\x1b[%d;1H Files: %d | Size: %s", row, file_count, size_str);
+    else
+        printf("\x1b[%d;1H Files: ? | Size: %s", row, size_str);
+}
+
 // Draw save details on top screen, returns current row for additional content
 static int draw_save_details(const TitleInfo *title, const SaveDetails *details) {
     consoleSelect(&top_screen);
     consoleClear();
+    invalidate_top();
 
     int row = 1;
 
@@ -197,10 +257,10 @@ static int draw_save_details(const TitleInfo *title, const SaveDetails *details)
 
     // Local save info
     printf("\x1b[%d;1H\x1b[33m-- Local Save --\x1b[0m", row++);
-    if (details->local_exists) {
-        char size_str[32];
-        format_size(details->local_size, size_str, sizeof(size_str));
-        printf("\x1b[%d;1H Files: %d | Size: %s", row++, details->local_file_count, size_str);
+    if (details->local_pending) {
+        printf("\x1b[%d;1H\x1b[90m Checking local save...\x1b[0m", row++);
+    } else if (details->local_exists) {
+        print_files_line(row++, details->local_file_count, details->local_size);
         printf("\x1b[%d;1H Hash:  %.32s...", row++, details->local_hash);
     } else {
         printf("\x1b[%d;1H No local save data", row++);
@@ -209,10 +269,10 @@ static int draw_save_details(const TitleInfo *title, const SaveDetails *details)
 
     // Server save info
     printf("\x1b[%d;1H\x1b[33m-- Server Save --\x1b[0m", row++);
-    if (details->server_exists) {
-        char size_str[32];
-        format_size(details->server_size, size_str, sizeof(size_str));
-        printf("\x1b[%d;1H Files: %d | Size: %s", row++, details->server_file_count, size_str);
+    if (details->server_pending) {
+        printf("\x1b[%d;1H\x1b[90m Checking server...\x1b[0m", row++);
+    } else if (details->server_exists) {
+        print_files_line(row++, details->server_file_count, details->server_size);
         printf("\x1b[%d;1H Hash:  %.32s...", row++, details->server_hash);
 
         char date_str[32];
@@ -229,7 +289,9 @@ static int draw_save_details(const TitleInfo *title, const SaveDetails *details)
 
     // Sync status
     printf("\x1b[%d;1H\x1b[33m-- Sync Status --\x1b[0m", row++);
-    if (details->is_synced) {
+    if (details->local_pending || details->server_pending) {
+        printf("\x1b[%d;1H\x1b[90m Checking...\x1b[0m", row++);
+    } else if (details->is_synced) {
         printf("\x1b[%d;1H\x1b[32m Synced (hashes match)\x1b[0m", row++);
     } else if (details->local_exists && details->server_exists) {
         printf("\x1b[%d;1H\x1b[31m Out of sync (different hashes)\x1b[0m", row++);
@@ -248,29 +310,37 @@ static int draw_save_details(const TitleInfo *title, const SaveDetails *details)
     return row;
 }
 
-void ui_show_save_details(const TitleInfo *title, const SaveDetails *details) {
-    draw_save_details(title, details);
+// Footer for the details dialogs, noting a refresh still in progress
+static void draw_details_footer(const SaveDetails *details, const char *keys) {
+    printf("\x1b[%d;1H\x1b[90m %s%s\x1b[0m", TOP_ROWS,
+        details->refreshing ? "Refreshing... | " : "", keys);
+}
 
-    // Footer
-    printf("\x1b[%d;1H\x1b[90m Press B to close\x1b[0m", TOP_ROWS);
+void ui_show_save_details(const TitleInfo *title, SaveDetails *details) {
+    draw_save_details(title, details);
+    draw_details_footer(details, "Press B to close");
 
     // Draw to both buffers to prevent flicker
     gfxFlushBuffers();
     gfxSwapBuffers();
     gspWaitForVBlank();
 
-    // Wait for B button
+    // Wait for B button, redrawing as refreshed details arrive
     while (aptMainLoop()) {
         hidScanInput();
         u32 kDown = hidKeysDown();
         if (kDown & KEY_B) break;
+        if (sync_details_poll(title, details)) {
+            draw_save_details(title, details);
+            draw_details_footer(details, "Press B to close");
+        }
         gfxFlushBuffers();
         gfxSwapBuffers();
         gspWaitForVBlank();
     }
 }
 
-bool ui_confirm_sync(const TitleInfo *title, const SaveDetails *details, bool is_upload) {
+static void draw_confirm_sync(const TitleInfo *title, const SaveDetails *details, bool is_upload) {
     int row = draw_save_details(title, details);
     row++;
 
@@ -281,20 +351,25 @@ bool ui_confirm_sync(const TitleInfo *title, const SaveDetails *details, bool is
         printf("\x1b[%d;1H\x1b[33;1m >> DOWNLOAD: server -> local\x1b[0m", row++);
     }
 
-    // Footer
-    printf("\x1b[%d;1H\x1b[90m A: Confirm | B: Cancel\x1b[0m", TOP_ROWS);
+    draw_details_footer(details, "A: Confirm | B: Cancel");
+}
+
+bool ui_confirm_sync(const TitleInfo *title, SaveDetails *details, bool is_upload) {
+    draw_confirm_sync(title, details, is_upload);
 
     // Draw to both buffers to prevent flicker
     gfxFlushBuffers();
     gfxSwapBuffers();
     gspWaitForVBlank();
 
-    // Wait for A (confirm) or B (cancel)
+    // Wait for A (confirm) or B (cancel), redrawing as refreshed details arrive
     while (aptMainLoop()) {
         hidScanInput();
         u32 kDown = hidKeysDown();
         if (kDown & KEY_A) return true;
         if (kDown & KEY_B) return false;
+        if (sync_details_poll(title, details))
+            draw_confirm_sync(title, details, is_upload);
         gfxFlushBuffers();
         gfxSwapBuffers();
         gspWaitForVBlank();
@@ -302,11 +377,85 @@ bool ui_confirm_sync(const TitleInfo *title, const SaveDetails *details, bool is
     return false;
 }
 
+#define BENCH_BUF_SIZE (1024 * 1024)
+#define BENCH_PASSES   8
+
+// MB/s hashing buf in chunk-sized updates (0 = whole buffer per update)
+static double bench_sha256(const u8 *buf, u32 chunk) {
+    u8 hash[32];
+    u64 start = svcGetSystemTick();
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        SHA256_CTX ctx;
+        sha256_init(&ctx);
+        if (chunk == 0) {
+            sha256_update(&ctx, buf, BENCH_BUF_SIZE);
+        } else {
+            for (u32 off = 0; off < BENCH_BUF_SIZE; off += chunk)
+                sha256_update(&ctx, buf + off, chunk);
+        }
+        sha256_final(&ctx, hash);
+    }
+    u64 ticks = svcGetSystemTick() - start;
+    if (ticks == 0) return 0.0;
+    double secs = (double)ticks / SYSCLOCK_ARM11;
+    return (double)BENCH_PASSES * BENCH_BUF_SIZE / (1024.0 * 1024.0) / secs;
+}
+
+void ui_show_hash_benchmark(void) {
+    consoleSelect(&top_screen);
+    consoleClear();
+    invalidate_top();
+
+    int row = 1;
+    printf("\x1b[%d;1H\x1b[36m%-*s\x1b[0m", row++, TOP_COLS, "--- Hash Benchmark ---");
+    row++;
+
+    bool is_new3ds = false;
+    APT_CheckNew3DS(&is_new3ds);
+    printf("\x1b[%d;1HConsole: %s", row++, is_new3ds ? "New 3DS" : "Old 3DS");
+    printf("\x1b[%d;1HHashing %dx %dKB...", row++, BENCH_PASSES, BENCH_BUF_SIZE / 1024);
+    gfxFlushBuffers();
+    gfxSwapBuffers();
+    gspWaitForVBlank();
+
+    u8 *buf = (u8 *)malloc(BENCH_BUF_SIZE);
+    if (!buf) {
+        printf("\x1b[%d;1H\x1b[31mOut of memory\x1b[0m", row++);
+    } else {
+        for (u32 i = 0; i < BENCH_BUF_SIZE; i++) buf[i] = (u8)(i * 2654435761u >> 24);
+
+        double bulk = bench_sha256(buf, 0);
+        double blocks = bench_sha256(buf, 4096);
+        double small = bench_sha256(buf, 64);
+        free(buf);
+
+        row++;
+        printf("\x1b[%d;1HSHA-256, one buffer:  %6.2f MB/s", row++, bulk);
+        printf("\x1b[%d;1HSHA-256, 4KB updates: %6.2f MB/s", row++, blocks);
+        printf("\x1b[%d;1HSHA-256, 64B updates: %6.2f MB/s", row++, small);
+    }
+
+    printf("\x1b[%d;1H\x1b[90m Press B to close\x1b[0m", TOP_ROWS);
+    gfxFlushBuffers();
+    gfxSwapBuffers();
+    gspWaitForVBlank();
+
+    while (aptMainLoop()) {
+        hidScanInput();
+        if (hidKeysDown() & KEY_B) break;
+        gfxFlushBuffers();
+        gfxSwapBuffers();
+        gspWaitForVBlank();
+    }
+    consoleClear();
+}
+
 #include "config.h"
 
 // Draw config editor menu
 static void draw_config_menu(const AppConfig *config, int selected) {
     consoleSelect(&top_screen);
+    invalidate_top();
 
     int row = 1;
 
@@ -319,11 +468,13 @@ static void draw_config_menu(const AppConfig *config, int selected) {
         "API Key",
         "NDS ROM Directory",
         "Rescan Titles",
+        "Rehash All Saves",
+        "Hash Benchmark",
         "Check for Updates",
         "Save & Exit",
         "Cancel"
     };
-    const int item_count = 7;
+    const int item_count = 9;
 
     for (int i = 0; i < item_count; i++) {
         const char *cursor = (i == selected) ? ">" : " ";
@@ -382,7 +533,7 @@ int ui_show_config_editor(AppConfig *config) {
     int selected = 0;
     int result = CONFIG_RESULT_UNCHANGED;
     bool changed = false;
-    const int item_count = 7;
+    const int item_count = 9;
     bool redraw = true;
 
     while (aptMainLoop()) {
@@ -421,20 +572,30 @@ int ui_show_config_editor(AppConfig *config) {
                 }
                 break;
             } else if (selected == 4) {
-                result = CONFIG_RESULT_UPDATE;
+                result = CONFIG_RESULT_REHASH;
                 if (changed) {
                     memcpy(config, &working, sizeof(AppConfig));
                     config_save(config);
                 }
                 break;
             } else if (selected == 5) {
+                ui_show_hash_benchmark();
+                redraw = true;
+            } else if (selected == 6) {
+                result = CONFIG_RESULT_UPDATE;
+                if (changed) {
+                    memcpy(config, &working, sizeof(AppConfig));
+                    config_save(config);
+                }
+                break;
+            } else if (selected == 7) {
                 if (changed) {
                     memcpy(config, &working, sizeof(AppConfig));
                     config_save(config);
                     result = CONFIG_RESULT_SAVED;
                 }
                 break;
-            } else if (selected == 6) {
+            } else if (selected == 8) {
                 break;
             }
         }
@@ -15,12 +15,15 @@ void ui_reinit(void);
 #define VIEW_3DS  1
 #define VIEW_NDS  2
 
-// Draw the title list on the top screen.
-// selected = currently highlighted index, count = number of titles.
-// view_mode controls the tab label in the header.
-void ui_draw_title_list(const TitleInfo *titles, int count, int selected, int scroll_offset, int view_mode);
-
-// Draw status/action bar on the bottom screen
+// Draw the title list on the top screen. The visible list is
+// titles[order[0]] .. titles[order[count - 1]]; selected and scroll_offset
+// are positions in order. view_mode controls the tab label in the header.
+// Only rows that differ from what the screen already shows are printed,
+// so calling this every time something might have changed is cheap.
+void ui_draw_title_list(const TitleInfo *titles, const int *order, int count,
+                        int selected, int scroll_offset, int view_mode);
+
+// Draw status/action bar on the bottom screen (changed rows only, as above)
 void ui_draw_status(const char *status_line);
 
 // Show a message on the bottom screen (clears it first)
@@ -32,19 +35,24 @@ void ui_update_progress(const char *msg);
 // Clear both screens
 void ui_clear(void);
 
-// Show save details dialog on top screen
+// Show save details dialog on top screen, updating details as a background
+// refresh (see sync_details_open) delivers them
 // Returns when user presses B to close
-void ui_show_save_details(const TitleInfo *title, const SaveDetails *details);
+void ui_show_save_details(const TitleInfo *title, SaveDetails *details);
 
-// Show sync confirmation dialog with save details
+// Show sync confirmation dialog with save details, refreshed the same way
 // Returns true if user confirmed (A), false if cancelled (B)
-bool ui_confirm_sync(const TitleInfo *title, const SaveDetails *details, bool is_upload);
+bool ui_confirm_sync(const TitleInfo *title, SaveDetails *details, bool is_upload);
+
+// Time SHA-256 on this console and show MB/s (top screen, B to close)
+void ui_show_hash_benchmark(void);
 
 // Config editor result codes
 #define CONFIG_RESULT_UNCHANGED 0
 #define CONFIG_RESULT_SAVED     1
 #define CONFIG_RESULT_RESCAN    2
 #define CONFIG_RESULT_UPDATE    3
+#define CONFIG_RESULT_REHASH    4
 
 // Show config editor menu on top screen
 // Returns CONFIG_RESULT_* code
@@ -5,12 +5,6 @@
 #include <string.h>
 #include <sys/stat.h>
 
-// CIA file path on SD card
-#define UPDATE_CIA_PATH "sdmc:/3ds/3dssync/update.cia"
-
-// Download buffer size
-#define DOWNLOAD_CHUNK_SIZE 0x8000  // 32KB
-
 // Helper to set error message
 static void set_error(char *error_out, int error_size, const char *msg) {
     if (error_out && error_size > 0) {
@@ -115,151 +109,139 @@ bool update_check(const AppConfig *config, UpdateInfo *info) {
     return true;
 }
 
-bool update_download(const AppConfig *config, const char *url, UpdateProgressCb progress) {
-    // Build proxy download path
-    // URL needs to be URL-encoded, but for simplicity we'll just use it directly
-    // since it's from our own server's response
-    char path[512];
-    snprintf(path, sizeof(path), "/update/download?url=%s", url);
-
-    // Report initial progress
-    if (progress) progress(0);
-
-    // Download the CIA file
-    u32 resp_size = 0;
-    u32 status = 0;
-    u8 *data = network_get(config, path, &resp_size, &status);
+// A download passed chunk by chunk into a CIA install (and optionally an
+// SD copy), so the CIA is never held in memory whole
+typedef struct {
+    Handle cia;
+    bool cia_open;
+    FILE *copy;           // SD copy (UPDATE_CIA_PATH), or NULL
+    u32 offset;           // Bytes received so far
+    u32 expected;         // Size from the update check, 0 if unknown
+    UpdateProgressCb progress;
+    int last_pct;
+    char *error_out;
+    int error_size;
+} UpdateStream;
+
+static void stream_progress(UpdateStream *s) {
+    if (!s->progress || s->expected == 0) return;
+    int pct = (int)(((u64)s->offset * 100) / s->expected);
+    if (pct > 99) pct = 99; // 100 once the install is finished
+    if (pct != s->last_pct) {
+        s->progress(pct);
+        s->last_pct = pct;
+    }
+}
 
-    if (!data || status != 200 || resp_size == 0) {
-        if (data) free(data);
+static bool stream_write(void *ctx, const u8 *data, u32 len) {
+    UpdateStream *s = (UpdateStream *)ctx;
+    if (!s->cia_open) return false; // Restart after a retry failed
+    u32 written = 0;
+    Result res = FSFILE_Write(s->cia, &written, s->offset, data, len, FS_WRITE_FLUSH);
+    if (R_FAILED(res) || written != len) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "FSFILE_Write: %08lX\nat offset %lu (wrote %lu/%lu)",
+            res, s->offset, written, len);
+        set_error(s->error_out, s->error_size, msg);
         return false;
     }
-
-    // Ensure directory exists
-    mkdir("sdmc:/3ds", 0777);
-    mkdir("sdmc:/3ds/3dssync", 0777);
-
-    // Write to SD card
-    FILE *f = fopen(UPDATE_CIA_PATH, "wb");
-    if (!f) {
-        free(data);
+    if (s->copy && fwrite(data, 1, len, s->copy) != len) {
+        set_error(s->error_out, s->error_size, "Failed to write CIA to SD");
         return false;
     }
+    s->offset += len;
+    stream_progress(s);
+    return true;
+}
 
-    // Write in chunks and report progress
-    u32 written = 0;
-    while (written < resp_size) {
-        u32 chunk = resp_size - written;
-        if (chunk > DOWNLOAD_CHUNK_SIZE) chunk = DOWNLOAD_CHUNK_SIZE;
-
-        size_t wrote = fwrite(data + written, 1, chunk, f);
-        if (wrote != chunk) {
-            fclose(f);
-            free(data);
-            remove(UPDATE_CIA_PATH);
-            return false;
-        }
-
-        written += chunk;
-        if (progress) {
-            int pct = (int)((written * 100) / resp_size);
-            progress(pct);
-        }
+// The request is being retried from the start: start over on both sides
+static void stream_reset(void *ctx) {
+    UpdateStream *s = (UpdateStream *)ctx;
+    if (s->cia_open) {
+        AM_CancelCIAInstall(s->cia);
+        s->cia_open = R_SUCCEEDED(AM_StartCiaInstall(MEDIATYPE_SD, &s->cia));
+        if (!s->cia_open) set_error(s->error_out, s->error_size, "AM_StartCiaInstall failed on retry");
     }
+    if (s->copy) {
+        fclose(s->copy);
+        s->copy = fopen(UPDATE_CIA_PATH, "wb");
+    }
+    s->offset = 0;
+    s->last_pct = -1;
+}
 
-    fclose(f);
-    free(data);
-
-    if (progress) progress(100);
-    return true;
+// Open the SD copy, creating its directory
+static FILE *open_sd_copy(void) {
+    mkdir("sdmc:/3ds", 0777);
+    mkdir("sdmc:/3ds/3dssync", 0777);
+    return fopen(UPDATE_CIA_PATH, "wb");
 }
 
-bool update_install(UpdateProgressCb progress, char *error_out, int error_size) {
-    // Open the CIA file
-    FILE *f = fopen(UPDATE_CIA_PATH, "rb");
-    if (!f) {
-        set_error(error_out, error_size, "Cannot open CIA file");
-        return false;
-    }
+// GET the update through the server's proxy into s. Returns true on a
+// complete, non-empty 200 response.
+static bool stream_update(const AppConfig *config, const char *url, UpdateStream *s) {
+    // URL needs to be URL-encoded, but for simplicity we'll just use it directly
+    // since it's from our own server's response
+    char path[512];
+    snprintf(path, sizeof(path), "/update/download?url=%s", url);
 
-    // Get file size
-    fseek(f, 0, SEEK_END);
-    u32 file_size = ftell(f);
-    fseek(f, 0, SEEK_SET);
+    NetworkSink sink = {stream_write, stream_reset, s};
+    u32 status = 0;
+    bool ok = network_get_stream(config, path, NULL, &sink, &status);
+    if (ok && status == 200 && s->offset > 0) return true;
 
-    if (file_size == 0) {
-        fclose(f);
-        set_error(error_out, error_size, "CIA file is empty");
-        return false;
+    if (s->error_out && s->error_out[0] == '\0') {
+        char msg[64];
+        snprintf(msg, sizeof(msg), "Download failed (HTTP %lu)", status);
+        set_error(s->error_out, s->error_size, msg);
     }
+    return false;
+}
+
+bool update_stream_install(const AppConfig *config, const char *url, u32 expected_size,
+                           UpdateProgressCb progress, char *error_out, int error_size) {
+    if (error_out && error_size > 0) error_out[0] = '\0';
+
+    UpdateStream s = {0};
+    s.expected = expected_size;
+    s.progress = progress;
+    s.last_pct = -1;
+    s.error_out = error_out;
+    s.error_size = error_size;
 
     if (progress) progress(0);
 
+    if (config->keep_update_cia) {
+        s.copy = open_sd_copy();
+        if (!s.copy) {
+            set_error(error_out, error_size, "Cannot create CIA file");
+            return false;
+        }
+    }
+
     // Start CIA installation to SD card
-    Handle cia_handle;
-    Result res = AM_StartCiaInstall(MEDIATYPE_SD, &cia_handle);
+    Result res = AM_StartCiaInstall(MEDIATYPE_SD, &s.cia);
     if (R_FAILED(res)) {
-        fclose(f);
+        if (s.copy) { fclose(s.copy); remove(UPDATE_CIA_PATH); }
         char msg[64];
         snprintf(msg, sizeof(msg), "AM_StartCiaInstall: %08lX", res);
         set_error(error_out, error_size, msg);
         return false;
     }
+    s.cia_open = true;
 
-    // Read and write in chunks
-    u8 *buffer = (u8 *)malloc(DOWNLOAD_CHUNK_SIZE);
-    if (!buffer) {
-        AM_CancelCIAInstall(cia_handle);
-        fclose(f);
-        set_error(error_out, error_size, "Out of memory");
-        return false;
+    bool ok = stream_update(config, url, &s);
+    if (s.copy) {
+        fclose(s.copy);
+        if (!ok) remove(UPDATE_CIA_PATH);
     }
-
-    u32 total_written = 0;
-    bool success = true;
-    Result write_res = 0;
-
-    while (total_written < file_size) {
-        u32 to_read = file_size - total_written;
-        if (to_read > DOWNLOAD_CHUNK_SIZE) to_read = DOWNLOAD_CHUNK_SIZE;
-
-        size_t read = fread(buffer, 1, to_read, f);
-        if (read != to_read) {
-            set_error(error_out, error_size, "Failed to read CIA");
-            success = false;
-            break;
-        }
-
-        // Write to CIA handle
-        u32 written = 0;
-        write_res = FSFILE_Write(cia_handle, &written, total_written, buffer, to_read, FS_WRITE_FLUSH);
-        if (R_FAILED(write_res) || written != to_read) {
-            char msg[128];
-            snprintf(msg, sizeof(msg), "FSFILE_Write: %08lX\nat offset %lu/%lu (wrote %lu/%lu)",
-                write_res, total_written, file_size, written, to_read);
-            set_error(error_out, error_size, msg);
-            success = false;
-            break;
-        }
-
-        total_written += written;
-
-        if (progress) {
-            int pct = (int)((total_written * 100) / file_size);
-            progress(pct);
-        }
-    }
-
-    free(buffer);
-    fclose(f);
-
-    if (!success) {
-        AM_CancelCIAInstall(cia_handle);
+    if (!ok) {
+        if (s.cia_open) AM_CancelCIAInstall(s.cia);
         return false;
     }
 
     // Finish installation
-    res = AM_FinishCiaInstall(cia_handle);
+    res = AM_FinishCiaInstall(s.cia);
     if (R_FAILED(res)) {
         char msg[64];
         snprintf(msg, sizeof(msg), "AM_FinishCiaInstall: %08lX", res);
@@ -267,9 +249,6 @@ bool update_install(UpdateProgressCb progress, char *error_out, int error_size)
         return false;
     }
 
-    // Clean up the downloaded CIA file
-    remove(UPDATE_CIA_PATH);
-
     if (progress) progress(100);
     return true;
 }
@@ -3,6 +3,9 @@
 
 #include "common.h"
 
+// Where keep_update_cia leaves a copy of the downloaded CIA
+#define UPDATE_CIA_PATH "sdmc:/3ds/3dssync/update.cia"
+
 // Update check result
 typedef struct {
     bool available;
@@ -15,16 +18,18 @@ typedef struct {
 // Returns true if check succeeded (regardless of whether update is available).
 bool update_check(const AppConfig *config, UpdateInfo *info);
 
-// Download update to SD card.
-// Returns true on success.
 // Progress callback receives percentage (0-100).
 typedef void (*UpdateProgressCb)(int percent);
-bool update_download(const AppConfig *config, const char *url, UpdateProgressCb progress);
 
-// Install CIA from SD card using AM service.
-// Returns true on success.
-// error_out receives a description of what failed (if not NULL).
-bool update_install(UpdateProgressCb progress, char *error_out, int error_size);
+// Download an update and install it as it arrives: the HTTP body goes
+// straight into the AM CIA install, never whole in memory or via the SD.
+// expected_size (the check's file_size, 0 if unknown) drives the progress
+// percentage. With config->keep_update_cia the CIA is also written to
+// UPDATE_CIA_PATH as it arrives, for installing again later (e.g. with FBI).
+// error_out receives a description of what failed.
+// Returns true once the install is finished.
+bool update_stream_install(const AppConfig *config, const char *url, u32 expected_size,
+                           UpdateProgressCb progress, char *error_out, int error_size);
 
 // Relaunch the application (works for CIA apps only).
 // This function does not return on success.
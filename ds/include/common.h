@@ -8,8 +8,8 @@
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include "strpool.h"
 
-#define MAX_TITLES 512
 #define MAX_PATH 256
 #define TITLE_ID_SIZE 8
 #define HASH_SIZE 32
@@ -28,11 +28,8 @@ typedef struct {
     uint8_t title_id[TITLE_ID_SIZE];
     uint32_t save_size;
     uint8_t hash[HASH_SIZE];
-    uint8_t last_hash[HASH_SIZE];
-    uint8_t server_hash[HASH_SIZE];
-    uint8_t local_hash[HASH_SIZE];
-    char game_name[256];
-    char save_path[MAX_PATH];
+    const char *game_name;  // In SyncState.strings
+    const char *save_path;  // In SyncState.strings
     uint32_t timestamp;
     int is_cartridge;
     int needs_sync;
@@ -50,8 +47,11 @@ typedef struct {
     char wifi_ssid[33];          // WiFi SSID (max 32 chars + null)
     char wifi_wep_key[14];       // WEP key (13 chars + null for 104-bit WEP)
     uint32_t console_id;
+    int log_level;               // HTTP_LOG_* level for network output
     int num_titles;
-    Title titles[MAX_TITLES];
+    int titles_cap;
+    Title *titles;               // Grown as saves_scan finds titles
+    StrPool strings;             // Title names and save paths, reset by each scan
 } SyncState;
 
 #endif
@@ -0,0 +1,21 @@
+#ifndef HASHCACHE_H
+#define HASHCACHE_H
+
+#include "common.h"
+
+// Persistent save-hash cache, stored next to the per-title sync state files.
+// Each entry maps a save path to the SHA-256 of the file, keyed on its size
+// and mtime, so scans only hash saves that changed since the last pass.
+
+// Look up a cached hash. Returns true if the path has an entry with the
+// same size and mtime, filling hash_out (32 bytes).
+bool hashcache_lookup(const char *path, uint32_t size, uint32_t mtime, uint8_t *hash_out);
+
+// Record the hash of a save file with its current size and mtime.
+void hashcache_store(const char *path, uint32_t size, uint32_t mtime, const uint8_t *hash);
+
+// Write pending changes back to the state directory. Call once after a
+// batch of updates.
+void hashcache_flush(void);
+
+#endif
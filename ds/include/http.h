@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <stdio.h>
 
 // HTTP method types
 typedef enum {
@@ -11,12 +12,18 @@ typedef enum {
     HTTP_PUT
 } HttpMethod;
 
+// Log levels for http_set_log_level
+#define HTTP_LOG_NONE  0
+#define HTTP_LOG_ERROR 1   // Failures only (default)
+#define HTTP_LOG_DEBUG 2   // Every request step and progress line
+
 // HTTP response
 typedef struct {
     int status_code;
     uint8_t *body;
     size_t body_size;
     int success;
+    char *headers;      // Response header block (malloc'd), NULL if none
 } HttpResponse;
 
 // HTTP client initialization
@@ -31,10 +38,43 @@ HttpResponse http_request(
     size_t body_size
 );
 
+// Make HTTP request, sending If-None-Match: "<if_none_match>" when not NULL.
+// A 304 response means the server still holds that version.
+HttpResponse http_request_ex(
+    const char *url,
+    HttpMethod method,
+    const char *api_key,
+    const uint8_t *body,
+    size_t body_size,
+    const char *if_none_match
+);
+
+// Streaming variant: sends body_size bytes read from body_file (NULL for no
+// body) in small chunks, and writes a 2xx response body to response_file
+// instead of memory when it is not NULL. response.body_size is the number of
+// bytes written; response.body stays NULL.
+HttpResponse http_request_file(
+    const char *url,
+    HttpMethod method,
+    const char *api_key,
+    FILE *body_file,
+    size_t body_size,
+    const char *if_none_match,
+    FILE *response_file
+);
+
+// Copy a response header value (case-insensitive name) into out.
+// Returns 1 if found, 0 otherwise.
+int http_response_header(const HttpResponse *response, const char *name,
+                         char *out, size_t out_size);
+
 // Free response body
 void http_response_free(HttpResponse *response);
 
-// Cleanup HTTP
+// Set how much the client prints to the console
+void http_set_log_level(int level);
+
+// Cleanup HTTP (closes the kept-alive connection)
 void http_cleanup(void);
 
 #endif
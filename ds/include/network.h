@@ -6,8 +6,18 @@
 // Initialize WiFi (for DS/DSi with WiFi)
 int network_init(SyncState *state);
 
-// Sync with server and get plan
-int network_sync(SyncState *state);
+// Server plan actions for network_sync (wire codes of the binary /sync)
+#define NET_PLAN_UPLOAD      0
+#define NET_PLAN_DOWNLOAD    1
+#define NET_PLAN_CONFLICT    2
+#define NET_PLAN_UP_TO_DATE  3
+#define NET_PLAN_SERVER_ONLY 4
+#define NET_PLAN_NONE        0xFF  // Title missing from the response
+
+// Sync with server and get plan: one binary /sync request for all titles.
+// plan must hold num_titles entries; plan[i] is the action for titles[i].
+// Returns 0 on success, -1 on error
+int network_sync(SyncState *state, uint8_t *plan);
 
 // Fetch save list from server (stores in state->server_saves)
 int network_fetch_saves(SyncState *state);
@@ -20,6 +30,20 @@ int network_get_save_info(SyncState *state, const char *title_id_hex, char *hash
 int network_get_save_info_ext(SyncState *state, const char *title_id_hex,
                                char *hash_out, size_t *size_out, uint32_t *timestamp_out);
 
+// Server metadata for one title, from network_get_save_info_bulk
+typedef struct {
+    bool found;              // Server has a save for the title
+    char hash[65];           // Save hash (hex string)
+    size_t size;             // Save size in bytes
+    uint32_t timestamp;      // Server's client_timestamp (unix epoch)
+} NetSaveInfo;
+
+// Get save info for several titles with one POST /titles/meta request.
+// info[n] receives the metadata of titles[indices[n]].
+// Returns 0 on success, -1 on error (older servers lack the endpoint)
+int network_get_save_info_bulk(SyncState *state, const int *indices, int count,
+                               NetSaveInfo *info);
+
 // Upload save bundle
 int network_upload(SyncState *state, int title_idx);
 
@@ -31,6 +31,10 @@ bool sync_load_last_hash(const char *title_id_hex, char *hash_out);
 // Returns true on success
 bool sync_save_last_hash(const char *title_id_hex, const char *hash);
 
+// Build the path of a file in the state directory (created if needed)
+// Returns false if no writable state directory was found
+bool sync_state_file(const char *name, char *path_out, size_t path_size);
+
 // Determine sync action for a single title (no side effects)
 // Returns 0 on success, -1 on network error
 int sync_decide(SyncState *state, int title_idx, SyncDecision *decision);
@@ -39,11 +43,11 @@ int sync_decide(SyncState *state, int title_idx, SyncDecision *decision);
 // Returns 0 on success, -1 on error
 int sync_execute(SyncState *state, int title_idx, SyncAction action);
 
-// Batch sync all titles: decide + execute for each
+// Batch sync all titles: decide all with one /sync request, then execute
 // Returns 0 on success, -1 on fatal error
 int sync_all(SyncState *state, SyncSummary *summary);
 
-// Scan all titles: decide sync status for each, store in title->scan_result
+// Scan all titles with one /sync request, store in title->scan_result
 // Does NOT upload/download — only checks status
 int sync_scan_all(SyncState *state, SyncSummary *summary);
 
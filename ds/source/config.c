@@ -1,4 +1,5 @@
 #include "config.h"
+#include "http.h"
 #include <stdio.h>
 #include <string.h>
 #include <fat.h>
@@ -42,7 +43,9 @@ static bool create_default_config(const char *path) {
     fprintf(f, "wifi_wep_key=\n\n");
     fprintf(f, "# Optional: Custom save directory to scan (in addition to defaults)\n");
     fprintf(f, "# Examples: /data/saves, sd:/nds/saves, fat:/saves\n");
-    fprintf(f, "#save_dir=/your/custom/path\n");
+    fprintf(f, "#save_dir=/your/custom/path\n\n");
+    fprintf(f, "# Optional: Network log level (0=none, 1=errors, 2=debug)\n");
+    fprintf(f, "#log_level=1\n");
     
     fclose(f);
     return true;
@@ -98,6 +101,7 @@ bool config_load(SyncState *state, char *error, size_t error_size) {
     state->custom_save_dir[0] = '\0';
     state->wifi_ssid[0] = '\0';
     state->wifi_wep_key[0] = '\0';
+    state->log_level = HTTP_LOG_ERROR;
     
     while (fgets(line, sizeof(line), f)) {
         // Remove trailing newline and carriage return
@@ -142,6 +146,8 @@ bool config_load(SyncState *state, char *error, size_t error_size) {
             strncpy(state->wifi_ssid, value, sizeof(state->wifi_ssid) - 1);
         } else if (strcmp(key, "wifi_wep_key") == 0) {
             strncpy(state->wifi_wep_key, value, sizeof(state->wifi_wep_key) - 1);
+        } else if (strcmp(key, "log_level") == 0) {
+            state->log_level = atoi(value);
         }
     }
     
@@ -206,6 +212,8 @@ bool config_save(const SyncState *state) {
         fprintf(f, "save_dir=%s\n", state->custom_save_dir);
     fprintf(f, "wifi_ssid=%s\n", state->wifi_ssid);
     fprintf(f, "wifi_wep_key=%s\n", state->wifi_wep_key);
+    if (state->log_level != HTTP_LOG_ERROR)
+        fprintf(f, "log_level=%d\n", state->log_level);
 
     fclose(f);
     return true;
@@ -0,0 +1,129 @@
+#include "hashcache.h"
+#include "sync.h"
+
+typedef struct {
+    char path[MAX_PATH];
+    uint32_t size;
+    uint32_t mtime;
+    uint8_t hash[HASH_SIZE];
+} HashCacheEntry;
+
+static HashCacheEntry *entries = NULL;
+static int entry_count = 0;
+static int entry_cap = 0;
+static int cursor = 0;  // Entry after the last match - scans go in order
+static bool loaded = false;
+static bool dirty = false;
+
+// Make room for one more entry. Returns false if out of memory.
+static bool reserve_entry(void) {
+    if (entry_count < entry_cap) return true;
+    int cap = entry_cap ? entry_cap * 2 : 64;
+    HashCacheEntry *grown = (HashCacheEntry *)realloc(entries, cap * sizeof(HashCacheEntry));
+    if (!grown) return false;
+    entries = grown;
+    entry_cap = cap;
+    return true;
+}
+
+static bool parse_hash(const char *hex, uint8_t *out) {
+    for (int i = 0; i < HASH_SIZE; i++) {
+        unsigned int byte;
+        if (sscanf(hex + i * 2, "%2x", &byte) != 1) return false;
+        out[i] = (uint8_t)byte;
+    }
+    return true;
+}
+
+// Load the cache file on first use.
+// Format: one "<size> <mtime> <hash> <path>" line per save.
+static void hashcache_load(void) {
+    if (loaded) return;
+    loaded = true;
+    entry_count = 0;
+
+    char cache_path[256];
+    if (!sync_state_file("hashcache.txt", cache_path, sizeof(cache_path))) return;
+
+    FILE *f = fopen(cache_path, "r");
+    if (!f) return;
+
+    char line[MAX_PATH + 96];
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long size, mtime;
+        char hash[65];
+        int path_at = 0;
+        if (sscanf(line, "%lu %lu %64s %n", &size, &mtime, hash, &path_at) != 3 || path_at == 0)
+            continue;
+
+        char *path = line + path_at;
+        path[strcspn(path, "\r\n")] = '\0';
+        if (path[0] == '\0' || strlen(path) >= MAX_PATH) continue;
+        if (!reserve_entry()) break;
+
+        HashCacheEntry *e = &entries[entry_count];
+        if (strlen(hash) != 64 || !parse_hash(hash, e->hash)) continue;
+        strcpy(e->path, path);
+        e->size = (uint32_t)size;
+        e->mtime = (uint32_t)mtime;
+        entry_count++;
+    }
+    fclose(f);
+}
+
+static HashCacheEntry *find_entry(const char *path) {
+    hashcache_load();
+    for (int n = 0; n < entry_count; n++) {
+        int i = (cursor + n) % entry_count;
+        if (strcmp(entries[i].path, path) == 0) {
+            cursor = i + 1;
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+bool hashcache_lookup(const char *path, uint32_t size, uint32_t mtime, uint8_t *hash_out) {
+    HashCacheEntry *e = find_entry(path);
+    if (!e || e->size != size || e->mtime != mtime) return false;
+
+    memcpy(hash_out, e->hash, HASH_SIZE);
+    return true;
+}
+
+void hashcache_store(const char *path, uint32_t size, uint32_t mtime, const uint8_t *hash) {
+    if (strlen(path) >= MAX_PATH || strchr(path, '\n')) return;
+
+    HashCacheEntry *e = find_entry(path);
+    if (!e) {
+        if (!reserve_entry()) return;
+        e = &entries[entry_count++];
+        strcpy(e->path, path);
+    } else if (e->size == size && e->mtime == mtime && memcmp(e->hash, hash, HASH_SIZE) == 0) {
+        return;
+    }
+
+    e->size = size;
+    e->mtime = mtime;
+    memcpy(e->hash, hash, HASH_SIZE);
+    dirty = true;
+}
+
+void hashcache_flush(void) {
+    if (!dirty) return;
+
+    char cache_path[256];
+    if (!sync_state_file("hashcache.txt", cache_path, sizeof(cache_path))) return;
+
+    FILE *f = fopen(cache_path, "w");
+    if (!f) return;
+
+    for (int i = 0; i < entry_count; i++) {
+        fprintf(f, "%lu %lu ", (unsigned long)entries[i].size, (unsigned long)entries[i].mtime);
+        for (int j = 0; j < HASH_SIZE; j++)
+            fprintf(f, "%02x", entries[i].hash[j]);
+        fprintf(f, " %s\n", entries[i].path);
+    }
+    fclose(f);
+    dirty = false;
+}
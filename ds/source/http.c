@@ -1,20 +1,57 @@
 #include "http.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
 #include <string.h>
+#include <strings.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <unistd.h>
 
-// Simple HTTP client for DS
-// Note: This is a minimal implementation suitable for DS constraints
+// Simple HTTP/1.1 client for DS
+// Note: This is a minimal implementation suitable for DS constraints. One
+// keep-alive connection is held open and reused while requests go to the
+// same host, which saves a DNS lookup and TCP handshake per request.
 
 #define HTTP_BUFFER_SIZE 4096
-#define HTTP_TIMEOUT 10
+#define HTTP_MAX_HEADERS 16384  // Cap on the response header block
+#define HTTP_TIMEOUT 30
 
-static int socket_fd = -1;
+#define LOG_DEBUG(...) do { if (log_level >= HTTP_LOG_DEBUG) iprintf(__VA_ARGS__); } while (0)
+#define LOG_ERROR(...) do { if (log_level >= HTTP_LOG_ERROR) iprintf(__VA_ARGS__); } while (0)
+
+// Persistent connection with its receive buffer
+typedef struct {
+    int fd;
+    char host[256];
+    int port;
+    bool reused;        // A response has already been read on fd
+    uint8_t buf[HTTP_BUFFER_SIZE];
+    int buf_pos;
+    int buf_len;
+} HttpConnection;
+
+// Response body destination: a file, or a growing memory buffer
+typedef struct {
+    FILE *file;
+    uint8_t *data;
+    size_t size;
+    size_t cap;
+} BodySink;
+
+static HttpConnection conn = { .fd = -1 };
+
+// Address of the last resolved host, so DNS is queried once per server
+static char dns_host[256];
+static struct in_addr dns_addr;
+static bool dns_valid = false;
+
+static int log_level = HTTP_LOG_ERROR;
+
+// Buffer for streaming request/response bodies to and from files
+static uint8_t stream_buf[HTTP_BUFFER_SIZE];
 
 int http_init(void) {
     // Sockets are already available through libc on DS
@@ -76,310 +113,487 @@ HttpResponse http_request(
     const uint8_t *body,
     size_t body_size
 ) {
-    HttpResponse response = {0};
-    char host[256] = {0};
-    char path[512] = {0};
-    int port = 80;
-    
-    iprintf("\n=== HTTP Debug ===\n");
-    iprintf("URL: %s\n", url);
-    
-    // Parse URL
-    if (parse_url(url, host, &port, path) != 0) {
-        iprintf("URL parse failed!\n");
-        response.success = 0;
-        return response;
+    return http_request_ex(url, method, api_key, body, body_size, NULL);
+}
+
+static void conn_close(void) {
+    if (conn.fd >= 0) {
+        shutdown(conn.fd, 0); // SHUT_RD - like dswifi example
+        closesocket(conn.fd); // Use closesocket() not close()
+        conn.fd = -1;
     }
-    
-    iprintf("Host: %s\n", host);
-    iprintf("Port: %d\n", port);
-    iprintf("Path: %s\n", path);
-    
-    // Resolve host
-    iprintf("Resolving DNS...\n");
+    conn.buf_pos = conn.buf_len = 0;
+}
+
+static bool resolve_host(const char *host, struct in_addr *addr) {
+    if (dns_valid && strcmp(dns_host, host) == 0) {
+        *addr = dns_addr;
+        return true;
+    }
+
+    LOG_DEBUG("Resolving %s...\n", host);
     struct hostent *he = gethostbyname(host);
-    if (!he) {
-        iprintf("DNS lookup failed for %s\n", host);
-        response.success = 0;
-        return response;
+    if (!he || !he->h_addr_list[0]) {
+        LOG_ERROR("DNS lookup failed for %s\n", host);
+        return false;
     }
-    
-    char *ip = inet_ntoa(*(struct in_addr*)he->h_addr_list[0]);
-    iprintf("Resolved to: %s\n", ip);
-    
-    // Create socket
-    iprintf("Creating socket...\n");
-    socket_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (socket_fd < 0) {
-        iprintf("Socket creation failed\n");
-        response.success = 0;
-        return response;
+
+    dns_addr = *(struct in_addr*)he->h_addr_list[0];
+    strncpy(dns_host, host, sizeof(dns_host) - 1);
+    dns_host[sizeof(dns_host) - 1] = '\0';
+    dns_valid = true;
+    *addr = dns_addr;
+    return true;
+}
+
+// Make sure conn is connected to host:port, reusing the open socket if it
+// already is. Returns 0 on success.
+static int conn_open(const char *host, int port) {
+    if (conn.fd >= 0 && conn.port == port && strcmp(conn.host, host) == 0) {
+        return 0;
     }
-    iprintf("Socket created: %d\n", socket_fd);
-    
-    // Set socket timeout (30 seconds)
+    conn_close();
+
+    struct in_addr addr;
+    if (!resolve_host(host, &addr)) return -1;
+
+    conn.fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (conn.fd < 0) {
+        LOG_ERROR("Socket creation failed\n");
+        return -1;
+    }
+
     struct timeval tv;
-    tv.tv_sec = 30;
+    tv.tv_sec = HTTP_TIMEOUT;
     tv.tv_usec = 0;
-    setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof(tv));
-    setsockopt(socket_fd, SOL_SOCKET, SO_SNDTIMEO, (const char*)&tv, sizeof(tv));
-    
-    // Connect to host
+    setsockopt(conn.fd, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof(tv));
+    setsockopt(conn.fd, SOL_SOCKET, SO_SNDTIMEO, (const char*)&tv, sizeof(tv));
+
     struct sockaddr_in server_addr;
     memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family = AF_INET;
     server_addr.sin_port = htons(port);
-    server_addr.sin_addr = *(struct in_addr*)he->h_addr_list[0];
-    
-    iprintf("Connecting to %s:%d...\n", 
-            inet_ntoa(server_addr.sin_addr), port);
-    
-    if (connect(socket_fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-        iprintf("Connection failed to %s:%d\n", host, port);
-        close(socket_fd);
-        socket_fd = -1;
-        response.success = 0;
+    server_addr.sin_addr = addr;
+
+    LOG_DEBUG("Connecting to %s:%d...\n", inet_ntoa(addr), port);
+    if (connect(conn.fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+        LOG_ERROR("Connection failed to %s:%d\n", host, port);
+        conn_close();
+        dns_valid = false;  // Address may have changed
+        return -1;
+    }
+
+    strncpy(conn.host, host, sizeof(conn.host) - 1);
+    conn.host[sizeof(conn.host) - 1] = '\0';
+    conn.port = port;
+    conn.reused = false;
+    return 0;
+}
+
+// Send len bytes, looping over partial sends. Returns 0 on success.
+static int send_all(const uint8_t *data, size_t len) {
+    size_t sent = 0;
+    while (sent < len) {
+        int chunk = send(conn.fd, data + sent, len - sent, 0);
+        if (chunk <= 0) return -1;
+        sent += chunk;
+    }
+    return 0;
+}
+
+// Copy body_size bytes from body_file to the socket. Returns 0 on success.
+static int send_file(FILE *body_file, size_t body_size) {
+    size_t total_sent = 0;
+    while (total_sent < body_size) {
+        size_t want = body_size - total_sent;
+        if (want > sizeof(stream_buf)) want = sizeof(stream_buf);
+        size_t got = fread(stream_buf, 1, want, body_file);
+        if (got == 0) {
+            LOG_ERROR("Save read failed\n");
+            return -1;
+        }
+        if (send_all(stream_buf, got) != 0) return -1;
+        total_sent += got;
+        LOG_DEBUG("Sent %d/%d bytes\n", (int)total_sent, (int)body_size);
+    }
+    return 0;
+}
+
+// Read up to max bytes, serving buffered data first. Returns bytes read,
+// 0 when the server closed the connection, or -1 on error.
+static int conn_read(uint8_t *out, int max) {
+    if (conn.buf_pos < conn.buf_len) {
+        int n = conn.buf_len - conn.buf_pos;
+        if (n > max) n = max;
+        memcpy(out, conn.buf + conn.buf_pos, n);
+        conn.buf_pos += n;
+        return n;
+    }
+    // Large reads bypass the buffer
+    if (max >= (int)sizeof(conn.buf)) {
+        return recv(conn.fd, out, max, 0);
+    }
+    int n = recv(conn.fd, conn.buf, sizeof(conn.buf), 0);
+    if (n <= 0) return n;
+    conn.buf_pos = 0;
+    conn.buf_len = n;
+    return conn_read(out, max);
+}
+
+// Read one CRLF (or LF) terminated line without the line ending.
+// Returns its length, or -1 on error, EOF or a line longer than size - 1.
+static int conn_read_line(char *line, int size) {
+    int len = 0;
+    for (;;) {
+        uint8_t c;
+        if (conn_read(&c, 1) != 1) return -1;
+        if (c == '\n') break;
+        if (len >= size - 1) return -1;
+        line[len++] = (char)c;
+    }
+    if (len > 0 && line[len - 1] == '\r') len--;
+    line[len] = '\0';
+    return len;
+}
+
+static int sink_write(BodySink *sink, const uint8_t *data, size_t len) {
+    if (sink->file) {
+        if (fwrite(data, 1, len, sink->file) != len) {
+            LOG_ERROR("Write failed!\n");
+            return -1;
+        }
+        sink->size += len;
+        return 0;
+    }
+    if (sink->size + len + 1 > sink->cap) {
+        size_t cap = sink->cap ? sink->cap : HTTP_BUFFER_SIZE;
+        while (sink->size + len + 1 > cap) cap *= 2;
+        uint8_t *data_new = realloc(sink->data, cap);
+        if (!data_new) {
+            LOG_ERROR("Failed to allocate %d bytes!\n", (int)cap);
+            return -1;
+        }
+        sink->data = data_new;
+        sink->cap = cap;
+    }
+    memcpy(sink->data + sink->size, data, len);
+    sink->size += len;
+    sink->data[sink->size] = '\0';
+    return 0;
+}
+
+// Read exactly len body bytes into sink. Returns 0 on success.
+static int read_body_exact(BodySink *sink, size_t len) {
+    size_t received = 0;
+    while (received < len) {
+        size_t want = len - received;
+        if (want > sizeof(stream_buf)) want = sizeof(stream_buf);
+        int chunk = conn_read(stream_buf, (int)want);
+        if (chunk <= 0) {
+            LOG_ERROR("Incomplete body: %d/%d\n", (int)received, (int)len);
+            return -1;
+        }
+        if (sink_write(sink, stream_buf, chunk) != 0) return -1;
+        received += chunk;
+        LOG_DEBUG("Progress: %d/%d bytes\n", (int)received, (int)len);
+    }
+    return 0;
+}
+
+// Read a Transfer-Encoding: chunked body into sink. Returns 0 on success.
+static int read_body_chunked(BodySink *sink) {
+    char line[128];
+    for (;;) {
+        if (conn_read_line(line, sizeof(line)) < 0) return -1;
+        char *end;
+        unsigned long chunk_size = strtoul(line, &end, 16);
+        if (end == line) return -1;
+        if (chunk_size == 0) break;
+        if (read_body_exact(sink, chunk_size) != 0) return -1;
+        if (conn_read_line(line, sizeof(line)) != 0) return -1;  // CRLF after data
+    }
+    // Skip trailer headers up to the blank line
+    int len;
+    while ((len = conn_read_line(line, sizeof(line))) > 0) {}
+    return len == 0 ? 0 : -1;
+}
+
+// Read the body until the server closes the connection
+static int read_body_to_close(BodySink *sink) {
+    for (;;) {
+        int chunk = conn_read(stream_buf, sizeof(stream_buf));
+        if (chunk < 0) return -1;
+        if (chunk == 0) return 0;
+        if (sink_write(sink, stream_buf, chunk) != 0) return -1;
+    }
+}
+
+// Case-insensitive search for token in a header value
+static bool has_token(const char *value, const char *token) {
+    size_t len = strlen(token);
+    for (; *value; value++) {
+        if (strncasecmp(value, token, len) == 0) return true;
+    }
+    return false;
+}
+
+// Append a header line to the malloc'd header block kept for
+// http_response_header. Returns 0 on success.
+static int append_header(char **block, size_t *block_len, const char *line, int len) {
+    if (*block_len + len + 3 > HTTP_MAX_HEADERS) return -1;
+    char *grown = realloc(*block, *block_len + len + 3);
+    if (!grown) return -1;
+    memcpy(grown + *block_len, line, len);
+    memcpy(grown + *block_len + len, "\r\n", 3);
+    *block = grown;
+    *block_len += len + 2;
+    return 0;
+}
+
+// Send the request on conn. Returns 0 on success.
+static int send_request(const char *request, const uint8_t *body, FILE *body_file,
+                        size_t body_size) {
+    if (send_all((const uint8_t*)request, strlen(request)) != 0) return -1;
+    if ((body || body_file) && body_size > 0) {
+        LOG_DEBUG("Uploading %d bytes...\n", (int)body_size);
+        int rc = body_file ? send_file(body_file, body_size) : send_all(body, body_size);
+        if (rc != 0) return -1;
+    }
+    return 0;
+}
+
+static HttpResponse http_do(
+    const char *url,
+    HttpMethod method,
+    const char *api_key,
+    const uint8_t *body,
+    FILE *body_file,
+    size_t body_size,
+    const char *if_none_match,
+    FILE *response_file
+) {
+    HttpResponse response = {0};
+    char host[256] = {0};
+    char path[512] = {0};
+    int port = 80;
+
+    LOG_DEBUG("HTTP %s\n", url);
+
+    if (parse_url(url, host, &port, path) != 0) {
+        LOG_ERROR("URL parse failed!\n");
         return response;
     }
-    
-    iprintf("Connected successfully!\n");
-    
+
     // Build HTTP request
-    char request[HTTP_BUFFER_SIZE];
-    const char *method_str = (method == HTTP_GET) ? "GET" : 
+    static char request[HTTP_BUFFER_SIZE];
+    const char *method_str = (method == HTTP_GET) ? "GET" :
                              (method == HTTP_POST) ? "POST" : "PUT";
-    
+
+    char host_header[272];
+    if (port == 80) snprintf(host_header, sizeof(host_header), "%s", host);
+    else snprintf(host_header, sizeof(host_header), "%s:%d", host, port);
+
     snprintf(request, sizeof(request),
-        "%s %s HTTP/1.0\r\n"
+        "%s %s HTTP/1.1\r\n"
         "Host: %s\r\n"
         "User-Agent: NDSSyncClient/1.0\r\n"
         "X-API-Key: %s\r\n",
-        method_str, path, host, api_key);
-    
-    if (body && body_size > 0) {
+        method_str, path, host_header, api_key);
+
+    if (if_none_match && if_none_match[0]) {
+        sprintf(request + strlen(request),
+            "If-None-Match: \"%.64s\"\r\n", if_none_match);
+    }
+
+    bool has_body = (body || body_file) && body_size > 0;
+    if (has_body) {
         sprintf(request + strlen(request),
             "Content-Type: application/octet-stream\r\n"
             "Content-Length: %d\r\n", (int)body_size);
+    } else if (method != HTTP_GET) {
+        strcat(request, "Content-Length: 0\r\n");
     }
-    
-    strcat(request, "Connection: close\r\n\r\n");
-    
-    // Send request headers
-    iprintf("Sending headers...\n");
-    if (send(socket_fd, request, strlen(request), 0) < 0) {
-        iprintf("Failed to send request\n");
-        close(socket_fd);
-        socket_fd = -1;
-        response.success = 0;
-        return response;
-    }
-    
-    // Send body if present
-    if (body && body_size > 0) {
-        iprintf("Uploading %d bytes...\n", (int)body_size);
-        int total_sent = 0;
-        while (total_sent < body_size) {
-            int remaining = body_size - total_sent;
-            int chunk = send(socket_fd, body + total_sent, remaining, 0);
-            if (chunk < 0) {
-                iprintf("Failed to send body\n");
-                closesocket(socket_fd);
-                socket_fd = -1;
-                response.success = 0;
-                return response;
-            }
-            total_sent += chunk;
-            iprintf("Sent %d/%d bytes\n", total_sent, (int)body_size);
+
+    strcat(request, "Connection: keep-alive\r\n\r\n");
+
+    // A kept-alive connection may have been closed by the server since the
+    // last request; in that case reconnect and send the request once more.
+    // Only a GET is resent once it was sent in full: the server may already
+    // have applied an upload or sync whose response was lost.
+    long body_start = body_file ? ftell(body_file) : 0;
+    char line[512];
+    int line_len = -1;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (conn_open(host, port) != 0) return response;
+        bool reused = conn.reused;
+
+        bool sent = send_request(request, body, body_file, body_size) == 0;
+        if (sent) {
+            line_len = conn_read_line(line, sizeof(line));
         }
-        iprintf("Upload complete\n");
+        if (line_len >= 0) break;
+
+        conn_close();
+        if (!reused || (sent && method != HTTP_GET)) break;
+        if (body_file && fseek(body_file, body_start, SEEK_SET) != 0) break;
+        LOG_DEBUG("Connection lost, retrying\n");
     }
-    
-    // Read response (loop until we have complete headers + body)
-    iprintf("Waiting for response...\n");
-    char header_buf[HTTP_BUFFER_SIZE];
-    int total_received = 0;
-    char *body_separator = NULL;
-    int content_length = -1;
-    int loop_count = 0;
-    
-    while (total_received < sizeof(header_buf) - 1) {
-        loop_count++;
-        iprintf("Loop %d: Calling recv...\n", loop_count);
-        int chunk = recv(socket_fd, header_buf + total_received, sizeof(header_buf) - 1 - total_received, 0);
-        iprintf("Loop %d: recv returned %d\n", loop_count, chunk);
-        
-        if (chunk <= 0) {
-            if (total_received == 0) {
-                iprintf("Failed to receive response (timeout?)\n");
-                close(socket_fd);
-                socket_fd = -1;
-                response.success = 0;
-                return response;
-            }
-            iprintf("recv returned %d, breaking\n", chunk);
-            break;  // Got some data, proceed
-        }
-        total_received += chunk;
-        header_buf[total_received] = '\0';
-        iprintf("Total so far: %d bytes\n", total_received);
-        
-        // Check if we have the body separator yet
-        if (!body_separator) {
-            body_separator = strstr(header_buf, "\r\n\r\n");
-            if (!body_separator) {
-                body_separator = strstr(header_buf, "\n\n");
-                if (body_separator) {
-                    body_separator += 2;
-                    iprintf("Found \\n\\n separator\n");
-                }
-            } else {
-                body_separator += 4;
-                iprintf("Found \\r\\n\\r\\n separator\n");
-            }
-        }
-        
-        // If we found separator, parse Content-Length
-        if (body_separator && content_length < 0) {
-            char *cl = strstr(header_buf, "Content-Length:");
-            if (!cl) cl = strstr(header_buf, "content-length:");
-            if (cl) {
-                sscanf(cl + 15, " %d", &content_length);
-                iprintf("Content-Length: %d\n", content_length);
-            } else {
-                iprintf("Content-Length header not found yet\n");
-                // Don't set to 0 - keep reading to find it
-            }
+    if (line_len < 0) {
+        LOG_ERROR("Failed to receive response (timeout?)\n");
+        return response;
+    }
+
+    // Status line, skipping any interim 1xx responses
+    char *headers = NULL;
+    size_t headers_len = 0;
+    long content_length = -1;
+    bool chunked = false;
+    bool keep_alive = true;
+    for (;;) {
+        int minor = 1;
+        if (sscanf(line, "HTTP/%*d.%d %d", &minor, &response.status_code) != 2) {
+            LOG_ERROR("Bad status line\n");
+            goto fail;
         }
-        
-        // Check if we have everything (headers + full body)
-        if (body_separator && content_length >= 0) {
-            int body_offset = body_separator - header_buf;
-            int body_received = total_received - body_offset;
-            iprintf("Body: %d/%d bytes\n", body_received, content_length);
-            
-            // If body is large and won't fit in buffer, break early
-            if (content_length > (int)(sizeof(header_buf) - body_offset - 100)) {
-                iprintf("Large body detected, breaking to read separately\n");
-                break;
-            }
-            
-            if (body_received >= content_length) {
-                iprintf("Got full body, breaking\n");
-                break;  // Got everything
+        keep_alive = minor >= 1;
+        headers_len = 0;
+        if (append_header(&headers, &headers_len, line, line_len) != 0) goto fail;
+
+        // Header lines up to the blank line
+        content_length = -1;
+        chunked = false;
+        while ((line_len = conn_read_line(line, sizeof(line))) > 0) {
+            if (append_header(&headers, &headers_len, line, line_len) != 0) goto fail;
+            char *colon = strchr(line, ':');
+            if (!colon) continue;
+            *colon = '\0';
+            char *value = colon + 1;
+            while (*value == ' ') value++;
+            if (strcasecmp(line, "Content-Length") == 0) {
+                content_length = strtol(value, NULL, 10);
+            } else if (strcasecmp(line, "Transfer-Encoding") == 0) {
+                chunked = has_token(value, "chunked");
+            } else if (strcasecmp(line, "Connection") == 0) {
+                if (has_token(value, "close")) keep_alive = false;
+                else if (has_token(value, "keep-alive")) keep_alive = true;
             }
-        } else if (body_separator && content_length < 0) {
-            iprintf("Have separator but no Content-Length yet, keep reading\n");
         }
+        if (line_len < 0) goto fail;
+
+        if (response.status_code >= 200 || response.status_code < 100) break;
+        if ((line_len = conn_read_line(line, sizeof(line))) < 0) goto fail;
     }
-    
-    iprintf("Got %d bytes total\n", total_received);
-    
-    int header_len = total_received;
-    
-    iprintf("Parsing status...\n");
-    // Parse status code
-    sscanf(header_buf, "HTTP/%*d.%*d %d", &response.status_code);
-    iprintf("Status: %d\n", response.status_code);
-    
-    iprintf("Finding body...\n");
-    // Find body start (after blank line)
-    char *body_start = strstr(header_buf, "\r\n\r\n");
-    if (!body_start) {
-        body_start = strstr(header_buf, "\n\n");
-        if (body_start) {
-            body_start += 2;
-        }
-    } else {
-        body_start += 4;
+    LOG_DEBUG("Status: %d\n", response.status_code);
+    response.headers = headers;
+    headers = NULL;
+
+    bool is_2xx = response.status_code >= 200 && response.status_code < 300;
+    bool no_body = response.status_code == 204 || response.status_code == 304;
+
+    // Stream successful bodies to the file if asked; keep the rest in memory
+    BodySink sink = {0};
+    if (response_file && is_2xx) {
+        sink.file = response_file;
+    } else if (content_length > 0 && !no_body) {
+        sink.data = malloc(content_length + 1);
+        if (sink.data) sink.cap = content_length + 1;
     }
-    
-    iprintf("Extracting body...\n");
-    // Calculate body size from Content-Length header
-    if (body_start && content_length >= 0) {
-        int body_offset = body_start - header_buf;
-        int body_in_buffer = header_len - body_offset;
-        
-        iprintf("Content-Length: %d bytes\n", content_length);
-        iprintf("Body in buffer: %d bytes\n", body_in_buffer);
-        
-        // Allocate memory for full body
-        response.body_size = content_length;
-        response.body = malloc(response.body_size + 1);
-        if (!response.body) {
-            iprintf("Failed to allocate %d bytes!\n", content_length);
-            closesocket(socket_fd);
-            socket_fd = -1;
-            response.success = 0;
-            return response;
-        }
-        
-        // Copy what we already have
-        if (body_in_buffer > 0) {
-            int to_copy = (body_in_buffer < content_length) ? body_in_buffer : content_length;
-            memcpy(response.body, body_start, to_copy);
-            iprintf("Copied %d bytes from buffer\n", to_copy);
-        }
-        
-        // Read remaining body data
-        int remaining = content_length - body_in_buffer;
-        int received = body_in_buffer;
-        
-        while (remaining > 0) {
-            iprintf("Reading %d more bytes...\n", remaining);
-            int chunk = recv(socket_fd, response.body + received, remaining, 0);
-            if (chunk <= 0) {
-                iprintf("recv failed: %d\n", chunk);
-                break;
-            }
-            received += chunk;
-            remaining -= chunk;
-            iprintf("Progress: %d/%d bytes\n", received, content_length);
-        }
-        
-        if (received == content_length) {
-            iprintf("Downloaded complete: %d bytes\n", received);
-            response.body[response.body_size] = '\0';
-        } else {
-            iprintf("Incomplete download: %d/%d\n", received, content_length);
-            free(response.body);
-            response.body = NULL;
-            response.body_size = 0;
-            closesocket(socket_fd);
-            socket_fd = -1;
-            response.success = 0;
-            return response;
-        }
+
+    int rc = 0;
+    if (no_body) {
+        // 204/304 never carry a body
+    } else if (chunked) {
+        rc = read_body_chunked(&sink);
+    } else if (content_length >= 0) {
+        rc = read_body_exact(&sink, (size_t)content_length);
     } else {
-        iprintf("No body separator or Content-Length\n");
-        response.body_size = 0;
+        rc = read_body_to_close(&sink);
+        keep_alive = false;
     }
-    
-    // Read remaining response body
-    // (For now, we're keeping it simple with first chunk)
-    
-    iprintf("Shutting down socket...\n");
-    shutdown(socket_fd, 0); // SHUT_RD - like dswifi example
-    iprintf("Closing socket...\n");
-    closesocket(socket_fd); // Use closesocket() not close()
-    socket_fd = -1;
-    iprintf("Socket closed\n");
-    
-    iprintf("Setting success flag...\n");
-    response.success = (response.status_code >= 200 && response.status_code < 300);
-    iprintf("Returning response\n");
+    if (rc != 0) {
+        free(sink.data);
+        http_response_free(&response);
+        goto fail;
+    }
+
+    response.body = sink.data;
+    response.body_size = sink.size;
+
+    if (keep_alive) conn.reused = true;
+    else conn_close();
+
+    response.success = is_2xx;
+    return response;
+
+fail:
+    free(headers);
+    conn_close();
+    response.success = 0;
     return response;
 }
 
+HttpResponse http_request_ex(
+    const char *url,
+    HttpMethod method,
+    const char *api_key,
+    const uint8_t *body,
+    size_t body_size,
+    const char *if_none_match
+) {
+    return http_do(url, method, api_key, body, NULL, body_size, if_none_match, NULL);
+}
+
+HttpResponse http_request_file(
+    const char *url,
+    HttpMethod method,
+    const char *api_key,
+    FILE *body_file,
+    size_t body_size,
+    const char *if_none_match,
+    FILE *response_file
+) {
+    return http_do(url, method, api_key, NULL, body_file, body_size, if_none_match, response_file);
+}
+
+int http_response_header(const HttpResponse *response, const char *name,
+                         char *out, size_t out_size) {
+    if (!response->headers || out_size == 0) return 0;
+    size_t name_len = strlen(name);
+
+    // Header lines start after a newline; the first line is the status
+    const char *line = strchr(response->headers, '\n');
+    while (line) {
+        line++;
+        if (strncasecmp(line, name, name_len) == 0 && line[name_len] == ':') {
+            const char *value = line + name_len + 1;
+            while (*value == ' ') value++;
+            size_t len = strcspn(value, "\r\n");
+            if (len >= out_size) len = out_size - 1;
+            memcpy(out, value, len);
+            out[len] = '\0';
+            return 1;
+        }
+        line = strchr(line, '\n');
+    }
+    return 0;
+}
+
 void http_response_free(HttpResponse *response) {
     if (response->body) {
         free(response->body);
         response->body = NULL;
     }
+    if (response->headers) {
+        free(response->headers);
+        response->headers = NULL;
+    }
+}
+
+void http_set_log_level(int level) {
+    log_level = level;
 }
 
 void http_cleanup(void) {
-    if (socket_fd >= 0) {
-        close(socket_fd);
-        socket_fd = -1;
-    }
+    conn_close();
+    dns_valid = false;
 }
@@ -3,8 +3,10 @@
 #include <fat.h>
 #include "common.h"
 #include "config.h"
+#include "hashcache.h"
 #include "saves.h"
 #include "network.h"
+#include "http.h"
 #include "sync.h"
 #include "ui.h"
 #include "update.h"
@@ -63,6 +65,8 @@ int main(int argc, char *argv[]) {
         return 0;
     }
     
+    http_set_log_level(state.log_level);
+    
     // Initialize network (optional - continue if fails)
     iprintf("Initializing network...\n");
     bool has_wifi = (network_init(&state) == 0);
@@ -148,7 +152,7 @@ int main(int argc, char *argv[]) {
         
         if (pressed & KEY_DOWN) {
             if (focus_on_config) {
-                config_selected = (config_selected + 1) % 7;
+                config_selected = (config_selected + 1) % 8;
                 redraw = true;
             } else if (state.num_titles > 0) {
                 selected = (selected + 1) % state.num_titles;
@@ -159,7 +163,7 @@ int main(int argc, char *argv[]) {
         
         if (pressed & KEY_UP) {
             if (focus_on_config) {
-                config_selected = (config_selected - 1 + 7) % 7;
+                config_selected = (config_selected - 1 + 8) % 8;
                 redraw = true;
             } else if (state.num_titles > 0) {
                 selected = (selected - 1 + state.num_titles) % state.num_titles;
@@ -320,6 +324,11 @@ int main(int argc, char *argv[]) {
                         }
                     }
                     redraw = true;
+                } else if (config_selected == 7) {
+                    // Hash benchmark
+                    consoleSelect(&bottomScreen);
+                    ui_show_hash_benchmark();
+                    redraw = true;
                 }
                 continue;
             }
@@ -615,6 +624,9 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    // Keep hashes computed for single titles (details, manual sync)
+    hashcache_flush();
+    
     // Disconnect WiFi before exit to allow other games to initialize it cleanly
     // This may help avoid the nds-bootstrap issue where games won't load after WiFi apps
     network_cleanup();
@@ -1,12 +1,14 @@
 #include "network.h"
 #include "http.h"
 #include "saves.h"
+#include "sync.h"
 #include <dswifi9.h>
 #include <wfc.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <netinet/in.h>
+#include <sys/stat.h>
 
 // WiFi connection state
 static bool wifi_connected = false;
@@ -221,48 +223,230 @@ int network_init(SyncState *state) {
     return -1;
 }
 
-// Helper: build sync request payload
+// Binary /sync exchange (see server/app/services/sync_binary.py).
+// Request: "3DSY", version, console ID[16], count, then per title
+// title ID (BE), hash[32], last synced hash[32] (zero = none), size, timestamp.
+// Response: "3DSP", version, count, then per title title ID (BE), action.
+#define SYNC_REQUEST_MAGIC "3DSY"
+#define SYNC_PLAN_MAGIC    "3DSP"
+#define SYNC_BINARY_VERSION 1
+#define SYNC_HEADER_SIZE   (4 + 4 + 16 + 4)
+#define SYNC_TITLE_SIZE    (8 + 32 + 32 + 4 + 4)
+#define SYNC_PLAN_HEADER   (4 + 4 + 4)
+#define SYNC_PLAN_ENTRY    (8 + 1)
+
+static void put_u32_le(uint8_t *p, uint32_t v) {
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = (v >> 24) & 0xFF;
+}
+
+static uint32_t get_u32_le(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool hex_to_bytes(const char *hex, uint8_t *out, int len) {
+    for (int i = 0; i < len; i++) {
+        unsigned int byte;
+        if (sscanf(hex + i * 2, "%2x", &byte) != 1) return false;
+        out[i] = (uint8_t)byte;
+    }
+    return true;
+}
+
+// Helper: build sync request payload. Titles without a local save are sent
+// with an all-zero hash and no sync history.
 static uint8_t* build_sync_payload(SyncState *state, size_t *payload_size) {
-    // TODO: Create JSON or binary payload with title metadata
-    // Format: array of {title_id, local_hash, last_synced_hash, size}
-    *payload_size = 0;
-    return NULL;
+    uint8_t *req = (uint8_t*)malloc(SYNC_HEADER_SIZE + state->num_titles * SYNC_TITLE_SIZE);
+    if (!req) return NULL;
+    
+    memcpy(req, SYNC_REQUEST_MAGIC, 4);
+    put_u32_le(req + 4, SYNC_BINARY_VERSION);
+    memset(req + 8, 0, 16);  // No console ID; DS uploads don't send one either
+    put_u32_le(req + 24, state->num_titles);
+    
+    uint8_t *entry = req + SYNC_HEADER_SIZE;
+    for (int i = 0; i < state->num_titles; i++, entry += SYNC_TITLE_SIZE) {
+        Title *title = &state->titles[i];
+        memcpy(entry, title->title_id, 8);
+        memset(entry + 8, 0, 64);
+        
+        bool has_local = title->save_size > 0 && saves_ensure_hash(title) == 0;
+        if (has_local) {
+            memcpy(entry + 8, title->hash, 32);
+            
+            char title_id_hex[17];
+            char last_hash[65];
+            snprintf(title_id_hex, sizeof(title_id_hex), "%02X%02X%02X%02X%02X%02X%02X%02X",
+                title->title_id[0], title->title_id[1], title->title_id[2], title->title_id[3],
+                title->title_id[4], title->title_id[5], title->title_id[6], title->title_id[7]);
+            if (!sync_load_last_hash(title_id_hex, last_hash) ||
+                !hex_to_bytes(last_hash, entry + 40, 32)) {
+                memset(entry + 40, 0, 32);
+            }
+        }
+        put_u32_le(entry + 72, has_local ? title->save_size : 0);
+        put_u32_le(entry + 76, title->timestamp);
+    }
+    
+    *payload_size = SYNC_HEADER_SIZE + state->num_titles * SYNC_TITLE_SIZE;
+    return req;
 }
 
-int network_sync(SyncState *state) {
+// Record each plan entry in plan[] at the index of its title
+static bool parse_sync_plan(SyncState *state, const uint8_t *resp, size_t resp_size,
+                            uint8_t *plan) {
+    if (resp_size < SYNC_PLAN_HEADER) return false;
+    if (memcmp(resp, SYNC_PLAN_MAGIC, 4) != 0) return false;
+    if (get_u32_le(resp + 4) != SYNC_BINARY_VERSION) return false;
+    
+    uint32_t count = get_u32_le(resp + 8);
+    if (count > (resp_size - SYNC_PLAN_HEADER) / SYNC_PLAN_ENTRY) return false;
+    
+    // Entries are grouped by action but keep request order within a group,
+    // so searching on from the last match is almost always one step
+    int cursor = 0;
+    const uint8_t *p = resp + SYNC_PLAN_HEADER;
+    for (uint32_t i = 0; i < count; i++, p += SYNC_PLAN_ENTRY) {
+        for (int n = 0; n < state->num_titles; n++) {
+            int j = (cursor + n) % state->num_titles;
+            if (memcmp(state->titles[j].title_id, p, 8) == 0) {
+                plan[j] = p[8];
+                cursor = j + 1;
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+int network_sync(SyncState *state, uint8_t *plan) {
     if (!wifi_connected) {
-        printf("Not connected to WiFi\n");
+        iprintf("Not connected to WiFi\n");
         return -1;
     }
     
+    memset(plan, NET_PLAN_NONE, state->num_titles);
+    if (state->num_titles == 0) return 0;
+    
     // Build sync request
     size_t payload_size = 0;
     uint8_t *payload = build_sync_payload(state, &payload_size);
+    if (!payload) {
+        iprintf("Out of memory!\n");
+        return -1;
+    }
+    
+    // Strip trailing slash from server_url if present
+    char server_url[256];
+    strncpy(server_url, state->server_url, sizeof(server_url) - 1);
+    server_url[sizeof(server_url) - 1] = '\0';
+    size_t len = strlen(server_url);
+    if (len > 0 && server_url[len - 1] == '/') {
+        server_url[len - 1] = '\0';
+    }
     
     // Build URL
     char url[512];
-    snprintf(url, sizeof(url), "%s/api/v1/sync", state->server_url);
-    
-    printf("Syncing to %s...\n", url);
+    snprintf(url, sizeof(url), "%s/api/v1/sync", server_url);
     
     // POST to sync endpoint
     HttpResponse response = http_request(url, HTTP_POST, state->api_key, payload, payload_size);
+    free(payload);
     
     if (!response.success) {
-        printf("Sync request failed (HTTP %d)\n", response.status_code);
+        iprintf("Sync request failed (HTTP %d)\n", response.status_code);
         http_response_free(&response);
-        if (payload) free(payload);
         return -1;
     }
     
-    printf("Sync complete\n");
-    
-    // TODO: Parse response and execute sync plan
-    // Response contains list of {title_id, action: UPLOAD|DOWNLOAD|CONFLICT}
-    
+    bool ok = parse_sync_plan(state, response.body, response.body_size, plan);
+    http_response_free(&response);
+    if (!ok) {
+        iprintf("Bad sync response\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Bulk metadata lookup (see server/app/services/meta_binary.py)
+#define META_REQUEST_MAGIC  "3DSM"
+#define META_RESPONSE_MAGIC "3DSI"
+#define META_BINARY_VERSION 1
+#define META_HEADER_SIZE    (4 + 4 + 4)
+#define META_ENTRY_SIZE     (8 + 32 + 4 + 4 + 4 + 4 + 16)
+
+int network_get_save_info_bulk(SyncState *state, const int *indices, int count,
+                               NetSaveInfo *info) {
+    if (!wifi_connected) {
+        return -1;
+    }
+
+    memset(info, 0, count * sizeof(NetSaveInfo));
+    if (count == 0) return 0;
+
+    size_t payload_size = META_HEADER_SIZE + count * 8;
+    uint8_t *payload = (uint8_t*)malloc(payload_size);
+    if (!payload) return -1;
+    memcpy(payload, META_REQUEST_MAGIC, 4);
+    put_u32_le(payload + 4, META_BINARY_VERSION);
+    put_u32_le(payload + 8, count);
+    for (int n = 0; n < count; n++) {
+        memcpy(payload + META_HEADER_SIZE + n * 8, state->titles[indices[n]].title_id, 8);
+    }
+
+    // Strip trailing slash from server_url if present
+    char server_url[256];
+    strncpy(server_url, state->server_url, sizeof(server_url) - 1);
+    server_url[sizeof(server_url) - 1] = '\0';
+    size_t len = strlen(server_url);
+    if (len > 0 && server_url[len - 1] == '/') {
+        server_url[len - 1] = '\0';
+    }
+
+    char url[512];
+    snprintf(url, sizeof(url), "%s/api/v1/titles/meta", server_url);
+
+    HttpResponse response = http_request(url, HTTP_POST, state->api_key, payload, payload_size);
+    free(payload);
+
+    const uint8_t *resp = response.body;
+    size_t resp_size = response.body_size;
+    if (!response.success || !resp || resp_size < META_HEADER_SIZE ||
+        memcmp(resp, META_RESPONSE_MAGIC, 4) != 0 ||
+        get_u32_le(resp + 4) != META_BINARY_VERSION) {
+        http_response_free(&response);
+        return -1;
+    }
+    uint32_t entries = get_u32_le(resp + 8);
+    if (entries > (resp_size - META_HEADER_SIZE) / META_ENTRY_SIZE) {
+        http_response_free(&response);
+        return -1;
+    }
+
+    // Entries follow request order (titles without a server save are left
+    // out), so searching on from the last match is almost always one step
+    uint32_t cursor = 0;
+    for (int n = 0; n < count && entries > 0; n++) {
+        const uint8_t *title_id = state->titles[indices[n]].title_id;
+        for (uint32_t k = 0; k < entries; k++) {
+            uint32_t e = (cursor + k) % entries;
+            const uint8_t *p = resp + META_HEADER_SIZE + e * META_ENTRY_SIZE;
+            if (memcmp(p, title_id, 8) != 0) continue;
+
+            info[n].found = true;
+            for (int i = 0; i < 32; i++) {
+                sprintf(&info[n].hash[i * 2], "%02x", p[8 + i]);
+            }
+            info[n].size = get_u32_le(p + 40);
+            info[n].timestamp = get_u32_le(p + 48);
+            cursor = e + 1;
+            break;
+        }
+    }
+
     http_response_free(&response);
-    if (payload) free(payload);
-    
     return 0;
 }
 
@@ -281,14 +465,13 @@ int network_upload(SyncState *state, int title_idx) {
     // Ensure hash is calculated
     if (!title->hash_calculated) {
         iprintf("Calculating hash...\n");
-        if (saves_compute_hash(title->save_path, title->hash) != 0) {
+        if (saves_ensure_hash(title) != 0) {
             iprintf("Failed to read save!\n");
             return -1;
         }
-        title->hash_calculated = true;
     }
     
-    // Read save file
+    // Open save file; its contents are streamed to the socket
     FILE *f = fopen(title->save_path, "rb");
     if (!f) {
         iprintf("Failed to open save file!\n");
@@ -299,18 +482,8 @@ int network_upload(SyncState *state, int title_idx) {
     long file_size = ftell(f);
     fseek(f, 0, SEEK_SET);
     
-    uint8_t *file_data = (uint8_t*)malloc(file_size);
-    if (!file_data) {
+    if (file_size <= 0) {
         fclose(f);
-        iprintf("Out of memory!\n");
-        return -1;
-    }
-    
-    size_t read_bytes = fread(file_data, 1, file_size, f);
-    fclose(f);
-    
-    if (read_bytes != file_size) {
-        free(file_data);
         iprintf("Failed to read save!\n");
         return -1;
     }
@@ -334,19 +507,21 @@ int network_upload(SyncState *state, int title_idx) {
         server_url,
         title_id_hex);
     
-    iprintf("=== Upload Debug ===\n");
-    iprintf("Server: %s\n", state->server_url);
-    iprintf("Game: %s\n", title->game_name);
-    iprintf("URL: %s\n", url);
-    iprintf("Size: %ld bytes\n", file_size);
-    iprintf("API Key: %.10s...\n\n", state->api_key);
+    if (state->log_level >= HTTP_LOG_DEBUG) {
+        iprintf("=== Upload Debug ===\n");
+        iprintf("Server: %s\n", state->server_url);
+        iprintf("Game: %s\n", title->game_name);
+        iprintf("URL: %s\n", url);
+        iprintf("Size: %ld bytes\n", file_size);
+        iprintf("API Key: %.10s...\n\n", state->api_key);
+    }
     
     iprintf("Sending POST...\n");
     
     // POST save data
-    HttpResponse response = http_request(url, HTTP_POST, state->api_key, file_data, file_size);
-    
-    free(file_data);
+    HttpResponse response = http_request_file(url, HTTP_POST, state->api_key,
+                                              f, (size_t)file_size, NULL, NULL);
+    fclose(f);
     
     if (!response.success) {
         iprintf("HTTP %d\n", response.status_code);
@@ -391,41 +566,63 @@ int network_download(SyncState *state, int title_idx) {
     
     iprintf("GET %s\n", url);
     
+    // Send the hash of the save we hold so the server can skip the transfer
+    char local_hash[65] = "";
+    if (title->hash_calculated) {
+        for (int i = 0; i < 32; i++)
+            sprintf(local_hash + i * 2, "%02x", title->hash[i]);
+    }
+    
+    // Stream the save into a temp file so a failed transfer leaves the
+    // current save untouched
+    char tmp_path[MAX_PATH + 4];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", title->save_path);
+    FILE *f = fopen(tmp_path, "wb");
+    if (!f) {
+        iprintf("Failed to open file!\n");
+        return -1;
+    }
+    
     // GET save data
-    HttpResponse response = http_request(url, HTTP_GET, state->api_key, NULL, 0);
+    HttpResponse response = http_request_file(url, HTTP_GET, state->api_key,
+                                              NULL, 0, local_hash, f);
+    bool write_failed = fclose(f) != 0;
     
-    if (!response.success) {
-        iprintf("HTTP %d\n", response.status_code);
+    if (response.status_code == 304) {
+        iprintf("Already up to date\n");
+        remove(tmp_path);
         http_response_free(&response);
-        return -1;
+        return 0;
     }
     
-    // Write to file
-    FILE *f = fopen(title->save_path, "wb");
-    if (!f) {
-        iprintf("Failed to open file!\n");
+    if (!response.success || write_failed) {
+        if (write_failed) iprintf("Write failed!\n");
+        else iprintf("HTTP %d\n", response.status_code);
+        remove(tmp_path);
         http_response_free(&response);
         return -1;
     }
     
-    size_t written = fwrite(response.body, 1, response.body_size, f);
-    fclose(f);
-    
-    if (written != response.body_size) {
-        iprintf("Write failed!\n");
+    remove(title->save_path);
+    if (rename(tmp_path, title->save_path) != 0) {
+        iprintf("Failed to replace save!\n");
+        remove(tmp_path);
         http_response_free(&response);
         return -1;
     }
     
-    iprintf("Wrote %zu bytes\n", written);
+    iprintf("Wrote %zu bytes\n", response.body_size);
     
-    // Update save size
+    // Update save size and time
     title->save_size = response.body_size;
+    struct stat st;
+    if (stat(title->save_path, &st) == 0) {
+        title->timestamp = (uint32_t)st.st_mtime;
+    }
     
     // Recalculate hash for downloaded file
-    if (saves_compute_hash(title->save_path, title->hash) == 0) {
-        title->hash_calculated = true;
-    }
+    title->hash_calculated = false;
+    saves_ensure_hash(title);
     
     http_response_free(&response);
     return 0;
@@ -562,7 +759,30 @@ int network_get_save_info_ext(SyncState *state, const char *title_id_hex,
     char url[512];
     snprintf(url, sizeof(url), "%s/api/v1/saves/%s/meta", server_url, title_id_hex);
 
-    HttpResponse response = http_request(url, HTTP_GET, state->api_key, NULL, 0);
+    // If the server still holds our last synced version it answers 304
+    // with just the X-Save-* headers
+    char last_hash[65];
+    bool has_last = sync_load_last_hash(title_id_hex, last_hash);
+
+    HttpResponse response = http_request_ex(url, HTTP_GET, state->api_key, NULL, 0,
+                                            has_last ? last_hash : NULL);
+
+    if (response.status_code == 304) {
+        char value[32];
+        if (hash_out) strcpy(hash_out, last_hash);
+        if (size_out) {
+            *size_out = 0;
+            if (http_response_header(&response, "X-Save-Size", value, sizeof(value)))
+                *size_out = (size_t)strtoul(value, NULL, 10);
+        }
+        if (timestamp_out) {
+            *timestamp_out = 0;
+            if (http_response_header(&response, "X-Save-Timestamp", value, sizeof(value)))
+                *timestamp_out = (uint32_t)strtoul(value, NULL, 10);
+        }
+        http_response_free(&response);
+        return 0;
+    }
 
     if (response.status_code == 404) {
         http_response_free(&response);
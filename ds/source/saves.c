@@ -1,5 +1,8 @@
 #include "saves.h"
+#include "hashcache.h"
+#include "romindex.h"
 #include "sha256.h"
+#include "sync.h"
 #include <dirent.h>
 #include <sys/stat.h>
 #include <fat.h>
@@ -7,35 +10,29 @@
 // nds-bootstrap save paths
 #define BOOTSTRAP_SAVES_PATH "sd:/roms/nds/saves"
 #define MAX_PATH_LEN 256
-#define NDS_GAMECODE_OFFSET 0x0C
+#define ROM_SCAN_DEPTH 4  // Subdirectory levels below a ROM directory
+#define HASH_CHUNK_SIZE 4096
 
 // Compare titles by name for sorting (case-insensitive)
 static int title_compare(const void *a, const void *b) {
     return strcasecmp(((const Title *)a)->game_name, ((const Title *)b)->game_name);
 }
 
-// Read product code from NDS ROM header
-// Returns true if successful, fills code_out with 4-char code
-static bool read_rom_gamecode(const char *rom_path, char *code_out) {
-    FILE *f = fopen(rom_path, "rb");
-    if (!f) return false;
-    
-    fseek(f, NDS_GAMECODE_OFFSET, SEEK_SET);
-    char code[4];
-    size_t rd = fread(code, 1, 4, f);
-    fclose(f);
-    
-    if (rd != 4) return false;
-    
-    // Validate printable ASCII
-    for (int i = 0; i < 4; i++) {
-        if (code[i] < 0x20 || code[i] > 0x7E)
-            return false;
+// Get a zeroed title at index count, growing the title table as needed.
+// Returns NULL if out of memory.
+static Title *title_slot(SyncState *state, int count) {
+    if (count >= state->titles_cap) {
+        int cap = state->titles_cap ? state->titles_cap * 2 : 64;
+        Title *grown = (Title *)realloc(state->titles, cap * sizeof(Title));
+        if (!grown) return NULL;
+        state->titles = grown;
+        state->titles_cap = cap;
     }
-    
-    memcpy(code_out, code, 4);
-    code_out[4] = '\0';
-    return true;
+    Title *title = &state->titles[count];
+    memset(title, 0, sizeof(Title));
+    title->game_name = "";
+    title->save_path = "";
+    return title;
 }
 
 // Find corresponding ROM file for a save file
@@ -126,14 +123,144 @@ static int is_nds_bootstrap() {
     return 0;
 }
 
+static bool is_rom_name(const char *name) {
+    const char *ext = strrchr(name, '.');
+    return ext && strcasecmp(ext, ".nds") == 0;
+}
+
+// Get the index entry for a ROM, reading its header only if the ROM is
+// new or changed since the last scan. Returns NULL if it isn't a valid ROM.
+static RomIndexEntry *index_rom(const char *rom_path, const struct stat *st) {
+    RomIndexEntry *e = romindex_find(rom_path, (uint32_t)st->st_size, (uint32_t)st->st_mtime);
+    if (e) return e;
+
+    char product_code[5];
+    if (!romindex_read_gamecode(rom_path, product_code)) {
+        return NULL;  // Skip if can't read product code
+    }
+    return romindex_add(rom_path, (uint32_t)st->st_size, (uint32_t)st->st_mtime, product_code);
+}
+
+// Fill the name and title ID of a title from its ROM.
+// Returns false if out of memory.
+static bool init_rom_title(SyncState *state, Title *title, const char *filename,
+                           const char *product_code) {
+    // Extract game name from filename (remove .nds)
+    const char *dot = strrchr(filename, '.');
+    const char *name = strpool_addn(&state->strings, filename,
+        dot ? (size_t)(dot - filename) : strlen(filename));
+    if (!name) return false;
+    title->game_name = name;
+    
+    // Generate title_id from product code
+    title->title_id[0] = 0x00;
+    title->title_id[1] = 0x04;
+    title->title_id[2] = 0x80;
+    title->title_id[3] = 0x00;
+    for (int i = 0; i < 4; i++) {
+        title->title_id[4 + i] = (uint8_t)product_code[i];
+    }
+    
+    title->is_cartridge = 0;
+    title->hash_calculated = false;
+    return true;
+}
+
+// Set the save path of a title, recording size and time if the save exists.
+// The path is left empty if it can't be stored.
+static bool set_title_save(SyncState *state, Title *title, const char *sav_path) {
+    struct stat sav_st;
+    const char *path = strpool_add(&state->strings, sav_path);
+    title->save_path = path ? path : "";
+    if (path && stat(sav_path, &sav_st) == 0 && S_ISREG(sav_st.st_mode)) {
+        title->save_size = sav_st.st_size;
+        title->timestamp = (uint32_t)sav_st.st_mtime;
+        return true;
+    }
+    title->save_size = 0;
+    return false;
+}
+
+// Scan one flashcard directory (recursing max_depth levels) for .nds ROMs
+static int scan_flashcard_dir(SyncState *state, const char *dir_path, int depth,
+                              int max_depth, int count) {
+    DIR *dir = opendir(dir_path);
+    if (!dir) {
+        if (depth == 0) iprintf("  Failed\n");
+        return count;
+    }
+    if (depth == 0) iprintf("  OK!\n");
+    
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL) {
+        // Skip . and .. (and hidden entries)
+        if (ent->d_name[0] == '.') {
+            continue;
+        }
+        
+        char path[MAX_PATH_LEN];
+        size_t dir_len = strlen(dir_path);
+        snprintf(path, MAX_PATH_LEN, "%s%s%s", dir_path,
+            (dir_len && dir_path[dir_len - 1] == '/') ? "" : "/", ent->d_name);
+        
+        if (ent->d_type == DT_DIR) {
+            if (depth < max_depth && strcasecmp(ent->d_name, "saves") != 0) {
+                count = scan_flashcard_dir(state, path, depth + 1, max_depth, count);
+            }
+            continue;
+        }
+        
+        // Look for .nds ROM files
+        if (!is_rom_name(ent->d_name)) continue;
+        
+        struct stat st;
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        
+        RomIndexEntry *e = index_rom(path, &st);
+        if (!e) continue;
+        
+        // Check for duplicate product codes (already scanned from different path)
+        bool is_duplicate = false;
+        for (int j = 0; j < count; j++) {
+            // Compare product codes (title_id bytes 4-7)
+            if (memcmp(&state->titles[j].title_id[4], e->code, 4) == 0) {
+                is_duplicate = true;
+                break;
+            }
+        }
+        if (is_duplicate) continue;
+        
+        Title *title = title_slot(state, count);
+        if (!title || !init_rom_title(state, title, ent->d_name, e->code)) break;
+        
+        // A save found last time only needs one stat to confirm
+        if (!(e->sav_path[0] && set_title_save(state, title, e->sav_path))) {
+            char sav_path[MAX_PATH_LEN];
+            if (find_sav_for_rom(path, sav_path, sizeof(sav_path))) {
+                set_title_save(state, title, sav_path);
+                romindex_set_save(e, sav_path);
+            } else {
+                // No save yet, use default path for future download
+                snprintf(sav_path, sizeof(sav_path), "%s", path);
+                char *dot = strrchr(sav_path, '.');
+                if (dot) strcpy(dot, ".sav");
+                set_title_save(state, title, sav_path);
+                romindex_set_save(e, "");
+            }
+        }
+        if (!title->save_path[0]) break;
+        
+        count++;
+    }
+    closedir(dir);
+    return count;
+}
+
 // Scan for .nds ROM files in flashcard directory
 static int scan_flashcard_roms(SyncState *state) {
-    DIR *dir;
-    struct dirent *ent;
-    char path[MAX_PATH_LEN];
     int count = 0;
     
-    // Default flashcard paths
+    // Default flashcard paths; the card root is not searched recursively
     const char *paths[] = {
         "fat:/roms/",
         "/roms/",
@@ -141,193 +268,73 @@ static int scan_flashcard_roms(SyncState *state) {
         "fat:/",
         NULL
     };
+    const int depths[] = { ROM_SCAN_DEPTH, ROM_SCAN_DEPTH, ROM_SCAN_DEPTH, 0 };
     
     // Scan default paths
-    for (int i = 0; paths[i] && count < MAX_TITLES; i++) {
+    for (int i = 0; paths[i]; i++) {
         iprintf("Trying: %s\n", paths[i]);
-        dir = opendir(paths[i]);
-        if (!dir) {
-            iprintf("  Failed\n");
-            continue;
-        }
-        
-        iprintf("  OK!\n");
-        int files_in_dir = 0;
-        while ((ent = readdir(dir)) != NULL && count < MAX_TITLES) {
-            files_in_dir++;
-            
-            // Skip . and ..
-            if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) {
-                continue;
-            }
-            
-            // Look for .nds ROM files
-            char *ext = strrchr(ent->d_name, '.');
-            if (ext && (strcasecmp(ext, ".nds") == 0 || strcasecmp(ext, ".NDS") == 0)) {
-                iprintf("Found ROM: %s\n", ent->d_name);
-                snprintf(path, MAX_PATH_LEN, "%s%s", paths[i], ent->d_name);
-                
-                struct stat st;
-                if (stat(path, &st) == 0 && S_ISREG(st.st_mode)) {
-                    // Read product code from ROM header
-                    char product_code[5];
-                    if (!read_rom_gamecode(path, product_code)) {
-                        continue;  // Skip if can't read product code
-                    }
-                    
-                    // Check for duplicate product codes (already scanned from different path)
-                    bool is_duplicate = false;
-                    for (int j = 0; j < count; j++) {
-                        // Compare product codes (title_id bytes 4-7)
-                        if (memcmp(&state->titles[j].title_id[4], product_code, 4) == 0) {
-                            is_duplicate = true;
-                            iprintf("  Duplicate (already added)\n");
-                            break;
-                        }
-                    }
-                    if (is_duplicate) continue;
-                    
-                    Title *title = &state->titles[count];
-                    
-                    // Extract game name from filename (remove .nds)
-                    strncpy(title->game_name, ent->d_name, sizeof(title->game_name) - 1);
-                    char *dot = strrchr(title->game_name, '.');
-                    if (dot) *dot = '\0';
-                    
-                    // Generate title_id from product code
-                    title->title_id[0] = 0x00;
-                    title->title_id[1] = 0x04;
-                    title->title_id[2] = 0x80;
-                    title->title_id[3] = 0x00;
-                    for (int i = 0; i < 4; i++) {
-                        title->title_id[4 + i] = (uint8_t)product_code[i];
-                    }
-                    
-                    // Find corresponding save file
-                    char sav_path[MAX_PATH_LEN];
-                    if (find_sav_for_rom(path, sav_path, sizeof(sav_path))) {
-                        // Save exists, get its size
-                        struct stat sav_st;
-                        if (stat(sav_path, &sav_st) == 0 && S_ISREG(sav_st.st_mode)) {
-                            title->save_size = sav_st.st_size;
-                            title->timestamp = (uint32_t)sav_st.st_mtime;
-                            strncpy(title->save_path, sav_path, sizeof(title->save_path) - 1);
-                        }
-                    } else {
-                        // No save yet, use default path for future download
-                        snprintf(sav_path, sizeof(sav_path), "%s", path);
-                        char *dot = strrchr(sav_path, '.');
-                        if (dot) strcpy(dot, ".sav");
-                        title->save_size = 0;
-                        strncpy(title->save_path, sav_path, sizeof(title->save_path) - 1);
-                    }
-
-                    title->is_cartridge = 0;
-                    title->hash_calculated = false;
-
-                    count++;
-                }
-            }
-        }
-        iprintf("  Files: %d, Added: %d\n", files_in_dir, count);
-        closedir(dir);
+        int before = count;
+        count = scan_flashcard_dir(state, paths[i], 0, depths[i], count);
+        iprintf("  Added: %d\n", count - before);
     }
     
     return count;
 }
 
-// Scan nds-bootstrap ROM directory (ROMs are in sd:/roms/nds, saves in sd:/roms/nds/saves)
-static int scan_bootstrap_roms(SyncState *state, const char *saves_path) {
-    DIR *dir;
-    struct dirent *ent;
-    char path[MAX_PATH_LEN];
-    int count = 0;
-    
-    // Extract parent directory (remove /saves suffix to get ROM directory)
-    char rom_dir[MAX_PATH_LEN];
-    strncpy(rom_dir, saves_path, sizeof(rom_dir) - 1);
-    rom_dir[sizeof(rom_dir) - 1] = '\0';
-    char *last_slash = strrchr(rom_dir, '/');
-    if (last_slash) {
-        *last_slash = '\0';  // Now rom_dir is "sd:/roms/nds"
-    } else {
-        return 0;  // Invalid path
-    }
-    
-    iprintf("ROM dir: %s\n", rom_dir);
-    
-    dir = opendir(rom_dir);
+// Scan an nds-bootstrap ROM directory (recursing max_depth levels). Saves
+// live in a saves/ folder next to each ROM.
+static int scan_bootstrap_dir(SyncState *state, const char *rom_dir, const char *saves_path,
+                              int depth, int count) {
+    DIR *dir = opendir(rom_dir);
     if (!dir) {
-        iprintf("Failed to open ROM dir\n");
-        return 0;
+        if (depth == 0) iprintf("Failed to open ROM dir\n");
+        return count;
     }
     
-    while ((ent = readdir(dir)) != NULL && count < MAX_TITLES) {
-        // Skip . and ..
-        if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0) {
+    struct dirent *ent;
+    char path[MAX_PATH_LEN];
+    while ((ent = readdir(dir)) != NULL) {
+        // Skip . and .. (and hidden entries)
+        if (ent->d_name[0] == '.') {
             continue;
         }
         
         // Look for .nds ROM files
-        char *ext = strrchr(ent->d_name, '.');
-        if (ext && (strcasecmp(ext, ".nds") == 0 || strcasecmp(ext, ".NDS") == 0)) {
+        if (is_rom_name(ent->d_name)) {
             char rom_path[MAX_PATH_LEN];
             snprintf(rom_path, MAX_PATH_LEN, "%s/%s", rom_dir, ent->d_name);
             
             struct stat st;
             if (stat(rom_path, &st) == 0 && S_ISREG(st.st_mode)) {
-                // Read product code from ROM header
-                char product_code[5];
-                if (!read_rom_gamecode(rom_path, product_code)) {
-                    continue;  // Skip if can't read product code
-                }
-                
-                Title *title = &state->titles[count];
+                RomIndexEntry *e = index_rom(rom_path, &st);
+                if (!e) continue;
                 
-                // Extract game name from filename (remove .nds)
-                strncpy(title->game_name, ent->d_name, sizeof(title->game_name) - 1);
-                char *dot = strrchr(title->game_name, '.');
-                if (dot) *dot = '\0';
-                
-                // Generate title_id from product code
-                title->title_id[0] = 0x00;
-                title->title_id[1] = 0x04;
-                title->title_id[2] = 0x80;
-                title->title_id[3] = 0x00;
-                for (int i = 0; i < 4; i++) {
-                    title->title_id[4 + i] = (uint8_t)product_code[i];
-                }
+                Title *title = title_slot(state, count);
+                if (!title || !init_rom_title(state, title, ent->d_name, e->code)) break;
                 
                 // Look for save file in saves directory
                 char sav_name[MAX_PATH_LEN];
                 strncpy(sav_name, ent->d_name, sizeof(sav_name) - 1);
+                sav_name[sizeof(sav_name) - 1] = '\0';
                 char *dot2 = strrchr(sav_name, '.');
                 if (dot2) strcpy(dot2, ".sav");
                 
                 char sav_path[MAX_PATH_LEN];
                 snprintf(sav_path, sizeof(sav_path), "%s/%s", saves_path, sav_name);
                 
-                struct stat sav_st;
-                if (stat(sav_path, &sav_st) == 0 && S_ISREG(sav_st.st_mode)) {
-                    // Save exists
-                    title->save_size = sav_st.st_size;
-                    title->timestamp = (uint32_t)sav_st.st_mtime;
-                    strncpy(title->save_path, sav_path, sizeof(title->save_path) - 1);
-                } else {
-                    // No save yet
-                    title->save_size = 0;
-                    strncpy(title->save_path, sav_path, sizeof(title->save_path) - 1);
-                }
-                
-                title->is_cartridge = 0;
-                title->hash_calculated = false;
+                // No save yet keeps the path for downloads
+                romindex_set_save(e, set_title_save(state, title, sav_path) ? sav_path : "");
+                if (!title->save_path[0]) break;
                 
                 count++;
             }
+            continue;
         }
         
+        if (ent->d_type != DT_DIR) continue;
+        
         // Also check for subdirectories with TID structure (original logic)
-        if (ent->d_type == DT_DIR && strlen(ent->d_name) == 16) {
+        if (depth == 0 && strlen(ent->d_name) == 16) {
             // This looks like a title ID (16 hex chars)
             snprintf(path, MAX_PATH_LEN, "%s/%s", saves_path, ent->d_name);
             
@@ -335,21 +342,24 @@ static int scan_bootstrap_roms(SyncState *state, const char *saves_path) {
             DIR *savedir = opendir(path);
             if (savedir) {
                 struct dirent *saveent;
-                while ((saveent = readdir(savedir)) != NULL && count < MAX_TITLES) {
+                while ((saveent = readdir(savedir)) != NULL) {
                     if (strstr(saveent->d_name, ".sav") || strstr(saveent->d_name, ".SAV")) {
                         char savepath[MAX_PATH_LEN];
                         snprintf(savepath, MAX_PATH_LEN, "%s/%s", path, saveent->d_name);
                         
                         struct stat st;
                         if (stat(savepath, &st) == 0 && S_ISREG(st.st_mode)) {
-                            Title *title = &state->titles[count];
+                            Title *title = title_slot(state, count);
                             
                             // Use TID as game name for now (can lookup later)
-                            strncpy(title->game_name, ent->d_name, sizeof(title->game_name) - 1);
+                            const char *name = title ? strpool_add(&state->strings, ent->d_name) : NULL;
+                            const char *save = name ? strpool_add(&state->strings, savepath) : NULL;
+                            if (!save) break;
+                            title->game_name = name;
                             title->save_size = st.st_size;
                             title->is_cartridge = 0;
                             title->hash_calculated = false;  // Don't calculate hash yet
-                            strncpy(title->save_path, savepath, sizeof(title->save_path) - 1);
+                            title->save_path = save;
                             
                             count++;
                         }
@@ -357,22 +367,53 @@ static int scan_bootstrap_roms(SyncState *state, const char *saves_path) {
                 }
                 closedir(savedir);
             }
+            continue;
+        }
+        
+        // ROM subfolder: its saves go in <subfolder>/saves
+        if (depth < ROM_SCAN_DEPTH && strcasecmp(ent->d_name, "saves") != 0) {
+            char sub_dir[MAX_PATH_LEN], sub_saves[MAX_PATH_LEN];
+            snprintf(sub_dir, sizeof(sub_dir), "%s/%s", rom_dir, ent->d_name);
+            snprintf(sub_saves, sizeof(sub_saves), "%s/saves", sub_dir);
+            count = scan_bootstrap_dir(state, sub_dir, sub_saves, depth + 1, count);
         }
     }
     
     closedir(dir);
-    
     return count;
 }
 
+// Scan nds-bootstrap ROM directory (ROMs are in sd:/roms/nds, saves in sd:/roms/nds/saves)
+static int scan_bootstrap_roms(SyncState *state, const char *saves_path) {
+    // Extract parent directory (remove /saves suffix to get ROM directory)
+    char rom_dir[MAX_PATH_LEN];
+    strncpy(rom_dir, saves_path, sizeof(rom_dir) - 1);
+    rom_dir[sizeof(rom_dir) - 1] = '\0';
+    char *last_slash = strrchr(rom_dir, '/');
+    if (last_slash) {
+        *last_slash = '\0';  // Now rom_dir is "sd:/roms/nds"
+    } else {
+        return 0;  // Invalid path
+    }
+    
+    iprintf("ROM dir: %s\n", rom_dir);
+    return scan_bootstrap_dir(state, rom_dir, saves_path, 0, 0);
+}
+
 int saves_scan(SyncState *state) {
+    // The previous scan's names and paths go with its titles
     state->num_titles = 0;
+    strpool_clear(&state->strings);
     
     // Check which type of setup we're running from
     int bootstrap_mode = is_nds_bootstrap();
     
     iprintf("Bootstrap mode: %d\n", bootstrap_mode);
     
+    // ROMs unchanged since the last scan aren't opened again
+    char index_file[MAX_PATH_LEN];
+    romindex_begin(sync_state_file("romindex.txt", index_file, sizeof(index_file)) ? index_file : "");
+    
     if (bootstrap_mode == 1) {
         iprintf("Scanning sd:/roms/nds/saves\n");
         state->num_titles = scan_bootstrap_roms(state, "sd:/roms/nds/saves");
@@ -386,6 +427,7 @@ int saves_scan(SyncState *state) {
         state->num_titles = scan_flashcard_roms(state);
         iprintf("Flashcard: %d saves\n", state->num_titles);
     }
+    romindex_end();
     
     // Sort titles alphabetically by name
     if (state->num_titles > 0) {
@@ -399,31 +441,20 @@ int saves_compute_hash(const char *path, uint8_t *hash) {
     FILE *f = fopen(path, "rb");
     if (!f) return -1;
     
-    // Get file size
-    fseek(f, 0, SEEK_END);
-    long size = ftell(f);
-    fseek(f, 0, SEEK_SET);
+    // Hash in fixed-size chunks so large (8MB DSi) saves need no big allocation
+    static uint8_t buffer[HASH_CHUNK_SIZE];
+    SHA256_CTX ctx;
+    sha256_init(&ctx);
     
-    // Allocate buffer
-    uint8_t *buffer = (uint8_t*)malloc(size);
-    if (!buffer) {
-        fclose(f);
-        return -1;
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        sha256_update(&ctx, buffer, read);
     }
-    
-    // Read file
-    size_t read = fread(buffer, 1, size, f);
+    bool failed = ferror(f);
     fclose(f);
+    if (failed) return -1;
     
-    if (read != size) {
-        free(buffer);
-        return -1;
-    }
-    
-    // Calculate SHA-256
-    sha256_hash(buffer, size, hash);
-    free(buffer);
-    
+    sha256_final(&ctx, hash);
     return 0;
 }
 
@@ -433,8 +464,22 @@ int saves_ensure_hash(Title *title) {
         return 0;  // Already calculated
     }
     
+    // A save with the same size and mtime as when it was last hashed
+    // takes its hash from the cache instead of being read again
+    struct stat st;
+    bool has_stat = stat(title->save_path, &st) == 0 && S_ISREG(st.st_mode);
+    if (has_stat && hashcache_lookup(title->save_path, (uint32_t)st.st_size,
+                                     (uint32_t)st.st_mtime, title->hash)) {
+        title->hash_calculated = true;
+        return 0;
+    }
+    
     if (saves_compute_hash(title->save_path, title->hash) == 0) {
         title->hash_calculated = true;
+        if (has_stat) {
+            hashcache_store(title->save_path, (uint32_t)st.st_size,
+                            (uint32_t)st.st_mtime, title->hash);
+        }
         return 0;
     }
     
@@ -1,4 +1,5 @@
 #include "sync.h"
+#include "hashcache.h"
 #include "saves.h"
 #include "network.h"
 #include <stdio.h>
@@ -66,6 +67,12 @@ static bool ensure_state_dir(void) {
     return false;
 }
 
+bool sync_state_file(const char *name, char *path_out, size_t path_size) {
+    if (!ensure_state_dir()) return false;
+    snprintf(path_out, path_size, "%s/%s", state_dir, name);
+    return true;
+}
+
 bool sync_load_last_hash(const char *title_id_hex, char *hash_out) {
     if (!ensure_state_dir()) return false;
 
@@ -108,7 +115,10 @@ bool sync_save_last_hash(const char *title_id_hex, const char *hash) {
     return written == 64;
 }
 
-int sync_decide(SyncState *state, int title_idx, SyncDecision *decision) {
+// Decide a title's action given the server's metadata for it.
+// Returns 0 on success, -1 if the local save couldn't be hashed.
+static int decide_with_info(SyncState *state, int title_idx, const NetSaveInfo *server,
+                            SyncDecision *decision) {
     Title *title = &state->titles[title_idx];
     memset(decision, 0, sizeof(SyncDecision));
 
@@ -127,10 +137,13 @@ int sync_decide(SyncState *state, int title_idx, SyncDecision *decision) {
 
     decision->has_last_synced = sync_load_last_hash(title_id_hex, decision->last_synced_hash);
 
-    // Step 3: Fetch server metadata
-    int server_result = network_get_save_info_ext(state, title_id_hex,
-        decision->server_hash, &decision->server_size, &decision->server_timestamp);
-    bool has_server = (server_result == 0);
+    // Step 3: Take the server metadata
+    bool has_server = server->found;
+    if (has_server) {
+        strcpy(decision->server_hash, server->hash);
+        decision->server_size = server->size;
+        decision->server_timestamp = server->timestamp;
+    }
 
     // Step 4: Get local mtime
     decision->local_mtime = title->timestamp;
@@ -194,6 +207,23 @@ int sync_decide(SyncState *state, int title_idx, SyncDecision *decision) {
     return 0;
 }
 
+int sync_decide(SyncState *state, int title_idx, SyncDecision *decision) {
+    Title *title = &state->titles[title_idx];
+    if (title->save_size > 0 && saves_ensure_hash(title) != 0) {
+        memset(decision, 0, sizeof(SyncDecision));
+        return -1;
+    }
+
+    char title_id_hex[17];
+    title_id_to_hex(title->title_id, title_id_hex);
+
+    NetSaveInfo server;
+    memset(&server, 0, sizeof(server));
+    server.found = (network_get_save_info_ext(state, title_id_hex,
+        server.hash, &server.size, &server.timestamp) == 0);
+    return decide_with_info(state, title_idx, &server, decision);
+}
+
 int sync_execute(SyncState *state, int title_idx, SyncAction action) {
     Title *title = &state->titles[title_idx];
     char title_id_hex[17];
@@ -230,105 +260,218 @@ int sync_execute(SyncState *state, int title_idx, SyncAction action) {
             hash_to_hex(title->hash, hash_hex);
             sync_save_last_hash(title_id_hex, hash_hex);
         }
+        hashcache_flush();
     }
 
     return result;
 }
 
+// Whether a state file records the last synced hash of a title
+static bool has_sync_history(const Title *title) {
+    char title_id_hex[17];
+    char last_hash[65];
+    title_id_to_hex(title->title_id, title_id_hex);
+    return sync_load_last_hash(title_id_hex, last_hash);
+}
+
+// Whether plan_to_action needs the server's metadata for a title: the
+// server can only call a title without sync history a conflict, and the
+// decision then falls back to comparing timestamps
+static bool plan_needs_info(const Title *title, uint8_t plan) {
+    return plan == NET_PLAN_CONFLICT && title->save_size > 0 && title->hash_calculated &&
+           !has_sync_history(title);
+}
+
+// Turn the server's plan entry for a title into a local action. server is
+// the title's metadata if already fetched, else NULL (asked for if needed).
+// Returns 0 on success, -1 if the title couldn't be decided.
+static int plan_to_action(SyncState *state, int title_idx, uint8_t plan,
+                          const NetSaveInfo *server, SyncAction *action) {
+    Title *title = &state->titles[title_idx];
+    if (title->save_size > 0 && !title->hash_calculated) {
+        return -1;  // Save couldn't be read for hashing
+    }
+    bool has_local = (title->save_size > 0);
+
+    switch (plan) {
+        case NET_PLAN_UPLOAD:
+            // Neither side has a save when there is nothing local to upload
+            *action = has_local ? SYNC_UPLOAD : SYNC_UP_TO_DATE;
+            return 0;
+
+        case NET_PLAN_DOWNLOAD:
+        case NET_PLAN_SERVER_ONLY:
+            *action = SYNC_DOWNLOAD;
+            return 0;
+
+        case NET_PLAN_UP_TO_DATE:
+            *action = SYNC_UP_TO_DATE;
+            return 0;
+
+        case NET_PLAN_CONFLICT: {
+            // No local save means nothing to lose - safe to download
+            if (!has_local) {
+                *action = SYNC_DOWNLOAD;
+                return 0;
+            }
+
+            // Without sync history the server can only report a conflict;
+            // the decision falls back to comparing timestamps
+            if (!has_sync_history(title)) {
+                SyncDecision decision;
+                int result = server ? decide_with_info(state, title_idx, server, &decision)
+                                    : sync_decide(state, title_idx, &decision);
+                if (result != 0) return -1;
+                *action = decision.action;
+                return 0;
+            }
+
+            *action = SYNC_CONFLICT;
+            return 0;
+        }
+
+        default:
+            return -1;  // Missing from the server's response
+    }
+}
+
+// Decide every title from one batched /sync request. Titles that also need
+// server metadata (or every title, if /sync can't be answered) get it from
+// one bulk /titles/meta request, falling back to one /meta request per
+// title on older servers. Sets failed[i] for titles that couldn't be
+// decided. Returns 0 on success.
+static int plan_all(SyncState *state, SyncAction *actions, bool *failed) {
+    int n = state->num_titles;
+    uint8_t *plan = (uint8_t*)malloc(n ? n : 1);
+    int *need = (int*)malloc((n + 1) * sizeof(int));
+    NetSaveInfo *info = (NetSaveInfo*)malloc((n + 1) * sizeof(NetSaveInfo));
+    if (!plan || !need || !info) {
+        free(plan);
+        free(need);
+        free(info);
+        return -1;
+    }
+
+    iprintf("  Checking %d titles...\n", n);
+    bool batched = (network_sync(state, plan) == 0);
+    hashcache_flush();  // Building the request hashed every save
+    if (!batched) {
+        iprintf("  Batch failed, checking each\n");
+    }
+
+    int need_count = 0;
+    for (int i = 0; i < n; i++) {
+        if (!batched || plan_needs_info(&state->titles[i], plan[i])) {
+            need[need_count++] = i;
+        }
+    }
+    bool have_info = need_count > 0 &&
+                     network_get_save_info_bulk(state, need, need_count, info) == 0;
+
+    int k = 0;
+    for (int i = 0; i < n; i++) {
+        const NetSaveInfo *server = NULL;
+        if (k < need_count && need[k] == i) {
+            if (have_info) server = &info[k];
+            k++;
+        }
+
+        failed[i] = false;
+        if (batched) {
+            failed[i] = (plan_to_action(state, i, plan[i], server, &actions[i]) != 0);
+        } else {
+            SyncDecision decision;
+            int result = server ? decide_with_info(state, i, server, &decision)
+                                : sync_decide(state, i, &decision);
+            failed[i] = (result != 0);
+            actions[i] = decision.action;
+        }
+    }
+
+    hashcache_flush();
+    free(plan);
+    free(need);
+    free(info);
+    return 0;
+}
+
 int sync_scan_all(SyncState *state, SyncSummary *summary) {
     memset(summary, 0, sizeof(SyncSummary));
 
+    SyncAction *actions = (SyncAction*)malloc((state->num_titles + 1) * sizeof(SyncAction));
+    bool *failed = (bool*)malloc(state->num_titles + 1);
+    if (!actions || !failed || plan_all(state, actions, failed) != 0) {
+        free(actions);
+        free(failed);
+        return -1;
+    }
+
     for (int i = 0; i < state->num_titles; i++) {
         Title *title = &state->titles[i];
 
-        iprintf("  [%d/%d] %.20s\n", i + 1, state->num_titles, title->game_name);
-
-        SyncDecision decision;
-        if (sync_decide(state, i, &decision) != 0) {
+        if (failed[i]) {
             summary->failed++;
             title->scanned = true;
             title->scan_result = SYNC_CONFLICT;
-            iprintf("    -> FAILED\n");
+            iprintf("  %.20s: FAILED\n", title->game_name);
             continue;
         }
 
         title->scanned = true;
-        title->scan_result = decision.action;
+        title->scan_result = actions[i];
 
-        switch (decision.action) {
+        switch (actions[i]) {
             case SYNC_UP_TO_DATE:
                 summary->up_to_date++;
                 break;
             case SYNC_UPLOAD:
                 summary->uploaded++;
-                iprintf("    -> Needs upload\n");
+                iprintf("  %.20s: needs upload\n", title->game_name);
                 break;
             case SYNC_DOWNLOAD:
                 summary->downloaded++;
-                iprintf("    -> Needs download\n");
+                iprintf("  %.20s: needs download\n", title->game_name);
                 break;
             case SYNC_CONFLICT:
                 summary->conflicts++;
-                iprintf("    -> CONFLICT\n");
+                iprintf("  %.20s: CONFLICT\n", title->game_name);
                 break;
         }
     }
 
+    free(actions);
+    free(failed);
     return 0;
 }
 
 int sync_all(SyncState *state, SyncSummary *summary) {
     memset(summary, 0, sizeof(SyncSummary));
 
+    SyncAction *actions = (SyncAction*)malloc((state->num_titles + 1) * sizeof(SyncAction));
+    bool *failed = (bool*)malloc(state->num_titles + 1);
+    if (!actions || !failed || plan_all(state, actions, failed) != 0) {
+        free(actions);
+        free(failed);
+        return -1;
+    }
+
+    // Only uploads and downloads need further requests
     for (int i = 0; i < state->num_titles; i++) {
         Title *title = &state->titles[i];
 
-        // Skip titles with no local save and not on server
-        if (title->save_size == 0) {
-            // Check if server has it by trying to decide
-            SyncDecision decision;
-            if (sync_decide(state, i, &decision) != 0) {
-                summary->failed++;
-                iprintf("  %s: FAILED\n", title->game_name);
-                continue;
-            }
-
-            if (decision.action == SYNC_UP_TO_DATE) {
-                summary->up_to_date++;
-                continue;
-            }
-
-            if (decision.action == SYNC_DOWNLOAD) {
-                iprintf("  %s: DL...", title->game_name);
-                if (sync_execute(state, i, SYNC_DOWNLOAD) == 0) {
-                    summary->downloaded++;
-                    iprintf("OK\n");
-                } else {
-                    summary->failed++;
-                    iprintf("FAIL\n");
-                }
-            }
-            continue;
-        }
-
-        // Normal title with local save
-        iprintf("  [%d/%d] %.20s\n", i + 1, state->num_titles, title->game_name);
-
-        SyncDecision decision;
-        if (sync_decide(state, i, &decision) != 0) {
+        if (failed[i]) {
             summary->failed++;
-            iprintf("    -> FAILED\n");
+            iprintf("  %s: FAILED\n", title->game_name);
             continue;
         }
 
-        switch (decision.action) {
+        switch (actions[i]) {
             case SYNC_UP_TO_DATE:
                 summary->up_to_date++;
-                iprintf("    -> Up to date\n");
                 break;
 
             case SYNC_UPLOAD:
-                iprintf("    -> Uploading...");
+                iprintf("  %.20s: UL...", title->game_name);
                 if (sync_execute(state, i, SYNC_UPLOAD) == 0) {
                     summary->uploaded++;
                     iprintf("OK\n");
@@ -339,7 +482,7 @@ int sync_all(SyncState *state, SyncSummary *summary) {
                 break;
 
             case SYNC_DOWNLOAD:
-                iprintf("    -> Downloading...");
+                iprintf("  %.20s: DL...", title->game_name);
                 if (sync_execute(state, i, SYNC_DOWNLOAD) == 0) {
                     summary->downloaded++;
                     iprintf("OK\n");
@@ -351,10 +494,12 @@ int sync_all(SyncState *state, SyncSummary *summary) {
 
             case SYNC_CONFLICT:
                 summary->conflicts++;
-                iprintf("    -> CONFLICT\n");
+                iprintf("  %.20s: CONFLICT\n", title->game_name);
                 break;
         }
     }
 
+    free(actions);
+    free(failed);
     return 0;
 }
@@ -2,7 +2,9 @@
 #include "saves.h"
 #include "config.h"
 #include "sync.h"
+#include "sha256.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 void ui_show_save_details(Title *title) {
@@ -241,9 +243,10 @@ void ui_draw_config(const SyncState *state, int selected, bool focused, bool has
         "WiFi WEP Key",
         "Rescan Saves",
         "Connect WiFi",
-        "Check Updates"
+        "Check Updates",
+        "Hash Benchmark"
     };
-    const int item_count = 7;
+    const int item_count = 8;
 
     for (int i = 0; i < item_count; i++) {
         char cursor = (focused && i == selected) ? '>' : ' ';
@@ -293,3 +296,58 @@ void ui_draw_config(const SyncState *state, int selected, bool focused, bool has
         iprintf("Y:Info L:Config START:Exit\n");
     }
 }
+
+#define BENCH_BUF_SIZE (256 * 1024)
+#define BENCH_PASSES   4
+
+// KB/s hashing buf in chunk-sized updates (0 = whole buffer per update)
+static u32 bench_sha256(const u8 *buf, u32 chunk) {
+    u8 hash[32];
+    cpuStartTiming(0);
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        SHA256_CTX ctx;
+        sha256_init(&ctx);
+        if (chunk == 0) {
+            sha256_update(&ctx, buf, BENCH_BUF_SIZE);
+        } else {
+            for (u32 off = 0; off < BENCH_BUF_SIZE; off += chunk)
+                sha256_update(&ctx, buf + off, chunk);
+        }
+        sha256_final(&ctx, hash);
+    }
+    u32 ticks = cpuEndTiming();
+    if (ticks == 0) return 0;
+    return (u32)((u64)BENCH_PASSES * BENCH_BUF_SIZE * BUS_CLOCK / ticks / 1024);
+}
+
+static void print_rate(const char *label, u32 kbps) {
+    iprintf("%s %lu.%02lu MB/s\n", label,
+        (unsigned long)(kbps / 1024), (unsigned long)(kbps % 1024 * 100 / 1024));
+}
+
+// Time SHA-256 on this console and show MB/s on the current console
+void ui_show_hash_benchmark(void) {
+    consoleClear();
+    iprintf("=== Hash Benchmark ===\n\n");
+    iprintf("Console: %s\n", isDSiMode() ? "DSi" : "DS");
+    iprintf("Hashing %dx %dKB...\n\n", BENCH_PASSES, BENCH_BUF_SIZE / 1024);
+
+    u8 *buf = (u8 *)malloc(BENCH_BUF_SIZE);
+    if (!buf) {
+        iprintf("Out of memory\n");
+    } else {
+        for (u32 i = 0; i < BENCH_BUF_SIZE; i++) buf[i] = (u8)(i * 2654435761u >> 24);
+
+        print_rate("One buffer: ", bench_sha256(buf, 0));
+        print_rate("4KB updates:", bench_sha256(buf, 4096));
+        print_rate("64B updates:", bench_sha256(buf, 64));
+        free(buf);
+    }
+
+    iprintf("\nPress any button\n");
+    while (pmMainLoop()) {
+        swiWaitForVBlank();
+        scanKeys();
+        if (keysDown()) break;
+    }
+}
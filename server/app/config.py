@@ -7,7 +7,14 @@ class Settings(BaseSettings):
     api_key: str = "anything"
     host: str = "0.0.0.0"
     port: int = 8000
-    max_history_versions: int = 10
+    max_history_versions: int = 100
+    history_snapshot_interval: int = 16
+    history_compaction: bool = True
+    upload_part_size: int = 256 * 1024
+    max_upload_size: int = 32 * 1024 * 1024
+    upload_session_ttl: int = 3600
+    delta_block_size: int = 4096
+    storage_workers: int = 4
 
     model_config = {"env_prefix": "SYNC_"}
 
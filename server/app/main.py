@@ -1,3 +1,4 @@
+import asyncio
 from contextlib import asynccontextmanager
 from pathlib import Path
 
@@ -6,18 +7,23 @@ from fastapi import FastAPI
 from app.config import settings
 from app.middleware.auth import APIKeyMiddleware
 from app.routes import saves, status, sync, titles, update
-from app.services import game_names
+from app.services import game_names, metrics, storage, workers
 
 
 @asynccontextmanager
 async def lifespan(app: FastAPI):
     settings.save_dir.mkdir(parents=True, exist_ok=True)
+    print(f"Indexed {storage.load_index()} stored saves")
     # Load game names databases (3DS + DS)
     data_dir = Path(__file__).parent.parent / "data"
     count_3ds = game_names.load_database(data_dir / "3dstdb.txt")
     count_ds = game_names.load_database(data_dir / "dstdb.txt")
     print(f"Loaded {count_3ds} 3DS + {count_ds} DS game names from database")
+
+    lag_monitor = asyncio.create_task(metrics.monitor_loop_lag())
     yield
+    lag_monitor.cancel()
+    workers.shutdown()
 
 
 def create_app() -> FastAPI:
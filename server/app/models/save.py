@@ -11,6 +11,7 @@ from pydantic import BaseModel, field_validator
 BUNDLE_MAGIC = b"3DSS"
 BUNDLE_VERSION = 1
 BUNDLE_VERSION_COMPRESSED = 2
+BUNDLE_VERSION_CODECS = 3
 
 
 @dataclass
@@ -48,6 +49,7 @@ class SaveMetadata:
     client_timestamp: int  # timestamp reported by the 3DS
     server_timestamp: str  # server wall-clock time at upload
     console_id: str = ""  # ID of the console that uploaded this save
+    change_seq: int = 0  # storage change sequence number of this version
 
     def to_dict(self) -> dict:
         return {
@@ -61,6 +63,7 @@ class SaveMetadata:
             "client_timestamp": self.client_timestamp,
             "server_timestamp": self.server_timestamp,
             "console_id": self.console_id,
+            "change_seq": self.change_seq,
         }
 
 
@@ -88,6 +91,20 @@ class SyncRequest(BaseModel):
     console_id: str | None = None  # ID of the console making the request
 
 
+class MetadataRequest(BaseModel):
+    """Title IDs to look up in one bulk metadata request."""
+    title_ids: list[str]
+
+    @field_validator("title_ids")
+    @classmethod
+    def validate_title_ids(cls, v: list[str]) -> list[str]:
+        v = [t.upper() for t in v]
+        for t in v:
+            if len(t) != 16 or not all(c in "0123456789ABCDEF" for c in t):
+                raise ValueError("title IDs must be 16 hex characters")
+        return v
+
+
 class ConflictInfo(BaseModel):
     """Details about a conflicting save to help user decide."""
     title_id: str
@@ -108,3 +125,8 @@ class SyncPlan(BaseModel):
     up_to_date: list[str]  # title IDs with matching hashes
     server_only: list[str]  # title IDs only on server -> 3DS should download
     conflict_info: list[ConflictInfo] = []  # Details for each conflict
+
+
+class UploadStartRequest(BaseModel):
+    """Start a chunked upload session for a bundle of the given size."""
+    size: int
@@ -1,15 +1,37 @@
 import hashlib
 import re
+import time
+from collections.abc import Iterable
+from pathlib import Path
 
 from fastapi import APIRouter, HTTPException, Query, Request, Response
+from fastapi.responses import FileResponse, JSONResponse
 
-from app.models.save import BundleFile, SaveBundle
-from app.services import storage
-from app.services.bundle import BundleError, create_bundle, parse_bundle
+from app.config import settings
+from app.models.save import (
+    BUNDLE_VERSION_CODECS,
+    BUNDLE_VERSION_COMPRESSED,
+    BundleFile,
+    SaveBundle,
+    UploadStartRequest,
+)
+from app.services import storage, uploads, workers
+from app.services.bundle import BundleError, BundleParser, create_bundle
+from app.services.delta import (
+    DeltaError,
+    apply_delta,
+    create_delta,
+    encode_block_list,
+    parse_delta,
+)
+from app.services.uploads import UploadError
 
 router = APIRouter()
 
 _TITLE_ID_RE = re.compile(r"^[0-9A-Fa-f]{16}$")
+_UPLOAD_ID_RE = re.compile(r"^[0-9a-f]{32}$")
+_RANGE_RE = re.compile(r"^bytes=(\d*)-(\d*)$")
+_VERSION_RE = re.compile(r"^\d[0-9T_.-]*$")
 
 
 def _validate_title_id(title_id: str) -> str:
@@ -19,24 +41,65 @@ def _validate_title_id(title_id: str) -> str:
     return title_id.upper()
 
 
+def _get_upload_session(title_id: str, upload_id: str) -> dict:
+    """Look up an upload session for a title, or raise 404."""
+    session = None
+    if _UPLOAD_ID_RE.match(upload_id):
+        session = uploads.get_session(title_id, upload_id)
+    if session is None:
+        raise HTTPException(status_code=404, detail="Upload session not found")
+    return session
+
+
+def _save_headers(meta) -> dict:
+    """Headers describing a stored save; the save hash doubles as a strong ETag."""
+    return {
+        "ETag": f'"{meta.save_hash}"',
+        "X-Save-Timestamp": str(meta.client_timestamp),
+        "X-Save-Hash": meta.save_hash,
+        "X-Save-Size": str(meta.save_size),
+    }
+
+
+def _not_modified(request: Request, meta) -> Response | None:
+    """A 304 response if If-None-Match names the stored save, else None."""
+    header = request.headers.get("If-None-Match")
+    if not header:
+        return None
+    etag = f'"{meta.save_hash}"'
+    for tag in header.split(","):
+        tag = tag.strip()
+        if tag.startswith("W/"):
+            tag = tag[2:]
+        if tag == "*" or tag.lower() == etag:
+            return Response(status_code=304, headers=_save_headers(meta))
+    return None
+
+
 @router.get("/saves/{title_id}/meta")
-async def get_save_meta(title_id: str):
+async def get_save_meta(title_id: str, request: Request):
     title_id = _validate_title_id(title_id)
     meta = storage.get_metadata(title_id)
     if meta is None:
         raise HTTPException(status_code=404, detail="No save found for this title")
-    return meta.to_dict()
+    not_modified = _not_modified(request, meta)
+    if not_modified:
+        return not_modified
+    return JSONResponse(meta.to_dict(), headers=_save_headers(meta))
 
 
 @router.get("/saves/{title_id}/raw")
-async def download_save_raw(title_id: str):
+async def download_save_raw(title_id: str, request: Request):
     """Download raw save file (first file only) - for DS client compatibility."""
     title_id = _validate_title_id(title_id)
     meta = storage.get_metadata(title_id)
     if meta is None:
         raise HTTPException(status_code=404, detail="No save found for this title")
+    not_modified = _not_modified(request, meta)
+    if not_modified:
+        return not_modified
 
-    files = storage.load_save_files(title_id)
+    files = await workers.run(storage.load_save_files, title_id)
     if files is None or len(files) == 0:
         raise HTTPException(status_code=404, detail="Save data missing on disk")
 
@@ -46,26 +109,19 @@ async def download_save_raw(title_id: str):
         content=data,
         media_type="application/octet-stream",
         headers={
-            "X-Save-Timestamp": str(meta.client_timestamp),
-            "X-Save-Hash": meta.save_hash,
+            **_save_headers(meta),
             "X-Save-Size": str(len(data)),
             "X-Save-Path": path,
         },
     )
 
 
-@router.get("/saves/{title_id}")
-async def download_save(title_id: str):
-    title_id = _validate_title_id(title_id)
-    meta = storage.get_metadata(title_id)
-    if meta is None:
-        raise HTTPException(status_code=404, detail="No save found for this title")
-
+def _load_current_bundle(title_id: str, meta) -> SaveBundle:
+    """Build a bundle from the stored files of a title's current save."""
     files = storage.load_save_files(title_id)
     if files is None:
         raise HTTPException(status_code=404, detail="Save data missing on disk")
 
-    # Build a bundle from stored files
     bundle_files = []
     for path, data in files:
         bundle_files.append(
@@ -77,15 +133,42 @@ async def download_save(title_id: str):
             )
         )
 
-    bundle = SaveBundle(
+    return SaveBundle(
         title_id=int(title_id, 16),
         timestamp=meta.client_timestamp,
         files=bundle_files,
     )
 
-    bundle_data = create_bundle(bundle)
+
+@router.get("/saves/{title_id}/blocks")
+async def get_save_blocks(title_id: str):
+    """Per-block hashes of the current save, for delta uploads."""
+    title_id = _validate_title_id(title_id)
+    block_list = await workers.run(storage.get_block_list, title_id)
+    if block_list is None:
+        raise HTTPException(status_code=404, detail="No save found for this title")
+    return Response(content=encode_block_list(block_list), media_type="application/octet-stream")
+
+
+@router.get("/saves/{title_id}/delta")
+async def download_save_delta(title_id: str, base: str = Query(...)):
+    """Download only the blocks that changed since the client's version (base hash)."""
+    title_id = _validate_title_id(title_id)
+    meta = storage.get_metadata(title_id)
+    if meta is None:
+        raise HTTPException(status_code=404, detail="No save found for this title")
+
+    return await workers.run(_build_delta_response, title_id, meta, base)
+
+
+def _build_delta_response(title_id: str, meta, base: str) -> Response:
+    base_blocks = storage.get_block_list(title_id, base)
+    if base_blocks is None:
+        raise HTTPException(status_code=404, detail="Base version not known to server")
+
+    bundle = _load_current_bundle(title_id, meta)
     return Response(
-        content=bundle_data,
+        content=create_delta(bundle, base_blocks, settings.delta_block_size),
         media_type="application/octet-stream",
         headers={
             "X-Save-Timestamp": str(meta.client_timestamp),
@@ -95,6 +178,143 @@ async def download_save(title_id: str):
     )
 
 
+@router.post("/saves/{title_id}/delta")
+async def upload_save_delta(
+    title_id: str,
+    request: Request,
+    force: bool = Query(False),
+    source: str = Query("3ds"),
+):
+    """Upload only changed blocks against the server's current save."""
+    title_id = _validate_title_id(title_id)
+    console_id = request.headers.get("X-Console-ID", "")
+
+    body = await request.body()
+    return await workers.run(_store_delta, title_id, body, force, source, console_id)
+
+
+def _store_delta(
+    title_id: str, body: bytes, force: bool, source: str, console_id: str
+) -> dict:
+    try:
+        delta = parse_delta(body)
+    except DeltaError as e:
+        raise HTTPException(status_code=400, detail=f"Invalid delta: {e}")
+
+    if delta.title_id_hex != title_id:
+        raise HTTPException(
+            status_code=400,
+            detail=f"Title ID mismatch: URL={title_id}, delta={delta.title_id_hex}",
+        )
+
+    with storage.title_lock(title_id):
+        # The delta only makes sense against the version it was built from
+        meta = storage.get_metadata(title_id)
+        if meta is None or meta.save_hash != delta.base_hash:
+            raise HTTPException(
+                status_code=412,
+                detail="Delta base does not match the server's current save",
+            )
+
+        base_files = dict(storage.load_save_files(title_id) or [])
+        try:
+            bundle = apply_delta(delta, base_files)
+        except DeltaError as e:
+            raise HTTPException(status_code=400, detail=f"Invalid delta: {e}")
+
+        return _store_parsed_bundle(title_id, bundle, force, source, console_id)
+
+
+def _byte_range(
+    header: str | None, if_range: str | None, size: int, etag: str
+) -> tuple[int, int] | None:
+    """(start, end) of a single-range Range request, end exclusive.
+
+    None means send the whole file: no Range, an If-Range naming another
+    version, or a Range this endpoint doesn't serve (multiple ranges).
+    Raises 416 for a range that starts past the end.
+    """
+    if not header:
+        return None
+    if if_range and if_range.strip() != etag:
+        return None
+    m = _RANGE_RE.match(header.strip())
+    if not m or m.groups() == ("", ""):
+        return None
+    first, last = m.groups()
+    if first:
+        start = int(first)
+        if last and int(last) < start:
+            return None
+        end = min(int(last) + 1, size) if last else size
+    else:
+        start, end = max(size - int(last), 0), size
+    if start >= end:
+        raise HTTPException(
+            status_code=416,
+            detail="Requested range not satisfiable",
+            headers={"Content-Range": f"bytes */{size}"},
+        )
+    return start, end
+
+
+def _read_range(
+    path: Path, header: str | None, if_range: str | None, etag: str
+) -> tuple[tuple[int, int], int, bytes] | None:
+    """The requested byte range of a bundle file, or None for all of it."""
+    size = path.stat().st_size
+    byte_range = _byte_range(header, if_range, size, etag)
+    if byte_range is None:
+        return None
+    start, end = byte_range
+    with open(path, "rb") as f:
+        f.seek(start)
+        return byte_range, size, f.read(end - start)
+
+
+@router.get("/saves/{title_id}")
+async def download_save(
+    title_id: str, request: Request, format: int = Query(BUNDLE_VERSION_COMPRESSED)
+):
+    """Download the current save as a bundle.
+
+    format=3 asks for a v3 bundle, whose uncompressed file table locates
+    every file's own frame: with Range requests a client can fetch the
+    header and table, then just the files it wants.
+    """
+    title_id = _validate_title_id(title_id)
+    if format not in (BUNDLE_VERSION_COMPRESSED, BUNDLE_VERSION_CODECS):
+        raise HTTPException(status_code=400, detail=f"Unsupported bundle format: {format}")
+    meta = storage.get_metadata(title_id)
+    if meta is None:
+        raise HTTPException(status_code=404, detail="No save found for this title")
+    not_modified = _not_modified(request, meta)
+    if not_modified:
+        return not_modified
+
+    bundle_path = await workers.run(storage.get_bundle_path, title_id, format)
+    if bundle_path is None:
+        raise HTTPException(status_code=404, detail="Save data missing on disk")
+    headers = {**_save_headers(meta), "Accept-Ranges": "bytes"}
+
+    part = await workers.run(
+        _read_range,
+        bundle_path,
+        request.headers.get("Range"),
+        request.headers.get("If-Range"),
+        headers["ETag"],
+    )
+    if part is not None:
+        (start, end), size, data = part
+        return Response(
+            content=data,
+            status_code=206,
+            media_type="application/octet-stream",
+            headers={**headers, "Content-Range": f"bytes {start}-{end - 1}/{size}"},
+        )
+    return FileResponse(bundle_path, media_type="application/octet-stream", headers=headers)
+
+
 @router.post("/saves/{title_id}")
 async def upload_save(
     title_id: str,
@@ -111,22 +331,54 @@ async def upload_save(
     if not body:
         raise HTTPException(status_code=400, detail="Empty request body")
 
-    try:
-        bundle = parse_bundle(body)
-    except BundleError as e:
-        raise HTTPException(status_code=400, detail=f"Invalid bundle: {e}")
+    return await workers.run(_store_bundle, title_id, [body], force, source, console_id)
 
+
+def _store_bundle(
+    title_id: str, chunks: Iterable[bytes], force: bool, source: str, console_id: str
+) -> dict:
+    """Parse an uploaded bundle straight into storage (single and chunked uploads).
+
+    The title and conflict checks run as soon as the header is in, before
+    any file data is decoded.
+    """
+    with storage.title_lock(title_id):
+        writer = storage.SaveWriter(title_id)
+        parser = BundleParser(
+            sink=writer,
+            on_header=lambda p: _check_upload(title_id, p.title_id_hex, p.timestamp, force),
+        )
+        try:
+            for chunk in chunks:
+                parser.feed(chunk)
+            bundle = parser.close()
+        except BundleError as e:
+            writer.abort()
+            raise HTTPException(status_code=400, detail=f"Invalid bundle: {e}")
+        except BaseException:
+            writer.abort()
+            raise
+
+        meta = writer.commit(bundle, parser.save_hash, source=source, console_id=console_id)
+    return _stored(meta)
+
+
+def _check_upload(title_id: str, bundle_title_id: str, timestamp: int, force: bool) -> None:
+    """Reject a bundle for another title, or one older than the stored save.
+
+    Caller holds the title lock.
+    """
     # Verify title ID in URL matches bundle
-    if bundle.title_id_hex != title_id:
+    if bundle_title_id != title_id:
         raise HTTPException(
             status_code=400,
-            detail=f"Title ID mismatch: URL={title_id}, bundle={bundle.title_id_hex}",
+            detail=f"Title ID mismatch: URL={title_id}, bundle={bundle_title_id}",
         )
 
     # Conflict check
     if not force:
         existing = storage.get_metadata(title_id)
-        if existing and existing.client_timestamp >= bundle.timestamp:
+        if existing and existing.client_timestamp >= timestamp:
             raise HTTPException(
                 status_code=409,
                 detail="Server has a newer or equal save. Use ?force=true to override.",
@@ -136,7 +388,17 @@ async def upload_save(
                 },
             )
 
-    meta = storage.store_save(bundle, source=source, console_id=console_id)
+
+def _store_parsed_bundle(
+    title_id: str, bundle: SaveBundle, force: bool, source: str, console_id: str
+) -> dict:
+    with storage.title_lock(title_id):
+        _check_upload(title_id, bundle.title_id_hex, bundle.timestamp, force)
+        meta = storage.store_save(bundle, source=source, console_id=console_id)
+    return _stored(meta)
+
+
+def _stored(meta) -> dict:
     return {
         "status": "ok",
         "timestamp": meta.last_sync,
@@ -144,6 +406,89 @@ async def upload_save(
     }
 
 
+@router.post("/saves/{title_id}/upload")
+async def start_upload(title_id: str, req: UploadStartRequest):
+    """Start a chunked upload for bundles too large for a single request."""
+    title_id = _validate_title_id(title_id)
+    try:
+        session = await workers.run(uploads.create_session, title_id, req.size)
+    except UploadError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+    return {
+        "upload_id": session["upload_id"],
+        "part_size": session["part_size"],
+        "parts": session["parts"],
+    }
+
+
+@router.get("/saves/{title_id}/upload/{upload_id}")
+async def get_upload_status(title_id: str, upload_id: str):
+    """Report which parts have arrived, so an interrupted upload can resume."""
+    title_id = _validate_title_id(title_id)
+    session = _get_upload_session(title_id, upload_id)
+    return {
+        "upload_id": upload_id,
+        "size": session["size"],
+        "part_size": session["part_size"],
+        "parts": session["parts"],
+        "received": uploads.received_parts(session),
+    }
+
+
+@router.post("/saves/{title_id}/upload/{upload_id}/commit")
+async def commit_upload(
+    title_id: str,
+    upload_id: str,
+    request: Request,
+    force: bool = Query(False),
+    source: str = Query("3ds"),
+):
+    """Assemble all parts and store the bundle."""
+    title_id = _validate_title_id(title_id)
+    session = _get_upload_session(title_id, upload_id)
+    console_id = request.headers.get("X-Console-ID", "")
+    return await workers.run(
+        _commit_upload, title_id, session, upload_id, force, source, console_id
+    )
+
+
+def _commit_upload(
+    title_id: str, session: dict, upload_id: str, force: bool, source: str, console_id: str
+) -> dict:
+    try:
+        uploads.check_complete(session)
+    except UploadError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+
+    # Parts are parsed one by one rather than joined into one buffer.
+    # Keep the session on a 409 so the client can retry with force.
+    result = _store_bundle(title_id, uploads.iter_parts(session), force, source, console_id)
+    uploads.delete_session(upload_id)
+    return result
+
+
+@router.post("/saves/{title_id}/upload/{upload_id}/{index}")
+async def upload_part(title_id: str, upload_id: str, index: int, request: Request):
+    """Store one part of a chunked upload. Safe to retry."""
+    title_id = _validate_title_id(title_id)
+    session = _get_upload_session(title_id, upload_id)
+
+    body = await request.body()
+    try:
+        await workers.run(uploads.store_part, session, index, body)
+    except UploadError as e:
+        raise HTTPException(status_code=400, detail=str(e))
+    return {"status": "ok", "part": index}
+
+
+@router.delete("/saves/{title_id}/upload/{upload_id}")
+async def abort_upload(title_id: str, upload_id: str):
+    title_id = _validate_title_id(title_id)
+    _get_upload_session(title_id, upload_id)
+    await workers.run(uploads.delete_session, upload_id)
+    return {"status": "ok"}
+
+
 @router.post("/saves/{title_id}/raw")
 async def upload_save_raw(
     title_id: str,
@@ -160,40 +505,81 @@ async def upload_save_raw(
     if not body:
         raise HTTPException(status_code=400, detail="Empty request body")
     
+    return await workers.run(_store_raw, title_id, body, force, console_id)
+
+
+def _store_raw(title_id: str, body: bytes, force: bool, console_id: str) -> dict:
     # Wrap raw save data into a bundle with a single file
     # Use standard save.bin filename for compatibility
-    import time
     timestamp = int(time.time())
-    
+
     bundle_file = BundleFile(
         path="save.bin",
         size=len(body),
         sha256=hashlib.sha256(body).digest(),
         data=body,
     )
-    
+
     bundle = SaveBundle(
         title_id=int(title_id, 16),
         timestamp=timestamp,
         files=[bundle_file],
     )
-    
-    # Conflict check
-    if not force:
-        existing = storage.get_metadata(title_id)
-        if existing and existing.client_timestamp >= timestamp:
-            raise HTTPException(
-                status_code=409,
-                detail="Server has a newer or equal save. Use ?force=true to override.",
-                headers={
-                    "X-Server-Timestamp": str(existing.client_timestamp),
-                    "X-Server-Hash": existing.save_hash,
-                },
-            )
-    
-    meta = storage.store_save(bundle, source="nds", console_id=console_id)
-    return {
-        "status": "ok",
-        "timestamp": meta.last_sync,
-        "sha256": meta.save_hash,
-    }
+
+    return _store_parsed_bundle(title_id, bundle, force, "nds", console_id)
+
+
+def _validate_version(version: str) -> str:
+    if not _VERSION_RE.match(version):
+        raise HTTPException(status_code=400, detail="Invalid history version")
+    return version
+
+
+@router.get("/saves/{title_id}/history")
+async def list_save_history(title_id: str):
+    """Previous versions of a save, newest first."""
+    title_id = _validate_title_id(title_id)
+    if not storage.title_exists(title_id):
+        raise HTTPException(status_code=404, detail="No save found for this title")
+    return {"versions": await workers.run(storage.list_history, title_id)}
+
+
+@router.get("/saves/{title_id}/history/{version}")
+async def download_save_history(title_id: str, version: str):
+    """Download a previous version as a bundle, rebuilt from its deltas."""
+    title_id = _validate_title_id(title_id)
+    version = _validate_version(version)
+    return await workers.run(_build_history_bundle, title_id, version)
+
+
+def _build_history_bundle(title_id: str, version: str) -> Response:
+    files = storage.load_history_files(title_id, version)
+    if files is None:
+        raise HTTPException(status_code=404, detail="History version not found")
+
+    bundle = SaveBundle(
+        title_id=int(title_id, 16),
+        timestamp=int(time.time()),
+        files=[
+            BundleFile(path=p, size=len(d), sha256=hashlib.sha256(d).digest(), data=d)
+            for p, d in files
+        ],
+    )
+    return Response(
+        content=create_bundle(bundle, compress=True),
+        media_type="application/octet-stream",
+        headers={"X-Save-Size": str(sum(len(d) for _, d in files))},
+    )
+
+
+@router.post("/saves/{title_id}/history/{version}/restore")
+async def restore_save_history(title_id: str, version: str, request: Request):
+    """Make a previous version the current save; consoles pick it up on their next sync."""
+    title_id = _validate_title_id(title_id)
+    version = _validate_version(version)
+    console_id = request.headers.get("X-Console-ID", "")
+
+    meta = await workers.run(storage.restore_history, title_id, version, console_id)
+    if meta is None:
+        raise HTTPException(status_code=404, detail="History version not found")
+    return _stored(meta)
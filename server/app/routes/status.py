@@ -1,6 +1,6 @@
 from fastapi import APIRouter
 
-from app.services import storage
+from app.services import game_names, metrics, storage
 
 router = APIRouter()
 
@@ -12,4 +12,6 @@ async def get_status():
         "status": "ok",
         "version": "1.0.0",
         "save_count": len(titles),
+        "event_loop_lag": metrics.loop_lag_stats(),
+        "names_version": game_names.database_version(),
     }
@@ -1,7 +1,11 @@
-from fastapi import APIRouter
+from fastapi import APIRouter, HTTPException, Query, Request, Response
+from fastapi.exceptions import RequestValidationError
+from pydantic import ValidationError
 
 from app.models.save import ConflictInfo, SyncPlan, SyncRequest
 from app.services import storage
+from app.services.changes_binary import encode_changes
+from app.services.sync_binary import SyncBinaryError, encode_sync_plan, parse_sync_request
 
 router = APIRouter()
 
@@ -32,9 +36,52 @@ def _add_conflict(
     )
 
 
-@router.post("/sync")
-async def sync(request: SyncRequest) -> SyncPlan:
-    """Compare 3DS title metadata against server state and return a sync plan."""
+@router.post("/sync", response_model=SyncPlan)
+async def sync(request: Request):
+    """Compare client title metadata against server state and return a sync plan.
+
+    Accepts the JSON request, or the binary format from services/sync_binary
+    (Content-Type: application/octet-stream), which is answered in kind.
+    """
+    body = await request.body()
+    content_type = request.headers.get("content-type", "")
+
+    if content_type.startswith("application/octet-stream"):
+        try:
+            sync_request = parse_sync_request(body)
+        except (SyncBinaryError, ValidationError) as e:
+            raise HTTPException(status_code=400, detail=f"Invalid sync request: {e}")
+        return Response(
+            content=encode_sync_plan(_build_plan(sync_request)),
+            media_type="application/octet-stream",
+        )
+
+    try:
+        sync_request = SyncRequest.model_validate_json(body)
+    except ValidationError as e:
+        raise RequestValidationError(e.errors())
+    return _build_plan(sync_request)
+
+
+@router.get("/changes")
+async def changes(since: int | None = Query(None, ge=0), format: str = Query("json")):
+    """Titles whose save changed after a cursor from an earlier call.
+
+    Without since, only the current cursor is returned. A client that saved
+    the cursor before its last sync can ask for what changed since then;
+    if none of its own titles did, it can skip the full /sync comparison.
+
+    Answered as {"cursor": N, "reset": false, "changes": [{"title_id",
+    "save_hash", "change_seq"}, ...]}, or in the binary format from
+    services/changes_binary with format=binary.
+    """
+    cursor, changed, reset = storage.changes_since(since)
+    if format == "binary":
+        return Response(content=encode_changes(cursor, changed, reset), media_type="application/octet-stream")
+    return {"cursor": cursor, "reset": reset, "changes": changed}
+
+
+def _build_plan(request: SyncRequest) -> SyncPlan:
     upload: list[str] = []
     download: list[str] = []
     conflict: list[str] = []
@@ -87,8 +134,7 @@ async def sync(request: SyncRequest) -> SyncPlan:
 
     # Find titles that exist only on the server
     server_only: list[str] = []
-    for meta in storage.list_titles():
-        tid = meta["title_id"]
+    for tid in storage.list_title_ids():
         if tid not in client_title_ids:
             server_only.append(tid)
 
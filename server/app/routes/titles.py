@@ -1,7 +1,10 @@
-from fastapi import APIRouter
-from pydantic import BaseModel
+from fastapi import APIRouter, HTTPException, Request, Response
+from fastapi.exceptions import RequestValidationError
+from pydantic import BaseModel, ValidationError
 
+from app.models.save import MetadataRequest
 from app.services import storage, game_names
+from app.services.meta_binary import MetaBinaryError, encode_meta_response, parse_meta_request
 
 router = APIRouter()
 
@@ -16,6 +19,40 @@ async def list_titles():
     return {"titles": titles}
 
 
+@router.post("/titles/meta")
+async def lookup_metadata(request: Request):
+    """Metadata of several titles' saves in one request.
+
+    JSON: {"title_ids": ["0004000000055D00", ...]} is answered with
+    {"saves": {"0004000000055D00": {...same as /saves/{id}/meta...}},
+     "missing": [IDs without a save]}.
+
+    Also accepts the binary format from services/meta_binary
+    (Content-Type: application/octet-stream), which is answered in kind.
+    """
+    body = await request.body()
+    content_type = request.headers.get("content-type", "")
+
+    if content_type.startswith("application/octet-stream"):
+        try:
+            title_ids = parse_meta_request(body)
+        except MetaBinaryError as e:
+            raise HTTPException(status_code=400, detail=f"Invalid metadata request: {e}")
+        return Response(
+            content=encode_meta_response(storage.get_metadata_many(title_ids)),
+            media_type="application/octet-stream",
+        )
+
+    try:
+        title_ids = MetadataRequest.model_validate_json(body).title_ids
+    except ValidationError as e:
+        raise RequestValidationError(e.errors())
+    metas = storage.get_metadata_many(title_ids)
+    found = {meta.title_id: meta.to_dict() for meta in metas}
+    missing = list(dict.fromkeys(t for t in title_ids if t not in found))
+    return {"saves": found, "missing": missing}
+
+
 @router.post("/titles/names")
 async def lookup_game_names(request: NameLookupRequest):
     """Look up game names for product codes.
@@ -24,7 +61,11 @@ async def lookup_game_names(request: NameLookupRequest):
     - Full: CTR-P-BRBE
     - Short: BRBE (4-char code)
 
-    Returns: {"names": {"CTR-P-BRBE": "Resident Evil Revelations", ...}}
+    Returns: {"names": {"CTR-P-BRBE": "Resident Evil Revelations", ...},
+              "db_version": "<hash>"}
+
+    Clients cache names (and misses) under db_version and only ask again
+    for codes they haven't seen, or when the version changes.
     """
     names = game_names.lookup_names(request.codes)
-    return {"names": names}
+    return {"names": names, "db_version": game_names.database_version()}
@@ -1,7 +1,9 @@
 """Update checking endpoint - proxies GitHub releases for 3DS/NDS clients."""
 
-from fastapi import APIRouter
+from fastapi import APIRouter, HTTPException
+from fastapi.responses import Response, StreamingResponse
 from pydantic import BaseModel
+from starlette.background import BackgroundTask
 import httpx
 
 router = APIRouter()
@@ -85,24 +87,48 @@ async def check_update(current: str = "0.0.0", platform: str = "3ds") -> UpdateI
 async def proxy_download(url: str):
     """Proxy download from GitHub (3DS/NDS can't do HTTPS with GitHub).
 
-    Downloads the full file then returns it with Content-Length,
-    which is required by the DS client's HTTP/1.0 implementation.
-    Homebrew binaries are small (a few MB) so this is fine.
+    The body is passed through as it arrives, so the 3DS can install the
+    CIA while it downloads. GitHub's Content-Length is forwarded, which the
+    DS client's HTTP/1.0 implementation requires; on the rare response
+    without one, the file is buffered to measure it.
     """
-    from fastapi.responses import Response
-
     filename = url.rsplit("/", 1)[-1] if "/" in url else "update"
+    headers = {"Content-Disposition": f"attachment; filename={filename}"}
 
-    async with httpx.AsyncClient() as client:
-        resp = await client.get(url, follow_redirects=True, timeout=300.0)
-
-    return Response(
-        content=resp.content,
+    client = httpx.AsyncClient(follow_redirects=True, timeout=300.0)
+    try:
+        # identity, so the forwarded length matches the bytes sent on
+        request = client.build_request("GET", url, headers={"Accept-Encoding": "identity"})
+        resp = await client.send(request, stream=True)
+    except httpx.HTTPError:
+        await client.aclose()
+        raise HTTPException(status_code=502, detail="Update download failed")
+
+    async def close():
+        await resp.aclose()
+        await client.aclose()
+
+    if resp.status_code != 200:
+        await close()
+        raise HTTPException(status_code=502, detail=f"Update download failed (HTTP {resp.status_code})")
+
+    length = resp.headers.get("Content-Length")
+    if length is None or "Content-Encoding" in resp.headers:
+        try:
+            content = await resp.aread()
+        finally:
+            await close()
+        return Response(
+            content=content,
+            media_type="application/octet-stream",
+            headers={**headers, "Content-Length": str(len(content))},
+        )
+
+    return StreamingResponse(
+        resp.aiter_raw(),
         media_type="application/octet-stream",
-        headers={
-            "Content-Disposition": f"attachment; filename={filename}",
-            "Content-Length": str(len(resp.content)),
-        },
+        headers={**headers, "Content-Length": length},
+        background=BackgroundTask(close),
     )
 
 
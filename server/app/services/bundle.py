@@ -24,6 +24,27 @@ Bundle format v2 (compressed):
   [4B]  Uncompressed payload size (uint32 LE)
   -- Zlib compressed payload: --
     File table + file data (same format as v1 payload)
+
+Bundle format v3 (per-file codecs):
+  [4B]  Magic: "3DSS"
+  [4B]  Version: 3 (uint32 LE)
+  [8B]  Title ID (uint64 BE)
+  [4B]  Timestamp - unix epoch (uint32 LE)
+  [4B]  File count (uint32 LE)
+  [4B]  Decoded payload size: the same save as a v1 payload (uint32 LE)
+  -- File table (for each file, uncompressed): --
+    [2B]  Path length (uint16 LE)
+    [NB]  Path (UTF-8)
+    [4B]  File size (uint32 LE)
+    [32B] SHA-256 hash
+    [1B]  Codec: 0 = stored, 1 = zlib
+    [4B]  Encoded size (uint32 LE)
+  -- File data (for each file, same order): --
+    [NB]  Stored bytes, or one zlib stream per file
+
+Writers pick each file's codec with the same entropy probe
+(_choose_codec), so the client, this module and tools/ds_sync.py produce
+identical v3 bundles for the same save and level.
 """
 
 from __future__ import annotations
@@ -31,10 +52,13 @@ from __future__ import annotations
 import hashlib
 import struct
 import zlib
+from collections import Counter
+from collections.abc import Callable
 
 from app.models.save import (
     BUNDLE_MAGIC,
     BUNDLE_VERSION,
+    BUNDLE_VERSION_CODECS,
     BUNDLE_VERSION_COMPRESSED,
     BundleFile,
     SaveBundle,
@@ -45,107 +69,429 @@ class BundleError(Exception):
     pass
 
 
-def _parse_payload(data: bytes, file_count: int) -> list[BundleFile]:
-    """Parse the file table and file data from payload bytes."""
-    offset = 0
-    files: list[BundleFile] = []
+# Hard cap on a decoded payload; the header's declared size is checked
+# against it before anything is inflated.
+MAX_PAYLOAD_SIZE = 128 * 1024 * 1024
 
-    # File table
-    for _ in range(file_count):
-        if offset + 2 > len(data):
-            raise BundleError("Truncated file table")
+# Most output produced by a single inflate step
+_INFLATE_CHUNK = 256 * 1024
 
-        (path_len,) = struct.unpack_from("<H", data, offset)
-        offset += 2
+_HEADER_SIZE = 28
 
-        if offset + path_len > len(data):
-            raise BundleError("Truncated file path")
-        path = data[offset : offset + path_len].decode("utf-8")
-        offset += path_len
+# v3 codecs, and the zlib levels a v3 writer uses
+CODEC_STORED = 0
+CODEC_ZLIB = 1
+LEVEL_FAST = 1
+LEVEL_HIGH = 9
 
-        if offset + 4 > len(data):
-            raise BundleError("Truncated file size")
-        (file_size,) = struct.unpack_from("<I", data, offset)
-        offset += 4
+# Smallest v1 file table entry (empty path); bounds a v3 file count
+_MIN_ENTRY_SIZE = 2 + 4 + 32
 
-        if offset + 32 > len(data):
-            raise BundleError("Truncated file hash")
-        sha256 = data[offset : offset + 32]
-        offset += 32
+# Entropy probe samples, as in client/source/bundle.c
+_PROBE_WINDOW = 1024
+_PROBE_MIN_SIZE = 32
 
-        files.append(BundleFile(path=path, size=file_size, sha256=sha256))
 
-    # File data
-    for f in files:
-        if offset + f.size > len(data):
-            raise BundleError(f"Truncated file data for {f.path}")
-        f.data = data[offset : offset + f.size]
-        offset += f.size
-
-        # Verify hash
-        actual_hash = hashlib.sha256(f.data).digest()
-        if actual_hash != f.sha256:
-            raise BundleError(
-                f"Hash mismatch for {f.path}: "
-                f"expected {f.sha256.hex()}, got {actual_hash.hex()}"
-            )
+class BundleSink:
+    """Receives file contents from BundleParser as they are decoded.
 
-    return files
+    write() gets memoryview slices that are only valid during the call;
+    copy them if they need to outlive it.
+    """
 
+    def begin_file(self, f: BundleFile) -> None:
+        pass
 
-def parse_bundle(data: bytes) -> SaveBundle:
-    """Parse a binary save bundle into a SaveBundle object.
+    def write(self, data: memoryview) -> None:
+        pass
 
-    Supports both v1 (uncompressed) and v2 (zlib compressed) formats.
-    """
-    if len(data) < 28:
-        raise BundleError("Bundle too small for header")
+    def end_file(self, f: BundleFile) -> None:
+        pass
 
-    offset = 0
 
-    # Header
-    magic = data[offset : offset + 4]
-    if magic != BUNDLE_MAGIC:
-        raise BundleError(f"Invalid magic: {magic!r}")
-    offset += 4
+class _MemorySink(BundleSink):
+    """Collects file data into BundleFile.data (what parse_bundle returns)."""
+
+    def __init__(self) -> None:
+        self._buf = bytearray()
+
+    def begin_file(self, f: BundleFile) -> None:
+        self._buf = bytearray()
+
+    def write(self, data: memoryview) -> None:
+        self._buf += data
 
-    (version,) = struct.unpack_from("<I", data, offset)
-    if version not in (BUNDLE_VERSION, BUNDLE_VERSION_COMPRESSED):
-        raise BundleError(f"Unsupported version: {version}")
-    offset += 4
+    def end_file(self, f: BundleFile) -> None:
+        f.data = bytes(self._buf)
+        self._buf = bytearray()
 
-    (title_id,) = struct.unpack_from(">Q", data, offset)
-    offset += 8
 
-    (timestamp,) = struct.unpack_from("<I", data, offset)
-    offset += 4
+class BundleParser:
+    """Incremental bundle parser.
 
-    (file_count,) = struct.unpack_from("<I", data, offset)
-    offset += 4
+    feed() the body in pieces of any size, then close() for the SaveBundle.
+    on_header, if given, runs once the header is parsed and before any
+    payload is decoded; raise from it to reject the bundle early.
+    A v2 payload (or v3 file) is inflated step by step and never past the
+    size declared for it, only the file table is buffered, and file data
+    goes to the sink as it is decoded, hashed on the way. Peak memory is
+    one inflate step plus whatever the sink keeps.
+    """
 
-    (size_field,) = struct.unpack_from("<I", data, offset)
-    offset += 4
+    def __init__(
+        self,
+        sink: BundleSink | None = None,
+        on_header: Callable[[BundleParser], None] | None = None,
+        max_payload: int = MAX_PAYLOAD_SIZE,
+    ):
+        self._sink = sink if sink is not None else _MemorySink()
+        self._on_header = on_header
+        self._max_payload = max_payload
+        self._header = bytearray()
+        self._inflater = None
+        self._payload_len = 0
+        self._table = bytearray()
+        self._table_pos = 0
+        self._pending: list[BundleFile] = []
+        self._files: list[BundleFile] | None = None
+        self._file_index = 0
+        self._file_remaining = 0
+        self._file_hash = None
+        self._save_hash = hashlib.sha256()
+        self._done = False
+        # v3: (codec, encoded size) per file, and the file being decoded
+        self._codec_table: list[tuple[int, int]] = []
+        self._codecs: list[tuple[int, int]] | None = None
+        self._codec_index = 0
+        self._encoded_left = 0
+        self._file_inflater = None
+
+        self.title_id = 0
+        self.timestamp = 0
+        self.version = 0
+        self.file_count = 0
+        self.payload_size = 0
+
+    @property
+    def header_ready(self) -> bool:
+        return len(self._header) == _HEADER_SIZE
+
+    @property
+    def title_id_hex(self) -> str:
+        return f"{self.title_id:016X}"
+
+    @property
+    def save_hash(self) -> str:
+        """SHA-256 of all file data in bundle order (valid after close)."""
+        return self._save_hash.hexdigest()
+
+    def feed(self, data: bytes | bytearray | memoryview) -> None:
+        view = memoryview(data).cast("B")
+        if not self.header_ready:
+            need = _HEADER_SIZE - len(self._header)
+            self._header += view[:need]
+            view = view[need:]
+            if not self.header_ready:
+                return
+            self._parse_header()
+
+        if self.version == BUNDLE_VERSION_CODECS:
+            if not self._done:
+                self._consume_codecs(view)
+            return
+
+        if self._inflater is None:
+            if not self._done:
+                self._consume(view)
+            return
 
-    # Get payload (compressed or not)
-    if version == BUNDLE_VERSION_COMPRESSED:
-        # v2: decompress payload
-        compressed_payload = data[offset:]
         try:
-            payload = zlib.decompress(compressed_payload)
+            while view and not self._inflater.eof:
+                limit = min(_INFLATE_CHUNK, self.payload_size - self._payload_len + 1)
+                out = self._inflater.decompress(view, limit)
+                view = memoryview(self._inflater.unconsumed_tail)
+                self._consume(memoryview(out))
         except zlib.error as e:
             raise BundleError(f"Decompression failed: {e}")
 
-        if len(payload) != size_field:
+    def close(self) -> SaveBundle:
+        if not self.header_ready:
+            raise BundleError("Bundle too small for header")
+
+        if self._inflater is not None:
+            try:
+                self._consume(memoryview(self._inflater.flush()))
+            except zlib.error as e:
+                raise BundleError(f"Decompression failed: {e}")
+            if not self._inflater.eof:
+                raise BundleError("Decompression failed: incomplete or truncated stream")
+            if self._payload_len != self.payload_size:
+                raise BundleError(
+                    f"Decompressed size mismatch: expected {self.payload_size}, "
+                    f"got {self._payload_len}"
+                )
+
+        if self.version == BUNDLE_VERSION_CODECS:
+            if self._codecs is None:
+                self._table_truncated(codecs=True)
+            if self._codec_index < len(self._files):
+                raise BundleError(
+                    f"Truncated file data for {self._files[self._codec_index].path}"
+                )
+
+        if self._files is None and not self._parse_table():
+            self._table_truncated()
+        if self._file_index < len(self._files):
+            raise BundleError(f"Truncated file data for {self._files[self._file_index].path}")
+
+        return SaveBundle(title_id=self.title_id, timestamp=self.timestamp, files=self._files)
+
+    def _parse_header(self) -> None:
+        magic = bytes(self._header[0:4])
+        if magic != BUNDLE_MAGIC:
+            raise BundleError(f"Invalid magic: {magic!r}")
+
+        (self.version,) = struct.unpack_from("<I", self._header, 4)
+        if self.version not in (BUNDLE_VERSION, BUNDLE_VERSION_COMPRESSED, BUNDLE_VERSION_CODECS):
+            raise BundleError(f"Unsupported version: {self.version}")
+
+        (self.title_id,) = struct.unpack_from(">Q", self._header, 8)
+        self.timestamp, self.file_count, self.payload_size = struct.unpack_from(
+            "<III", self._header, 16
+        )
+        if self.payload_size > self._max_payload:
             raise BundleError(
-                f"Decompressed size mismatch: expected {size_field}, got {len(payload)}"
+                f"Payload too large: {self.payload_size} > {self._max_payload}"
             )
-    else:
-        # v1: payload is uncompressed
-        payload = data[offset:]
 
-    files = _parse_payload(payload, file_count)
+        if (
+            self.version == BUNDLE_VERSION_CODECS
+            and self.file_count > self.payload_size // _MIN_ENTRY_SIZE
+        ):
+            raise BundleError(f"File count too large: {self.file_count}")
+
+        if self.version == BUNDLE_VERSION_COMPRESSED:
+            self._inflater = zlib.decompressobj()
+        if self._on_header is not None:
+            self._on_header(self)
+
+    def _consume(self, data: memoryview) -> None:
+        """Take decoded payload bytes: file table first, then file data."""
+        if not data:
+            return
+        self._payload_len += len(data)
+        if self._payload_len > self._max_payload or (
+            self._inflater is not None and self._payload_len > self.payload_size
+        ):
+            raise BundleError(
+                f"Decompressed size mismatch: payload exceeds {self.payload_size} bytes"
+            )
 
-    return SaveBundle(title_id=title_id, timestamp=timestamp, files=files)
+        if self._files is None:
+            self._table += data
+            if not self._parse_table():
+                return
+            data = memoryview(bytes(self._table[self._table_pos :]))
+            self._table = bytearray()
+
+        self._write_files(data)
+
+    def _parse_table(self, codecs: list[tuple[int, int]] | None = None) -> bool:
+        """Parse buffered file table entries. True once the table is complete.
+
+        With codecs (v3), each entry's codec and encoded size go there.
+        """
+        files = self._pending
+        buf = self._table
+        pos = self._table_pos
+        extra = 5 if codecs is not None else 0
+        while len(files) < self.file_count:
+            if pos + 2 > len(buf):
+                break
+            (path_len,) = struct.unpack_from("<H", buf, pos)
+            end = pos + 2 + path_len + 4 + 32
+            if end + extra > len(buf):
+                break
+            try:
+                path = buf[pos + 2 : pos + 2 + path_len].decode("utf-8")
+            except UnicodeDecodeError:
+                raise BundleError("Invalid file path encoding")
+            (size,) = struct.unpack_from("<I", buf, pos + 2 + path_len)
+            sha256 = bytes(buf[end - 32 : end])
+            files.append(BundleFile(path=path, size=size, sha256=sha256))
+            if codecs is not None:
+                codec, encoded = struct.unpack_from("<BI", buf, end)
+                self._check_codec(path, size, codec, encoded)
+                codecs.append((codec, encoded))
+                # Entries and data count against the declared v1 payload
+                self._payload_len += end - pos + size
+                if self._payload_len > self.payload_size:
+                    raise BundleError(
+                        f"Decoded size mismatch: payload exceeds {self.payload_size} bytes"
+                    )
+            pos = end + extra
+        self._table_pos = pos
+
+        if len(files) < self.file_count:
+            return False
+        self._files = files
+        self._start_file()
+        return True
+
+    def _table_truncated(self, codecs: bool = False) -> None:
+        buf, pos = self._table, self._table_pos
+        if pos + 2 > len(buf):
+            raise BundleError("Truncated file table")
+        (path_len,) = struct.unpack_from("<H", buf, pos)
+        pos += 2
+        if pos + path_len > len(buf):
+            raise BundleError("Truncated file path")
+        pos += path_len
+        if pos + 4 > len(buf):
+            raise BundleError("Truncated file size")
+        if not codecs or pos + 4 + 32 > len(buf):
+            raise BundleError("Truncated file hash")
+        raise BundleError("Truncated file codec")
+
+    @staticmethod
+    def _check_codec(path: str, size: int, codec: int, encoded: int) -> None:
+        if codec == CODEC_STORED:
+            if encoded != size:
+                raise BundleError(f"Stored size mismatch for {path}: {encoded} != {size}")
+        elif codec == CODEC_ZLIB:
+            if (size == 0) != (encoded == 0):
+                raise BundleError(f"Invalid encoded size for {path}: {encoded}")
+        else:
+            raise BundleError(f"Unknown codec {codec} for {path}")
+
+    def _consume_codecs(self, data: memoryview) -> None:
+        """v3: the uncompressed file table, then each file's encoded data."""
+        if self._codecs is None:
+            self._table += data
+            if not self._parse_table(self._codec_table):
+                return
+            if self._payload_len != self.payload_size:
+                raise BundleError(
+                    f"Decoded size mismatch: expected {self.payload_size}, "
+                    f"got {self._payload_len}"
+                )
+            self._codecs = self._codec_table
+            data = memoryview(bytes(self._table[self._table_pos :]))
+            self._table = bytearray()
+            self._open_encoded()
+
+        try:
+            while self._codec_index < len(self._codecs):
+                if self._encoded_left == 0:
+                    self._close_encoded()
+                    continue
+                if not data:
+                    return
+                part = data[: self._encoded_left]
+                data = data[len(part) :]
+                self._encoded_left -= len(part)
+                if self._file_inflater is None:
+                    self._write_files(part)
+                    continue
+                while part:
+                    if self._file_inflater.eof:
+                        raise BundleError(
+                            f"Encoded size mismatch for {self._files[self._codec_index].path}"
+                        )
+                    remaining = self._decoded_left()
+                    out = self._file_inflater.decompress(part, min(_INFLATE_CHUNK, remaining + 1))
+                    if len(out) > remaining:
+                        raise BundleError(
+                            f"Decoded size mismatch for {self._files[self._codec_index].path}"
+                        )
+                    part = memoryview(self._file_inflater.unconsumed_tail)
+                    self._write_files(memoryview(out))
+        except zlib.error as e:
+            raise BundleError(f"Decompression failed: {e}")
+        # Anything after the last file is ignored, as for v1
+        self._done = True
+
+    def _decoded_left(self) -> int:
+        """Bytes still due from the v3 file being decoded."""
+        if self._file_index != self._codec_index:
+            return 0
+        return self._file_remaining
+
+    def _open_encoded(self) -> None:
+        if self._codec_index >= len(self._codecs):
+            return
+        codec, self._encoded_left = self._codecs[self._codec_index]
+        self._file_inflater = (
+            zlib.decompressobj() if codec == CODEC_ZLIB and self._encoded_left else None
+        )
+
+    def _close_encoded(self) -> None:
+        """All of a v3 file's encoded bytes are in: it must have decoded exactly."""
+        inflater = self._file_inflater
+        if inflater is not None:
+            out = inflater.flush()
+            if len(out) > self._decoded_left():
+                raise BundleError(
+                    f"Decoded size mismatch for {self._files[self._codec_index].path}"
+                )
+            self._write_files(memoryview(out))
+            if not inflater.eof or inflater.unused_data:
+                raise BundleError(
+                    f"Encoded size mismatch for {self._files[self._codec_index].path}"
+                )
+        if self._file_index <= self._codec_index:
+            raise BundleError(
+                f"Decoded size mismatch for {self._files[self._codec_index].path}"
+            )
+        self._codec_index += 1
+        self._open_encoded()
+
+    def _start_file(self) -> None:
+        """Move to the next file with data, finishing empty files on the way."""
+        while self._file_index < len(self._files):
+            f = self._files[self._file_index]
+            self._sink.begin_file(f)
+            self._file_hash = hashlib.sha256()
+            self._file_remaining = f.size
+            if f.size:
+                return
+            self._end_file(f)
+        self._done = True
+
+    def _end_file(self, f: BundleFile) -> None:
+        actual_hash = self._file_hash.digest()
+        if actual_hash != f.sha256:
+            raise BundleError(
+                f"Hash mismatch for {f.path}: "
+                f"expected {f.sha256.hex()}, got {actual_hash.hex()}"
+            )
+        self._sink.end_file(f)
+        self._file_index += 1
+
+    def _write_files(self, data: memoryview) -> None:
+        while data and self._file_index < len(self._files):
+            f = self._files[self._file_index]
+            part = data[: self._file_remaining]
+            data = data[len(part) :]
+            self._file_hash.update(part)
+            self._save_hash.update(part)
+            self._sink.write(part)
+            self._file_remaining -= len(part)
+            if self._file_remaining == 0:
+                self._end_file(f)
+                self._start_file()
+        # Anything after the last file is ignored, as it always was
+
+
+def parse_bundle(data: bytes) -> SaveBundle:
+    """Parse a binary save bundle into a SaveBundle object.
+
+    Supports v1 (uncompressed), v2 (zlib compressed) and v3 (per-file
+    codec) formats.
+    """
+    parser = BundleParser()
+    parser.feed(data)
+    return parser.close()
 
 
 def _build_payload(bundle: SaveBundle) -> bytes:
@@ -167,6 +513,66 @@ def _build_payload(bundle: SaveBundle) -> bytes:
     return b"".join(parts)
 
 
+def _choose_codec(data: bytes) -> int:
+    """Entropy probe: zlib unless the sampled bytes look random.
+
+    Samples the whole file, or for files over three windows the first,
+    middle and last _PROBE_WINDOW bytes, and compares how often byte values
+    repeat with what uniformly random bytes would give. Must match
+    probe_codec() in client/source/bundle.c exactly.
+    """
+    size = len(data)
+    if size < _PROBE_MIN_SIZE:
+        return CODEC_STORED
+    if size <= 3 * _PROBE_WINDOW:
+        sample = data
+    else:
+        mid = size // 2 - _PROBE_WINDOW // 2
+        sample = b"".join(
+            (
+                data[:_PROBE_WINDOW],
+                data[mid : mid + _PROBE_WINDOW],
+                data[size - _PROBE_WINDOW :],
+            )
+        )
+    n = len(sample)
+    sum_sq = sum(c * c for c in Counter(sample).values())
+    # Random bytes collide n + n(n-1)/256 times on average; allow 1.25x that
+    return CODEC_ZLIB if 1024 * sum_sq > 5 * n * (n + 255) else CODEC_STORED
+
+
+def create_codec_bundle(bundle: SaveBundle, level: int = LEVEL_FAST) -> bytes:
+    """Serialize a SaveBundle as a v3 bundle.
+
+    Each file is stored or deflated on its own at the given zlib level,
+    as _choose_codec decides.
+    """
+    table: list[bytes] = []
+    data: list[bytes] = []
+    payload_size = 0
+    for f in bundle.files:
+        path_bytes = f.path.encode("utf-8")
+        codec = _choose_codec(f.data)
+        encoded = zlib.compress(f.data, level=level) if codec == CODEC_ZLIB else f.data
+        table.append(struct.pack("<H", len(path_bytes)))
+        table.append(path_bytes)
+        table.append(struct.pack("<I", f.size))
+        table.append(f.sha256)
+        table.append(struct.pack("<BI", codec, len(encoded)))
+        data.append(encoded)
+        payload_size += 2 + len(path_bytes) + 4 + 32 + f.size
+
+    header = b"".join(
+        [
+            BUNDLE_MAGIC,
+            struct.pack("<I", BUNDLE_VERSION_CODECS),
+            struct.pack(">Q", bundle.title_id),
+            struct.pack("<III", bundle.timestamp, len(bundle.files), payload_size),
+        ]
+    )
+    return b"".join([header, *table, *data])
+
+
 def create_bundle(bundle: SaveBundle, compress: bool = True) -> bytes:
     """Serialize a SaveBundle into the binary bundle format.
 
@@ -0,0 +1,37 @@
+"""Binary variant of the change feed (GET /changes?format=binary).
+
+Response format:
+  [4B]  Magic: "3DSF"
+  [4B]  Version: 1 (uint32 LE)
+  [8B]  Cursor (uint64 LE) - pass as ?since= next time
+  [4B]  Flags (uint32 LE) - bit 0: reset, the client's cursor was ahead of
+        the server and every title is listed
+  [4B]  Entry count (uint32 LE)
+  -- For each changed title (40 bytes), oldest change first: --
+    [8B]  Title ID (uint64 BE)
+    [32B] Save hash (SHA-256) of its current save
+"""
+
+from __future__ import annotations
+
+import struct
+
+CHANGES_MAGIC = b"3DSF"
+CHANGES_BINARY_VERSION = 1
+CHANGES_FLAG_RESET = 1
+
+_HEADER = struct.Struct("<4sIQII")
+_ENTRY = struct.Struct(">Q32s")
+
+
+def encode_changes(cursor: int, changes: list[dict], reset: bool) -> bytes:
+    """Serialize a changes_since result."""
+    records: list[bytes] = []
+    for change in changes:
+        try:
+            records.append(_ENTRY.pack(int(change["title_id"], 16), bytes.fromhex(change["save_hash"])))
+        except (ValueError, struct.error):
+            continue  # Not a 64-bit hex ID - can't be a client title
+    flags = CHANGES_FLAG_RESET if reset else 0
+    header = _HEADER.pack(CHANGES_MAGIC, CHANGES_BINARY_VERSION, cursor, flags, len(records))
+    return header + b"".join(records)
@@ -0,0 +1,343 @@
+"""Block-level delta transfer of saves.
+
+Files are split into fixed-size blocks and each block is hashed. Saves are
+fixed-layout files that change in place, so blocks are compared at the same
+offset (no rolling checksum).
+
+Block list format (GET /saves/{id}/blocks):
+  [4B]  Magic: "3DBL"
+  [4B]  Version: 1 (uint32 LE)
+  [4B]  Block size (uint32 LE)
+  [4B]  File count (uint32 LE)
+  [32B] Save hash (SHA-256 of all file data, bundle order)
+  -- For each file: --
+    [2B]  Path length (uint16 LE)
+    [NB]  Path (UTF-8)
+    [4B]  File size (uint32 LE)
+    [4B]  Block count (uint32 LE)
+    [32B] SHA-256 of each block
+
+Delta format (upload body / download response):
+  [4B]  Magic: "3DDL"
+  [4B]  Version: 1 (uint32 LE)
+  [8B]  Title ID (uint64 BE)
+  [4B]  Timestamp - unix epoch (uint32 LE)
+  [4B]  File count (uint32 LE)
+  [4B]  Block size (uint32 LE)
+  [32B] Base save hash - the version the delta applies to
+  [4B]  Uncompressed payload size (uint32 LE)
+  -- Zlib compressed payload: --
+    -- For each file of the new version: --
+      [2B]  Path length (uint16 LE)
+      [NB]  Path (UTF-8)
+      [4B]  File size (uint32 LE)
+      [32B] SHA-256 of the whole new file
+      [4B]  Changed block count (uint32 LE)
+      [4B]  Index of each changed block (uint32 LE)
+    -- Data of each changed block, same order: --
+      [NB]  Block data (block size, or less for a file's last block)
+  Files missing from the delta are deleted; unchanged blocks are copied
+  from the base version.
+
+History delta format (one file of an archived version, stored as a blob):
+  [4B]  Magic: "3DHD"
+  [4B]  Version: 1 (uint32 LE)
+  [4B]  Block size (uint32 LE)
+  [4B]  File size (uint32 LE)
+  [32B] SHA-256 of the file
+  [32B] SHA-256 of the base - the same path in the next newer version
+  [4B]  Uncompressed payload size (uint32 LE)
+  -- Zlib compressed payload: --
+    [4B]  Changed block count (uint32 LE)
+    [4B]  Index of each changed block (uint32 LE)
+    [NB]  Data of each changed block, same order
+"""
+
+from __future__ import annotations
+
+import hashlib
+import struct
+import zlib
+from dataclasses import dataclass, field
+
+from app.config import settings
+from app.models.save import BundleFile, SaveBundle
+
+BLOCK_LIST_MAGIC = b"3DBL"
+DELTA_MAGIC = b"3DDL"
+DELTA_VERSION = 1
+FILE_DELTA_MAGIC = b"3DHD"
+FILE_DELTA_HEADER_SIZE = 4 + 4 + 4 + 4 + 32 + 32 + 4
+
+
+class DeltaError(Exception):
+    pass
+
+
+def _decompress(data: bytes, expected_size: int) -> bytes:
+    """Inflate a payload that should be expected_size bytes, never producing
+    more than the largest save the server accepts."""
+    limit = settings.max_upload_size
+    if expected_size > limit:
+        raise DeltaError(f"Payload too large: {expected_size} > {limit}")
+    try:
+        d = zlib.decompressobj()
+        payload = d.decompress(data, limit)
+        if d.unconsumed_tail:
+            raise DeltaError(f"Payload too large: more than {limit} bytes")
+    except zlib.error as e:
+        raise DeltaError(f"Decompression failed: {e}")
+    if len(payload) != expected_size:
+        raise DeltaError(
+            f"Decompressed size mismatch: expected {expected_size}, got {len(payload)}"
+        )
+    return payload
+
+
+def _check_size(size: int) -> None:
+    if size > settings.max_upload_size:
+        raise DeltaError(f"File too large: {size} > {settings.max_upload_size}")
+
+
+@dataclass
+class DeltaFile:
+    path: str
+    size: int
+    sha256: bytes
+    blocks: dict[int, bytes] = field(default_factory=dict)  # index -> data
+
+
+@dataclass
+class SaveDelta:
+    title_id: int
+    timestamp: int
+    block_size: int
+    base_hash: str
+    files: list[DeltaFile] = field(default_factory=list)
+
+    @property
+    def title_id_hex(self) -> str:
+        return f"{self.title_id:016X}"
+
+
+def block_hashes(data: bytes, block_size: int) -> list[str]:
+    """Hex SHA-256 of each block of a file."""
+    return [
+        hashlib.sha256(data[i : i + block_size]).hexdigest()
+        for i in range(0, len(data), block_size)
+    ]
+
+
+def build_block_list(
+    save_hash: str, block_size: int, files: list[tuple[str, bytes]]
+) -> dict:
+    """Block list for a save version, in the form stored on disk."""
+    return {
+        "save_hash": save_hash,
+        "block_size": block_size,
+        "files": [
+            {"path": path, "size": len(data), "blocks": block_hashes(data, block_size)}
+            for path, data in files
+        ],
+    }
+
+
+def encode_block_list(block_list: dict) -> bytes:
+    """Serialize a stored block list into the binary wire format."""
+    parts = [
+        BLOCK_LIST_MAGIC,
+        struct.pack("<III", DELTA_VERSION, block_list["block_size"], len(block_list["files"])),
+        bytes.fromhex(block_list["save_hash"]),
+    ]
+    for f in block_list["files"]:
+        path_bytes = f["path"].encode("utf-8")
+        parts.append(struct.pack("<H", len(path_bytes)))
+        parts.append(path_bytes)
+        parts.append(struct.pack("<II", f["size"], len(f["blocks"])))
+        parts.extend(bytes.fromhex(h) for h in f["blocks"])
+    return b"".join(parts)
+
+
+def create_delta(
+    bundle: SaveBundle, base_block_list: dict, block_size: int | None = None
+) -> bytes:
+    """Build a delta that turns the base version into the bundle's files."""
+    if block_size is None:
+        block_size = base_block_list["block_size"]
+    base_files = {f["path"]: f for f in base_block_list["files"]}
+    if base_block_list["block_size"] != block_size:
+        base_files = {}  # Block sizes differ - every block counts as changed
+
+    table: list[bytes] = []
+    data: list[bytes] = []
+    for f in bundle.files:
+        base = base_files.get(f.path)
+        base_hashes = base["blocks"] if base else []
+        changed = [
+            i
+            for i, h in enumerate(block_hashes(f.data, block_size))
+            if i >= len(base_hashes) or base_hashes[i] != h
+        ]
+
+        path_bytes = f.path.encode("utf-8")
+        table.append(struct.pack("<H", len(path_bytes)))
+        table.append(path_bytes)
+        table.append(struct.pack("<I", f.size))
+        table.append(hashlib.sha256(f.data).digest())
+        table.append(struct.pack("<I", len(changed)))
+        table.append(struct.pack(f"<{len(changed)}I", *changed))
+        for i in changed:
+            data.append(f.data[i * block_size : (i + 1) * block_size])
+
+    payload = b"".join(table + data)
+    header = (
+        DELTA_MAGIC
+        + struct.pack("<I", DELTA_VERSION)
+        + struct.pack(">Q", bundle.title_id)
+        + struct.pack("<III", bundle.timestamp, len(bundle.files), block_size)
+        + bytes.fromhex(base_block_list["save_hash"])
+        + struct.pack("<I", len(payload))
+    )
+    return header + zlib.compress(payload, level=6)
+
+
+def parse_delta(data: bytes) -> SaveDelta:
+    """Parse a binary delta."""
+    header_size = 4 + 4 + 8 + 4 + 4 + 4 + 32 + 4
+    if len(data) < header_size:
+        raise DeltaError("Delta too small for header")
+    if data[:4] != DELTA_MAGIC:
+        raise DeltaError(f"Invalid magic: {data[:4]!r}")
+
+    (version,) = struct.unpack_from("<I", data, 4)
+    if version != DELTA_VERSION:
+        raise DeltaError(f"Unsupported version: {version}")
+    (title_id,) = struct.unpack_from(">Q", data, 8)
+    timestamp, file_count, block_size = struct.unpack_from("<III", data, 16)
+    base_hash = data[28:60].hex()
+    (payload_size,) = struct.unpack_from("<I", data, 60)
+
+    if block_size == 0:
+        raise DeltaError("Invalid block size")
+    payload = _decompress(data[header_size:], payload_size)
+
+    delta = SaveDelta(
+        title_id=title_id, timestamp=timestamp, block_size=block_size, base_hash=base_hash
+    )
+    offset = 0
+    indices: list[list[int]] = []
+    try:
+        for _ in range(file_count):
+            (path_len,) = struct.unpack_from("<H", payload, offset)
+            offset += 2
+            path = payload[offset : offset + path_len].decode("utf-8")
+            offset += path_len
+            (size,) = struct.unpack_from("<I", payload, offset)
+            offset += 4
+            sha256 = payload[offset : offset + 32]
+            offset += 32
+            (count,) = struct.unpack_from("<I", payload, offset)
+            offset += 4
+            indices.append(list(struct.unpack_from(f"<{count}I", payload, offset)))
+            offset += 4 * count
+            delta.files.append(DeltaFile(path=path, size=size, sha256=sha256))
+    except (struct.error, UnicodeDecodeError) as e:
+        raise DeltaError(f"Truncated file table: {e}")
+    _check_size(sum(f.size for f in delta.files))
+
+    for f, file_indices in zip(delta.files, indices):
+        for i in file_indices:
+            start = i * block_size
+            length = min(block_size, f.size - start)
+            if length <= 0:
+                raise DeltaError(f"Block {i} out of range for {f.path}")
+            if offset + length > len(payload):
+                raise DeltaError(f"Truncated block data for {f.path}")
+            f.blocks[i] = payload[offset : offset + length]
+            offset += length
+
+    return delta
+
+
+def apply_delta(delta: SaveDelta, base_files: dict[str, bytes]) -> SaveBundle:
+    """Rebuild the full save from a delta and the base version's files."""
+    files: list[BundleFile] = []
+    _check_size(sum(f.size for f in delta.files))
+    for f in delta.files:
+        data = bytearray(base_files.get(f.path, b"")[: f.size])
+        data.extend(b"\x00" * (f.size - len(data)))
+        for i, block in f.blocks.items():
+            start = i * delta.block_size
+            data[start : start + len(block)] = block
+
+        data = bytes(data)
+        if hashlib.sha256(data).digest() != f.sha256:
+            raise DeltaError(f"Hash mismatch for {f.path} after applying delta")
+        files.append(BundleFile(path=f.path, size=f.size, sha256=f.sha256, data=data))
+
+    return SaveBundle(title_id=delta.title_id, timestamp=delta.timestamp, files=files)
+
+
+def create_file_delta(data: bytes, base: bytes, block_size: int) -> bytes:
+    """Build a history delta that turns base into data."""
+    changed = [
+        i
+        for i in range(0, (len(data) + block_size - 1) // block_size)
+        if data[i * block_size : (i + 1) * block_size]
+        != base[i * block_size : (i + 1) * block_size]
+    ]
+    payload = b"".join(
+        [struct.pack(f"<I{len(changed)}I", len(changed), *changed)]
+        + [data[i * block_size : (i + 1) * block_size] for i in changed]
+    )
+    header = (
+        FILE_DELTA_MAGIC
+        + struct.pack("<III", DELTA_VERSION, block_size, len(data))
+        + hashlib.sha256(data).digest()
+        + hashlib.sha256(base).digest()
+        + struct.pack("<I", len(payload))
+    )
+    return header + zlib.compress(payload, level=6)
+
+
+def apply_file_delta(delta: bytes, base: bytes) -> bytes:
+    """Rebuild a file from a history delta and its base, checking both hashes."""
+    if len(delta) < FILE_DELTA_HEADER_SIZE:
+        raise DeltaError("History delta too small for header")
+    if delta[:4] != FILE_DELTA_MAGIC:
+        raise DeltaError(f"Invalid magic: {delta[:4]!r}")
+    version, block_size, size = struct.unpack_from("<III", delta, 4)
+    if version != DELTA_VERSION:
+        raise DeltaError(f"Unsupported version: {version}")
+    if block_size == 0:
+        raise DeltaError("Invalid block size")
+    if hashlib.sha256(base).digest() != delta[48:80]:
+        raise DeltaError("History delta base does not match")
+    (payload_size,) = struct.unpack_from("<I", delta, 80)
+
+    payload = _decompress(delta[FILE_DELTA_HEADER_SIZE:], payload_size)
+
+    try:
+        (count,) = struct.unpack_from("<I", payload, 0)
+        indices = struct.unpack_from(f"<{count}I", payload, 4)
+    except struct.error as e:
+        raise DeltaError(f"Truncated block table: {e}")
+
+    _check_size(size)
+    data = bytearray(base[:size])
+    data.extend(b"\x00" * (size - len(data)))
+    offset = 4 + 4 * count
+    for i in indices:
+        start = i * block_size
+        length = min(block_size, size - start)
+        if length <= 0:
+            raise DeltaError(f"Block {i} out of range")
+        if offset + length > len(payload):
+            raise DeltaError("Truncated block data")
+        data[start : start + length] = payload[offset : offset + length]
+        offset += length
+
+    data = bytes(data)
+    if hashlib.sha256(data).digest() != delta[16:48]:
+        raise DeltaError("Hash mismatch after applying history delta")
+    return data
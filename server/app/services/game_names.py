@@ -1,49 +1,83 @@
-"""Game name lookup service using 3dstdb.txt and dstdb.txt databases."""
+"""Game name lookup service using 3dstdb.txt and dstdb.txt databases.
 
+Each database is served from its prebuilt index (3dstdb.idx, dstdb.idx; see
+names_index) when one at least as new as the text file exists, and from an
+index built in memory from the text otherwise.
+"""
+
+import hashlib
+from functools import lru_cache
 from pathlib import Path
 
+from app.services.names_index import NameIndex, NameIndexError, parse_text
+
 # Global cache for game names (loaded once at startup)
 # Keep DS and 3DS databases separate to handle duplicate product codes
-_3ds_names: dict[str, str] = {}
-_ds_names: dict[str, str] = {}
+_3ds_names = NameIndex.from_names({})
+_ds_names = NameIndex.from_names({})
+_version: str | None = None
+
+
+def index_path(db_path: Path) -> Path:
+    """Where the prebuilt index for a text database lives."""
+    return db_path.with_suffix(".idx")
+
+
+def _open_index(db_path: Path) -> NameIndex | None:
+    """The prebuilt index for db_path, or None if it's missing or stale."""
+    idx_path = index_path(db_path)
+    try:
+        if db_path.exists() and idx_path.stat().st_mtime_ns < db_path.stat().st_mtime_ns:
+            print(f"Ignoring {idx_path.name}: older than {db_path.name}")
+            return None
+        return NameIndex.open(idx_path)
+    except FileNotFoundError:
+        return None
+    except (OSError, NameIndexError) as e:
+        print(f"Ignoring {idx_path.name}: {e}")
+        return None
 
 
 def load_database(db_path: Path | None = None) -> int:
-    """Load a game names database from file into the appropriate cache.
+    """Load a game names database into the appropriate cache.
 
     Automatically detects whether it's loading a 3DS or DS database based on filename.
     Returns the number of entries loaded.
     """
-    global _3ds_names, _ds_names
+    global _3ds_names, _ds_names, _version
 
     if db_path is None:
         # Default path relative to server root
         db_path = Path(__file__).parent.parent.parent / "data" / "3dstdb.txt"
 
-    if not db_path.exists():
-        return 0
+    index = _open_index(db_path)
+    if index is None:
+        if not db_path.exists():
+            return 0
+        index = NameIndex.from_names(parse_text(db_path))
 
     # Determine which database to load into based on filename
     is_ds = "ds" in db_path.name.lower() and "3ds" not in db_path.name.lower()
-    target_dict = _ds_names if is_ds else _3ds_names
+    if is_ds:
+        _ds_names = index
+    else:
+        _3ds_names = index
+
+    _version = None
+    _lookup_one.cache_clear()
+    return len(index)
 
-    added = 0
-    with open(db_path, "r", encoding="utf-8") as f:
-        for line in f:
-            line = line.strip()
-            if not line or "," not in line:
-                continue
 
-            # Format: CODE,Game Name
-            parts = line.split(",", 1)
-            if len(parts) == 2:
-                code = parts[0].strip().upper()
-                name = parts[1].strip()
-                if code and name:
-                    target_dict[code] = name
-                    added += 1
+def database_version() -> str:
+    """Short hash of the loaded databases, for clients that cache names.
 
-    return added
+    It changes whenever the databases do, so a client holding names from
+    another version knows to look them up again.
+    """
+    global _version
+    if _version is None:
+        _version = hashlib.sha256(_3ds_names.digest + _ds_names.digest).hexdigest()[:16]
+    return _version
 
 
 def lookup_names(product_codes: list[str]) -> dict[str, str]:
@@ -61,41 +95,42 @@ def lookup_names(product_codes: list[str]) -> dict[str, str]:
     Unknown codes are omitted from the result.
     """
     result = {}
-
     for code in product_codes:
-        # Extract the 4-char game code
-        code_upper = code.upper().strip()
-        is_3ds_format = code_upper.startswith("CTR-")
-
-        if len(code_upper) >= 10 and "-" in code_upper:
-            # Full format like CTR-P-BRBE - extract last 4 chars before any suffix
-            parts = code_upper.split("-")
-            if len(parts) >= 3:
-                game_code = parts[2][:4]  # Take first 4 chars of the game code part
-            else:
-                game_code = code_upper[-4:]
-        elif len(code_upper) == 4:
-            # Already just the 4-char code
-            game_code = code_upper
-        else:
-            # Try last 4 chars as fallback
-            game_code = code_upper[-4:] if len(code_upper) >= 4 else code_upper
-
-        # Check appropriate database based on format
-        # For CTR- prefix, check 3DS first, then DS as fallback
-        # For short codes, check DS first, then 3DS as fallback
-        name = None
-        if is_3ds_format:
-            name = _3ds_names.get(game_code) or _ds_names.get(game_code)
-        else:
-            name = _ds_names.get(game_code) or _3ds_names.get(game_code)
-
+        name = _lookup_one(code)
         if name:
             result[code] = name
-
     return result
 
 
+@lru_cache(maxsize=8192)
+def _lookup_one(code: str) -> str | None:
+    """Name for one product code (memoized; cleared when a database loads)."""
+    # Extract the 4-char game code
+    code_upper = code.upper().strip()
+    is_3ds_format = code_upper.startswith("CTR-")
+
+    if len(code_upper) >= 10 and "-" in code_upper:
+        # Full format like CTR-P-BRBE - extract last 4 chars before any suffix
+        parts = code_upper.split("-")
+        if len(parts) >= 3:
+            game_code = parts[2][:4]  # Take first 4 chars of the game code part
+        else:
+            game_code = code_upper[-4:]
+    elif len(code_upper) == 4:
+        # Already just the 4-char code
+        game_code = code_upper
+    else:
+        # Try last 4 chars as fallback
+        game_code = code_upper[-4:] if len(code_upper) >= 4 else code_upper
+
+    # Check appropriate database based on format
+    # For CTR- prefix, check 3DS first, then DS as fallback
+    # For short codes, check DS first, then 3DS as fallback
+    if is_3ds_format:
+        return _3ds_names.get(game_code) or _ds_names.get(game_code)
+    return _ds_names.get(game_code) or _3ds_names.get(game_code)
+
+
 def get_name(product_code: str) -> str | None:
     """Look up a single game name. Returns None if not found."""
     result = lookup_names([product_code])
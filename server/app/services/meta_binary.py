@@ -0,0 +1,98 @@
+"""Binary variant of the bulk metadata lookup (POST /titles/meta,
+Content-Type: application/octet-stream).
+
+Request format:
+  [4B]  Magic: "3DSM"
+  [4B]  Version: 1 (uint32 LE)
+  [4B]  Title count (uint32 LE)
+  -- For each title (8 bytes): --
+    [8B]  Title ID (uint64 BE)
+
+Response format:
+  [4B]  Magic: "3DSI"
+  [4B]  Version: 1 (uint32 LE)
+  [4B]  Entry count (uint32 LE)
+  -- For each requested title the server has a save for (72 bytes),
+     in request order, once each: --
+    [8B]  Title ID (uint64 BE)
+    [32B] Save hash (SHA-256)
+    [4B]  Save size (uint32 LE)
+    [4B]  File count (uint32 LE)
+    [4B]  Client timestamp - unix epoch (uint32 LE)
+    [4B]  Last sync - unix epoch (uint32 LE)
+    [16B] Console ID (ASCII, NUL padded)
+
+Titles missing from the response have no save on the server.
+"""
+
+from __future__ import annotations
+
+import struct
+from datetime import datetime
+
+from app.models.save import SaveMetadata
+
+META_REQUEST_MAGIC = b"3DSM"
+META_RESPONSE_MAGIC = b"3DSI"
+META_BINARY_VERSION = 1
+
+_HEADER = struct.Struct("<4sII")
+_TITLE_ID = struct.Struct(">Q")
+_ENTRY = struct.Struct("<32sIIII16s")
+ENTRY_SIZE = _TITLE_ID.size + _ENTRY.size
+
+
+class MetaBinaryError(Exception):
+    pass
+
+
+def parse_meta_request(data: bytes) -> list[str]:
+    """Parse a binary metadata request into uppercase hex title IDs."""
+    if len(data) < _HEADER.size:
+        raise MetaBinaryError("Request too small for header")
+
+    magic, version, count = _HEADER.unpack_from(data, 0)
+    if magic != META_REQUEST_MAGIC:
+        raise MetaBinaryError(f"Invalid magic: {magic!r}")
+    if version != META_BINARY_VERSION:
+        raise MetaBinaryError(f"Unsupported version: {version}")
+
+    expected = _HEADER.size + count * _TITLE_ID.size
+    if len(data) != expected:
+        raise MetaBinaryError(f"Size mismatch: expected {expected}, got {len(data)}")
+
+    return [
+        f"{title_id:016X}"
+        for (title_id,) in _TITLE_ID.iter_unpack(data[_HEADER.size:])
+    ]
+
+
+def _unix_time(iso: str) -> int:
+    try:
+        return max(0, int(datetime.fromisoformat(iso).timestamp()))
+    except ValueError:
+        return 0
+
+
+def encode_meta_response(metas: list[SaveMetadata]) -> bytes:
+    """Serialize the metadata of the titles that have a save."""
+    records: list[bytes] = []
+    for meta in metas:
+        try:
+            title_id = _TITLE_ID.pack(int(meta.title_id, 16))
+            save_hash = bytes.fromhex(meta.save_hash)
+        except (ValueError, struct.error):
+            continue  # Not a 64-bit hex ID - can't be a client title
+        records.append(
+            title_id
+            + _ENTRY.pack(
+                save_hash,
+                meta.save_size,
+                meta.file_count,
+                meta.client_timestamp & 0xFFFFFFFF,
+                _unix_time(meta.last_sync) & 0xFFFFFFFF,
+                meta.console_id.encode("ascii", errors="replace")[:16],
+            )
+        )
+    header = _HEADER.pack(META_RESPONSE_MAGIC, META_BINARY_VERSION, len(records))
+    return header + b"".join(records)
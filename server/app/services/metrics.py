@@ -0,0 +1,48 @@
+"""Event loop latency.
+
+A background task sleeps for a fixed interval and records how late it
+wakes up. Lag well above zero means something blocked the loop (a
+synchronous read, a large zlib call) and every request waited for it.
+"""
+
+from __future__ import annotations
+
+import asyncio
+import time
+from collections import deque
+
+LAG_INTERVAL = 0.1  # seconds between samples
+LAG_WINDOW = 600  # samples kept (one minute)
+
+_samples: deque[float] = deque(maxlen=LAG_WINDOW)
+_max_lag = 0.0
+
+
+async def monitor_loop_lag() -> None:
+    """Sample loop lag until cancelled."""
+    while True:
+        start = time.perf_counter()
+        await asyncio.sleep(LAG_INTERVAL)
+        record_lag(max(0.0, time.perf_counter() - start - LAG_INTERVAL))
+
+
+def record_lag(lag: float) -> None:
+    """Add one lag sample in seconds (used by the monitor and tests)."""
+    global _max_lag
+    _samples.append(lag)
+    _max_lag = max(_max_lag, lag)
+
+
+def loop_lag_stats() -> dict:
+    """Lag over the recent window plus the worst since startup, in milliseconds."""
+    if not _samples:
+        return {"samples": 0, "avg_ms": 0.0, "p99_ms": 0.0, "max_ms": 0.0, "max_ever_ms": 0.0}
+    ordered = sorted(_samples)
+    p99 = ordered[min(len(ordered) - 1, int(len(ordered) * 0.99))]
+    return {
+        "samples": len(ordered),
+        "avg_ms": round(sum(ordered) / len(ordered) * 1000, 2),
+        "p99_ms": round(p99 * 1000, 2),
+        "max_ms": round(ordered[-1] * 1000, 2),
+        "max_ever_ms": round(_max_lag * 1000, 2),
+    }
@@ -0,0 +1,135 @@
+"""Prebuilt game-name index (3dstdb.idx / dstdb.idx next to the text files).
+
+File format:
+  [4B]  Magic: "3DSN"
+  [4B]  Version: 1 (uint32 LE)
+  [4B]  Entry count (uint32 LE)
+  [4B]  Name blob size (uint32 LE)
+  [32B] Digest: SHA-256 of the sorted "CODE,Name\\n" lines
+  -- For each entry (12 bytes), sorted by code: --
+    [4B]  Product code (ASCII)
+    [4B]  Name offset into the blob (uint32 LE)
+    [4B]  Name length in bytes (uint32 LE)
+  -- Name blob: the UTF-8 names, back to back --
+
+Build it with tools/build_name_index.py. The server maps it instead of
+parsing the text at startup and finds codes by binary search; the digest
+is what the names version clients cache under is made from.
+"""
+
+from __future__ import annotations
+
+import hashlib
+import mmap
+import struct
+from pathlib import Path
+
+NAMES_MAGIC = b"3DSN"
+NAMES_INDEX_VERSION = 1
+CODE_LEN = 4
+
+_HEADER = struct.Struct("<4sIII32s")
+_ENTRY = struct.Struct("<4sII")
+
+
+class NameIndexError(ValueError):
+    pass
+
+
+def parse_text(path: Path) -> dict[str, str]:
+    """Read a CODE,Name text database. Later lines win for repeated codes."""
+    names: dict[str, str] = {}
+    with open(path, "r", encoding="utf-8") as f:
+        for line in f:
+            line = line.strip()
+            if not line or "," not in line:
+                continue
+            code, name = line.split(",", 1)
+            code = code.strip().upper()
+            name = name.strip()
+            if code and name:
+                names[code] = name
+    return names
+
+
+def build_index(names: dict[str, str]) -> bytes:
+    """Serialize a code -> name table. Codes that aren't 4 ASCII chars are
+    dropped; lookups only ever ask for 4-char codes."""
+    digest = hashlib.sha256()
+    entries: list[bytes] = []
+    blob = bytearray()
+    for code in sorted(names):
+        raw_code = code.encode("ascii", "ignore")
+        if len(raw_code) != CODE_LEN or len(raw_code) != len(code):
+            continue
+        name = names[code].encode("utf-8")
+        digest.update(raw_code + b"," + name + b"\n")
+        entries.append(_ENTRY.pack(raw_code, len(blob), len(name)))
+        blob += name
+    header = _HEADER.pack(NAMES_MAGIC, NAMES_INDEX_VERSION, len(entries), len(blob), digest.digest())
+    return header + b"".join(entries) + bytes(blob)
+
+
+class NameIndex:
+    """Read-only view of an index, in memory or mapped from disk."""
+
+    def __init__(self, data: bytes | mmap.mmap):
+        if len(data) < _HEADER.size:
+            raise NameIndexError("Index too short")
+        magic, version, count, blob_size, digest = _HEADER.unpack_from(data)
+        if magic != NAMES_MAGIC:
+            raise NameIndexError(f"Invalid magic: {magic!r}")
+        if version != NAMES_INDEX_VERSION:
+            raise NameIndexError(f"Unsupported version: {version}")
+        self._blob = _HEADER.size + count * _ENTRY.size
+        if len(data) != self._blob + blob_size:
+            raise NameIndexError("Index size doesn't match its header")
+        self._data = data
+        self._count = count
+        self._blob_size = blob_size
+        self.digest = digest
+
+    @classmethod
+    def open(cls, path: Path) -> NameIndex:
+        """Map an index file. Raises OSError or NameIndexError."""
+        with open(path, "rb") as f:
+            size = f.seek(0, 2)
+            if size < _HEADER.size:
+                raise NameIndexError("Index too short")
+            data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        try:
+            return cls(data)
+        except NameIndexError:
+            data.close()
+            raise
+
+    @classmethod
+    def from_names(cls, names: dict[str, str]) -> NameIndex:
+        return cls(build_index(names))
+
+    def __len__(self) -> int:
+        return self._count
+
+    def _code_at(self, i: int) -> bytes:
+        start = _HEADER.size + i * _ENTRY.size
+        return self._data[start : start + CODE_LEN]
+
+    def get(self, code: str) -> str | None:
+        """Name for a 4-char product code, or None."""
+        key = code.encode("ascii", "ignore")
+        if len(key) != CODE_LEN:
+            return None
+        lo, hi = 0, self._count
+        while lo < hi:
+            mid = (lo + hi) // 2
+            if self._code_at(mid) < key:
+                lo = mid + 1
+            else:
+                hi = mid
+        if lo == self._count or self._code_at(lo) != key:
+            return None
+        _, offset, length = _ENTRY.unpack_from(self._data, _HEADER.size + lo * _ENTRY.size)
+        if offset + length > self._blob_size:
+            return None
+        start = self._blob + offset
+        return self._data[start : start + length].decode("utf-8", "replace")
@@ -3,21 +3,71 @@
 Saves are stored as:
   saves/<title_id>/
     metadata.json
-    current/          -- extracted save files
+    current.json      -- manifest of the current save: [{path, size, sha256}]
     history/
-      <timestamp>/    -- previous versions
+      <timestamp>.json  -- manifests of previous versions; a file entry with a
+                           "delta" blob is stored as a delta against the same
+                           path in the next newer version
+    blocks/
+      <save_hash>.json  -- per-block hashes of current/recent versions (delta sync)
+    bundles/
+      <save_hash>.bin   -- compressed (v2) bundle of the current save, served as-is
+      v3/<save_hash>.bin  -- the same as a v3 bundle, built on first request
+  saves/blobs/<sha[:2]>/<sha256>  -- file contents, shared by all manifests
+
+A file is written once no matter how many versions, titles or consoles
+reference it. Blob reference counts are built from all manifests on first
+use and kept in memory; a blob is deleted when its last manifest is pruned.
+Saves stored before the blob store (current/ and history/<timestamp>/
+directories) are converted on their next upload. Uploaded bundles are
+written through SaveWriter as they are parsed, so a save is never held in
+memory whole; their download bundle is built on the worker pool after the
+commit.
+
+History is compacted in the background after each upload: files only
+history refers to are rewritten as block deltas against the next newer
+version, so a version costs roughly what changed in it. Every
+history_snapshot_interval hops a file is kept (or made) whole again, which
+bounds how many deltas a restore has to apply.
+
+metadata.json files are read once per save directory into an in-memory
+index; store_save writes the file and updates the index together, so
+metadata lookups never touch the disk. Title directories added or removed
+behind the server's back are picked up on the next restart.
+
+Every stored version gets the next number of a store-wide change sequence
+(metadata change_seq; the sequence resumes from the highest one on disk),
+so changes_since can tell a client which titles changed after a cursor.
 """
 
 from __future__ import annotations
 
 import json
 import hashlib
+import os
 import shutil
+import threading
+import time
+import uuid
 from datetime import datetime, timezone
 from pathlib import Path
 
 from app.config import settings
-from app.models.save import SaveBundle, SaveMetadata
+from app.models.save import (
+    BUNDLE_VERSION_CODECS,
+    BUNDLE_VERSION_COMPRESSED,
+    BundleFile,
+    SaveBundle,
+    SaveMetadata,
+)
+from app.services import workers
+from app.services.bundle import LEVEL_HIGH, BundleSink, create_bundle, create_codec_bundle
+from app.services.delta import (
+    DeltaError,
+    apply_file_delta,
+    build_block_list,
+    create_file_delta,
+)
 
 
 def _title_dir(title_id: str) -> Path:
@@ -28,6 +78,10 @@ def _current_dir(title_id: str) -> Path:
     return _title_dir(title_id) / "current"
 
 
+def _current_manifest(title_id: str) -> Path:
+    return _title_dir(title_id) / "current.json"
+
+
 def _history_dir(title_id: str) -> Path:
     return _title_dir(title_id) / "history"
 
@@ -36,69 +90,353 @@ def _metadata_path(title_id: str) -> Path:
     return _title_dir(title_id) / "metadata.json"
 
 
+def _blocks_dir(title_id: str) -> Path:
+    return _title_dir(title_id) / "blocks"
+
+
+def _bundles_dir(title_id: str, version: int = BUNDLE_VERSION_COMPRESSED) -> Path:
+    bundles = _title_dir(title_id) / "bundles"
+    return bundles if version == BUNDLE_VERSION_COMPRESSED else bundles / f"v{version}"
+
+
+def _blob_path(sha256: str) -> Path:
+    return settings.save_dir / "blobs" / sha256[:2] / sha256
+
+
+_title_locks_lock = threading.Lock()
+_title_locks: dict[str, threading.RLock] = {}
+
+
+def title_lock(title_id: str) -> threading.RLock:
+    """Lock serializing changes to one title.
+
+    Hold it across a check-then-store (conflict check, delta base check) so a
+    concurrent upload of the same title can't slip in between.
+    """
+    with _title_locks_lock:
+        lock = _title_locks.get(title_id)
+        if lock is None:
+            lock = _title_locks[title_id] = threading.RLock()
+        return lock
+
+
+_index_lock = threading.Lock()
+_index_dir: Path | None = None
+_index: dict[str, dict] = {}
+_change_seq = 0  # Highest change_seq in the index
+# Held from taking a sequence number until its metadata is in the index, so
+# changes_since never hands out a cursor past a change it can't see yet
+_change_lock = threading.Lock()
+
+
+def _metadata_index() -> dict[str, dict]:
+    """The metadata index for settings.save_dir, loading it on first use."""
+    global _index_dir, _index, _change_seq
+    save_dir = settings.save_dir
+    with _index_lock:
+        if _index_dir != save_dir:
+            index: dict[str, dict] = {}
+            if save_dir.exists():
+                for entry in save_dir.iterdir():
+                    meta_path = entry / "metadata.json"
+                    if entry.is_dir() and meta_path.exists():
+                        index[entry.name] = json.loads(meta_path.read_text(encoding="utf-8"))
+            _index = index
+            _index_dir = save_dir
+            _change_seq = max((d.get("change_seq", 0) for d in index.values()), default=0)
+        return _index
+
+
+def load_index() -> int:
+    """Load the metadata index (at startup). Returns the number of titles."""
+    return len(_metadata_index())
+
+
 def title_exists(title_id: str) -> bool:
-    return _metadata_path(title_id).exists()
+    return title_id in _metadata_index()
 
 
 def list_titles() -> list[dict]:
     """Return metadata for all stored titles."""
-    results = []
-    save_dir = settings.save_dir
-    if not save_dir.exists():
-        return results
+    index = _metadata_index()
+    return [dict(index[tid]) for tid in sorted(index)]
 
-    for entry in sorted(save_dir.iterdir()):
-        meta_path = entry / "metadata.json"
-        if entry.is_dir() and meta_path.exists():
-            meta = json.loads(meta_path.read_text(encoding="utf-8"))
-            results.append(meta)
 
-    return results
+def list_title_ids() -> list[str]:
+    """Return the IDs of all stored titles."""
+    return sorted(_metadata_index())
 
 
 def get_metadata(title_id: str) -> SaveMetadata | None:
     """Load metadata for a title, or None if it doesn't exist."""
-    path = _metadata_path(title_id)
-    if not path.exists():
+    data = _metadata_index().get(title_id)
+    if data is None:
         return None
-
-    data = json.loads(path.read_text(encoding="utf-8"))
     return SaveMetadata(**data)
 
 
+def get_metadata_many(title_ids: list[str]) -> list[SaveMetadata]:
+    """Load metadata for several titles from one read of the index.
+
+    Titles without a save are skipped; the rest keep their order, once each.
+    """
+    index = _metadata_index()
+    found: dict[str, SaveMetadata] = {}
+    for title_id in title_ids:
+        data = index.get(title_id)
+        if data is not None and title_id not in found:
+            found[title_id] = SaveMetadata(**data)
+    return list(found.values())
+
+
+def _write_metadata(meta: SaveMetadata) -> None:
+    """Replace a title's metadata.json and its index entry.
+
+    The metadata gets the next change sequence number.
+    """
+    global _change_seq
+    index = _metadata_index()
+    with _change_lock:
+        meta.change_seq = _change_seq + 1
+        data = meta.to_dict()
+
+        # Write-then-rename so a crash never leaves a truncated metadata.json
+        meta_path = _metadata_path(meta.title_id)
+        tmp_path = meta_path.with_suffix(".json.tmp")
+        tmp_path.write_text(json.dumps(data, indent=2), encoding="utf-8")
+        os.replace(tmp_path, meta_path)
+
+        with _index_lock:
+            index[meta.title_id] = data
+            _change_seq = meta.change_seq
+
+
+def changes_since(since: int | None) -> tuple[int, list[dict], bool]:
+    """Titles whose save changed after the cursor since.
+
+    Returns (cursor, changes, reset): the current cursor, the changed
+    titles' {title_id, save_hash, change_seq} in sequence order, and
+    whether since was ahead of this store (its saves were replaced or
+    restored from a backup), in which case every title is listed, as for
+    since 0. With since None only the cursor is returned.
+    """
+    index = _metadata_index()
+    with _change_lock, _index_lock:
+        cursor = _change_seq
+        if since is None:
+            return cursor, [], False
+        reset = since > cursor
+        if reset:
+            since = 0
+        changes = [
+            {"title_id": tid, "save_hash": data["save_hash"], "change_seq": data.get("change_seq", 0)}
+            for tid, data in index.items()
+            if since == 0 or data.get("change_seq", 0) > since
+        ]
+    changes.sort(key=lambda c: (c["change_seq"], c["title_id"]))
+    return cursor, changes, reset
+
+
+# --- Blob store ---
+
+_blob_lock = threading.Lock()
+_refs_dir: Path | None = None
+_refs: dict[str, int] = {}
+
+
+def _blob_refs() -> dict[str, int]:
+    """Reference counts of all blobs (caller holds _blob_lock)."""
+    global _refs_dir, _refs
+    save_dir = settings.save_dir
+    if _refs_dir != save_dir:
+        refs: dict[str, int] = {}
+        if save_dir.exists():
+            for entry in save_dir.iterdir():
+                manifests = [entry / "current.json"]
+                history = entry / "history"
+                if history.is_dir():
+                    manifests += [p for p in history.iterdir() if p.suffix == ".json"]
+                for path in manifests:
+                    if path.is_file():
+                        for f in _read_manifest(path):
+                            sha256 = _entry_blob(f)
+                            refs[sha256] = refs.get(sha256, 0) + 1
+        _refs = refs
+        _refs_dir = save_dir
+    return _refs
+
+
+def _entry_blob(entry: dict) -> str:
+    """The blob a manifest entry holds: its delta if it has one, else the file."""
+    return entry.get("delta", entry["sha256"])
+
+
+def _read_manifest(path: Path) -> list[dict]:
+    return json.loads(path.read_text(encoding="utf-8"))["files"]
+
+
+def _write_manifest(path: Path, files: list[dict]) -> None:
+    tmp_path = path.with_suffix(".json.tmp")
+    tmp_path.write_text(json.dumps({"files": files}), encoding="utf-8")
+    os.replace(tmp_path, path)
+
+
+def _add_blob(sha256: str, data: bytes) -> None:
+    """Take a reference to a blob, writing it if it isn't stored yet."""
+    with _blob_lock:
+        refs = _blob_refs()
+        path = _blob_path(sha256)
+        if not path.exists():
+            path.parent.mkdir(parents=True, exist_ok=True)
+            tmp_path = path.with_suffix(".tmp")
+            tmp_path.write_bytes(data)
+            os.replace(tmp_path, path)
+        refs[sha256] = refs.get(sha256, 0) + 1
+
+
+def _ref_blob(sha256: str) -> bool:
+    """Take a reference to a blob if it is already stored."""
+    with _blob_lock:
+        refs = _blob_refs()
+        if not _blob_path(sha256).exists():
+            return False
+        refs[sha256] = refs.get(sha256, 0) + 1
+        return True
+
+
+def _install_blob(sha256: str, tmp_path: Path) -> None:
+    """Move a fully written temp file into the store and take a reference."""
+    with _blob_lock:
+        refs = _blob_refs()
+        path = _blob_path(sha256)
+        if path.exists():
+            tmp_path.unlink()  # Another upload stored the same contents first
+        else:
+            path.parent.mkdir(parents=True, exist_ok=True)
+            os.replace(tmp_path, path)
+        refs[sha256] = refs.get(sha256, 0) + 1
+
+
+def _drop_refs(shas: list[str]) -> None:
+    """Drop one reference per hash, deleting blobs nothing refers to anymore."""
+    with _blob_lock:
+        refs = _blob_refs()
+        for sha256 in shas:
+            count = refs.get(sha256, 0) - 1
+            if count > 0:
+                refs[sha256] = count
+                continue
+            refs.pop(sha256, None)
+            _blob_path(sha256).unlink(missing_ok=True)
+
+
+def _release_manifest(path: Path) -> None:
+    """Delete a manifest, dropping its blob references."""
+    files = _read_manifest(path)
+    path.unlink()
+    _drop_refs([_entry_blob(f) for f in files])
+
+
+def _store_files(files: list[tuple[str, bytes, str]]) -> list[dict]:
+    """Store (path, data, sha256 hex) files as blobs, returning manifest entries."""
+    entries = []
+    for path, data, sha256 in files:
+        _add_blob(sha256, data)
+        entries.append({"path": path, "size": len(data), "sha256": sha256})
+    return entries
+
+
+def _migrate_legacy_current(title_id: str) -> None:
+    """Convert a pre-blob-store current/ directory into a manifest."""
+    current = _current_dir(title_id)
+    if not current.is_dir():
+        return
+    files = [
+        (path, data, hashlib.sha256(data).hexdigest())
+        for path, data in _load_legacy_files(current)
+    ]
+    _write_manifest(_current_manifest(title_id), _store_files(files))
+    shutil.rmtree(current)
+
+
 def store_save(bundle: SaveBundle, source: str = "3ds", console_id: str = "") -> SaveMetadata:
-    """Store a save bundle to disk, archiving any existing save to history."""
+    """Store a save bundle, archiving any existing save to history.
+
+    Only file contents not already in the blob store are written.
+    """
+    with title_lock(bundle.title_id_hex):
+        return _store_save(bundle, source, console_id)
+
+
+def _store_save(bundle: SaveBundle, source: str, console_id: str) -> SaveMetadata:
     title_id = bundle.title_id_hex
-    current = _current_dir(title_id)
-    history = _history_dir(title_id)
 
-    # Archive existing save to history
-    if current.exists():
+    # New blobs first, so files shared with the old version keep a reference
+    entries = _store_files([(f.path, f.data, f.sha256.hex()) for f in bundle.files])
+
+    # Compute bundle hash
+    all_data = b"".join(f.data for f in bundle.files)
+    bundle_hash = hashlib.sha256(all_data).hexdigest()
+
+    meta = _commit_version(
+        title_id,
+        entries,
+        build_block_list(
+            bundle_hash,
+            settings.delta_block_size,
+            [(f.path, f.data) for f in bundle.files],
+        ),
+        bundle.timestamp,
+        source,
+        console_id,
+    )
+
+    # Download bundle, in the same file order as load_save_files
+    _write_bundle(
+        title_id,
+        bundle_hash,
+        SaveBundle(
+            title_id=bundle.title_id,
+            timestamp=bundle.timestamp,
+            files=sorted(bundle.files, key=lambda f: f.path),
+        ),
+    )
+
+    return meta
+
+
+def _commit_version(
+    title_id: str,
+    entries: list[dict],
+    block_list: dict,
+    client_timestamp: int,
+    source: str,
+    console_id: str,
+) -> SaveMetadata:
+    """Make stored blobs (entries already referenced) the title's current save."""
+    _title_dir(title_id).mkdir(parents=True, exist_ok=True)
+    _migrate_legacy_current(title_id)
+
+    # Archive existing save to history (the manifest moves, blobs stay put)
+    manifest = _current_manifest(title_id)
+    if manifest.exists():
         old_meta = get_metadata(title_id)
         if old_meta:
+            history = _history_dir(title_id)
+            history.mkdir(parents=True, exist_ok=True)
             ts = old_meta.last_sync.replace(":", "_").replace("+", "_")
-            archive_dir = history / ts
-            archive_dir.mkdir(parents=True, exist_ok=True)
-            for item in current.iterdir():
-                if item.is_file():
-                    shutil.copy2(item, archive_dir / item.name)
+            archived = history / f"{ts}.json"
+            if archived.exists():
+                _release_manifest(archived)
+            os.replace(manifest, archived)
 
             # Prune old history
             _prune_history(title_id)
+            _schedule_compaction(title_id)
+        else:
+            _release_manifest(manifest)
 
-        # Clear current directory
-        shutil.rmtree(current)
-
-    # Write new save files
-    current.mkdir(parents=True, exist_ok=True)
-    for f in bundle.files:
-        file_path = current / f.path
-        file_path.parent.mkdir(parents=True, exist_ok=True)
-        file_path.write_bytes(f.data)
-
-    # Compute bundle hash
-    all_data = b"".join(f.data for f in bundle.files)
-    bundle_hash = hashlib.sha256(all_data).hexdigest()
+    _write_manifest(manifest, entries)
 
     # Write metadata
     now = datetime.now(timezone.utc).isoformat()
@@ -107,26 +445,227 @@ def store_save(bundle: SaveBundle, source: str = "3ds", console_id: str = "") ->
         name=title_id,  # no game name available from bundle alone
         last_sync=now,
         last_sync_source=source,
-        save_hash=bundle_hash,
-        save_size=bundle.total_size,
-        file_count=len(bundle.files),
-        client_timestamp=bundle.timestamp,
+        save_hash=block_list["save_hash"],
+        save_size=sum(e["size"] for e in entries),
+        file_count=len(entries),
+        client_timestamp=client_timestamp,
         server_timestamp=now,
         console_id=console_id,
     )
 
-    meta_path = _metadata_path(title_id)
-    meta_path.write_text(json.dumps(meta.to_dict(), indent=2), encoding="utf-8")
+    _write_metadata(meta)
 
+    # Block hashes for delta sync
+    _write_block_list(title_id, block_list)
     return meta
 
 
+class SaveWriter(BundleSink):
+    """Streams files decoded by a BundleParser straight into the blob store.
+
+    Contents already stored are just referenced; new ones go to a temp file
+    that is moved into place once the parser has verified its hash. Block
+    hashes for delta sync are computed on the way. commit() makes the files
+    the title's current save; abort() drops them.
+    """
+
+    def __init__(self, title_id: str):
+        self.title_id = title_id
+        self._block_size = settings.delta_block_size
+        self._held: list[str] = []  # blob references taken so far
+        self._entries: list[dict] = []
+        self._blocks: list[dict] = []
+        self._tmp_path: Path | None = None
+        self._fh = None
+        self._block_buf = bytearray()
+        self._block_hashes: list[str] = []
+
+    def begin_file(self, f: BundleFile) -> None:
+        self._block_buf = bytearray()
+        self._block_hashes = []
+        sha256 = f.sha256.hex()
+        if _ref_blob(sha256):
+            self._held.append(sha256)
+            return
+        tmp_dir = settings.save_dir / "blobs" / "tmp"
+        tmp_dir.mkdir(parents=True, exist_ok=True)
+        self._tmp_path = tmp_dir / uuid.uuid4().hex
+        self._fh = open(self._tmp_path, "wb")
+
+    def write(self, data: memoryview) -> None:
+        if self._fh is not None:
+            self._fh.write(data)
+
+        buf, size = self._block_buf, self._block_size
+        if buf:
+            fill = size - len(buf)
+            buf += data[:fill]
+            data = data[fill:]
+            if len(buf) < size:
+                return
+            self._block_hashes.append(hashlib.sha256(buf).hexdigest())
+            buf.clear()
+        while len(data) >= size:
+            self._block_hashes.append(hashlib.sha256(data[:size]).hexdigest())
+            data = data[size:]
+        buf += data
+
+    def end_file(self, f: BundleFile) -> None:
+        if self._block_buf:
+            self._block_hashes.append(hashlib.sha256(self._block_buf).hexdigest())
+        sha256 = f.sha256.hex()
+        if self._fh is not None:
+            self._fh.close()
+            self._fh = None
+            _install_blob(sha256, self._tmp_path)
+            self._tmp_path = None
+            self._held.append(sha256)
+        self._entries.append({"path": f.path, "size": f.size, "sha256": sha256})
+        self._blocks.append({"path": f.path, "size": f.size, "blocks": self._block_hashes})
+
+    def commit(
+        self, bundle: SaveBundle, save_hash: str, source: str = "3ds", console_id: str = ""
+    ) -> SaveMetadata:
+        """Store the parsed bundle (its files already written) as the current save."""
+        block_list = {
+            "save_hash": save_hash,
+            "block_size": self._block_size,
+            "files": self._blocks,
+        }
+        with title_lock(self.title_id):
+            meta = _commit_version(
+                self.title_id, self._entries, block_list, bundle.timestamp, source, console_id
+            )
+        self._held = []  # Owned by the manifest now
+        # The files were never held whole, so the download bundle is built
+        # from the blob store off the request
+        _schedule_bundle(self.title_id, save_hash)
+        return meta
+
+    def abort(self) -> None:
+        """Discard everything written for an upload that won't be stored."""
+        if self._fh is not None:
+            self._fh.close()
+            self._fh = None
+        if self._tmp_path is not None:
+            self._tmp_path.unlink(missing_ok=True)
+            self._tmp_path = None
+        _drop_refs(self._held)
+        self._held = []
+
+
+def _write_bundle(
+    title_id: str, save_hash: str, bundle: SaveBundle, version: int = BUNDLE_VERSION_COMPRESSED
+) -> Path:
+    """Write a bundle and prune older ones. Call with title_lock held."""
+    bundles = _bundles_dir(title_id, version)
+    bundles.mkdir(parents=True, exist_ok=True)
+    path = bundles / f"{save_hash}.bin"
+    tmp_path = bundles / f"{uuid.uuid4().hex}.tmp"
+    if version == BUNDLE_VERSION_CODECS:
+        # Built once and downloaded many times: worth the slower level
+        data = create_codec_bundle(bundle, level=LEVEL_HIGH)
+    else:
+        data = create_bundle(bundle)
+    tmp_path.write_bytes(data)
+    os.replace(tmp_path, path)
+
+    # Keep the previous bundle too: a download may have just picked it
+    cached = sorted(bundles.glob("*.bin"), key=lambda p: p.stat().st_mtime)
+    for old in cached[:-2]:
+        old.unlink(missing_ok=True)
+    return path
+
+
+def get_bundle_path(title_id: str, version: int = BUNDLE_VERSION_COMPRESSED) -> Path | None:
+    """Path of the compressed bundle of a title's current save, or None.
+
+    The v2 bundle every client reads is built once per upload; saves stored
+    before bundles were cached get theirs built on first request, as does
+    the v3 bundle (per-file codecs, for random access) of any save.
+    """
+    meta = get_metadata(title_id)
+    if meta is None:
+        return None
+    path = _bundles_dir(title_id, version) / f"{meta.save_hash}.bin"
+    if path.exists():
+        return path
+
+    # Two first downloads can race here; one builds, the other finds it built
+    with title_lock(title_id):
+        meta = get_metadata(title_id)
+        if meta is None:
+            return None
+        path = _bundles_dir(title_id, version) / f"{meta.save_hash}.bin"
+        if path.exists():
+            return path
+
+        files = load_save_files(title_id)
+        if files is None:
+            return None
+        bundle = SaveBundle(
+            title_id=int(title_id, 16),
+            timestamp=meta.client_timestamp,
+            files=[
+                BundleFile(path=p, size=len(d), sha256=hashlib.sha256(d).digest(), data=d)
+                for p, d in files
+            ],
+        )
+        return _write_bundle(title_id, meta.save_hash, bundle, version)
+
+
+def _write_block_list(title_id: str, block_list: dict) -> None:
+    blocks = _blocks_dir(title_id)
+    blocks.mkdir(parents=True, exist_ok=True)
+    path = blocks / f"{block_list['save_hash']}.json"
+    path.write_text(json.dumps(block_list), encoding="utf-8")
+    _prune_block_lists(title_id)
+
+
+def get_block_list(title_id: str, save_hash: str | None = None) -> dict | None:
+    """Block hashes of a save version (default: current), or None if unknown.
+
+    Older versions are kept for as long as their history entries, so a
+    client holding one of them can download just the changed blocks.
+    """
+    meta = get_metadata(title_id)
+    if meta is None:
+        return None
+    if save_hash is None:
+        save_hash = meta.save_hash
+    save_hash = save_hash.lower()
+    if len(save_hash) != 64 or not all(c in "0123456789abcdef" for c in save_hash):
+        return None
+
+    path = _blocks_dir(title_id) / f"{save_hash}.json"
+    if path.exists():
+        return json.loads(path.read_text(encoding="utf-8"))
+
+    # Saves stored before delta sync existed - build the current list lazily
+    if save_hash != meta.save_hash:
+        return None
+    files = load_save_files(title_id)
+    if files is None:
+        return None
+    block_list = build_block_list(save_hash, settings.delta_block_size, files)
+    _write_block_list(title_id, block_list)
+    return block_list
+
+
 def load_save_files(title_id: str) -> list[tuple[str, bytes]] | None:
     """Load all save files for a title. Returns list of (path, data) or None."""
-    current = _current_dir(title_id)
-    if not current.exists():
-        return None
+    manifest = _current_manifest(title_id)
+    if not manifest.exists():
+        current = _current_dir(title_id)
+        return _load_legacy_files(current) if current.is_dir() else None
 
+    files = []
+    for f in sorted(_read_manifest(manifest), key=lambda f: f["path"]):
+        files.append((f["path"], _blob_path(f["sha256"]).read_bytes()))
+    return files
+
+
+def _load_legacy_files(current: Path) -> list[tuple[str, bytes]]:
     files = []
     for file_path in sorted(current.rglob("*")):
         if file_path.is_file():
@@ -144,4 +683,214 @@ def _prune_history(title_id: str) -> None:
     versions = sorted(history.iterdir(), key=lambda p: p.name)
     while len(versions) > settings.max_history_versions:
         oldest = versions.pop(0)
-        shutil.rmtree(oldest)
+        if oldest.is_dir():
+            shutil.rmtree(oldest)  # Pre-blob-store version
+        else:
+            _release_manifest(oldest)
+
+
+def _prune_block_lists(title_id: str) -> None:
+    """Keep block lists for the current version plus retained history."""
+    blocks = _blocks_dir(title_id)
+    if not blocks.exists():
+        return
+
+    lists = sorted(blocks.iterdir(), key=lambda p: p.stat().st_mtime)
+    while len(lists) > settings.max_history_versions + 1:
+        lists.pop(0).unlink()
+
+
+# --- History ---
+
+
+class _StoredFile:
+    """One file of a history version, read or rebuilt from its delta on first use."""
+
+    def __init__(self, entry: dict, newer: _StoredFile | None):
+        self.entry = entry
+        self._newer = newer if "delta" in entry else None
+        # Deltas between this file and a whole copy of it
+        self.depth = self._newer.depth + 1 if self._newer else 0
+        self._data: bytes | None = None
+
+    def data(self) -> bytes:
+        if self._data is None:
+            if "delta" not in self.entry:
+                self._data = _blob_path(self.entry["sha256"]).read_bytes()
+            elif self._newer is None:
+                raise DeltaError(f"No base version for {self.entry['path']}")
+            else:
+                delta = _blob_path(self.entry["delta"]).read_bytes()
+                self._data = apply_file_delta(delta, self._newer.data())
+            self._newer = None
+        return self._data
+
+
+def _history_versions(title_id: str) -> list[Path]:
+    """History entries, newest first."""
+    history = _history_dir(title_id)
+    if not history.is_dir():
+        return []
+    return sorted(
+        (p for p in history.iterdir() if p.suffix == ".json" or p.is_dir()),
+        key=lambda p: p.name,
+        reverse=True,
+    )
+
+
+def _walk_history(title_id: str):
+    """Yield (manifest, files, newer files) per history version, newest first.
+
+    files maps each path to a _StoredFile whose deltas resolve through the
+    newer versions. A caller may replace entries of files before moving on.
+    Caller holds the title lock.
+    """
+    newer: dict[str, _StoredFile] = {}
+    current = _current_manifest(title_id)
+    if current.exists():
+        newer = {e["path"]: _StoredFile(e, None) for e in _read_manifest(current)}
+    for version in _history_versions(title_id):
+        if version.is_dir():
+            newer = {}  # Pre-blob-store version, never a delta base
+            continue
+        files = {e["path"]: _StoredFile(e, newer.get(e["path"])) for e in _read_manifest(version)}
+        yield version, files, newer
+        newer = files
+
+
+def _only_ref(sha256: str) -> bool:
+    with _blob_lock:
+        return _blob_refs().get(sha256, 0) == 1
+
+
+def _schedule_bundle(title_id: str, save_hash: str) -> None:
+    """Build the v2 bundle of a just-stored save on the worker pool."""
+    workers.submit(_bundle_job, title_id, save_hash, settings.save_dir)
+
+
+def _bundle_job(title_id: str, save_hash: str, save_dir: Path) -> None:
+    if settings.save_dir != save_dir:  # Storage moved since it was queued
+        return
+    meta = get_metadata(title_id)
+    if meta is not None and meta.save_hash == save_hash:  # Not replaced meanwhile
+        get_bundle_path(title_id)
+
+
+def _schedule_compaction(title_id: str) -> None:
+    """Compact a title's history on the worker pool once the caller is done."""
+    if settings.history_compaction:
+        workers.submit(_compact_job, title_id, settings.save_dir)
+
+
+def _compact_job(title_id: str, save_dir: Path) -> None:
+    if settings.save_dir == save_dir:  # Unless storage moved since it was queued
+        compact_history(title_id)
+
+
+def compact_history(title_id: str) -> int:
+    """Delta-encode a title's history and keep chains bounded by snapshots.
+
+    A whole file that only this version refers to becomes a delta against
+    its next newer version when that is smaller and keeps the chain within
+    history_snapshot_interval; a delta whose chain has grown past it (newer
+    versions were added in front) is made whole again. Returns the number
+    of files rewritten.
+    """
+    interval = max(settings.history_snapshot_interval, 1)
+    rewritten = 0
+    with title_lock(title_id):
+        for version, files, newer in _walk_history(title_id):
+            dropped: list[str] = []
+            for path, stored in files.items():
+                entry = stored.entry
+                base = newer.get(path)
+                if "delta" in entry:
+                    if stored.depth <= interval:
+                        continue
+                    # Too far from a whole copy: this version becomes a snapshot
+                    data = stored.data()
+                    _add_blob(entry["sha256"], data)
+                    dropped.append(entry["delta"])
+                    new_entry = {k: v for k, v in entry.items() if k != "delta"}
+                else:
+                    if (
+                        base is None
+                        or base.entry["sha256"] == entry["sha256"]
+                        or base.depth + 1 > interval
+                        or not _only_ref(entry["sha256"])
+                    ):
+                        continue
+                    data = stored.data()
+                    delta = create_file_delta(data, base.data(), settings.delta_block_size)
+                    if len(delta) >= len(data):
+                        continue
+                    delta_sha = hashlib.sha256(delta).hexdigest()
+                    _add_blob(delta_sha, delta)
+                    dropped.append(entry["sha256"])
+                    new_entry = {**entry, "delta": delta_sha}
+
+                replaced = _StoredFile(new_entry, base)
+                replaced._data = data
+                files[path] = replaced
+
+            if dropped:
+                _write_manifest(version, [f.entry for f in files.values()])
+                _drop_refs(dropped)
+                rewritten += len(dropped)
+    return rewritten
+
+
+def list_history(title_id: str) -> list[dict]:
+    """Stored previous versions of a title, newest first.
+
+    Held under the title lock: compaction and pruning rewrite and remove
+    the manifests this reads.
+    """
+    versions = []
+    with title_lock(title_id):
+        for path in _history_versions(title_id):
+            if path.is_dir():
+                continue
+            entries = _read_manifest(path)
+            versions.append(
+                {
+                    "version": path.stem,
+                    "size": sum(e["size"] for e in entries),
+                    "file_count": len(entries),
+                    "delta_files": sum("delta" in e for e in entries),
+                }
+            )
+    return versions
+
+
+def load_history_files(title_id: str, version: str) -> list[tuple[str, bytes]] | None:
+    """Rebuild the files of a history version. Returns list of (path, data) or None."""
+    with title_lock(title_id):
+        legacy = _history_dir(title_id) / version
+        if legacy.is_dir():
+            return _load_legacy_files(legacy)
+        for path, files, _ in _walk_history(title_id):
+            if path.stem == version:
+                return [(p, f.data()) for p, f in sorted(files.items())]
+    return None
+
+
+def restore_history(title_id: str, version: str, console_id: str = "") -> SaveMetadata | None:
+    """Make a history version the current save again, or None if it doesn't exist.
+
+    The restored save is stored as a new upload, timestamped now, so every
+    console sees it as the newest version; the replaced save goes to history.
+    """
+    with title_lock(title_id):
+        files = load_history_files(title_id, version)
+        if files is None:
+            return None
+        bundle = SaveBundle(
+            title_id=int(title_id, 16),
+            timestamp=int(time.time()),
+            files=[
+                BundleFile(path=p, size=len(d), sha256=hashlib.sha256(d).digest(), data=d)
+                for p, d in files
+            ],
+        )
+        return _store_save(bundle, "restore", console_id)
@@ -0,0 +1,108 @@
+"""Binary variant of the /sync exchange (Content-Type: application/octet-stream).
+
+Request format:
+  [4B]  Magic: "3DSY"
+  [4B]  Version: 1 (uint32 LE)
+  [16B] Console ID (ASCII, NUL padded)
+  [4B]  Title count (uint32 LE)
+  -- For each title (80 bytes): --
+    [8B]  Title ID (uint64 BE)
+    [32B] Current save hash (SHA-256)
+    [32B] Last synced hash (all zero = never synced)
+    [4B]  Save size (uint32 LE)
+    [4B]  Timestamp - unix epoch (uint32 LE)
+
+Response format:
+  [4B]  Magic: "3DSP"
+  [4B]  Version: 1 (uint32 LE)
+  [4B]  Entry count (uint32 LE)
+  -- For each entry (9 bytes): --
+    [8B]  Title ID (uint64 BE)
+    [1B]  Action (see ACTION_*)
+"""
+
+from __future__ import annotations
+
+import struct
+
+from app.models.save import SyncPlan, SyncRequest, TitleSyncInfo
+
+SYNC_REQUEST_MAGIC = b"3DSY"
+SYNC_PLAN_MAGIC = b"3DSP"
+SYNC_BINARY_VERSION = 1
+
+ACTION_UPLOAD = 0
+ACTION_DOWNLOAD = 1
+ACTION_CONFLICT = 2
+ACTION_UP_TO_DATE = 3
+ACTION_SERVER_ONLY = 4
+
+_HEADER = struct.Struct("<4sI16sI")
+_TITLE = struct.Struct(">Q32s32s")
+_TITLE_TAIL = struct.Struct("<II")
+_TITLE_SIZE = _TITLE.size + _TITLE_TAIL.size
+_NO_HASH = b"\x00" * 32
+
+
+class SyncBinaryError(Exception):
+    pass
+
+
+def parse_sync_request(data: bytes) -> SyncRequest:
+    """Parse a binary sync request into the same model as the JSON variant."""
+    if len(data) < _HEADER.size:
+        raise SyncBinaryError("Request too small for header")
+
+    magic, version, console_raw, count = _HEADER.unpack_from(data, 0)
+    if magic != SYNC_REQUEST_MAGIC:
+        raise SyncBinaryError(f"Invalid magic: {magic!r}")
+    if version != SYNC_BINARY_VERSION:
+        raise SyncBinaryError(f"Unsupported version: {version}")
+
+    expected = _HEADER.size + count * _TITLE_SIZE
+    if len(data) != expected:
+        raise SyncBinaryError(f"Size mismatch: expected {expected}, got {len(data)}")
+
+    try:
+        console_id = console_raw.rstrip(b"\x00").decode("ascii") or None
+    except UnicodeDecodeError:
+        raise SyncBinaryError("Console ID is not ASCII")
+
+    titles: list[TitleSyncInfo] = []
+    offset = _HEADER.size
+    for _ in range(count):
+        title_id, save_hash, last_synced = _TITLE.unpack_from(data, offset)
+        size, timestamp = _TITLE_TAIL.unpack_from(data, offset + _TITLE.size)
+        offset += _TITLE_SIZE
+        titles.append(
+            TitleSyncInfo(
+                title_id=f"{title_id:016X}",
+                save_hash=save_hash.hex(),
+                timestamp=timestamp,
+                size=size,
+                last_synced_hash=None if last_synced == _NO_HASH else last_synced.hex(),
+            )
+        )
+
+    return SyncRequest(titles=titles, console_id=console_id)
+
+
+def encode_sync_plan(plan: SyncPlan) -> bytes:
+    """Serialize a sync plan as per-title action codes (conflict details omitted)."""
+    entries = [
+        (plan.upload, ACTION_UPLOAD),
+        (plan.download, ACTION_DOWNLOAD),
+        (plan.conflict, ACTION_CONFLICT),
+        (plan.up_to_date, ACTION_UP_TO_DATE),
+        (plan.server_only, ACTION_SERVER_ONLY),
+    ]
+
+    records: list[bytes] = []
+    for ids, action in entries:
+        for title_id in ids:
+            try:
+                records.append(struct.pack(">QB", int(title_id, 16), action))
+            except (ValueError, struct.error):
+                continue  # Not a 64-bit hex ID - can't be a client title
+    header = SYNC_PLAN_MAGIC + struct.pack("<II", SYNC_BINARY_VERSION, len(records))
+    return header + b"".join(records)
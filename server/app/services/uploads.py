@@ -0,0 +1,133 @@
+"""Chunked upload sessions for bundles too large for a single request.
+
+A client starts a session with the total bundle size, sends fixed-size
+parts (each one can be retried on its own), then commits. Sessions are
+stored as:
+  saves/.uploads/<upload_id>/
+    session.json
+    <index>.part
+"""
+
+from __future__ import annotations
+
+import json
+import secrets
+import shutil
+import time
+from collections.abc import Iterator
+from pathlib import Path
+
+from app.config import settings
+
+
+class UploadError(Exception):
+    pass
+
+
+def _uploads_dir() -> Path:
+    return settings.save_dir / ".uploads"
+
+
+def _session_dir(upload_id: str) -> Path:
+    return _uploads_dir() / upload_id
+
+
+def _part_count(size: int, part_size: int) -> int:
+    return (size + part_size - 1) // part_size
+
+
+def _expire_sessions() -> None:
+    """Remove sessions older than the configured TTL."""
+    uploads = _uploads_dir()
+    if not uploads.exists():
+        return
+
+    cutoff = time.time() - settings.upload_session_ttl
+    for entry in uploads.iterdir():
+        session_path = entry / "session.json"
+        try:
+            created = json.loads(session_path.read_text(encoding="utf-8"))["created"]
+        except (OSError, ValueError, KeyError):
+            created = 0
+        if created < cutoff:
+            shutil.rmtree(entry, ignore_errors=True)
+
+
+def create_session(title_id: str, size: int) -> dict:
+    """Start a new upload session for a bundle of the given size."""
+    if size <= 0:
+        raise UploadError("Upload size must be positive")
+    if size > settings.max_upload_size:
+        raise UploadError(f"Upload too large: {size} > {settings.max_upload_size}")
+
+    _expire_sessions()
+
+    upload_id = secrets.token_hex(16)
+    session = {
+        "upload_id": upload_id,
+        "title_id": title_id,
+        "size": size,
+        "part_size": settings.upload_part_size,
+        "parts": _part_count(size, settings.upload_part_size),
+        "created": int(time.time()),
+    }
+
+    session_dir = _session_dir(upload_id)
+    session_dir.mkdir(parents=True)
+    (session_dir / "session.json").write_text(json.dumps(session), encoding="utf-8")
+    return session
+
+
+def get_session(title_id: str, upload_id: str) -> dict | None:
+    """Load a session, or None if it doesn't exist or belongs to another title."""
+    path = _session_dir(upload_id) / "session.json"
+    if not path.exists():
+        return None
+
+    session = json.loads(path.read_text(encoding="utf-8"))
+    if session["title_id"] != title_id:
+        return None
+    return session
+
+
+def received_parts(session: dict) -> list[int]:
+    """Indices of the parts stored so far."""
+    session_dir = _session_dir(session["upload_id"])
+    return [i for i in range(session["parts"]) if (session_dir / f"{i}.part").exists()]
+
+
+def store_part(session: dict, index: int, data: bytes) -> None:
+    """Store one part. Re-sending a part overwrites it."""
+    if index < 0 or index >= session["parts"]:
+        raise UploadError(f"Part index out of range: {index}")
+
+    part_size = session["part_size"]
+    if index == session["parts"] - 1:
+        expected = session["size"] - part_size * index
+    else:
+        expected = part_size
+    if len(data) != expected:
+        raise UploadError(f"Part {index} size mismatch: expected {expected}, got {len(data)}")
+
+    # Write then rename so an interrupted request never leaves a short part
+    session_dir = _session_dir(session["upload_id"])
+    tmp_path = session_dir / f"{index}.tmp"
+    tmp_path.write_bytes(data)
+    tmp_path.replace(session_dir / f"{index}.part")
+
+
+def check_complete(session: dict) -> None:
+    """Raise UploadError if any parts are missing."""
+    missing = session["parts"] - len(received_parts(session))
+    if missing:
+        raise UploadError(f"Upload incomplete: {missing} part(s) missing")
+
+
+def iter_parts(session: dict) -> Iterator[bytes]:
+    """Yield the parts in order, one at a time."""
+    session_dir = _session_dir(session["upload_id"])
+    for i in range(session["parts"]):
+        yield (session_dir / f"{i}.part").read_bytes()
+
+def delete_session(upload_id: str) -> None:
+    shutil.rmtree(_session_dir(upload_id), ignore_errors=True)
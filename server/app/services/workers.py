@@ -0,0 +1,50 @@
+"""Bounded worker pool for blocking storage and bundle work.
+
+The routes are async, so file I/O, hashing and zlib run here rather than on
+the event loop, where one large upload or history prune would stall every
+other console's requests. The pool size caps how much disk work runs at once.
+"""
+
+from __future__ import annotations
+
+import asyncio
+import functools
+import threading
+from concurrent.futures import Future, ThreadPoolExecutor
+from typing import Callable, TypeVar
+
+from app.config import settings
+
+T = TypeVar("T")
+
+_pool_lock = threading.Lock()
+_pool: ThreadPoolExecutor | None = None
+
+
+def _executor() -> ThreadPoolExecutor:
+    global _pool
+    with _pool_lock:
+        if _pool is None:
+            _pool = ThreadPoolExecutor(
+                max_workers=settings.storage_workers, thread_name_prefix="storage"
+            )
+        return _pool
+
+
+async def run(func: Callable[..., T], *args, **kwargs) -> T:
+    """Run func(*args, **kwargs) on the worker pool and await its result."""
+    loop = asyncio.get_running_loop()
+    return await loop.run_in_executor(_executor(), functools.partial(func, *args, **kwargs))
+
+
+def submit(func: Callable[..., T], *args, **kwargs) -> Future:
+    """Queue background work on the pool without waiting for it."""
+    return _executor().submit(func, *args, **kwargs)
+
+
+def shutdown() -> None:
+    global _pool
+    with _pool_lock:
+        if _pool is not None:
+            _pool.shutdown(wait=True)
+            _pool = None
@@ -10,12 +10,17 @@ from app.config import settings
 
 @pytest.fixture(autouse=True)
 def tmp_save_dir(tmp_path):
-    """Use a temporary directory for saves during tests."""
-    original = settings.save_dir
+    """Use a temporary directory for saves during tests.
+
+    Background history compaction is off so tests see the blobs they wrote;
+    the history tests run it explicitly.
+    """
+    original = settings.save_dir, settings.history_compaction
     settings.save_dir = tmp_path / "saves"
     settings.save_dir.mkdir()
+    settings.history_compaction = False
     yield settings.save_dir
-    settings.save_dir = original
+    settings.save_dir, settings.history_compaction = original
 
 
 @pytest.fixture()
@@ -35,3 +40,19 @@ def api_key():
 @pytest.fixture()
 def auth_headers(api_key):
     return {"X-API-Key": api_key}
+
+
+@pytest.fixture()
+def upload_save(client, auth_headers):
+    """POST a save bundle to /saves/{title_id}; returns the response JSON."""
+
+    def upload(title_id: str, bundle: bytes) -> dict:
+        r = client.post(
+            f"/api/v1/saves/{title_id}",
+            content=bundle,
+            headers={**auth_headers, "Content-Type": "application/octet-stream"},
+        )
+        assert r.status_code == 200
+        return r.json()
+
+    return upload
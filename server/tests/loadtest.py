@@ -0,0 +1,523 @@
+"""Load test: many consoles syncing against one server at once.
+
+Synthesizes N consoles with M titles each (a share of them installed on
+every console, the rest unique) and runs rounds of the client's sync flow
+concurrently: each console changes some of its saves, posts a binary /sync,
+then uploads, downloads and resolves conflicts from the plan with a few
+transfers in flight, like the 3DS client's transfer window.
+
+Reports per-operation p50/p99 latency, request and byte throughput, disk
+I/O of the server process, and checks afterwards that every stored save is
+intact and history was pruned to max_history_versions.
+
+Everything is seeded, so two runs with the same options do the same work
+and their numbers can be compared across server changes:
+
+    uv run python -m tests.loadtest --json before.json
+    # ... change the server ...
+    uv run python -m tests.loadtest --baseline before.json
+
+By default a server is started in-process on a temporary save directory;
+--server points it at a running one instead (disk I/O is then not measured).
+"""
+
+from __future__ import annotations
+
+import argparse
+import asyncio
+import hashlib
+import json
+import random
+import shutil
+import socket
+import statistics
+import struct
+import sys
+import tempfile
+import threading
+import time
+from dataclasses import dataclass, field
+from pathlib import Path
+
+import httpx
+
+from app.config import settings
+from app.models.save import BundleFile, SaveBundle
+from app.services.bundle import create_bundle, parse_bundle
+from app.services.sync_binary import (
+    ACTION_CONFLICT,
+    ACTION_DOWNLOAD,
+    ACTION_UPLOAD,
+    SYNC_BINARY_VERSION,
+    SYNC_PLAN_MAGIC,
+    SYNC_REQUEST_MAGIC,
+)
+
+OPERATIONS = ("sync", "upload", "download")
+
+# Save shapes (weight, file sizes): small multi-file 3DS saves, DS flash
+# images and the odd large 3DS save
+_SAVE_SHAPES = [
+    (6, [8 * 1024, 8 * 1024, 32 * 1024, 2 * 1024]),
+    (3, [512 * 1024]),
+    (1, [1024 * 1024, 64 * 1024]),
+]
+
+
+@dataclass
+class LoadConfig:
+    consoles: int = 8
+    titles: int = 20
+    shared: float = 0.25  # Fraction of each console's titles that every console has
+    rounds: int = 5
+    change: float = 0.3  # Chance a title's save changes between rounds
+    window: int = 2  # Transfers in flight per console
+    seed: int = 1
+
+
+@dataclass
+class Title:
+    title_id: int
+    files: list[tuple[str, bytes]]
+    last_synced: str | None = None
+
+    @property
+    def save_hash(self) -> str:
+        h = hashlib.sha256()
+        for _, data in self.files:
+            h.update(data)
+        return h.hexdigest()
+
+    @property
+    def size(self) -> int:
+        return sum(len(data) for _, data in self.files)
+
+
+@dataclass
+class Console:
+    console_id: str
+    rng: random.Random
+    titles: dict[int, Title]
+
+
+@dataclass
+class Stats:
+    latency: dict[str, list[float]] = field(default_factory=lambda: {op: [] for op in OPERATIONS})
+    sent: int = 0
+    received: int = 0
+    errors: int = 0
+    rejected: int = 0  # 409s from two consoles racing on a shared title
+    conflicts: int = 0
+
+    def record(self, op: str, start: float) -> None:
+        self.latency[op].append(time.perf_counter() - start)
+
+
+class _Clock:
+    """Bundle timestamps that only move forward, so uploads order cleanly."""
+
+    def __init__(self) -> None:
+        self._now = 1700000000
+
+    def next(self) -> int:
+        self._now += 1
+        return self._now
+
+
+def _save_data(rng: random.Random, size: int) -> bytes:
+    """Save-like content: high-entropy records separated by zero padding."""
+    out = bytearray(size)
+    pos = 0
+    while pos < size:
+        run = rng.randint(16, 512)
+        out[pos:pos + run] = rng.randbytes(min(run, size - pos))
+        pos += run + rng.randint(64, 2048)
+    return bytes(out)
+
+
+def build_consoles(config: LoadConfig) -> list[Console]:
+    rng = random.Random(config.seed)
+    shapes = [s for weight, s in _SAVE_SHAPES for _ in range(weight)]
+
+    def make_title(title_id: int, title_rng: random.Random) -> Title:
+        sizes = title_rng.choice(shapes)
+        files = [(f"data{i}.bin", _save_data(title_rng, size)) for i, size in enumerate(sizes)]
+        return Title(title_id, files)
+
+    shared_count = round(config.titles * config.shared)
+    shared_ids = [0x0004000000100000 + i * 0x100 for i in range(shared_count)]
+
+    consoles = []
+    for c in range(config.consoles):
+        crng = random.Random(rng.getrandbits(64))
+        titles = {}
+        for tid in shared_ids:
+            titles[tid] = make_title(tid, random.Random(tid ^ config.seed))
+        for i in range(config.titles - shared_count):
+            tid = 0x0004000000200000 + (c * config.titles + i) * 0x100
+            titles[tid] = make_title(tid, crng)
+        consoles.append(Console(f"{crng.getrandbits(64):016x}", crng, titles))
+    return consoles
+
+
+def _make_bundle(title: Title, timestamp: int) -> bytes:
+    files = [
+        BundleFile(path, len(data), hashlib.sha256(data).digest(), data)
+        for path, data in title.files
+    ]
+    return create_bundle(SaveBundle(title.title_id, timestamp, files))
+
+
+def _sync_request(console: Console, timestamp: int) -> bytes:
+    parts = [
+        SYNC_REQUEST_MAGIC,
+        struct.pack("<I16sI", SYNC_BINARY_VERSION, console.console_id.encode(), len(console.titles)),
+    ]
+    for title in console.titles.values():
+        last = bytes.fromhex(title.last_synced) if title.last_synced else b"\x00" * 32
+        parts.append(struct.pack(">Q32s32s", title.title_id, bytes.fromhex(title.save_hash), last))
+        parts.append(struct.pack("<II", title.size, timestamp))
+    return b"".join(parts)
+
+
+def _parse_plan(data: bytes) -> list[tuple[int, int]]:
+    magic, version, count = struct.unpack_from("<4sII", data, 0)
+    if magic != SYNC_PLAN_MAGIC or version != SYNC_BINARY_VERSION:
+        raise ValueError("bad sync plan")
+    return [struct.unpack_from(">QB", data, 12 + i * 9) for i in range(count)]
+
+
+def _mutate(console: Console, title: Title) -> None:
+    path, data = console.rng.choice(title.files)
+    data = bytearray(data)
+    pos = console.rng.randrange(max(1, len(data) - 4096))
+    chunk = console.rng.randbytes(min(4096, len(data) - pos))
+    data[pos:pos + len(chunk)] = chunk
+    title.files = [(p, bytes(data) if p == path else d) for p, d in title.files]
+
+
+async def _upload(
+    http: httpx.AsyncClient, console: Console, title: Title, clock: _Clock, stats: Stats, force: bool
+) -> None:
+    body = _make_bundle(title, clock.next())
+    start = time.perf_counter()
+    r = await http.post(
+        f"/api/v1/saves/{title.title_id:016X}",
+        content=body,
+        params={"force": "true"} if force else None,
+        headers={"Content-Type": "application/octet-stream", "X-Console-ID": console.console_id},
+    )
+    stats.record("upload", start)
+    stats.sent += len(body)
+    if r.status_code == 200:
+        title.last_synced = r.json()["sha256"]
+    elif r.status_code == 409:
+        stats.rejected += 1
+    else:
+        stats.errors += 1
+
+
+async def _download(http: httpx.AsyncClient, title: Title, stats: Stats) -> None:
+    start = time.perf_counter()
+    r = await http.get(f"/api/v1/saves/{title.title_id:016X}")
+    stats.record("download", start)
+    stats.received += len(r.content)
+    if r.status_code != 200:
+        stats.errors += 1
+        return
+    bundle = parse_bundle(r.content)
+    title.files = [(f.path, bytes(f.data)) for f in bundle.files]
+    if title.save_hash != r.headers.get("X-Save-Hash"):
+        stats.errors += 1
+    title.last_synced = title.save_hash
+
+
+async def _sync_console(
+    http: httpx.AsyncClient, console: Console, clock: _Clock, config: LoadConfig, stats: Stats
+) -> None:
+    for title in console.titles.values():
+        if title.last_synced is not None and console.rng.random() < config.change:
+            _mutate(console, title)
+
+    body = _sync_request(console, clock.next())
+    start = time.perf_counter()
+    r = await http.post(
+        "/api/v1/sync", content=body, headers={"Content-Type": "application/octet-stream"}
+    )
+    stats.record("sync", start)
+    stats.sent += len(body)
+    if r.status_code != 200:
+        stats.errors += 1
+        return
+
+    jobs = []
+    for title_id, action in _parse_plan(r.content):
+        title = console.titles.get(title_id)
+        if title is None:
+            continue  # Server-only: not installed on this console
+        if action == ACTION_UPLOAD:
+            jobs.append(_upload(http, console, title, clock, stats, force=False))
+        elif action == ACTION_DOWNLOAD:
+            jobs.append(_download(http, title, stats))
+        elif action == ACTION_CONFLICT:
+            # The user picks a side; keep local half the time
+            stats.conflicts += 1
+            if console.rng.random() < 0.5:
+                jobs.append(_upload(http, console, title, clock, stats, force=True))
+            else:
+                jobs.append(_download(http, title, stats))
+
+    window = asyncio.Semaphore(config.window)
+
+    async def run(job):
+        async with window:
+            await job
+
+    await asyncio.gather(*(run(job) for job in jobs))
+
+
+def _disk_io() -> tuple[int, int] | None:
+    """(read_bytes, write_bytes) of this process, or None off Linux."""
+    try:
+        fields = dict(
+            line.split(": ") for line in Path("/proc/self/io").read_text().splitlines()
+        )
+        return int(fields["read_bytes"]), int(fields["write_bytes"])
+    except (OSError, KeyError, ValueError):
+        return None
+
+
+def _percentile(values: list[float], pct: float) -> float:
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(len(ordered) * pct / 100))]
+
+
+async def _verify(http: httpx.AsyncClient, consoles: list[Console]) -> int:
+    """Check every stored save downloads with the hash the server reports."""
+    bad = 0
+    title_ids = {tid for console in consoles for tid in console.titles}
+    for tid in sorted(title_ids):
+        r = await http.get(f"/api/v1/saves/{tid:016X}")
+        if r.status_code == 404:
+            continue
+        if r.status_code != 200:
+            bad += 1
+            continue
+        h = hashlib.sha256()
+        for f in parse_bundle(r.content).files:
+            h.update(f.data)
+        if h.hexdigest() != r.headers.get("X-Save-Hash"):
+            bad += 1
+    return bad
+
+
+async def run_load(
+    config: LoadConfig,
+    base_url: str,
+    api_key: str,
+    transport: httpx.AsyncBaseTransport | None = None,
+    save_dir: Path | None = None,
+) -> dict:
+    """Run the workload and return the results (see format_results)."""
+    consoles = build_consoles(config)
+    clock = _Clock()
+    stats = Stats()
+    clients = [
+        httpx.AsyncClient(
+            base_url=base_url, transport=transport, timeout=60.0, headers={"X-API-Key": api_key}
+        )
+        for _ in consoles
+    ]
+
+    io_before = _disk_io() if save_dir is not None else None
+    start = time.perf_counter()
+    try:
+        for _ in range(config.rounds):
+            await asyncio.gather(
+                *(_sync_console(http, c, clock, config, stats) for http, c in zip(clients, consoles))
+            )
+        elapsed = time.perf_counter() - start
+        io_after = _disk_io() if io_before is not None else None
+        corrupt = await _verify(clients[0], consoles)
+        status = (await clients[0].get("/api/v1/status")).json()
+    finally:
+        for http in clients:
+            await http.aclose()
+
+    requests = sum(len(v) for v in stats.latency.values())
+    results = {
+        "config": config.__dict__,
+        "elapsed_s": elapsed,
+        "requests": requests,
+        "requests_per_s": requests / elapsed,
+        "sent_mb_per_s": stats.sent / elapsed / 1e6,
+        "received_mb_per_s": stats.received / elapsed / 1e6,
+        "operations": {
+            op: {
+                "count": len(values),
+                "p50_ms": _percentile(values, 50) * 1000,
+                "p99_ms": _percentile(values, 99) * 1000,
+                "max_ms": max(values, default=0.0) * 1000,
+                "mean_ms": statistics.fmean(values) * 1000 if values else 0.0,
+            }
+            for op, values in stats.latency.items()
+        },
+        "errors": stats.errors,
+        "rejected": stats.rejected,
+        "conflicts": stats.conflicts,
+        "corrupt_saves": corrupt,
+        "event_loop_lag_ms": status.get("event_loop_lag", {}),
+    }
+    if io_before is not None and io_after is not None:
+        results["disk_read_mb"] = (io_after[0] - io_before[0]) / 1e6
+        results["disk_write_mb"] = (io_after[1] - io_before[1]) / 1e6
+    if save_dir is not None:
+        results["disk_used_mb"] = sum(
+            p.stat().st_size for p in save_dir.rglob("*") if p.is_file()
+        ) / 1e6
+        results["max_history_versions"] = max(
+            (len(list(h.iterdir())) for h in save_dir.glob("*/history")), default=0
+        )
+    return results
+
+
+def format_results(results: dict, baseline: dict | None = None) -> str:
+    def delta(value: float, base: float | None) -> str:
+        if base is None or base == 0:
+            return ""
+        return f" ({(value - base) / base * 100:+.0f}%)"
+
+    def base_of(*keys) -> float | None:
+        node = baseline
+        for key in keys:
+            if not isinstance(node, dict) or key not in node:
+                return None
+            node = node[key]
+        return node
+
+    c = results["config"]
+    lines = [
+        f"{c['consoles']} consoles x {c['titles']} titles, {c['rounds']} rounds, "
+        f"window {c['window']}, seed {c['seed']}",
+        "",
+        f"{'operation':<10} {'count':>6} {'p50 ms':>16} {'p99 ms':>16} {'max ms':>10}",
+    ]
+    for op, o in results["operations"].items():
+        p50 = f"{o['p50_ms']:.1f}{delta(o['p50_ms'], base_of('operations', op, 'p50_ms'))}"
+        p99 = f"{o['p99_ms']:.1f}{delta(o['p99_ms'], base_of('operations', op, 'p99_ms'))}"
+        lines.append(f"{op:<10} {o['count']:>6} {p50:>16} {p99:>16} {o['max_ms']:>10.1f}")
+    lines += [
+        "",
+        f"throughput   {results['requests_per_s']:.1f} req/s"
+        f"{delta(results['requests_per_s'], base_of('requests_per_s'))}, "
+        f"{results['sent_mb_per_s']:.2f} MB/s up, {results['received_mb_per_s']:.2f} MB/s down",
+        f"elapsed      {results['elapsed_s']:.2f} s{delta(results['elapsed_s'], base_of('elapsed_s'))}",
+    ]
+    if "disk_write_mb" in results:
+        lines.append(
+            f"disk I/O     {results['disk_read_mb']:.1f} MB read, "
+            f"{results['disk_write_mb']:.1f} MB written"
+            f"{delta(results['disk_write_mb'], base_of('disk_write_mb'))}"
+        )
+    if "disk_used_mb" in results:
+        lines.append(
+            f"disk used    {results['disk_used_mb']:.1f} MB, max history "
+            f"{results['max_history_versions']} (limit {settings.max_history_versions})"
+        )
+    lag = results["event_loop_lag_ms"]
+    if lag:
+        lines.append(f"loop lag     p99 {lag.get('p99_ms', 0):.1f} ms, max {lag.get('max_ms', 0):.1f} ms")
+    lines.append(
+        f"errors       {results['errors']} failed, {results['corrupt_saves']} corrupt, "
+        f"{results['rejected']} rejected (409), {results['conflicts']} conflicts"
+    )
+    return "\n".join(lines)
+
+
+class _InProcessServer:
+    """The app under uvicorn on a free localhost port, in a background thread."""
+
+    def __init__(self, save_dir: Path):
+        import uvicorn
+
+        from app.main import create_app
+
+        settings.save_dir = save_dir
+        self._sock = socket.socket()
+        self._sock.bind(("127.0.0.1", 0))
+        self.url = f"http://127.0.0.1:{self._sock.getsockname()[1]}"
+        self._server = uvicorn.Server(
+            uvicorn.Config(create_app(), log_level="warning", access_log=False)
+        )
+        self._thread = threading.Thread(
+            target=self._server.run, kwargs={"sockets": [self._sock]}, daemon=True
+        )
+
+    def __enter__(self) -> _InProcessServer:
+        self._thread.start()
+        while not self._server.started:
+            if not self._thread.is_alive():
+                raise RuntimeError("server failed to start")
+            time.sleep(0.01)
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self._server.should_exit = True
+        self._thread.join()
+        self._sock.close()
+
+
+def main(argv: list[str] | None = None) -> int:
+    defaults = LoadConfig()
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--consoles", type=int, default=defaults.consoles)
+    parser.add_argument("--titles", type=int, default=defaults.titles, help="titles per console")
+    parser.add_argument("--shared", type=float, default=defaults.shared,
+                        help="fraction of titles installed on every console")
+    parser.add_argument("--rounds", type=int, default=defaults.rounds)
+    parser.add_argument("--change", type=float, default=defaults.change,
+                        help="chance a save changes between rounds")
+    parser.add_argument("--window", type=int, default=defaults.window,
+                        help="transfers in flight per console")
+    parser.add_argument("--seed", type=int, default=defaults.seed)
+    parser.add_argument("--server", help="URL of a running server (default: start one)")
+    parser.add_argument("--max-history", type=int,
+                        help="history versions the in-process server keeps (exercises pruning)")
+    parser.add_argument("--api-key", default=settings.api_key)
+    parser.add_argument("--json", type=Path, help="write the results here")
+    parser.add_argument("--baseline", type=Path, help="results JSON to compare against")
+    args = parser.parse_args(argv)
+
+    config = LoadConfig(
+        consoles=args.consoles,
+        titles=args.titles,
+        shared=args.shared,
+        rounds=args.rounds,
+        change=args.change,
+        window=args.window,
+        seed=args.seed,
+    )
+    baseline = json.loads(args.baseline.read_text()) if args.baseline else None
+
+    if args.server:
+        results = asyncio.run(run_load(config, args.server, args.api_key))
+    else:
+        if args.max_history is not None:
+            settings.max_history_versions = args.max_history
+        save_dir = Path(tempfile.mkdtemp(prefix="3dssync-load-"))
+        try:
+            with _InProcessServer(save_dir) as server:
+                results = asyncio.run(run_load(config, server.url, args.api_key, save_dir=save_dir))
+        finally:
+            shutil.rmtree(save_dir, ignore_errors=True)
+
+    print(format_results(results, baseline))
+    if args.json:
+        args.json.write_text(json.dumps(results, indent=2))
+    return 1 if results["errors"] or results["corrupt_saves"] else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,7 +1,15 @@
 import hashlib
+import struct
+import zlib
 
 from app.models.save import BundleFile, SaveBundle
 from app.services.bundle import create_bundle
+from app.services.meta_binary import (
+    ENTRY_SIZE,
+    META_BINARY_VERSION,
+    META_REQUEST_MAGIC,
+    META_RESPONSE_MAGIC,
+)
 
 
 def _make_bundle_bytes(
@@ -32,6 +40,7 @@ class TestStatusEndpoint:
         assert data["status"] == "ok"
         assert data["version"] == "1.0.0"
         assert data["save_count"] == 0
+        assert "max_ms" in data["event_loop_lag"]
 
 
 class TestAuthMiddleware:
@@ -68,6 +77,14 @@ class TestTitlesEndpoint:
         assert len(titles) == 1
         assert titles[0]["title_id"] == "0004000000055D00"
 
+    def test_names_include_db_version(self, client, auth_headers):
+        r = client.post("/api/v1/titles/names", json={"codes": ["ZZZZ"]}, headers=auth_headers)
+        assert r.status_code == 200
+        assert r.json()["names"] == {}
+
+        status = client.get("/api/v1/status").json()
+        assert r.json()["db_version"] == status["names_version"]
+
 
 class TestUploadEndpoint:
     def test_upload_success(self, client, auth_headers):
@@ -151,6 +168,122 @@ class TestUploadEndpoint:
         assert r.status_code == 200
 
 
+class TestChunkedUpload:
+    def _upload_parts(self, client, auth_headers, data, part_size):
+        r = client.post(
+            "/api/v1/saves/0004000000055D00/upload",
+            json={"size": len(data)},
+            headers=auth_headers,
+        )
+        assert r.status_code == 200
+        upload_id = r.json()["upload_id"]
+        assert r.json()["part_size"] == part_size
+
+        for i in range(0, len(data), part_size):
+            r = client.post(
+                f"/api/v1/saves/0004000000055D00/upload/{upload_id}/{i // part_size}",
+                content=data[i : i + part_size],
+                headers={**auth_headers, "Content-Type": "application/octet-stream"},
+            )
+            assert r.status_code == 200
+        return upload_id
+
+    def test_chunked_upload_roundtrip(self, client, auth_headers, monkeypatch):
+        from app.config import settings
+
+        monkeypatch.setattr(settings, "upload_part_size", 64)
+        save_data = bytes(range(256)) * 8
+        bundle = _make_bundle_bytes(files=[("main", save_data)])
+        upload_id = self._upload_parts(client, auth_headers, bundle, 64)
+
+        r = client.post(
+            f"/api/v1/saves/0004000000055D00/upload/{upload_id}/commit",
+            headers=auth_headers,
+        )
+        assert r.status_code == 200
+        assert r.json()["sha256"] == hashlib.sha256(save_data).hexdigest()
+
+        # Session is removed after commit
+        r = client.get(
+            f"/api/v1/saves/0004000000055D00/upload/{upload_id}",
+            headers=auth_headers,
+        )
+        assert r.status_code == 404
+
+    def test_part_retry_and_status(self, client, auth_headers, monkeypatch):
+        from app.config import settings
+
+        monkeypatch.setattr(settings, "upload_part_size", 64)
+        bundle = _make_bundle_bytes(files=[("main", bytes(range(256)) * 8)])
+        r = client.post(
+            "/api/v1/saves/0004000000055D00/upload",
+            json={"size": len(bundle)},
+            headers=auth_headers,
+        )
+        upload_id = r.json()["upload_id"]
+        part_url = f"/api/v1/saves/0004000000055D00/upload/{upload_id}/0"
+
+        # Sending the same part twice is fine
+        for _ in range(2):
+            r = client.post(part_url, content=bundle[:64], headers=auth_headers)
+            assert r.status_code == 200
+
+        r = client.get(
+            f"/api/v1/saves/0004000000055D00/upload/{upload_id}",
+            headers=auth_headers,
+        )
+        assert r.status_code == 200
+        assert r.json()["received"] == [0]
+
+        # Commit with parts missing is rejected
+        r = client.post(
+            f"/api/v1/saves/0004000000055D00/upload/{upload_id}/commit",
+            headers=auth_headers,
+        )
+        assert r.status_code == 400
+
+    def test_part_size_mismatch(self, client, auth_headers, monkeypatch):
+        from app.config import settings
+
+        monkeypatch.setattr(settings, "upload_part_size", 64)
+        r = client.post(
+            "/api/v1/saves/0004000000055D00/upload",
+            json={"size": 200},
+            headers=auth_headers,
+        )
+        upload_id = r.json()["upload_id"]
+        r = client.post(
+            f"/api/v1/saves/0004000000055D00/upload/{upload_id}/0",
+            content=b"short",
+            headers=auth_headers,
+        )
+        assert r.status_code == 400
+
+    def test_unknown_session(self, client, auth_headers):
+        r = client.post(
+            "/api/v1/saves/0004000000055D00/upload/not-a-session/0",
+            content=b"x",
+            headers=auth_headers,
+        )
+        assert r.status_code == 404
+        r = client.post(
+            "/api/v1/saves/0004000000055D00/upload/" + "0" * 32 + "/commit",
+            headers=auth_headers,
+        )
+        assert r.status_code == 404
+
+    def test_oversized_upload_rejected(self, client, auth_headers, monkeypatch):
+        from app.config import settings
+
+        monkeypatch.setattr(settings, "max_upload_size", 1024)
+        r = client.post(
+            "/api/v1/saves/0004000000055D00/upload",
+            json={"size": 2048},
+            headers=auth_headers,
+        )
+        assert r.status_code == 400
+
+
 class TestDownloadEndpoint:
     def test_download_not_found(self, client, auth_headers):
         r = client.get(
@@ -181,6 +314,72 @@ class TestDownloadEndpoint:
         assert len(downloaded.files) == 1
         assert downloaded.files[0].data == save_data
 
+    def test_download_v3_ranges(self, client, auth_headers):
+        """A single file can be restored from Range requests on a v3 bundle."""
+        import struct
+
+        from app.services.bundle import parse_bundle
+
+        files = [("main", b"A" * 4000), ("slot2", b"slot two data " * 100)]
+        client.post(
+            "/api/v1/saves/0004000000055D00",
+            content=_make_bundle_bytes(files=files),
+            headers={**auth_headers, "Content-Type": "application/octet-stream"},
+        )
+
+        url = "/api/v1/saves/0004000000055D00?format=3"
+        full = client.get(url, headers=auth_headers)
+        assert full.status_code == 200
+        assert full.headers["accept-ranges"] == "bytes"
+        assert int.from_bytes(full.content[4:8], "little") == 3
+        assert [f.data for f in parse_bundle(full.content).files] == [d for _, d in files]
+
+        # Header and table first, then just the second file's frame
+        head = client.get(url, headers={**auth_headers, "Range": "bytes=0-199"})
+        assert head.status_code == 206
+        assert head.headers["content-range"] == f"bytes 0-199/{len(full.content)}"
+        assert head.content == full.content[:200]
+        pos, offset = 28, 0
+        for path, data in files:
+            (path_len,) = struct.unpack_from("<H", head.content, pos)
+            pos += 2 + path_len + 4 + 32
+            codec, encoded = struct.unpack_from("<BI", head.content, pos)
+            pos += 5
+            if path != "slot2":
+                offset += encoded
+        start = pos + offset
+        part = client.get(
+            url,
+            headers={**auth_headers, "Range": f"bytes={start}-{start + encoded - 1}"},
+        )
+        assert part.status_code == 206
+        assert zlib.decompress(part.content) == files[1][1]
+
+    def test_download_range_errors(self, client, auth_headers):
+        client.post(
+            "/api/v1/saves/0004000000055D00",
+            content=_make_bundle_bytes(),
+            headers={**auth_headers, "Content-Type": "application/octet-stream"},
+        )
+        url = "/api/v1/saves/0004000000055D00"
+        size = len(client.get(url, headers=auth_headers).content)
+
+        r = client.get(url, headers={**auth_headers, "Range": f"bytes={size}-"})
+        assert r.status_code == 416
+        assert r.headers["content-range"] == f"bytes */{size}"
+
+        r = client.get(url, headers={**auth_headers, "Range": "bytes=-10"})
+        assert r.status_code == 206
+        assert len(r.content) == 10
+
+        # A Range for another version of the save is ignored
+        r = client.get(url, headers={**auth_headers, "Range": "bytes=0-9", "If-Range": '"old"'})
+        assert r.status_code == 200
+        assert len(r.content) == size
+
+        r = client.get(url + "?format=7", headers=auth_headers)
+        assert r.status_code == 400
+
     def test_upload_preserves_history(self, client, auth_headers, tmp_save_dir):
         # Upload v1
         bundle1 = _make_bundle_bytes(timestamp=1000, files=[("main", b"v1")])
@@ -229,3 +428,175 @@ class TestMetadataEndpoint:
         assert data["client_timestamp"] == 1700000000
         assert data["file_count"] == 1
         assert "save_hash" in data
+
+
+class TestBulkMetadataEndpoint:
+    def test_json_lookup(self, client, auth_headers, upload_save):
+        upload_save(
+            "0004000000055D00",
+            _make_bundle_bytes(title_id=0x0004000000055D00, files=[("main", b"one")]),
+        )
+        upload_save(
+            "0004000000030800",
+            _make_bundle_bytes(title_id=0x0004000000030800, files=[("main", b"two")]),
+        )
+
+        r = client.post(
+            "/api/v1/titles/meta",
+            json={"title_ids": ["0004000000055d00", "0004000000030800", "00040000000AAA00"]},
+            headers=auth_headers,
+        )
+        assert r.status_code == 200
+        data = r.json()
+        assert set(data["saves"]) == {"0004000000055D00", "0004000000030800"}
+        assert data["missing"] == ["00040000000AAA00"]
+
+        single = client.get("/api/v1/saves/0004000000030800/meta", headers=auth_headers)
+        assert data["saves"]["0004000000030800"] == single.json()
+
+    def test_json_invalid_title_id(self, client, auth_headers):
+        r = client.post("/api/v1/titles/meta", json={"title_ids": ["XYZ"]}, headers=auth_headers)
+        assert r.status_code == 422
+
+    def test_binary_lookup(self, client, auth_headers, upload_save):
+        upload_save(
+            "0004000000055D00",
+            _make_bundle_bytes(title_id=0x0004000000055D00, files=[("main", b"one")]),
+        )
+        meta = client.get("/api/v1/saves/0004000000055D00/meta", headers=auth_headers).json()
+
+        ids = [0x00040000000AAA00, 0x0004000000055D00]
+        body = META_REQUEST_MAGIC + struct.pack("<II", META_BINARY_VERSION, len(ids))
+        body += b"".join(struct.pack(">Q", t) for t in ids)
+        r = client.post(
+            "/api/v1/titles/meta",
+            content=body,
+            headers={**auth_headers, "Content-Type": "application/octet-stream"},
+        )
+        assert r.status_code == 200
+        assert r.headers["content-type"] == "application/octet-stream"
+
+        magic, version, count = struct.unpack_from("<4sII", r.content)
+        assert (magic, version, count) == (META_RESPONSE_MAGIC, META_BINARY_VERSION, 1)
+        assert len(r.content) == 12 + ENTRY_SIZE
+        title_id, save_hash, size, file_count, timestamp, _, console = struct.unpack_from(
+            ">Q32s", r.content, 12
+        ) + struct.unpack_from("<IIII16s", r.content, 52)
+        assert title_id == 0x0004000000055D00
+        assert save_hash.hex() == meta["save_hash"]
+        assert (size, file_count, timestamp) == (meta["save_size"], 1, meta["client_timestamp"])
+        assert console.rstrip(b"\x00").decode() == meta["console_id"]
+
+    def test_binary_truncated_rejected(self, client, auth_headers):
+        body = META_REQUEST_MAGIC + struct.pack("<II", META_BINARY_VERSION, 2) + b"\x00" * 8
+        r = client.post(
+            "/api/v1/titles/meta",
+            content=body,
+            headers={**auth_headers, "Content-Type": "application/octet-stream"},
+        )
+        assert r.status_code == 400
+
+
+class TestHistoryEndpoints:
+    def test_list_and_download_version(self, client, auth_headers, upload_save):
+        from app.services.bundle import parse_bundle
+
+        for i, data in enumerate((b"v1", b"v2", b"v3")):
+            upload_save(
+                "0004000000055D00", _make_bundle_bytes(timestamp=1000 + i, files=[("main", data)])
+            )
+
+        r = client.get("/api/v1/saves/0004000000055D00/history", headers=auth_headers)
+        assert r.status_code == 200
+        versions = r.json()["versions"]
+        assert [v["size"] for v in versions] == [2, 2]
+
+        r = client.get(
+            f"/api/v1/saves/0004000000055D00/history/{versions[-1]['version']}",
+            headers=auth_headers,
+        )
+        assert r.status_code == 200
+        assert parse_bundle(r.content).files[0].data == b"v1"
+
+    def test_restore_version(self, client, auth_headers, upload_save):
+        upload_save(
+            "0004000000055D00", _make_bundle_bytes(timestamp=1000, files=[("main", b"v1")])
+        )
+        upload_save(
+            "0004000000055D00", _make_bundle_bytes(timestamp=2000, files=[("main", b"v2")])
+        )
+        version = client.get(
+            "/api/v1/saves/0004000000055D00/history", headers=auth_headers
+        ).json()["versions"][0]["version"]
+
+        r = client.post(
+            f"/api/v1/saves/0004000000055D00/history/{version}/restore",
+            headers=auth_headers,
+        )
+        assert r.status_code == 200
+        assert r.json()["sha256"] == hashlib.sha256(b"v1").hexdigest()
+
+        r = client.get("/api/v1/saves/0004000000055D00/meta", headers=auth_headers)
+        assert r.json()["last_sync_source"] == "restore"
+
+    def test_unknown_version(self, client, auth_headers, upload_save):
+        upload_save(
+            "0004000000055D00", _make_bundle_bytes(timestamp=1000, files=[("main", b"v1")])
+        )
+        r = client.get(
+            "/api/v1/saves/0004000000055D00/history/2000-01-01T00_00_00", headers=auth_headers
+        )
+        assert r.status_code == 404
+        r = client.post(
+            "/api/v1/saves/0004000000055D00/history/..json/restore", headers=auth_headers
+        )
+        assert r.status_code == 400
+
+    def test_unknown_title(self, client, auth_headers):
+        r = client.get("/api/v1/saves/0004000000055D00/history", headers=auth_headers)
+        assert r.status_code == 404
+
+
+class TestConditionalRequests:
+    PATHS = [
+        "/api/v1/saves/0004000000055D00",
+        "/api/v1/saves/0004000000055D00/meta",
+        "/api/v1/saves/0004000000055D00/raw",
+    ]
+
+    def test_etag_is_save_hash(self, client, auth_headers, upload_save):
+        save_hash = upload_save("0004000000055D00", _make_bundle_bytes())["sha256"]
+        for path in self.PATHS:
+            r = client.get(path, headers=auth_headers)
+            assert r.status_code == 200
+            assert r.headers["ETag"] == f'"{save_hash}"'
+
+    def test_matching_hash_not_modified(self, client, auth_headers, upload_save):
+        save_hash = upload_save("0004000000055D00", _make_bundle_bytes())["sha256"]
+        for path in self.PATHS:
+            r = client.get(path, headers={**auth_headers, "If-None-Match": f'"{save_hash}"'})
+            assert r.status_code == 304
+            assert r.content == b""
+            assert r.headers["X-Save-Hash"] == save_hash
+            assert r.headers["X-Save-Timestamp"] == "1700000000"
+
+    def test_stale_hash_gets_full_response(self, client, auth_headers, upload_save):
+        old_hash = upload_save("0004000000055D00", _make_bundle_bytes())["sha256"]
+        client.post(
+            "/api/v1/saves/0004000000055D00?force=true",
+            content=_make_bundle_bytes(files=[("main", b"newer")]),
+            headers={**auth_headers, "Content-Type": "application/octet-stream"},
+        )
+        from app.services.bundle import parse_bundle
+
+        r = client.get(self.PATHS[0], headers={**auth_headers, "If-None-Match": f'"{old_hash}"'})
+        assert r.status_code == 200
+        assert parse_bundle(r.content).files[0].data == b"newer"
+
+    def test_any_of_several_tags_matches(self, client, auth_headers, upload_save):
+        save_hash = upload_save("0004000000055D00", _make_bundle_bytes())["sha256"]
+        r = client.get(
+            self.PATHS[1],
+            headers={**auth_headers, "If-None-Match": f'"{"0" * 64}", "{save_hash.upper()}"'},
+        )
+        assert r.status_code == 304
@@ -1,7 +1,16 @@
 import hashlib
 
 from app.models.save import BundleFile, SaveBundle
-from app.services.bundle import BundleError, create_bundle, parse_bundle
+from app.services.bundle import (
+    CODEC_STORED,
+    CODEC_ZLIB,
+    LEVEL_HIGH,
+    BundleError,
+    BundleParser,
+    create_bundle,
+    create_codec_bundle,
+    parse_bundle,
+)
 import pytest
 
 
@@ -112,3 +121,158 @@ class TestBundleErrors:
         data[-1] ^= 0xFF
         with pytest.raises(BundleError, match="Hash mismatch"):
             parse_bundle(bytes(data))
+
+
+class TestStreamingParser:
+    def _feed(self, data: bytes, step: int, **kwargs):
+        parser = BundleParser(**kwargs)
+        for i in range(0, len(data), step):
+            parser.feed(data[i : i + step])
+        return parser, parser.close()
+
+    def test_byte_at_a_time(self):
+        original = _make_bundle(files=[("main", b"A" * 5000), ("empty", b""), ("b", b"xyz")])
+        for compress in (True, False):
+            parser, parsed = self._feed(create_bundle(original, compress=compress), 1)
+            assert [(f.path, f.data) for f in parsed.files] == [
+                ("main", b"A" * 5000),
+                ("empty", b""),
+                ("b", b"xyz"),
+            ]
+            assert parser.save_hash == hashlib.sha256(b"A" * 5000 + b"xyz").hexdigest()
+
+    def test_truncated_stream(self):
+        data = create_bundle(_make_bundle(files=[("main", bytes(range(256)) * 64)]))
+        with pytest.raises(BundleError, match="Decompression failed"):
+            self._feed(data[:-10], 100)
+
+    def test_truncated_uncompressed_data(self):
+        data = create_bundle(_make_bundle(), compress=False)
+        with pytest.raises(BundleError, match="Truncated file data"):
+            self._feed(data[:-1], 7)
+
+    def test_payload_over_declared_size(self):
+        """A stream that inflates past the header's size is cut off, not decoded."""
+        data = bytearray(create_bundle(_make_bundle(files=[("main", b"\0" * 100000)])))
+        data[24:28] = (1000).to_bytes(4, "little")
+        with pytest.raises(BundleError, match="size mismatch"):
+            self._feed(bytes(data), 4096)
+
+    def test_declared_size_over_cap(self):
+        data = create_bundle(_make_bundle(files=[("main", b"x" * 2000)]))
+        with pytest.raises(BundleError, match="Payload too large"):
+            self._feed(data, 4096, max_payload=1000)
+
+    def test_on_header_runs_before_payload(self):
+        seen = []
+
+        class Sink:
+            def begin_file(self, f):
+                seen.append("file")
+
+            def write(self, data):
+                pass
+
+            def end_file(self, f):
+                pass
+
+        def on_header(parser):
+            seen.append(parser.title_id_hex)
+            raise BundleError("rejected")
+
+        with pytest.raises(BundleError, match="rejected"):
+            self._feed(create_bundle(_make_bundle()), 1 << 20, sink=Sink(), on_header=on_header)
+        assert seen == ["0004000000055D00"]
+
+
+class TestCodecBundle:
+    FILES = [
+        ("text", b"save data " * 500),
+        # 8KB of hash output: looks random to the probe
+        ("random", b"".join(hashlib.sha256(bytes([i])).digest() for i in range(256))),
+        ("tiny", b"abc"),
+        ("empty", b""),
+    ]
+
+    def _codecs(self, data: bytes) -> list[tuple[int, int]]:
+        """(codec, encoded size) of each table entry of a v3 bundle."""
+        pos, codecs = 28, []
+        for _ in range(int.from_bytes(data[20:24], "little")):
+            path_len = int.from_bytes(data[pos : pos + 2], "little")
+            pos += 2 + path_len + 4 + 32
+            codecs.append((data[pos], int.from_bytes(data[pos + 1 : pos + 5], "little")))
+            pos += 5
+        return codecs
+
+    def test_round_trip(self):
+        original = _make_bundle(files=self.FILES)
+        for level in (1, LEVEL_HIGH):
+            data = create_codec_bundle(original, level=level)
+            assert int.from_bytes(data[4:8], "little") == 3
+            # The size field is the v1 payload, as for v2
+            assert data[24:28] == create_bundle(original, compress=True)[24:28]
+            parsed = parse_bundle(data)
+            assert [(f.path, f.data) for f in parsed.files] == [
+                (f.path, f.data) for f in original.files
+            ]
+
+    def test_codec_choice(self):
+        data = create_codec_bundle(_make_bundle(files=self.FILES))
+        codecs = self._codecs(data)
+        assert codecs[0][0] == CODEC_ZLIB and codecs[0][1] < 5000
+        assert codecs[1] == (CODEC_STORED, 8192)
+        assert codecs[2] == (CODEC_STORED, 3)
+        assert codecs[3] == (CODEC_STORED, 0)
+
+    def test_byte_at_a_time(self):
+        original = _make_bundle(files=self.FILES)
+        parser = BundleParser()
+        for b in create_codec_bundle(original):
+            parser.feed(bytes([b]))
+        parsed = parser.close()
+        assert [f.data for f in parsed.files] == [f.data for f in original.files]
+        assert parser.save_hash == hashlib.sha256(b"".join(d for _, d in self.FILES)).hexdigest()
+
+    def test_only_empty_files(self):
+        data = create_codec_bundle(_make_bundle(files=[("a", b""), ("b", b"")]))
+        assert [f.path for f in parse_bundle(data).files] == ["a", "b"]
+
+    def test_corrupted_stored_data(self):
+        data = bytearray(create_codec_bundle(_make_bundle(files=[("random", self.FILES[1][1])])))
+        data[-1] ^= 0xFF
+        with pytest.raises(BundleError, match="Hash mismatch"):
+            parse_bundle(bytes(data))
+
+    def test_truncated_file_data(self):
+        data = create_codec_bundle(_make_bundle(files=self.FILES[:2]))
+        with pytest.raises(BundleError, match="Truncated file data for random"):
+            parse_bundle(data[:-1])
+
+    def test_stored_size_must_match(self):
+        data = bytearray(create_codec_bundle(_make_bundle(files=[("tiny", b"abc")])))
+        entry_end = 28 + 2 + 4 + 4 + 32
+        data[entry_end + 1 : entry_end + 5] = (4).to_bytes(4, "little")
+        with pytest.raises(BundleError, match="Stored size mismatch"):
+            parse_bundle(bytes(data))
+
+    def test_encoded_size_past_stream(self):
+        """Bytes inside a file's encoded size but after its zlib stream are rejected."""
+        text = self.FILES[0][1]
+        data = bytearray(create_codec_bundle(_make_bundle(files=[("text", text)])))
+        pos = 28 + 2 + 4 + 4 + 32 + 1
+        encoded = int.from_bytes(data[pos : pos + 4], "little")
+        data[pos : pos + 4] = (encoded + 1).to_bytes(4, "little")
+        with pytest.raises(BundleError, match="Encoded size mismatch"):
+            parse_bundle(bytes(data) + b"\0")
+
+    def test_unknown_codec(self):
+        data = bytearray(create_codec_bundle(_make_bundle(files=[("tiny", b"abc")])))
+        data[28 + 2 + 4 + 4 + 32] = 7
+        with pytest.raises(BundleError, match="Unknown codec"):
+            parse_bundle(bytes(data))
+
+    def test_file_count_over_payload(self):
+        data = bytearray(create_codec_bundle(_make_bundle()))
+        data[20:24] = (1 << 20).to_bytes(4, "little")
+        with pytest.raises(BundleError, match="File count too large"):
+            BundleParser().feed(bytes(data[:28]))
@@ -0,0 +1,196 @@
+import hashlib
+import struct
+import zlib
+
+import pytest
+
+from app.config import settings
+from app.models.save import BundleFile, SaveBundle
+from app.services.bundle import create_bundle, parse_bundle
+from app.services.delta import (
+    DeltaError,
+    apply_delta,
+    apply_file_delta,
+    build_block_list,
+    create_delta,
+    create_file_delta,
+    parse_delta,
+)
+
+TITLE_ID = "0004000000055D00"
+
+
+def _make_bundle(
+    timestamp: int = 1700000000, files: list[tuple[str, bytes]] | None = None
+) -> SaveBundle:
+    if files is None:
+        files = [("main", b"save data here")]
+    bundle_files = [
+        BundleFile(
+            path=path,
+            size=len(data),
+            sha256=hashlib.sha256(data).digest(),
+            data=data,
+        )
+        for path, data in files
+    ]
+    return SaveBundle(title_id=int(TITLE_ID, 16), timestamp=timestamp, files=bundle_files)
+
+
+def _save_hash(files: list[tuple[str, bytes]]) -> str:
+    return hashlib.sha256(b"".join(data for _, data in files)).hexdigest()
+
+
+def _block_list(files: list[tuple[str, bytes]], block_size: int = 16) -> dict:
+    return build_block_list(_save_hash(files), block_size, files)
+
+
+class TestDeltaRoundTrip:
+    def test_only_changed_blocks_sent(self):
+        old = [("main", b"A" * 64)]
+        new = [("main", b"A" * 16 + b"B" * 16 + b"A" * 32)]
+
+        delta = parse_delta(create_delta(_make_bundle(files=new), _block_list(old)))
+        assert delta.base_hash == _save_hash(old)
+        assert list(delta.files[0].blocks) == [1]
+
+        rebuilt = apply_delta(delta, dict(old))
+        assert rebuilt.files[0].data == new[0][1]
+
+    def test_file_grows_shrinks_and_is_added(self):
+        old = [("main", b"A" * 40), ("extra", b"E" * 20)]
+        new = [("main", b"A" * 20), ("extra", b"E" * 50), ("added", b"new file")]
+
+        delta = parse_delta(create_delta(_make_bundle(files=new), _block_list(old)))
+        rebuilt = apply_delta(delta, dict(old))
+        assert [(f.path, f.data) for f in rebuilt.files] == new
+
+    def test_removed_file_is_dropped(self):
+        old = [("main", b"A" * 16), ("gone", b"G" * 16)]
+        new = [("main", b"A" * 16)]
+
+        delta = parse_delta(create_delta(_make_bundle(files=new), _block_list(old)))
+        rebuilt = apply_delta(delta, dict(old))
+        assert [f.path for f in rebuilt.files] == ["main"]
+
+    def test_wrong_base_detected(self):
+        old = [("main", b"A" * 32)]
+        new = [("main", b"A" * 16 + b"B" * 16)]
+
+        delta = parse_delta(create_delta(_make_bundle(files=new), _block_list(old)))
+        with pytest.raises(DeltaError, match="Hash mismatch"):
+            apply_delta(delta, {"main": b"C" * 32})
+
+    def test_invalid_magic(self):
+        with pytest.raises(DeltaError, match="Invalid magic"):
+            parse_delta(b"XXXX" + b"\x00" * 60)
+
+    def test_target_size_limited(self, monkeypatch):
+        monkeypatch.setattr(settings, "max_upload_size", 1024)
+        files = [("main", b"\x00" * 2048)]
+        data = create_delta(_make_bundle(files=files), _block_list(files))
+        with pytest.raises(DeltaError, match="File too large"):
+            parse_delta(data)
+
+    def test_payload_inflation_limited(self, monkeypatch):
+        monkeypatch.setattr(settings, "max_upload_size", 1024)
+        files = [("main", b"small")]
+        header = create_delta(_make_bundle(files=files), _block_list(files))[:64]
+        bomb = header[:60] + struct.pack("<I", 100) + zlib.compress(b"\x00" * 1024 * 1024)
+        with pytest.raises(DeltaError, match="Payload too large"):
+            parse_delta(bomb)
+
+
+class TestFileDelta:
+    def test_round_trip(self):
+        base = b"A" * 64 + b"B" * 32
+        for data in (b"A" * 16 + b"C" * 16 + b"A" * 32 + b"B" * 32, b"A" * 40, base + b"D" * 20):
+            assert apply_file_delta(create_file_delta(data, base, 16), base) == data
+
+    def test_wrong_base_detected(self):
+        delta = create_file_delta(b"A" * 32, b"B" * 32, 16)
+        with pytest.raises(DeltaError, match="base does not match"):
+            apply_file_delta(delta, b"C" * 32)
+
+
+class TestDeltaEndpoints:
+    def test_blocks_not_found(self, client, auth_headers):
+        r = client.get(f"/api/v1/saves/{TITLE_ID}/blocks", headers=auth_headers)
+        assert r.status_code == 404
+
+    def test_blocks_after_upload(self, client, auth_headers, upload_save):
+        upload_save(
+            TITLE_ID, create_bundle(_make_bundle(timestamp=1000, files=[("main", b"x" * 5000)]))
+        )
+        r = client.get(f"/api/v1/saves/{TITLE_ID}/blocks", headers=auth_headers)
+        assert r.status_code == 200
+        assert r.content[:4] == b"3DBL"
+
+    def test_delta_upload(self, client, auth_headers, upload_save):
+        old = [("main", b"A" * 8192)]
+        new = [("main", b"A" * 4096 + b"B" * 4096)]
+        upload_save(TITLE_ID, create_bundle(_make_bundle(timestamp=1000, files=old)))
+
+        from app.services import storage
+
+        delta = create_delta(
+            _make_bundle(timestamp=2000, files=new), storage.get_block_list(TITLE_ID)
+        )
+        r = client.post(
+            f"/api/v1/saves/{TITLE_ID}/delta",
+            content=delta,
+            headers={**auth_headers, "Content-Type": "application/octet-stream"},
+        )
+        assert r.status_code == 200
+        assert r.json()["sha256"] == _save_hash(new)
+
+        r = client.get(f"/api/v1/saves/{TITLE_ID}", headers=auth_headers)
+        assert parse_bundle(r.content).files[0].data == new[0][1]
+
+    def test_delta_upload_stale_base(self, client, auth_headers, upload_save):
+        old = [("main", b"A" * 4096)]
+        upload_save(TITLE_ID, create_bundle(_make_bundle(timestamp=1000, files=old)))
+
+        from app.services import storage
+
+        base = storage.get_block_list(TITLE_ID)
+        upload_save(
+            TITLE_ID, create_bundle(_make_bundle(timestamp=2000, files=[("main", b"C" * 4096)]))
+        )
+
+        delta = create_delta(_make_bundle(timestamp=3000, files=[("main", b"B" * 4096)]), base)
+        r = client.post(
+            f"/api/v1/saves/{TITLE_ID}/delta",
+            content=delta,
+            headers={**auth_headers, "Content-Type": "application/octet-stream"},
+        )
+        assert r.status_code == 412
+
+    def test_delta_download_from_history(self, client, auth_headers, upload_save):
+        old = [("main", b"A" * 8192)]
+        new = [("main", b"B" * 4096 + b"A" * 4096)]
+        upload_save(TITLE_ID, create_bundle(_make_bundle(timestamp=1000, files=old)))
+        upload_save(TITLE_ID, create_bundle(_make_bundle(timestamp=2000, files=new)))
+
+        r = client.get(
+            f"/api/v1/saves/{TITLE_ID}/delta",
+            params={"base": _save_hash(old)},
+            headers=auth_headers,
+        )
+        assert r.status_code == 200
+        assert r.headers["X-Save-Hash"] == _save_hash(new)
+
+        delta = parse_delta(r.content)
+        assert list(delta.files[0].blocks) == [0]
+        assert apply_delta(delta, dict(old)).files[0].data == new[0][1]
+
+    def test_delta_download_unknown_base(self, client, auth_headers, upload_save):
+        upload_save(
+            TITLE_ID, create_bundle(_make_bundle(timestamp=1000, files=[("main", b"A" * 100)]))
+        )
+        r = client.get(
+            f"/api/v1/saves/{TITLE_ID}/delta",
+            params={"base": "0" * 64},
+            headers=auth_headers,
+        )
+        assert r.status_code == 404
@@ -0,0 +1,100 @@
+import os
+
+import pytest
+
+from app.services import game_names
+from app.services.names_index import NameIndex, NameIndexError, build_index
+
+
+@pytest.fixture(autouse=True)
+def empty_databases(monkeypatch):
+    monkeypatch.setattr(game_names, "_3ds_names", NameIndex.from_names({}))
+    monkeypatch.setattr(game_names, "_ds_names", NameIndex.from_names({}))
+    game_names._lookup_one.cache_clear()
+
+
+class TestNameIndex:
+    def test_lookup(self):
+        names = {f"A{i:03d}": f"Game {i}" for i in range(500)}
+        names["BRBE"] = "Pokémon Ultra Sun"
+        index = NameIndex(build_index(names))
+        assert len(index) == 501
+        assert index.get("A000") == "Game 0"
+        assert index.get("A499") == "Game 499"
+        assert index.get("BRBE") == "Pokémon Ultra Sun"
+        assert index.get("A500") is None
+        assert index.get("0000") is None
+        assert index.get("ZZZZ") is None
+        assert index.get("TOOLONG") is None
+
+    def test_digest_follows_content(self):
+        a = build_index({"BRBE": "One", "AAAA": "Two"})
+        assert NameIndex(a).digest == NameIndex(build_index({"AAAA": "Two", "BRBE": "One"})).digest
+        assert NameIndex(a).digest != NameIndex(build_index({"AAAA": "Two", "BRBE": "Three"})).digest
+
+    def test_rejects_bad_files(self):
+        data = build_index({"BRBE": "One"})
+        with pytest.raises(NameIndexError):
+            NameIndex(b"XXXX" + data[4:])
+        with pytest.raises(NameIndexError):
+            NameIndex(data[:-1])
+        with pytest.raises(NameIndexError):
+            NameIndex(data[:8])
+
+
+class TestNameDatabase:
+    def test_lookup_and_version(self, tmp_path):
+        db = tmp_path / "3dstdb.txt"
+        db.write_text("BRBE,Resident Evil Revelations\n", encoding="utf-8")
+
+        game_names.load_database(db)
+        version = game_names.database_version()
+        assert game_names.lookup_names(["CTR-P-BRBE", "CTR-P-ZZZZ"]) == {
+            "CTR-P-BRBE": "Resident Evil Revelations"
+        }
+        assert game_names.database_version() == version
+
+        db.write_text("BRBE,Resident Evil Revelations\nZZZZ,New Game\n", encoding="utf-8")
+        game_names.load_database(db)
+        assert game_names.database_version() != version
+        # Memoized misses are dropped when a database loads
+        assert game_names.get_name("CTR-P-ZZZZ") == "New Game"
+
+    def test_prebuilt_index_matches_text(self, tmp_path):
+        db = tmp_path / "dstdb.txt"
+        db.write_text("A22E,WarioWare: Touched!\nADME,Animal Crossing\n", encoding="utf-8")
+        assert game_names.load_database(db) == 2
+        version = game_names.database_version()
+
+        # Index holds different names so it's clear which one was read
+        game_names.index_path(db).write_bytes(build_index({"A22E": "From Index", "ADME": "Other"}))
+        assert game_names.load_database(db) == 2
+        assert game_names.get_name("A22E") == "From Index"
+        assert game_names.database_version() != version
+
+        game_names.index_path(db).write_bytes(
+            build_index({"A22E": "WarioWare: Touched!", "ADME": "Animal Crossing"})
+        )
+        game_names.load_database(db)
+        assert game_names.database_version() == version
+
+    def test_stale_or_broken_index_falls_back_to_text(self, tmp_path):
+        db = tmp_path / "dstdb.txt"
+        db.write_text("A22E,WarioWare: Touched!\n", encoding="utf-8")
+        idx = game_names.index_path(db)
+        idx.write_bytes(build_index({"A22E": "Old Name"}))
+        stat = db.stat()
+        os.utime(idx, ns=(stat.st_atime_ns, stat.st_mtime_ns - 1_000_000_000))
+        game_names.load_database(db)
+        assert game_names.get_name("A22E") == "WarioWare: Touched!"
+
+        idx.write_bytes(b"garbage")
+        game_names.load_database(db)
+        assert game_names.get_name("A22E") == "WarioWare: Touched!"
+
+    def test_index_without_text(self, tmp_path):
+        db = tmp_path / "3dstdb.txt"
+        game_names.index_path(db).write_bytes(build_index({"BRBE": "Resident Evil Revelations"}))
+        assert game_names.load_database(db) == 1
+        assert game_names.get_name("CTR-P-BRBE") == "Resident Evil Revelations"
+        assert game_names.load_database(tmp_path / "missing.txt") == 0
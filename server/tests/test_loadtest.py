@@ -0,0 +1,49 @@
+import asyncio
+
+import httpx
+
+from app.config import settings
+from app.services.sync_binary import parse_sync_request
+from tests.loadtest import LoadConfig, _sync_request, build_consoles, format_results, run_load
+
+
+class TestLoadTest:
+    def test_workload_is_deterministic(self):
+        a = build_consoles(LoadConfig(consoles=3, titles=5, seed=7))
+        b = build_consoles(LoadConfig(consoles=3, titles=5, seed=7))
+        assert [c.console_id for c in a] == [c.console_id for c in b]
+        for ca, cb in zip(a, b):
+            assert [t.save_hash for t in ca.titles.values()] == [
+                t.save_hash for t in cb.titles.values()
+            ]
+
+    def test_shared_titles_match_across_consoles(self):
+        consoles = build_consoles(LoadConfig(consoles=2, titles=4, shared=0.5))
+        shared = set(consoles[0].titles) & set(consoles[1].titles)
+        assert len(shared) == 2
+        for tid in shared:
+            assert consoles[0].titles[tid].save_hash == consoles[1].titles[tid].save_hash
+
+    def test_sync_request_is_valid_binary(self):
+        console = build_consoles(LoadConfig(consoles=1, titles=3))[0]
+        request = parse_sync_request(_sync_request(console, 1700000000))
+        assert request.console_id == console.console_id
+        assert [int(t.title_id, 16) for t in request.titles] == list(console.titles)
+        assert all(t.last_synced_hash is None for t in request.titles)
+
+    def test_small_run_is_clean(self, tmp_save_dir, monkeypatch):
+        from app.main import create_app
+
+        monkeypatch.setattr(settings, "max_history_versions", 2)
+        config = LoadConfig(consoles=3, titles=4, rounds=3, change=0.5)
+        transport = httpx.ASGITransport(app=create_app())
+        results = asyncio.run(
+            run_load(config, "http://test", settings.api_key, transport=transport, save_dir=tmp_save_dir)
+        )
+
+        assert results["errors"] == 0
+        assert results["corrupt_saves"] == 0
+        assert results["operations"]["sync"]["count"] == 9
+        assert results["operations"]["upload"]["count"] > 0
+        assert results["max_history_versions"] <= 2
+        assert "p99 ms" in format_results(results, baseline=results)
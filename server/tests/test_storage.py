@@ -0,0 +1,403 @@
+import asyncio
+import hashlib
+import json
+import shutil
+import threading
+
+from app.config import settings
+from app.models.save import BundleFile, SaveBundle
+from app.services import metrics, storage, workers
+from app.services.bundle import BundleParser, create_bundle, parse_bundle
+
+
+def _bundle(title_id: int, data: bytes) -> SaveBundle:
+    return SaveBundle(
+        title_id=title_id,
+        timestamp=1700000000,
+        files=[BundleFile(path="main", size=len(data), sha256=hashlib.sha256(data).digest(), data=data)],
+    )
+
+
+class TestMetadataIndex:
+    def test_store_updates_index_and_disk(self):
+        meta = storage.store_save(_bundle(0x0004000000055D00, b"save"), console_id="abc")
+
+        assert storage.title_exists("0004000000055D00")
+        assert storage.get_metadata("0004000000055D00").save_hash == meta.save_hash
+        assert storage.list_title_ids() == ["0004000000055D00"]
+
+        on_disk = json.loads((settings.save_dir / "0004000000055D00" / "metadata.json").read_text())
+        assert on_disk["save_hash"] == meta.save_hash
+        assert not list(settings.save_dir.rglob("*.tmp"))
+
+    def test_lookups_served_from_memory(self):
+        storage.store_save(_bundle(0x0004000000055D00, b"save"))
+        meta_path = settings.save_dir / "0004000000055D00" / "metadata.json"
+        meta_path.write_text("not json")
+
+        assert storage.get_metadata("0004000000055D00") is not None
+        assert len(storage.list_titles()) == 1
+
+    def test_existing_metadata_loaded(self, tmp_path):
+        storage.store_save(_bundle(0x0004000000055D00, b"one"))
+        storage.store_save(_bundle(0x0004000000030800, b"two"))
+        saved = storage.list_titles()
+
+        # Point at a copy of the directory to force a fresh load from disk
+        copy = tmp_path / "copy"
+        shutil.copytree(settings.save_dir, copy)
+        settings.save_dir = copy
+
+        assert storage.load_index() == 2
+        assert storage.list_titles() == saved
+
+    def test_returned_metadata_is_a_copy(self):
+        storage.store_save(_bundle(0x0004000000055D00, b"save"))
+        storage.list_titles()[0]["save_hash"] = "x"
+        storage.get_metadata("0004000000055D00").save_hash = "y"
+
+        assert storage.get_metadata("0004000000055D00").save_hash not in ("x", "y")
+
+    def test_get_metadata_many(self):
+        storage.store_save(_bundle(0x0004000000055D00, b"one"))
+        storage.store_save(_bundle(0x0004000000030800, b"two"))
+
+        metas = storage.get_metadata_many(
+            ["0004000000030800", "00040000000AAA00", "0004000000055D00", "0004000000030800"]
+        )
+        assert [m.title_id for m in metas] == ["0004000000030800", "0004000000055D00"]
+        assert metas[1].save_hash == storage.get_metadata("0004000000055D00").save_hash
+
+
+class TestChangeFeed:
+    def test_each_store_takes_the_next_sequence(self):
+        a = storage.store_save(_bundle(0x0004000000055D00, b"one"))
+        b = storage.store_save(_bundle(0x0004000000030800, b"two"))
+        c = storage.store_save(_bundle(0x0004000000055D00, b"three"))
+        assert (a.change_seq, b.change_seq, c.change_seq) == (1, 2, 3)
+        assert storage.changes_since(None) == (3, [], False)
+
+    def test_changes_since_cursor(self):
+        storage.store_save(_bundle(0x0004000000055D00, b"one"))
+        cursor, _, _ = storage.changes_since(None)
+        meta = storage.store_save(_bundle(0x0004000000030800, b"two"))
+
+        cursor2, changes, reset = storage.changes_since(cursor)
+        assert cursor2 == cursor + 1 and not reset
+        assert changes == [{"title_id": "0004000000030800", "save_hash": meta.save_hash, "change_seq": cursor2}]
+        assert storage.changes_since(cursor2)[1] == []
+
+    def test_sequence_resumes_after_restart(self, tmp_path):
+        storage.store_save(_bundle(0x0004000000055D00, b"one"))
+        storage.store_save(_bundle(0x0004000000030800, b"two"))
+
+        copy = tmp_path / "copy"
+        shutil.copytree(settings.save_dir, copy)
+        settings.save_dir = copy
+
+        assert storage.changes_since(None)[0] == 2
+        assert storage.store_save(_bundle(0x0004000000055D00, b"three")).change_seq == 3
+
+    def test_cursor_ahead_of_store_lists_everything(self):
+        storage.store_save(_bundle(0x0004000000055D00, b"one"))
+        cursor, changes, reset = storage.changes_since(50)
+        assert reset and cursor == 1
+        assert [c["title_id"] for c in changes] == ["0004000000055D00"]
+
+
+def _blobs(save_dir):
+    return sorted(p.name for p in (save_dir / "blobs").rglob("*") if p.is_file())
+
+
+class TestBlobStore:
+    def test_identical_files_stored_once(self):
+        storage.store_save(_bundle(0x0004000000055D00, b"same"))
+        storage.store_save(_bundle(0x0004000000030800, b"same"))
+
+        assert _blobs(settings.save_dir) == [hashlib.sha256(b"same").hexdigest()]
+        assert storage.load_save_files("0004000000030800") == [("main", b"same")]
+
+    def test_history_keeps_old_blobs(self):
+        storage.store_save(_bundle(0x0004000000055D00, b"v1"))
+        storage.store_save(_bundle(0x0004000000055D00, b"v2"))
+
+        assert len(_blobs(settings.save_dir)) == 2
+        assert storage.load_save_files("0004000000055D00") == [("main", b"v2")]
+
+    def test_pruning_releases_unreferenced_blobs(self, monkeypatch):
+        monkeypatch.setattr(settings, "max_history_versions", 1)
+        for data in (b"v1", b"v2", b"v3"):
+            storage.store_save(_bundle(0x0004000000055D00, data))
+
+        # current (v3) + one history version (v2)
+        assert _blobs(settings.save_dir) == sorted(
+            hashlib.sha256(d).hexdigest() for d in (b"v2", b"v3")
+        )
+
+    def test_shared_blob_survives_pruning(self, monkeypatch):
+        monkeypatch.setattr(settings, "max_history_versions", 0)
+        storage.store_save(_bundle(0x0004000000055D00, b"shared"))
+        storage.store_save(_bundle(0x0004000000030800, b"shared"))
+        storage.store_save(_bundle(0x0004000000055D00, b"new"))
+
+        assert storage.load_save_files("0004000000030800") == [("main", b"shared")]
+
+    def test_legacy_current_dir_migrated(self):
+        title_dir = settings.save_dir / "0004000000055D00"
+        (title_dir / "current").mkdir(parents=True)
+        (title_dir / "current" / "main").write_bytes(b"old")
+        (title_dir / "metadata.json").write_text(json.dumps({
+            "title_id": "0004000000055D00", "name": "0004000000055D00",
+            "last_sync": "2024-01-01T00:00:00+00:00", "last_sync_source": "3ds",
+            "save_hash": hashlib.sha256(b"old").hexdigest(), "save_size": 3,
+            "file_count": 1, "client_timestamp": 1000,
+            "server_timestamp": "2024-01-01T00:00:00+00:00", "console_id": "",
+        }))
+        assert storage.load_save_files("0004000000055D00") == [("main", b"old")]
+
+        storage.store_save(_bundle(0x0004000000055D00, b"new"))
+        assert not (title_dir / "current").exists()
+        assert storage.load_save_files("0004000000055D00") == [("main", b"new")]
+        assert len(list((title_dir / "history").iterdir())) == 1
+        assert len(_blobs(settings.save_dir)) == 2
+
+
+class TestBundleCache:
+    def test_bundle_built_on_store(self):
+        meta = storage.store_save(_bundle(0x0004000000055D00, b"save"))
+        path = storage.get_bundle_path("0004000000055D00")
+
+        assert path.name == f"{meta.save_hash}.bin"
+        bundle = parse_bundle(path.read_bytes())
+        assert bundle.timestamp == 1700000000
+        assert [(f.path, f.data) for f in bundle.files] == [("main", b"save")]
+
+    def test_only_recent_bundles_kept(self):
+        for data in (b"v1", b"v2", b"v3"):
+            storage.store_save(_bundle(0x0004000000055D00, data))
+
+        bundles = settings.save_dir / "0004000000055D00" / "bundles"
+        assert len(list(bundles.glob("*.bin"))) == 2
+
+    def test_missing_bundle_rebuilt(self):
+        storage.store_save(_bundle(0x0004000000055D00, b"save"))
+        path = storage.get_bundle_path("0004000000055D00")
+        path.unlink()
+
+        assert storage.get_bundle_path("0004000000055D00") == path
+        assert parse_bundle(path.read_bytes()).files[0].data == b"save"
+
+    def test_v3_bundle_built_on_request(self):
+        meta = storage.store_save(_bundle(0x0004000000055D00, b"save"))
+        v3_dir = settings.save_dir / "0004000000055D00" / "bundles" / "v3"
+        assert not v3_dir.exists()
+
+        path = storage.get_bundle_path("0004000000055D00", 3)
+        assert path == v3_dir / f"{meta.save_hash}.bin"
+        data = path.read_bytes()
+        assert int.from_bytes(data[4:8], "little") == 3
+        assert parse_bundle(data).files[0].data == b"save"
+        # The v2 bundle is left alone
+        assert storage.get_bundle_path("0004000000055D00").parent == v3_dir.parent
+
+    def test_unknown_title(self):
+        assert storage.get_bundle_path("0004000000055D00") is None
+
+
+class TestSaveWriter:
+    def _stream(self, bundle: SaveBundle, step: int = 1000):
+        writer = storage.SaveWriter(bundle.title_id_hex)
+        parser = BundleParser(sink=writer)
+        data = create_bundle(bundle)
+        for i in range(0, len(data), step):
+            parser.feed(data[i : i + step])
+        return writer, parser, parser.close()
+
+    def test_matches_store_save(self, monkeypatch):
+        monkeypatch.setattr(settings, "delta_block_size", 1024)
+        data = bytes(range(256)) * 20
+        writer, parser, parsed = self._stream(_bundle(0x0004000000055D00, data))
+        meta = writer.commit(parsed, parser.save_hash)
+
+        assert meta.save_hash == hashlib.sha256(data).hexdigest()
+        assert storage.load_save_files("0004000000055D00") == [("main", data)]
+        blocks = storage.get_block_list("0004000000055D00")["files"][0]["blocks"]
+        assert blocks == [
+            hashlib.sha256(data[i : i + 1024]).hexdigest() for i in range(0, len(data), 1024)
+        ]
+        assert not list((settings.save_dir / "blobs" / "tmp").iterdir())
+
+    def test_existing_blob_not_rewritten(self):
+        storage.store_save(_bundle(0x0004000000055D00, b"shared"))
+        blob = next(p for p in (settings.save_dir / "blobs").rglob("*") if p.is_file())
+        mtime = blob.stat().st_mtime_ns
+
+        writer, parser, parsed = self._stream(_bundle(0x0004000000055D01, b"shared"))
+        writer.commit(parsed, parser.save_hash)
+        assert blob.stat().st_mtime_ns == mtime
+        assert storage.load_save_files("0004000000055D01") == [("main", b"shared")]
+
+    def test_bundle_built_after_commit(self):
+        writer, parser, parsed = self._stream(_bundle(0x0004000000055D00, b"streamed"))
+        meta = writer.commit(parsed, parser.save_hash)
+        workers.shutdown()  # Waits for queued work
+
+        path = settings.save_dir / "0004000000055D00" / "bundles" / f"{meta.save_hash}.bin"
+        assert path.exists()
+        assert parse_bundle(path.read_bytes()).files[0].data == b"streamed"
+
+    def test_abort_leaves_nothing_behind(self):
+        writer, parser, parsed = self._stream(_bundle(0x0004000000055D00, b"new data"))
+        writer.abort()
+
+        assert not [p for p in (settings.save_dir / "blobs").rglob("*") if p.is_file()]
+        assert not storage.title_exists("0004000000055D00")
+
+
+class TestConcurrency:
+    def test_concurrent_uploads_of_one_title(self):
+        def upload(i):
+            storage.store_save(_bundle(0x0004000000055D00, b"v%d" % i))
+
+        threads = [threading.Thread(target=upload, args=(i,)) for i in range(8)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+
+        meta = storage.get_metadata("0004000000055D00")
+        files = storage.load_save_files("0004000000055D00")
+        assert hashlib.sha256(files[0][1]).hexdigest() == meta.save_hash
+        assert storage.get_bundle_path("0004000000055D00").name == f"{meta.save_hash}.bin"
+
+    def test_concurrent_first_v3_downloads(self):
+        meta = storage.store_save(_bundle(0x0004000000055D00, bytes(range(256)) * 64))
+        paths, errors = [], []
+
+        def download():
+            try:
+                paths.append(storage.get_bundle_path("0004000000055D00", 3))
+            except Exception as e:
+                errors.append(e)
+
+        threads = [threading.Thread(target=download) for _ in range(8)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+
+        assert not errors
+        v3_dir = settings.save_dir / "0004000000055D00" / "bundles" / "v3"
+        assert set(paths) == {v3_dir / f"{meta.save_hash}.bin"}
+        assert [p.name for p in v3_dir.iterdir()] == [f"{meta.save_hash}.bin"]
+        assert parse_bundle(paths[0].read_bytes()).files[0].data == bytes(range(256)) * 64
+
+    def test_title_lock_is_per_title(self):
+        assert storage.title_lock("0004000000055D00") is storage.title_lock("0004000000055D00")
+        assert storage.title_lock("0004000000055D00") is not storage.title_lock("0004000000030800")
+
+    def test_worker_pool_runs_off_loop(self):
+        async def main():
+            return await workers.run(threading.current_thread)
+
+        assert asyncio.run(main()) is not threading.current_thread()
+
+    def test_loop_lag_stats(self):
+        for lag in (0.001, 0.002, 0.250):
+            metrics.record_lag(lag)
+        stats = metrics.loop_lag_stats()
+        assert stats["samples"] >= 3
+        assert stats["max_ms"] >= 250
+
+
+def _versions(block: int, count: int) -> list[bytes]:
+    """count versions of a 64KB save, each changing one block of the last."""
+    data = bytearray(hashlib.sha256(b"seed").digest() * 2048)
+    versions = []
+    for i in range(count):
+        data[(i * 7 % 16) * block : (i * 7 % 16) * block + 8] = b"v%07d" % i
+        versions.append(bytes(data))
+    return versions
+
+
+class TestDeltaHistory:
+    TITLE = "0004000000055D00"
+
+    def _store_all(self, versions, compact=True):
+        for data in versions:
+            storage.store_save(_bundle(0x0004000000055D00, data))
+            if compact:
+                storage.compact_history(self.TITLE)
+
+    def test_versions_restore_from_deltas(self, monkeypatch):
+        monkeypatch.setattr(settings, "max_history_versions", 100)
+        versions = _versions(settings.delta_block_size, 30)
+        self._store_all(versions)
+
+        history = storage.list_history(self.TITLE)
+        assert len(history) == 29
+        assert sum(v["delta_files"] for v in history) > 20
+        for entry, data in zip(history, reversed(versions[:-1])):
+            assert storage.load_history_files(self.TITLE, entry["version"]) == [("main", data)]
+
+        # Snapshots plus small deltas, far below 30 whole copies
+        stored = sum(p.stat().st_size for p in (settings.save_dir / "blobs").rglob("*") if p.is_file())
+        assert stored < 5 * len(versions[0])
+
+    def test_snapshots_bound_chain_length(self, monkeypatch):
+        monkeypatch.setattr(settings, "history_snapshot_interval", 4)
+        versions = _versions(settings.delta_block_size, 20)
+        self._store_all(versions)
+
+        with storage.title_lock(self.TITLE):
+            depths = [f.depth for _, files, _ in storage._walk_history(self.TITLE) for f in files.values()]
+        assert max(depths) <= 4
+        assert depths.count(0) >= 3
+        oldest = storage.list_history(self.TITLE)[-1]["version"]
+        assert storage.load_history_files(self.TITLE, oldest) == [("main", versions[0])]
+
+    def test_compaction_is_idempotent(self):
+        self._store_all(_versions(settings.delta_block_size, 5), compact=False)
+        assert storage.compact_history(self.TITLE) == 4
+        assert storage.compact_history(self.TITLE) == 0
+
+    def test_shared_blob_stays_whole(self):
+        versions = _versions(settings.delta_block_size, 2)
+        storage.store_save(_bundle(0x0004000000030800, versions[0]))
+        self._store_all(versions)
+
+        assert storage.list_history(self.TITLE)[0]["delta_files"] == 0
+        assert storage.load_save_files("0004000000030800") == [("main", versions[0])]
+
+    def test_pruning_keeps_newer_deltas_restorable(self, monkeypatch):
+        monkeypatch.setattr(settings, "max_history_versions", 3)
+        versions = _versions(settings.delta_block_size, 8)
+        self._store_all(versions)
+
+        history = storage.list_history(self.TITLE)
+        assert len(history) == 3
+        for entry, data in zip(history, reversed(versions[:-1])):
+            assert storage.load_history_files(self.TITLE, entry["version"]) == [("main", data)]
+        # Every blob left is referenced by a manifest
+        with storage._blob_lock:
+            refs = set(storage._blob_refs())
+        assert set(_blobs(settings.save_dir)) == refs
+
+    def test_restore_makes_version_current(self):
+        versions = _versions(settings.delta_block_size, 3)
+        self._store_all(versions)
+        oldest = storage.list_history(self.TITLE)[-1]["version"]
+
+        meta = storage.restore_history(self.TITLE, oldest, console_id="abc")
+        assert meta.last_sync_source == "restore"
+        assert meta.save_hash == hashlib.sha256(versions[0]).hexdigest()
+        assert storage.load_save_files(self.TITLE) == [("main", versions[0])]
+        assert len(storage.list_history(self.TITLE)) == 3
+        assert storage.restore_history(self.TITLE, "2000-01-01T00_00_00") is None
+
+    def test_compaction_scheduled_after_upload(self, monkeypatch):
+        monkeypatch.setattr(settings, "history_compaction", True)
+        self._store_all(_versions(settings.delta_block_size, 2), compact=False)
+        workers.shutdown()  # Waits for queued work
+
+        assert storage.list_history(self.TITLE)[0]["delta_files"] == 1
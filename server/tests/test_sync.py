@@ -1,7 +1,20 @@
 import hashlib
+import struct
+from pathlib import Path
+
+import pytest
+
+from app.services.changes_binary import CHANGES_FLAG_RESET, CHANGES_MAGIC
 
 from app.models.save import BundleFile, SaveBundle
 from app.services.bundle import create_bundle
+from app.services.sync_binary import (
+    ACTION_CONFLICT,
+    ACTION_DOWNLOAD,
+    ACTION_SERVER_ONLY,
+    ACTION_UP_TO_DATE,
+    ACTION_UPLOAD,
+)
 
 
 def _make_bundle_bytes(
@@ -445,3 +458,176 @@ class TestSyncEndpoint:
             headers=auth_headers,
         )
         assert r.status_code == 422
+
+
+def _binary_sync_request(
+    titles: list[tuple[int, bytes, bytes | None, int, int]], console_id: str = ""
+) -> bytes:
+    """Build a binary sync request from (title_id, hash, last_synced, size, timestamp)."""
+    parts = [b"3DSY", struct.pack("<I16sI", 1, console_id.encode(), len(titles))]
+    for title_id, save_hash, last_synced, size, timestamp in titles:
+        parts.append(struct.pack(">Q32s32s", title_id, save_hash, last_synced or b"\x00" * 32))
+        parts.append(struct.pack("<II", size, timestamp))
+    return b"".join(parts)
+
+
+def _parse_binary_plan(data: bytes) -> dict[str, int]:
+    assert data[:4] == b"3DSP"
+    version, count = struct.unpack_from("<II", data, 4)
+    assert version == 1
+    assert len(data) == 12 + count * 9
+    plan = {}
+    for i in range(count):
+        title_id, action = struct.unpack_from(">QB", data, 12 + i * 9)
+        plan[f"{title_id:016X}"] = action
+    return plan
+
+
+class TestBinarySync:
+    def _post(self, client, auth_headers, body: bytes):
+        return client.post(
+            "/api/v1/sync",
+            content=body,
+            headers={**auth_headers, "Content-Type": "application/octet-stream"},
+        )
+
+    def test_empty_sync(self, client, auth_headers):
+        r = self._post(client, auth_headers, _binary_sync_request([]))
+        assert r.status_code == 200
+        assert r.headers["content-type"] == "application/octet-stream"
+        assert _parse_binary_plan(r.content) == {}
+
+    def test_actions_match_json_plan(self, client, auth_headers):
+        data_a, data_b, data_c = b"save A", b"save B", b"save C"
+        _upload(client, auth_headers, "0004000000055D00",
+                _make_bundle_bytes(0x0004000000055D00, 1000, [("main", data_a)]))
+        _upload(client, auth_headers, "00040000001B5000",
+                _make_bundle_bytes(0x00040000001B5000, 1000, [("main", data_b)]))
+        _upload(client, auth_headers, "0004000000030800",
+                _make_bundle_bytes(0x0004000000030800, 1000, [("main", data_c)]))
+
+        local_b = hashlib.sha256(b"old B").digest()
+        body = _binary_sync_request([
+            # Same hash -> up to date
+            (0x0004000000055D00, hashlib.sha256(data_a).digest(), None, 6, 1000),
+            # Unchanged locally since last sync -> download
+            (0x00040000001B5000, local_b, local_b, 5, 900),
+            # Not on server -> upload
+            (0x0004000000044B00, hashlib.sha256(b"new").digest(), None, 3, 1000),
+            # Never synced, different hash -> conflict
+            (0x00040000000AAA00, hashlib.sha256(b"x").digest(), None, 1, 1000),
+        ])
+        _upload(client, auth_headers, "00040000000AAA00",
+                _make_bundle_bytes(0x00040000000AAA00, 1000, [("main", b"y")]))
+
+        r = self._post(client, auth_headers, body)
+        assert r.status_code == 200
+        assert _parse_binary_plan(r.content) == {
+            "0004000000055D00": ACTION_UP_TO_DATE,
+            "00040000001B5000": ACTION_DOWNLOAD,
+            "0004000000044B00": ACTION_UPLOAD,
+            "00040000000AAA00": ACTION_CONFLICT,
+            "0004000000030800": ACTION_SERVER_ONLY,
+        }
+
+    def test_truncated_request_rejected(self, client, auth_headers):
+        body = _binary_sync_request([(0x0004000000055D00, b"\x11" * 32, None, 1, 1)])
+        r = self._post(client, auth_headers, body[:-1])
+        assert r.status_code == 400
+
+    def test_invalid_magic_rejected(self, client, auth_headers):
+        r = self._post(client, auth_headers, b"XXXX" + b"\x00" * 24)
+        assert r.status_code == 400
+
+
+class TestChangesEndpoint:
+    def test_cursor_only_without_since(self, client, auth_headers):
+        _upload(client, auth_headers, "0004000000055D00", _make_bundle_bytes())
+        r = client.get("/api/v1/changes", headers=auth_headers)
+        assert r.status_code == 200
+        assert r.json() == {"cursor": 1, "reset": False, "changes": []}
+
+    def test_lists_titles_changed_since_cursor(self, client, auth_headers):
+        _upload(client, auth_headers, "0004000000055D00", _make_bundle_bytes())
+        cursor = client.get("/api/v1/changes", headers=auth_headers).json()["cursor"]
+        data = b"other save"
+        _upload(client, auth_headers, "0004000000030800",
+                _make_bundle_bytes(0x0004000000030800, files=[("main", data)]))
+
+        body = client.get(f"/api/v1/changes?since={cursor}", headers=auth_headers).json()
+        assert body["cursor"] == cursor + 1
+        assert [(c["title_id"], c["save_hash"]) for c in body["changes"]] == [
+            ("0004000000030800", _save_hash(data))
+        ]
+
+    def test_binary_format(self, client, auth_headers):
+        data = b"save data here"
+        _upload(client, auth_headers, "0004000000055D00", _make_bundle_bytes(files=[("main", data)]))
+        r = client.get("/api/v1/changes?since=5&format=binary", headers=auth_headers)
+        assert r.headers["content-type"] == "application/octet-stream"
+
+        magic, version, cursor, flags, count = struct.unpack_from("<4sIQII", r.content, 0)
+        assert (magic, version, cursor, count) == (CHANGES_MAGIC, 1, 1, 1)
+        assert flags & CHANGES_FLAG_RESET  # since was ahead of the server
+        title_id, save_hash = struct.unpack_from(">Q32s", r.content, 24)
+        assert title_id == 0x0004000000055D00
+        assert save_hash.hex() == _save_hash(data)
+
+    def test_negative_cursor_rejected(self, client, auth_headers):
+        r = client.get("/api/v1/changes?since=-1", headers=auth_headers)
+        assert r.status_code == 422
+
+
+@pytest.fixture()
+def ds_sync(client, monkeypatch):
+    """tools/ds_sync.py talking to the test app instead of a server."""
+    monkeypatch.syspath_prepend(str(Path(__file__).resolve().parents[2] / "tools"))
+    import ds_sync
+
+    def api_request(server, path, api_key, method="GET", data=None,
+                    content_type="application/octet-stream"):
+        headers = {"X-API-Key": api_key}
+        if data is not None:
+            headers["Content-Type"] = content_type
+        r = client.request(method, f"/api/v1{path}", content=data, headers=headers)
+        return r.status_code, r.content
+
+    monkeypatch.setattr(ds_sync, "api_request", api_request)
+    return ds_sync
+
+
+def _ds_game(ds_sync, tmp_path, code: str, save: bytes | None) -> dict:
+    sav_path = tmp_path / f"{code}.sav"
+    if save is not None:
+        sav_path.write_bytes(save)
+    return {
+        "rom_path": tmp_path / f"{code}.nds",
+        "sav_path": sav_path,
+        "gamecode": code,
+        "title_id": ds_sync.gamecode_to_title_id(code),
+        "name": code,
+        "has_save": save is not None,
+    }
+
+
+class TestDsSyncChangeFeed:
+    def test_new_saveless_rom_downloads_older_server_save(
+        self, ds_sync, client, auth_headers, api_key, tmp_path
+    ):
+        # Another console uploaded this game's save before our last sync
+        server_save = b"\x5a" * 512
+        title_id = ds_sync.gamecode_to_title_id("BBBE")
+        _upload(client, auth_headers, title_id,
+                ds_sync.create_bundle(int(title_id, 16), server_save))
+
+        games = [_ds_game(ds_sync, tmp_path, "AAAE", b"\x11" * 512)]
+        state = ds_sync.do_sync(games, "http://test", api_key, "ds-console", {})
+        assert ds_sync.CHANGES_CURSOR_KEY in state
+
+        # The ROM shows up later without a .sav: the feed doesn't list its
+        # save, but it must still come down
+        games.append(_ds_game(ds_sync, tmp_path, "BBBE", None))
+        state = ds_sync.do_sync(games, "http://test", api_key, "ds-console", state)
+        assert (tmp_path / "BBBE.sav").read_bytes() == server_save
+        assert state[title_id] == _save_hash(server_save)
+
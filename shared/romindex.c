@@ -0,0 +1,161 @@
+// NDS ROM scan index, stored as one "<size> <mtime> <code> <rom path>\t<save path>"
+// line per ROM. Lookups try the entry after the previous hit first, since
+// directories are read back in the same order on every scan.
+
+#include "romindex.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NDS_GAMECODE_OFFSET 0x0C
+
+static RomIndexEntry *entries = NULL;
+static int entry_count = 0;
+static int entry_cap = 0;
+static int cursor = 0;
+static bool dirty = false;
+static char index_path[ROMINDEX_PATH_LEN];
+
+bool romindex_read_gamecode(const char *rom_path, char *code_out) {
+    FILE *f = fopen(rom_path, "rb");
+    if (!f) return false;
+
+    fseek(f, NDS_GAMECODE_OFFSET, SEEK_SET);
+    char code[4];
+    size_t rd = fread(code, 1, 4, f);
+    fclose(f);
+
+    if (rd != 4) return false;
+
+    // Validate printable ASCII
+    for (int i = 0; i < 4; i++) {
+        if (code[i] < 0x20 || code[i] > 0x7E)
+            return false;
+    }
+
+    memcpy(code_out, code, 4);
+    code_out[4] = '\0';
+    return true;
+}
+
+static RomIndexEntry *new_entry(void) {
+    if (entry_count == entry_cap) {
+        int cap = entry_cap ? entry_cap * 2 : 64;
+        RomIndexEntry *grown = (RomIndexEntry *)realloc(entries, cap * sizeof(RomIndexEntry));
+        if (!grown) return NULL;
+        entries = grown;
+        entry_cap = cap;
+    }
+    RomIndexEntry *e = &entries[entry_count++];
+    memset(e, 0, sizeof(RomIndexEntry));
+    return e;
+}
+
+void romindex_begin(const char *index_file) {
+    entry_count = 0;
+    cursor = 0;
+    dirty = false;
+    snprintf(index_path, sizeof(index_path), "%s", index_file);
+
+    FILE *f = fopen(index_path, "r");
+    if (!f) return;
+
+    char line[ROMINDEX_PATH_LEN * 2 + 48];
+    while (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = '\0';
+
+        unsigned long size, mtime;
+        char code[5];
+        int consumed = 0;
+        if (sscanf(line, "%lu %lu %4s %n", &size, &mtime, code, &consumed) != 3 || !consumed)
+            continue;
+        char *path = line + consumed;
+        char *tab = strchr(path, '\t');
+        if (!tab || tab == path || strlen(code) != 4) continue;
+        *tab = '\0';
+
+        RomIndexEntry *e = new_entry();
+        if (!e) break;
+        snprintf(e->path, sizeof(e->path), "%s", path);
+        snprintf(e->sav_path, sizeof(e->sav_path), "%s", tab + 1);
+        memcpy(e->code, code, 5);
+        e->size = (uint32_t)size;
+        e->mtime = (uint32_t)mtime;
+    }
+    fclose(f);
+}
+
+static RomIndexEntry *find_path(const char *path) {
+    if (cursor < entry_count && strcmp(entries[cursor].path, path) == 0)
+        return &entries[cursor++];
+    for (int i = 0; i < entry_count; i++) {
+        if (strcmp(entries[i].path, path) == 0) {
+            cursor = i + 1;
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+RomIndexEntry *romindex_find(const char *path, uint32_t size, uint32_t mtime) {
+    RomIndexEntry *e = find_path(path);
+    if (!e || e->size != size || e->mtime != mtime) return NULL;
+    e->seen = true;
+    return e;
+}
+
+RomIndexEntry *romindex_add(const char *path, uint32_t size, uint32_t mtime,
+                            const char *code) {
+    RomIndexEntry *e = find_path(path);
+    if (!e) {
+        e = new_entry();
+        if (!e) return NULL;
+        snprintf(e->path, sizeof(e->path), "%s", path);
+    }
+    e->size = size;
+    e->mtime = mtime;
+    memcpy(e->code, code, 4);
+    e->code[4] = '\0';
+    e->sav_path[0] = '\0';
+    e->seen = true;
+    dirty = true;
+    return e;
+}
+
+void romindex_set_save(RomIndexEntry *entry, const char *sav_path) {
+    if (!entry || strcmp(entry->sav_path, sav_path) == 0) return;
+    snprintf(entry->sav_path, sizeof(entry->sav_path), "%s", sav_path);
+    dirty = true;
+}
+
+void romindex_end(void) {
+    // ROMs deleted (or in a directory no longer scanned) drop out
+    int kept = 0;
+    for (int i = 0; i < entry_count; i++) {
+        if (entries[i].seen)
+            entries[kept++] = entries[i];
+    }
+    if (kept != entry_count) dirty = true;
+    entry_count = kept;
+
+    if (dirty && index_path[0]) {
+        FILE *f = fopen(index_path, "w");
+        if (f) {
+            for (int i = 0; i < entry_count; i++) {
+                // Skip what the line format can't hold; it's just re-read next scan
+                if (strchr(entries[i].code, ' ') || strpbrk(entries[i].path, "\t\n") ||
+                    strpbrk(entries[i].sav_path, "\t\n"))
+                    continue;
+                fprintf(f, "%lu %lu %s %s\t%s\n",
+                    (unsigned long)entries[i].size, (unsigned long)entries[i].mtime,
+                    entries[i].code, entries[i].path, entries[i].sav_path);
+            }
+            fclose(f);
+        }
+    }
+
+    free(entries);
+    entries = NULL;
+    entry_count = entry_cap = 0;
+    dirty = false;
+}
@@ -0,0 +1,46 @@
+#ifndef ROMINDEX_H
+#define ROMINDEX_H
+
+// NDS ROM scan index shared by the 3DS and DS clients.
+// Maps a ROM path to its game code and resolved save path, keyed on the
+// ROM's size and mtime, so a rescan only opens ROMs that are new or have
+// changed. Entries are keyed by full path, so ROMs in subdirectories are
+// indexed like any other.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ROMINDEX_PATH_LEN 256
+
+typedef struct {
+    char path[ROMINDEX_PATH_LEN];
+    uint32_t size;
+    uint32_t mtime;
+    char code[5];                      // 4-char game code from the header
+    char sav_path[ROMINDEX_PATH_LEN];  // Save found for this ROM ("" = none)
+    bool seen;                         // Visited by the current scan
+} RomIndexEntry;
+
+// Read the 4-char game code at 0x0C of an NDS ROM header.
+// Returns true and fills code_out (5 bytes) if it is printable ASCII.
+bool romindex_read_gamecode(const char *rom_path, char *code_out);
+
+// Start a scan, loading the index from index_file.
+void romindex_begin(const char *index_file);
+
+// Look up a ROM. Returns its entry if the index has one with the same size
+// and mtime, else NULL (the caller reads the ROM and calls romindex_add).
+RomIndexEntry *romindex_find(const char *path, uint32_t size, uint32_t mtime);
+
+// Record a ROM read during this scan. Returns NULL if out of memory.
+RomIndexEntry *romindex_add(const char *path, uint32_t size, uint32_t mtime,
+                            const char *code);
+
+// Record the save found (or "" for none) for an entry.
+void romindex_set_save(RomIndexEntry *entry, const char *sav_path);
+
+// Finish a scan: drop ROMs that weren't seen and write the index back
+// if anything changed.
+void romindex_end(void);
+
+#endif // ROMINDEX_H
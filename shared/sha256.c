@@ -0,0 +1,167 @@
+// SHA-256 (FIPS 180-4) for the 3DS (ARM11) and DS (ARM9) clients.
+// Rounds are fully unrolled with the working variables renamed instead of
+// shifted, and the message schedule is expanded in a 16-word ring, so the
+// whole state stays in registers/stack on both CPUs. Data is hashed in
+// place; only partial blocks go through the context buffer.
+
+#include "sha256.h"
+#include <string.h>
+
+#if defined(ARM9)
+#include <nds/ndstypes.h>
+#endif
+
+// On the DS the block function runs from ITCM: the ARM9's 8KB instruction
+// cache can't hold it alongside the caller's code
+#ifdef ITCM_CODE
+#define SHA256_HOT ITCM_CODE
+#else
+#define SHA256_HOT
+#endif
+
+static const uint32_t K[64] = {
+    0x428a2f98,0x71374491,0xb5c0fbcf,0xe9b5dba5,0x3956c25b,0x59f111f1,0x923f82a4,0xab1c5ed5,
+    0xd807aa98,0x12835b01,0x243185be,0x550c7dc3,0x72be5d74,0x80deb1fe,0x9bdc06a7,0xc19bf174,
+    0xe49b69c1,0xefbe4786,0x0fc19dc6,0x240ca1cc,0x2de92c6f,0x4a7484aa,0x5cb0a9dc,0x76f988da,
+    0x983e5152,0xa831c66d,0xb00327c8,0xbf597fc7,0xc6e00bf3,0xd5a79147,0x06ca6351,0x14292967,
+    0x27b70a85,0x2e1b2138,0x4d2c6dfc,0x53380d13,0x650a7354,0x766a0abb,0x81c2c92e,0x92722c85,
+    0xa2bfe8a1,0xa81a664b,0xc24b8b70,0xc76c51a3,0xd192e819,0xd6990624,0xf40e3585,0x106aa070,
+    0x19a4c116,0x1e376c08,0x2748774c,0x34b0bcb5,0x391c0cb3,0x4ed8aa4a,0x5b9cca4f,0x682e6ff3,
+    0x748f82ee,0x78a5636f,0x84c87814,0x8cc70208,0x90befffa,0xa4506ceb,0xbef9a3f7,0xc67178f2
+};
+
+// ROTR maps onto the ARM barrel shifter, so each sigma is 3 instructions
+#define ROTR(x,n) (((x)>>(n))|((x)<<(32-(n))))
+#define CH(x,y,z) ((z)^((x)&((y)^(z))))
+#define MAJ(x,y,z) (((x)&(y))|((z)&((x)|(y))))
+#define EP0(x) (ROTR(x,2)^ROTR(x,13)^ROTR(x,22))
+#define EP1(x) (ROTR(x,6)^ROTR(x,11)^ROTR(x,25))
+#define SIG0(x) (ROTR(x,7)^ROTR(x,18)^((x)>>3))
+#define SIG1(x) (ROTR(x,17)^ROTR(x,19)^((x)>>10))
+
+#if defined(__ARM_ARCH) && __ARM_ARCH >= 6 && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+// ARMv6 (3DS): unaligned word load + REV
+static inline uint32_t load_be32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return __builtin_bswap32(v);
+}
+#else
+static inline uint32_t load_be32(const uint8_t *p) {
+    return ((uint32_t)p[0]<<24) | ((uint32_t)p[1]<<16) |
+           ((uint32_t)p[2]<<8)  | ((uint32_t)p[3]);
+}
+#endif
+
+// Message schedule: w[] holds the last 16 words, W[i] replaces W[i-16]
+#define W(i) w[(i) & 15]
+#define LOAD(i) (W(i) = load_be32(block + (i) * 4))
+#define EXPAND(i) (W(i) += SIG1(W((i) - 2)) + W((i) - 7) + SIG0(W((i) - 15)))
+
+// One round. Instead of shifting a..h, callers rotate the argument order:
+// d becomes the new e and h the new a.
+#define ROUND(a,b,c,d,e,f,g,h,i,wi) do { \
+    uint32_t t1 = h + EP1(e) + CH(e,f,g) + K[i] + (wi); \
+    d += t1; \
+    h = t1 + EP0(a) + MAJ(a,b,c); \
+} while (0)
+
+#define ROUNDS8(i, WF) do { \
+    ROUND(a,b,c,d,e,f,g,h,(i)+0,WF((i)+0)); \
+    ROUND(h,a,b,c,d,e,f,g,(i)+1,WF((i)+1)); \
+    ROUND(g,h,a,b,c,d,e,f,(i)+2,WF((i)+2)); \
+    ROUND(f,g,h,a,b,c,d,e,(i)+3,WF((i)+3)); \
+    ROUND(e,f,g,h,a,b,c,d,(i)+4,WF((i)+4)); \
+    ROUND(d,e,f,g,h,a,b,c,(i)+5,WF((i)+5)); \
+    ROUND(c,d,e,f,g,h,a,b,(i)+6,WF((i)+6)); \
+    ROUND(b,c,d,e,f,g,h,a,(i)+7,WF((i)+7)); \
+} while (0)
+
+// Hash count consecutive 64-byte blocks
+SHA256_HOT static void sha256_blocks(uint32_t state[8], const uint8_t *block, size_t count) {
+    uint32_t w[16];
+
+    while (count--) {
+        uint32_t a=state[0], b=state[1], c=state[2], d=state[3];
+        uint32_t e=state[4], f=state[5], g=state[6], h=state[7];
+
+        ROUNDS8(0, LOAD);
+        ROUNDS8(8, LOAD);
+        ROUNDS8(16, EXPAND);
+        ROUNDS8(24, EXPAND);
+        ROUNDS8(32, EXPAND);
+        ROUNDS8(40, EXPAND);
+        ROUNDS8(48, EXPAND);
+        ROUNDS8(56, EXPAND);
+
+        state[0]+=a; state[1]+=b; state[2]+=c; state[3]+=d;
+        state[4]+=e; state[5]+=f; state[6]+=g; state[7]+=h;
+        block += 64;
+    }
+}
+
+void sha256_init(SHA256_CTX *ctx) {
+    ctx->count = 0;
+    ctx->state[0]=0x6a09e667; ctx->state[1]=0xbb67ae85;
+    ctx->state[2]=0x3c6ef372; ctx->state[3]=0xa54ff53a;
+    ctx->state[4]=0x510e527f; ctx->state[5]=0x9b05688c;
+    ctx->state[6]=0x1f83d9ab; ctx->state[7]=0x5be0cd19;
+}
+
+void sha256_update(SHA256_CTX *ctx, const uint8_t *data, size_t len) {
+    size_t fill = (size_t)(ctx->count & 63);
+    ctx->count += len;
+
+    // Top up a partial block first
+    if (fill) {
+        size_t take = 64 - fill;
+        if (take > len) take = len;
+        memcpy(ctx->buffer + fill, data, take);
+        data += take;
+        len -= take;
+        if (fill + take < 64) return;
+        sha256_blocks(ctx->state, ctx->buffer, 1);
+    }
+
+    // Whole blocks straight from the caller's buffer
+    if (len >= 64) {
+        size_t blocks = len / 64;
+        sha256_blocks(ctx->state, data, blocks);
+        data += blocks * 64;
+        len -= blocks * 64;
+    }
+
+    if (len) memcpy(ctx->buffer, data, len);
+}
+
+void sha256_final(SHA256_CTX *ctx, uint8_t hash[32]) {
+    uint64_t bits = ctx->count * 8;
+    size_t pad_idx = (size_t)(ctx->count % 64);
+
+    ctx->buffer[pad_idx++] = 0x80;
+    if (pad_idx > 56) {
+        memset(ctx->buffer + pad_idx, 0, 64 - pad_idx);
+        sha256_blocks(ctx->state, ctx->buffer, 1);
+        pad_idx = 0;
+    }
+    memset(ctx->buffer + pad_idx, 0, 56 - pad_idx);
+
+    for (int i = 0; i < 8; i++)
+        ctx->buffer[63 - i] = (uint8_t)(bits >> (i * 8));
+
+    sha256_blocks(ctx->state, ctx->buffer, 1);
+
+    for (int i = 0; i < 8; i++) {
+        hash[i*4]   = (uint8_t)(ctx->state[i] >> 24);
+        hash[i*4+1] = (uint8_t)(ctx->state[i] >> 16);
+        hash[i*4+2] = (uint8_t)(ctx->state[i] >> 8);
+        hash[i*4+3] = (uint8_t)(ctx->state[i]);
+    }
+}
+
+void sha256(const uint8_t *data, size_t len, uint8_t hash[32]) {
+    SHA256_CTX ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, data, len);
+    sha256_final(&ctx, hash);
+}
@@ -1,6 +1,8 @@
 #ifndef SHA256_H
 #define SHA256_H
 
+// SHA-256 shared by the 3DS and DS clients
+
 #include <stdint.h>
 #include <stddef.h>
 
@@ -0,0 +1,48 @@
+// String pool: a list of blocks filled front to back. A string that does
+// not fit in the current block starts a new one (sized for the string if
+// it is bigger than a block); the leftover space is not reused.
+
+#include "strpool.h"
+#include <stdlib.h>
+#include <string.h>
+
+struct StrPoolBlock {
+    StrPoolBlock *next;
+    size_t used;
+    size_t size;
+    char data[];
+};
+
+const char *strpool_addn(StrPool *pool, const char *s, size_t len) {
+    const char *end = memchr(s, '\0', len);
+    if (end) len = (size_t)(end - s);
+
+    StrPoolBlock *b = pool->head;
+    if (!b || b->size - b->used < len + 1) {
+        size_t size = len + 1 > STRPOOL_BLOCK_SIZE ? len + 1 : STRPOOL_BLOCK_SIZE;
+        b = (StrPoolBlock *)malloc(sizeof(StrPoolBlock) + size);
+        if (!b) return NULL;
+        b->next = pool->head;
+        b->used = 0;
+        b->size = size;
+        pool->head = b;
+    }
+
+    char *out = b->data + b->used;
+    memcpy(out, s, len);
+    out[len] = '\0';
+    b->used += len + 1;
+    return out;
+}
+
+const char *strpool_add(StrPool *pool, const char *s) {
+    return strpool_addn(pool, s, strlen(s));
+}
+
+void strpool_clear(StrPool *pool) {
+    while (pool->head) {
+        StrPoolBlock *next = pool->head->next;
+        free(pool->head);
+        pool->head = next;
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef STRPOOL_H
+#define STRPOOL_H
+
+// String pool shared by the 3DS and DS clients' title tables.
+// Strings are copied into large blocks that never move, so the pointers
+// handed out stay valid until the pool is cleared. Names and paths live
+// here instead of in fixed-size buffers in every title, so memory follows
+// what the titles actually use.
+
+#include <stddef.h>
+
+#define STRPOOL_BLOCK_SIZE 4096
+
+typedef struct StrPoolBlock StrPoolBlock;
+
+typedef struct {
+    StrPoolBlock *head; // Newest block, the one being filled
+} StrPool;
+
+// Copy a string into the pool. Returns the pooled copy, or NULL if out of
+// memory.
+const char *strpool_add(StrPool *pool, const char *s);
+
+// Same for the first len bytes of s (stopping early at a NUL).
+const char *strpool_addn(StrPool *pool, const char *s, size_t len);
+
+// Free every block. All strings from the pool become invalid.
+void strpool_clear(StrPool *pool);
+
+#endif // STRPOOL_H
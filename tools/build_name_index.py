@@ -0,0 +1,43 @@
+#!/usr/bin/env python3
+"""Build the binary game-name indexes the server and ds_sync.py load.
+
+Turns each CODE,Name text database into a sorted index file next to it
+(3dstdb.txt -> 3dstdb.idx); the format is described in
+server/app/services/names_index.py. Rerun it whenever a text database
+changes - an index older than its text file is ignored.
+
+Usage: build_name_index.py [DB.txt ...]   (default: both server databases)
+"""
+
+import sys
+from pathlib import Path
+
+DATA_DIR = Path(__file__).resolve().parent.parent / "server" / "data"
+sys.path.insert(0, str(DATA_DIR.parent))
+
+from app.services.names_index import NameIndex, build_index, parse_text  # noqa: E402
+
+
+def build(db_path: Path) -> Path:
+    """Write the index for one text database and return its path."""
+    data = build_index(parse_text(db_path))
+    idx_path = db_path.with_suffix(".idx")
+    tmp_path = idx_path.with_suffix(".idx.tmp")
+    tmp_path.write_bytes(data)
+    tmp_path.replace(idx_path)
+    print(f"{idx_path.name}: {len(NameIndex(data))} names, {len(data)} bytes")
+    return idx_path
+
+
+def main() -> int:
+    paths = [Path(arg) for arg in sys.argv[1:]] or [DATA_DIR / "3dstdb.txt", DATA_DIR / "dstdb.txt"]
+    for path in paths:
+        if not path.exists():
+            print(f"{path}: not found", file=sys.stderr)
+            return 1
+        build(path)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
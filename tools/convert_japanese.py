@@ -6,6 +6,8 @@ from pathlib import Path
 
 import pykakasi
 
+from build_name_index import build
+
 DB_PATH = Path(__file__).parent.parent / "server" / "data" / "3dstdb.txt"
 
 # Japanese character ranges (hiragana, katakana, kanji)
@@ -101,6 +103,9 @@ def main():
     print(f"Removed {korean_count} Korean entries (no romaji available)")
     print(f"Total lines: {len(new_lines)}")
 
+    # Keep the server's prebuilt index in step with the text
+    build(DB_PATH)
+
 
 if __name__ == '__main__':
     main()
@@ -8,19 +8,23 @@ Usage:
     python ds_sync.py --sd-path E:\\ --server http://192.168.1.201:8000 --api-key mykey
     python ds_sync.py --roms-dir E:\\nds --saves-dir E:\\nds\\saves --server ... --api-key ...
     python ds_sync.py --sd-path E:\\ --server ... --api-key ... --dry-run
+    python ds_sync.py --sd-path E:\\ --server ... --api-key ... --jobs 8
 """
 
 import argparse
 import hashlib
+import http.client
 import json
 import random
 import struct
 import sys
+import threading
 import time
 import zlib
+from collections.abc import Mapping
+from concurrent.futures import ThreadPoolExecutor, as_completed
 from pathlib import Path
-from urllib.request import Request, urlopen
-from urllib.error import HTTPError, URLError
+from urllib.parse import urlsplit
 
 # --- Constants ---
 
@@ -28,7 +32,17 @@ TITLE_ID_PREFIX = 0x00048000  # Prefix for DS game title IDs
 NDS_GAMECODE_OFFSET = 0x0C    # Offset of 4-char game code in NDS ROM header
 BUNDLE_MAGIC = b"3DSS"
 BUNDLE_VERSION_COMPRESSED = 2
+BUNDLE_VERSION_CODECS = 3
+CODEC_STORED = 0
+CODEC_ZLIB = 1
+NAMES_MAGIC = b"3DSN"         # Prebuilt name index, see server/app/services/names_index.py
+NAMES_INDEX_VERSION = 1
+ZLIB_LEVEL_FAST = 1           # What the 3DS client deflates uploads at by default
 SYNC_DIR_NAME = ".ds_sync"    # Hidden folder on SD card for sync data
+HASH_CACHE_KEY = "hash_cache" # State entry: sav path -> [size, mtime_ns, sha256]
+CHANGES_CURSOR_KEY = "changes_cursor"  # State entry: server change cursor after a clean sync
+DEFAULT_JOBS = 4              # Worker threads for scanning, hashing and transfers
+HTTP_TIMEOUT = 30
 
 
 # --- Title ID generation ---
@@ -92,9 +106,13 @@ def find_sav_for_rom(rom_path: Path, saves_dir: Path | None = None) -> Path | No
     return None
 
 
-def scan_roms(scan_path: Path, saves_dir: Path | None = None) -> list[dict]:
+def scan_roms(scan_path: Path, saves_dir: Path | None = None,
+              jobs: int = DEFAULT_JOBS) -> list[dict]:
     """Scan for NDS ROMs and their matching .sav files.
 
+    ROM headers are read on `jobs` threads (SD card latency, not CPU, is
+    what a scan waits on); results keep the sorted path order.
+
     Returns list of dicts with: rom_path, sav_path, gamecode, title_id, name, has_save
     ROMs without saves are included (has_save=False) so server-only saves can be downloaded.
     """
@@ -102,8 +120,11 @@ def scan_roms(scan_path: Path, saves_dir: Path | None = None) -> list[dict]:
     seen_codes = set()
 
     # Find all .nds files recursively
-    for rom_path in sorted(scan_path.rglob("*.nds")):
-        code = read_gamecode(rom_path)
+    rom_paths = sorted(scan_path.rglob("*.nds"))
+    with ThreadPoolExecutor(max_workers=max(jobs, 1)) as pool:
+        codes = list(pool.map(read_gamecode, rom_paths))
+
+    for rom_path, code in zip(rom_paths, codes):
         if not code:
             continue
 
@@ -138,8 +159,65 @@ def scan_roms(scan_path: Path, saves_dir: Path | None = None) -> list[dict]:
 
 # --- Game name lookup ---
 
-def load_name_database(db_path: Path) -> dict[str, str]:
-    """Load game names from dstdb.txt. Returns dict of code -> name."""
+_NAMES_HEADER = struct.Struct("<4sIII32s")
+_NAMES_ENTRY = struct.Struct("<4sII")
+
+
+class NameIndex(Mapping):
+    """Read-only code -> name view of a prebuilt .idx file (binary search)."""
+
+    def __init__(self, data: bytes):
+        if len(data) < _NAMES_HEADER.size:
+            raise ValueError("Name index too short")
+        magic, version, count, blob_size, _ = _NAMES_HEADER.unpack_from(data)
+        if magic != NAMES_MAGIC or version != NAMES_INDEX_VERSION:
+            raise ValueError("Not a version 1 name index")
+        self._blob = _NAMES_HEADER.size + count * _NAMES_ENTRY.size
+        if len(data) != self._blob + blob_size:
+            raise ValueError("Name index size doesn't match its header")
+        self._data = data
+        self._count = count
+
+    def _entry(self, i: int) -> tuple[bytes, int, int]:
+        return _NAMES_ENTRY.unpack_from(self._data, _NAMES_HEADER.size + i * _NAMES_ENTRY.size)
+
+    def __getitem__(self, code: str) -> str:
+        key = code.encode("ascii", "ignore")
+        lo, hi = 0, self._count
+        while lo < hi:
+            mid = (lo + hi) // 2
+            if self._entry(mid)[0] < key:
+                lo = mid + 1
+            else:
+                hi = mid
+        if lo < self._count:
+            entry_code, offset, length = self._entry(lo)
+            if entry_code == key:
+                start = self._blob + offset
+                return self._data[start:start + length].decode("utf-8", "replace")
+        raise KeyError(code)
+
+    def __iter__(self):
+        for i in range(self._count):
+            yield self._entry(i)[0].decode("ascii")
+
+    def __len__(self) -> int:
+        return self._count
+
+
+def load_name_database(db_path: Path) -> Mapping[str, str]:
+    """Load game names for dstdb.txt. Returns a mapping of code -> name.
+
+    Uses the prebuilt dstdb.idx (tools/build_name_index.py) when it is at
+    least as new as the text file, and parses the text otherwise.
+    """
+    idx_path = db_path.with_suffix(".idx")
+    try:
+        if not db_path.exists() or idx_path.stat().st_mtime_ns >= db_path.stat().st_mtime_ns:
+            return NameIndex(idx_path.read_bytes())
+    except (OSError, ValueError):
+        pass
+
     names = {}
     if not db_path.exists():
         return names
@@ -165,37 +243,99 @@ def hash_save(sav_path: Path) -> str:
     return hashlib.sha256(data).hexdigest()
 
 
+def hash_saves(games: list[dict], state: dict, jobs: int = DEFAULT_JOBS) -> int:
+    """Set save_hash and save_size on every game, hashing saves in parallel.
+
+    A save whose size and mtime match the hash cache in state is not read
+    again. The cache is rewritten to hold just this scan's saves.
+    Returns the number of saves actually hashed.
+    """
+    cache = state.get(HASH_CACHE_KEY, {})
+    fresh = {}
+    todo = []
+    for g in games:
+        g["save_hash"] = ""
+        g["save_size"] = 0
+        if not g["has_save"]:
+            continue
+        st = g["sav_path"].stat()
+        g["save_size"] = st.st_size
+        key = str(g["sav_path"])
+        cached = cache.get(key)
+        if cached and cached[0] == st.st_size and cached[1] == st.st_mtime_ns:
+            g["save_hash"] = cached[2]
+            fresh[key] = cached
+        else:
+            todo.append((g, key, [st.st_size, st.st_mtime_ns]))
+
+    # hashlib drops the GIL for large buffers, so threads hash in parallel
+    with ThreadPoolExecutor(max_workers=max(jobs, 1)) as pool:
+        hashes = pool.map(lambda item: hash_save(item[0]["sav_path"]), todo)
+        for (g, key, stamp), save_hash in zip(todo, hashes):
+            g["save_hash"] = save_hash
+            fresh[key] = stamp + [save_hash]
+
+    state[HASH_CACHE_KEY] = fresh
+    return len(todo)
+
+
+def remember_hash(state: dict, sav_path: Path, save_hash: str):
+    """Record the hash of a save just written, so the next run can skip it."""
+    st = sav_path.stat()
+    state.setdefault(HASH_CACHE_KEY, {})[str(sav_path)] = [st.st_size, st.st_mtime_ns, save_hash]
+
+
 # --- Bundle format ---
 
-def create_bundle(title_id_int: int, sav_data: bytes) -> bytes:
-    """Create a 3DSS V2 (compressed) bundle from save data."""
+def choose_codec(data: bytes) -> int:
+    """Store the save raw if it looks incompressible, else deflate it.
+
+    Same entropy probe as the 3DS client and the server (first, middle and
+    last 1KB, or the whole file if it's 3KB or less), so all three build
+    the same bundle for the same save.
+    """
+    size = len(data)
+    if size < 32:
+        return CODEC_STORED
+    if size <= 3 * 1024:
+        sample = data
+    else:
+        mid = size // 2 - 512
+        sample = data[:1024] + data[mid:mid + 1024] + data[-1024:]
+    counts = [0] * 256
+    for b in sample:
+        counts[b] += 1
+    n = len(sample)
+    sum_sq = sum(c * c for c in counts)
+    return CODEC_ZLIB if 1024 * sum_sq > 5 * n * (n + 255) else CODEC_STORED
+
+
+def create_bundle(title_id_int: int, sav_data: bytes, level: int = ZLIB_LEVEL_FAST) -> bytes:
+    """Create a 3DSS V3 (per-file codec) bundle from save data."""
     timestamp = int(time.time())
     file_path = b"save.dat"
     file_hash = hashlib.sha256(sav_data).digest()
 
-    # Build payload: file table + file data
-    payload_parts = []
-    # File table entry
-    payload_parts.append(struct.pack("<H", len(file_path)))
-    payload_parts.append(file_path)
-    payload_parts.append(struct.pack("<I", len(sav_data)))
-    payload_parts.append(file_hash)
-    # File data
-    payload_parts.append(sav_data)
-    payload = b"".join(payload_parts)
-
-    # Compress
-    compressed = zlib.compress(payload, level=6)
+    codec = choose_codec(sav_data)
+    encoded = zlib.compress(sav_data, level=level) if codec == CODEC_ZLIB else sav_data
+    # The header's size field is the save as a V1 payload: table + data
+    payload_size = 2 + len(file_path) + 4 + 32 + len(sav_data)
 
     # Build bundle
     header = []
     header.append(BUNDLE_MAGIC)
-    header.append(struct.pack("<I", BUNDLE_VERSION_COMPRESSED))
+    header.append(struct.pack("<I", BUNDLE_VERSION_CODECS))
     header.append(struct.pack(">Q", title_id_int))
     header.append(struct.pack("<I", timestamp))
     header.append(struct.pack("<I", 1))  # file_count
-    header.append(struct.pack("<I", len(payload)))  # uncompressed size
-    header.append(compressed)
+    header.append(struct.pack("<I", payload_size))
+    # File table entry, then the file data
+    header.append(struct.pack("<H", len(file_path)))
+    header.append(file_path)
+    header.append(struct.pack("<I", len(sav_data)))
+    header.append(file_hash)
+    header.append(struct.pack("<BI", codec, len(encoded)))
+    header.append(encoded)
 
     return b"".join(header)
 
@@ -213,7 +353,31 @@ def parse_bundle(data: bytes) -> bytes:
     file_count = struct.unpack_from("<I", data, 20)[0]
     size_field = struct.unpack_from("<I", data, 24)[0]
 
-    if version == BUNDLE_VERSION_COMPRESSED:
+    if version == BUNDLE_VERSION_CODECS:
+        # Table entries carry a codec and encoded size; data is per file
+        offset = 28
+        entries = []
+        for _ in range(file_count):
+            path_len = struct.unpack_from("<H", data, offset)[0]
+            offset += 2 + path_len
+            file_size = struct.unpack_from("<I", data, offset)[0]
+            offset += 4 + 32
+            codec, encoded = struct.unpack_from("<BI", data, offset)
+            offset += 5
+            entries.append((file_size, codec, encoded))
+        all_data = []
+        for file_size, codec, encoded in entries:
+            chunk = data[offset:offset + encoded]
+            offset += encoded
+            if codec == CODEC_ZLIB and encoded:
+                chunk = zlib.decompress(chunk)
+            elif codec not in (CODEC_STORED, CODEC_ZLIB):
+                raise ValueError(f"Unknown codec: {codec}")
+            if len(chunk) != file_size:
+                raise ValueError("Decoded size mismatch")
+            all_data.append(chunk)
+        return b"".join(all_data)
+    elif version == BUNDLE_VERSION_COMPRESSED:
         payload = zlib.decompress(data[28:])
         if len(payload) != size_field:
             raise ValueError("Decompressed size mismatch")
@@ -273,7 +437,11 @@ def get_console_id(sync_dir: Path) -> str:
 
 
 def load_state(sync_dir: Path) -> dict:
-    """Load sync state (last_synced_hash per title_id) from SD card."""
+    """Load sync state from SD card.
+
+    Holds the last_synced_hash per title_id, plus the save hash cache
+    under HASH_CACHE_KEY.
+    """
     state_file = sync_dir / "state.json"
     if state_file.exists():
         return json.loads(state_file.read_text())
@@ -288,30 +456,52 @@ def save_state(sync_dir: Path, state: dict):
 
 # --- HTTP client ---
 
+# One keep-alive connection per thread and server, reused across requests
+_connections = threading.local()
+
+
+def _connection(server: str, fresh: bool = False) -> tuple[http.client.HTTPConnection, str]:
+    """The calling thread's connection to server, and the URL path prefix."""
+    pool = getattr(_connections, "pool", None)
+    if pool is None:
+        pool = _connections.pool = {}
+    url = urlsplit(server)
+    conn = pool.get(server)
+    if conn is None or fresh:
+        if conn is not None:
+            conn.close()
+        cls = http.client.HTTPSConnection if url.scheme == "https" else http.client.HTTPConnection
+        conn = pool[server] = cls(url.netloc, timeout=HTTP_TIMEOUT)
+    return conn, url.path.rstrip("/")
+
+
 def api_request(server: str, path: str, api_key: str,
                 method: str = "GET", data: bytes | None = None,
                 content_type: str = "application/octet-stream") -> tuple[int, bytes]:
-    """Make an HTTP request to the server API.
+    """Make an HTTP request to the server API over a kept-alive connection.
 
-    Returns (status_code, response_body).
+    A request on a connection the server has since closed is retried once
+    on a new one. Returns (status_code, response_body).
     """
-    url = f"{server}/api/v1{path}"
     headers = {"X-API-Key": api_key}
-
     if data is not None:
         headers["Content-Type"] = content_type
-        req = Request(url, data=data, headers=headers, method=method)
-    else:
-        req = Request(url, headers=headers, method=method)
 
-    try:
-        with urlopen(req, timeout=30) as resp:
+    for attempt in range(2):
+        conn, prefix = _connection(server, fresh=attempt > 0)
+        try:
+            conn.request(method, f"{prefix}/api/v1{path}", body=data, headers=headers)
+            resp = conn.getresponse()
             return resp.status, resp.read()
-    except HTTPError as e:
-        return e.code, e.read()
-    except URLError as e:
-        print(f"  Connection error: {e.reason}")
-        return 0, b""
+        except (http.client.RemoteDisconnected, BrokenPipeError, ConnectionResetError):
+            conn.close()
+            if attempt > 0:
+                print("  Connection error: server closed the connection")
+        except (OSError, http.client.HTTPException) as e:
+            conn.close()
+            print(f"  Connection error: {e}")
+            break
+    return 0, b""
 
 
 def api_get(server: str, path: str, api_key: str) -> tuple[int, bytes]:
@@ -330,28 +520,130 @@ def api_post_json(server: str, path: str, api_key: str, payload: dict) -> tuple[
 
 # --- Sync logic ---
 
+def print_server_save(meta: dict | None, indent: str):
+    """Print the server's side of a conflict (metadata from /titles/meta)."""
+    if not meta:
+        return
+    print(f"{indent}Server hash: {meta['save_hash'][:16]}... "
+          f"({meta['save_size']} bytes, synced {meta['last_sync'][:16].replace('T', ' ')}"
+          f"{', from ' + meta['console_id'] if meta.get('console_id') else ''})")
+
+
+def upload_save(server: str, api_key: str, g: dict) -> tuple[str | None, str]:
+    """Upload a game's local save. Returns (synced hash or None, status message)."""
+    sav_data = g["sav_path"].read_bytes()
+    bundle = create_bundle(int(g["title_id"], 16), sav_data)
+    s, r = api_post_bundle(server, f"/saves/{g['title_id']}?force=true&source=ds_sync",
+                           api_key, bundle)
+    if s == 200:
+        return g["save_hash"], "OK"
+    return None, f"Failed (HTTP {s})"
+
+
+def download_save(server: str, api_key: str, g: dict) -> tuple[str | None, str]:
+    """Download the server's save over the local one. Returns (hash or None, message)."""
+    s, r = api_get(server, f"/saves/{g['title_id']}", api_key)
+    if s != 200:
+        return None, f"Failed (HTTP {s})"
+    try:
+        sav_data = parse_bundle(r)
+    except Exception as e:
+        return None, f"Bundle parse error: {e}"
+    g["sav_path"].write_bytes(sav_data)
+    return hashlib.sha256(sav_data).hexdigest(), f"OK ({len(sav_data)} bytes)"
+
+
+def fetch_changes(server: str, api_key: str, since: int | None) -> dict | None:
+    """The server's change feed after since (just its cursor if None).
+
+    None if the server has no /changes endpoint or didn't answer.
+    """
+    s, r = api_get(server, "/changes" if since is None else f"/changes?since={since}", api_key)
+    if s != 200:
+        return None
+    try:
+        return json.loads(r)
+    except ValueError:
+        return None
+
+
+def server_has_unsynced(server: str, api_key: str, games: list[dict], state: dict) -> bool:
+    """Whether the server holds a save for a title with no local save and no sync record.
+
+    The change feed only lists changes after the cursor, so a save the
+    server had before then would otherwise never be downloaded. True if the
+    server couldn't be asked.
+    """
+    title_ids = sorted(g["title_id"] for g in games
+                       if not g["has_save"] and g["title_id"] not in state)
+    if not title_ids:
+        return False
+    s, r = api_post_json(server, "/titles/meta", api_key, {"title_ids": title_ids})
+    if s != 200:
+        return True
+    try:
+        return bool(json.loads(r).get("saves"))
+    except ValueError:
+        return True
+
+
+def changes_need_compare(changes: dict, games: list[dict], state: dict,
+                         server: str, api_key: str) -> bool:
+    """Whether the server may hold a version of a local title we haven't synced.
+
+    That is a change listed for one of our titles with a hash other than its
+    last synced one (our own uploads come back with the hash we recorded),
+    a save never synced at all, or a server save for a title we have no
+    save for and never synced.
+    """
+    if changes.get("reset"):
+        return True
+    if any(g["has_save"] and g["title_id"] not in state for g in games):
+        return True
+    local = {g["title_id"] for g in games}
+    if any(
+        c["title_id"] in local and c["save_hash"] != state.get(c["title_id"])
+        for c in changes.get("changes", [])
+    ):
+        return True
+    return server_has_unsynced(server, api_key, games, state)
+
+
+def record_transfer(state: dict, g: dict, new_hash: str | None, downloaded: bool):
+    if not new_hash:
+        return
+    state[g["title_id"]] = new_hash
+    if downloaded:
+        remember_hash(state, g["sav_path"], new_hash)
+
+
 def do_sync(games: list[dict], server: str, api_key: str, console_id: str,
-            state: dict, dry_run: bool = False) -> dict:
+            state: dict, dry_run: bool = False, jobs: int = DEFAULT_JOBS) -> dict:
     """Run the sync protocol against the server.
 
-    Returns updated state dict.
+    Saves are hashed and transferred `jobs` at a time; conflicts are still
+    resolved one by one. When the server's change feed shows none of our
+    titles changed since the last clean sync, the /sync comparison is
+    skipped and only locally changed saves are uploaded. Returns updated
+    state dict.
     """
     if not games:
         print("No games found.")
         return state
 
+    # Server changes since the last clean sync (before anything is uploaded)
+    since = state.get(CHANGES_CURSOR_KEY)
+    changes = fetch_changes(server, api_key, since)
+
     # Step 1: Build sync request with metadata for all titles
     print(f"\nPreparing sync for {len(games)} title(s)...")
+    hashed = hash_saves(games, state, jobs)
+    cached = sum(1 for g in games if g["has_save"]) - hashed
+    if cached:
+        print(f"  {cached} save(s) unchanged since the last run, {hashed} hashed")
+
     titles_meta = []
     for g in games:
-        if g["has_save"]:
-            save_hash = hash_save(g["sav_path"])
-            g["save_hash"] = save_hash
-            g["save_size"] = g["sav_path"].stat().st_size
-        else:
-            g["save_hash"] = ""
-            g["save_size"] = 0
-
         meta = {
             "title_id": g["title_id"],
             "save_hash": g["save_hash"],
@@ -368,16 +660,25 @@ def do_sync(games: list[dict], server: str, api_key: str, console_id: str,
 
     sync_request = {"console_id": console_id, "titles": titles_meta}
 
-    # Step 2: Send sync request
-    print("Sending sync request to server...")
-    status, resp = api_post_json(server, "/sync", api_key, sync_request)
-    if status != 200:
-        print(f"Sync request failed (HTTP {status})")
-        if resp:
-            print(f"  {resp.decode('utf-8', errors='replace')[:200]}")
-        return state
+    # Step 2: Send sync request, unless nothing changed on the server
+    if (changes is not None and since is not None
+            and not changes_need_compare(changes, games, state, server, api_key)):
+        print("No server changes since the last sync")
+        changed = {g["title_id"] for g in games if g["save_hash"] != state.get(g["title_id"])}
+        plan = {
+            "upload": sorted(changed),
+            "up_to_date": sorted({g["title_id"] for g in games} - changed),
+        }
+    else:
+        print("Sending sync request to server...")
+        status, resp = api_post_json(server, "/sync", api_key, sync_request)
+        if status != 200:
+            print(f"Sync request failed (HTTP {status})")
+            if resp:
+                print(f"  {resp.decode('utf-8', errors='replace')[:200]}")
+            return state
+        plan = json.loads(resp)
 
-    plan = json.loads(resp)
     upload_ids = set(plan.get("upload", []))
     download_ids = set(plan.get("download", []))
     conflict_ids = set(plan.get("conflict", []))
@@ -414,6 +715,13 @@ def do_sync(games: list[dict], server: str, api_key: str, console_id: str,
     if no_save_conflicts:
         print(f"  (auto-downloading {len(no_save_conflicts)} conflict(s) with no local save)")
 
+    # Server side of every conflict, for the user to choose from, in one request
+    server_saves = {}
+    if conflict_ids:
+        s, r = api_post_json(server, "/titles/meta", api_key, {"title_ids": sorted(conflict_ids)})
+        if s == 200:
+            server_saves = json.loads(r).get("saves", {})
+
     if dry_run:
         if upload_ids:
             print("\nWould upload:")
@@ -433,42 +741,33 @@ def do_sync(games: list[dict], server: str, api_key: str, console_id: str,
                 g = games_by_id.get(tid)
                 name = g["name"] if g else tid
                 print(f"  {name} ({tid})")
+                print_server_save(server_saves.get(tid), "    ")
         return state
 
-    # Step 3: Process uploads
-    for tid in upload_ids:
-        g = games_by_id.get(tid)
-        if not g or not g["has_save"]:
-            continue
-        print(f"  Uploading: {g['name']}...")
-        sav_data = g["sav_path"].read_bytes()
-        title_id_int = int(tid, 16)
-        bundle = create_bundle(title_id_int, sav_data)
-        s, r = api_post_bundle(server, f"/saves/{tid}?force=true&source=ds_sync", api_key, bundle)
-        if s == 200:
-            state[tid] = g["save_hash"]
-            print(f"    OK")
-        else:
-            print(f"    Failed (HTTP {s})")
-
-    # Step 4: Process downloads
-    for tid in list(download_ids) + list(server_only_ids):
-        g = games_by_id.get(tid)
-        if not g:
-            continue
-        print(f"  Downloading: {g['name']}...")
-        s, r = api_get(server, f"/saves/{tid}", api_key)
-        if s == 200:
-            try:
-                sav_data = parse_bundle(r)
-                g["sav_path"].write_bytes(sav_data)
-                new_hash = hashlib.sha256(sav_data).hexdigest()
-                state[tid] = new_hash
-                print(f"    OK ({len(sav_data)} bytes)")
-            except Exception as e:
-                print(f"    Bundle parse error: {e}")
-        else:
-            print(f"    Failed (HTTP {s})")
+    # Steps 3 and 4: uploads and downloads, `jobs` at a time. Results are
+    # printed (and state updated) here as each one finishes.
+    unresolved = 0
+    transfers = [
+        (upload_save, "Uploading", games_by_id[tid])
+        for tid in upload_ids
+        if tid in games_by_id and games_by_id[tid]["has_save"]
+    ] + [
+        (download_save, "Downloading", games_by_id[tid])
+        for tid in list(download_ids) + list(server_only_ids)
+        if tid in games_by_id
+    ]
+    with ThreadPoolExecutor(max_workers=max(jobs, 1)) as pool:
+        futures = {
+            pool.submit(transfer, server, api_key, g): (transfer, verb, g)
+            for transfer, verb, g in transfers
+        }
+        for future in as_completed(futures):
+            transfer, verb, g = futures[future]
+            new_hash, message = future.result()
+            print(f"  {verb}: {g['name']}...")
+            print(f"    {message}")
+            record_transfer(state, g, new_hash, transfer is download_save)
+            unresolved += new_hash is None
 
     # Step 5: Handle conflicts
     for tid in conflict_ids:
@@ -477,6 +776,7 @@ def do_sync(games: list[dict], server: str, api_key: str, console_id: str,
             continue
         print(f"\n  CONFLICT: {g['name']} ({tid})")
         print(f"    Local hash:  {g['save_hash'][:16]}...")
+        print_server_save(server_saves.get(tid), "    ")
         print(f"    Choose action:")
         print(f"      [u] Upload local save to server")
         print(f"      [d] Download server save (overwrites local)")
@@ -485,31 +785,19 @@ def do_sync(games: list[dict], server: str, api_key: str, console_id: str,
 
         if choice == "u":
             print(f"    Uploading...")
-            sav_data = g["sav_path"].read_bytes()
-            title_id_int = int(tid, 16)
-            bundle = create_bundle(title_id_int, sav_data)
-            s, r = api_post_bundle(server, f"/saves/{tid}?force=true&source=ds_sync", api_key, bundle)
-            if s == 200:
-                state[tid] = g["save_hash"]
-                print(f"    OK")
-            else:
-                print(f"    Failed (HTTP {s})")
+            new_hash, message = upload_save(server, api_key, g)
+            print(f"    {message}")
+            record_transfer(state, g, new_hash, False)
+            unresolved += new_hash is None
         elif choice == "d":
             print(f"    Downloading...")
-            s, r = api_get(server, f"/saves/{tid}", api_key)
-            if s == 200:
-                try:
-                    sav_data = parse_bundle(r)
-                    g["sav_path"].write_bytes(sav_data)
-                    new_hash = hashlib.sha256(sav_data).hexdigest()
-                    state[tid] = new_hash
-                    print(f"    OK ({len(sav_data)} bytes)")
-                except Exception as e:
-                    print(f"    Bundle parse error: {e}")
-            else:
-                print(f"    Failed (HTTP {s})")
+            new_hash, message = download_save(server, api_key, g)
+            print(f"    {message}")
+            record_transfer(state, g, new_hash, True)
+            unresolved += new_hash is None
         else:
             print(f"    Skipped")
+            unresolved += 1
 
     # Mark up-to-date titles in state
     for tid in up_to_date_ids:
@@ -517,6 +805,12 @@ def do_sync(games: list[dict], server: str, api_key: str, console_id: str,
         if g and "save_hash" in g:
             state[tid] = g["save_hash"]
 
+    # Every title now matches the server, so the next sync can start from
+    # this cursor; anything left unresolved needs the full comparison
+    if changes is not None and unresolved == 0:
+        state[CHANGES_CURSOR_KEY] = changes["cursor"]
+    else:
+        state.pop(CHANGES_CURSOR_KEY, None)
     return state
 
 
@@ -531,6 +825,7 @@ Examples:
   python ds_sync.py --sd-path E:\\ --server http://192.168.1.201:8000 --api-key mykey
   python ds_sync.py --roms-dir E:\\nds --saves-dir E:\\nds\\saves --server ... --api-key ...
   python ds_sync.py --sd-path E:\\ --server ... --api-key ... --dry-run
+  python ds_sync.py --sd-path E:\\ --server ... --api-key ... --jobs 8
         """,
     )
     parser.add_argument("--sd-path", type=Path,
@@ -547,6 +842,9 @@ Examples:
                         help="Console ID override (default: auto-generated per SD card)")
     parser.add_argument("--dry-run", action="store_true",
                         help="Show what would be synced without making changes")
+    parser.add_argument("--jobs", type=int, default=DEFAULT_JOBS,
+                        help=f"Saves scanned, hashed and transferred at once (default {DEFAULT_JOBS}, "
+                             "1 for one at a time)")
 
     args = parser.parse_args()
 
@@ -595,7 +893,7 @@ Examples:
 
     # Scan for games
     print("\nScanning for NDS ROMs + saves...")
-    games = scan_roms(scan_path, saves_dir)
+    games = scan_roms(scan_path, saves_dir, args.jobs)
 
     # Filter out ROMs not in the database (boot ROMs, utilities, etc.)
     unknown = [g for g in games if g["gamecode"] not in name_db]
@@ -629,11 +927,10 @@ Examples:
     state = load_state(sync_dir)
 
     # Run sync
-    state = do_sync(games, server, args.api_key, console_id, state, args.dry_run)
+    state = do_sync(games, server, args.api_key, console_id, state, args.dry_run, args.jobs)
 
-    # Save state to SD card
-    if not args.dry_run:
-        save_state(sync_dir, state)
+    # Save state to SD card (a dry run still keeps the hashes it computed)
+    save_state(sync_dir, state)
 
     print("\nDone.")
 